@@ -1,20 +1,25 @@
 enable_testing()
 
-include(FetchContent)
+# an installed googletest is used if there is one, so the tests also build offline
+find_package(GTest QUIET)
 
-FetchContent_Declare(
-  googletest
-  GIT_REPOSITORY "https://ghproxy.com/https://github.com/google/googletest"
-  GIT_TAG v1.13.0
-)
+if(NOT GTest_FOUND)
+  include(FetchContent)
 
-set(gtest_force_shared_crt ON CACHE BOOL "" FORCE)
+  FetchContent_Declare(
+    googletest
+    GIT_REPOSITORY "https://ghproxy.com/https://github.com/google/googletest"
+    GIT_TAG v1.13.0
+  )
 
-FetchContent_MakeAvailable(googletest)
+  set(gtest_force_shared_crt ON CACHE BOOL "" FORCE)
+
+  FetchContent_MakeAvailable(googletest)
+endif()
 
 include(GoogleTest)
 
 macro(AddTest target)
-  target_link_libraries(${target} PRIVATE gtest_main)
+  target_link_libraries(${target} PRIVATE GTest::gtest_main)
   gtest_discover_tests(${target})
-endmacro()
\ No newline at end of file
+endmacro()
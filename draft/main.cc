@@ -1,20 +1,53 @@
+#include "Driver/Frontend.hpp"
 #include "Frontend/Lexer.hpp"
 #include "Frontend/Parser.hpp"
 #include "Frontend/Visitor.hpp"
 
 #include <iostream>
+#include <llvm/Support/CommandLine.h>
 #include <llvm/Support/InitLLVM.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/raw_ostream.h>
 
+static llvm::cl::list<std::string> InputFiles(llvm::cl::Positional, llvm::cl::desc("<input files>"));
+
+static llvm::cl::opt<unsigned> ErrorLimit("error-limit", llvm::cl::desc("Stop reporting errors after N (0 = no limit)"),
+                                          llvm::cl::init(0));
+
+static llvm::cl::opt<DiagnosticsEngine::OutputFormat> DiagnosticFormat(
+    "diagnostic-format", llvm::cl::desc("Diagnostic output format"),
+    llvm::cl::values(clEnumValN(DiagnosticsEngine::OutputFormat::Text, "text", "Human readable text"),
+                     clEnumValN(DiagnosticsEngine::OutputFormat::Json, "json", "JSON array"),
+                     clEnumValN(DiagnosticsEngine::OutputFormat::Sarif, "sarif", "SARIF 2.1.0 log")),
+    llvm::cl::init(DiagnosticsEngine::OutputFormat::Text));
+
+static llvm::cl::opt<u64> ConstEvalSteps("const-eval-steps",
+                                      llvm::cl::desc("Maximum number of steps when evaluating a const fn call"),
+                                      llvm::cl::init(1'000'000));
+
+static llvm::cl::opt<bool> PrintStats("pass-stats", llvm::cl::desc("Print statistics of the AST transformation passes"));
+
+static llvm::cl::list<std::string> ExportedSymbols("export-symbol",
+                                                   llvm::cl::desc("Keep the function even if main never calls it"));
+
+static llvm::cl::opt<bool> PruneBeforeSema("prune-before-sema",
+                                           llvm::cl::desc("Remove unreachable functions before type checking, "
+                                                          "errors in their bodies are not reported"));
+
+static llvm::cl::opt<bool> EmitLLVM("emit-llvm", llvm::cl::desc("Print the generated LLVM IR instead of the AST"));
+
+static llvm::cl::opt<bool> Pipeline("pipeline",
+                                    llvm::cl::desc("Lower each function on a worker thread as soon as Sema has "
+                                                   "checked it, instead of after the whole crate"));
+
 int main(int argc, char* argv[])
 {
   llvm::InitLLVM vm(argc, argv);
-  llvm::SmallVector<char const*, 256> args(argv + 1, argv + argc);
+  llvm::cl::ParseCommandLineOptions(argc, argv, "RustyC draft driver\n");
 
   llvm::outs() << "RustyC v0.0.1\n";
 
-  for (char const* filename : args) {
+  for (auto const& filename : InputFiles) {
     llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> fileOrError = llvm::MemoryBuffer::getFile(filename);
     if (std::error_code bufErr = fileOrError.getError()) {
       llvm::errs() << "Error reading: " << filename << ':' << bufErr.message() << "\n";
@@ -22,13 +55,28 @@ int main(int argc, char* argv[])
     }
     llvm::SourceMgr srcMgr;
     DiagnosticsEngine diags{srcMgr};
+    diags.setErrorLimit(ErrorLimit);
+    diags.setOutputFormat(DiagnosticFormat);
 
     srcMgr.AddNewSourceBuffer(std::move(fileOrError.get()), llvm::SMLoc());
     auto tokens = Lexer{srcMgr, diags}.tokenize();
     auto parser = Parser{tokens, diags};
     auto crate = parser.parseCrate();
-    auto sema = Sema{diags};
-    sema.actOnCrate(&crate);
-    llvm::outs() << CrateToString(&crate);
+    auto opts = FrontendOptions{};
+    opts.mConstEvalSteps = ConstEvalSteps;
+    opts.mPipeline = Pipeline;
+    opts.mPruneBeforeSema = PruneBeforeSema;
+    opts.mPrintStats = PrintStats;
+    opts.mEmitIR = EmitLLVM;
+    opts.mExportedSymbols = ExportedSymbols;
+    auto llvmCtx = llvm::LLVMContext{};
+    auto module = RunFrontend(&crate, filename, diags, llvmCtx, opts);
+    if (module) {
+      module->print(llvm::outs(), nullptr);
+    }
+    diags.flush();
+    if (!EmitLLVM) {
+      llvm::outs() << CrateToString(&crate);
+    }
   }
-}
\ No newline at end of file
+}
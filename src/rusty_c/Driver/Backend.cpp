@@ -0,0 +1,325 @@
+#include "Backend.hpp"
+#include "utils/utils.hpp"
+
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/CodeGen/ParallelCG.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/WithColor.h>
+
+namespace {
+// Reports loops whose #[vectorize], #[interleave] or #[unroll] request was not honoured. The transform-warning pass
+// flags them after the loop passes ran, the vectorizer explains before that why it gave up on a forced loop, in a
+// remark that is always printed. The explanations are held back to follow the warning they belong to. Everything else
+// goes to the handler that was installed before.
+class LoopHintDiagnosticHandler final : public llvm::DiagnosticHandler {
+  std::unique_ptr<llvm::DiagnosticHandler> mNext;
+  struct Note {
+    std::string mFunction;
+    std::string mLoc; // empty if the loop has no location
+    std::string mMessage;
+  };
+  std::vector<Note> mNotes;
+
+public:
+  explicit LoopHintDiagnosticHandler(std::unique_ptr<llvm::DiagnosticHandler> next) : mNext(std::move(next)) {}
+
+  auto takeNext() -> std::unique_ptr<llvm::DiagnosticHandler>
+  {
+    flushNotes([](auto const&) { return true; });
+    return std::move(mNext);
+  }
+
+  auto handleDiagnostics(llvm::DiagnosticInfo const& info) -> bool override
+  {
+    if (auto failure = llvm::dyn_cast<llvm::DiagnosticInfoOptimizationFailure>(&info)) {
+      auto fn = failure->getFunction().getName();
+      Print(&llvm::WithColor::warning, LocOf(*failure), fn, failure->getMsg());
+      flushNotes([fn](auto const& note) { return note.mFunction == fn; });
+      return true;
+    }
+    if (auto remark = llvm::dyn_cast<llvm::DiagnosticInfoIROptimization>(&info);
+        remark != nullptr && remark->getSeverity() == llvm::DS_Remark &&
+        remark->getPassName() == llvm::OptimizationRemarkAnalysis::AlwaysPrint) {
+      mNotes.push_back({remark->getFunction().getName().str(), LocOf(*remark), remark->getMsg()});
+      return true;
+    }
+    return mNext->handleDiagnostics(info);
+  }
+  auto isAnalysisRemarkEnabled(llvm::StringRef pass) const -> bool override
+  {
+    return mNext->isAnalysisRemarkEnabled(pass);
+  }
+  auto isMissedOptRemarkEnabled(llvm::StringRef pass) const -> bool override
+  {
+    return mNext->isMissedOptRemarkEnabled(pass);
+  }
+  auto isPassedOptRemarkEnabled(llvm::StringRef pass) const -> bool override
+  {
+    return mNext->isPassedOptRemarkEnabled(pass);
+  }
+
+private:
+  // IRGen attaches the annotated loop's location to its metadata, loops from other sources only have their function
+  static auto LocOf(llvm::DiagnosticInfoOptimizationBase const& info) -> std::string
+  {
+    return info.isLocationAvailable() ? info.getLocationStr() : std::string{};
+  }
+  using Severity = llvm::raw_ostream& (*)(llvm::raw_ostream&, llvm::StringRef, bool);
+  static auto Print(Severity kind, llvm::StringRef loc, llvm::StringRef fn, llvm::StringRef msg) -> void
+  {
+    if (!loc.empty()) {
+      kind(llvm::errs(), loc, false) << msg << '\n';
+    } else {
+      kind(llvm::errs(), "rusty_c", false) << "in function '" << fn << "': " << msg << '\n';
+    }
+  }
+
+  template <typename Pred>
+  auto flushNotes(Pred pred) -> void
+  {
+    for (auto const& note : mNotes) {
+      if (pred(note)) {
+        Print(&llvm::WithColor::note, note.mLoc, note.mFunction, note.mMessage);
+      }
+    }
+    llvm::erase_if(mNotes, pred);
+  }
+};
+} // namespace
+
+static auto ToPassBuilderLevel(OptLevel level) -> llvm::OptimizationLevel
+{
+  switch (level) {
+  case OptLevel::O0:
+    return llvm::OptimizationLevel::O0;
+  case OptLevel::O1:
+    return llvm::OptimizationLevel::O1;
+  case OptLevel::O2:
+    return llvm::OptimizationLevel::O2;
+  case OptLevel::O3:
+    return llvm::OptimizationLevel::O3;
+  case OptLevel::Os:
+    return llvm::OptimizationLevel::Os;
+  case OptLevel::Oz:
+    return llvm::OptimizationLevel::Oz;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+auto ToCodeGenLevel(OptLevel level) -> llvm::CodeGenOpt::Level
+{
+  switch (level) {
+  case OptLevel::O0:
+    return llvm::CodeGenOpt::None;
+  case OptLevel::O1:
+    return llvm::CodeGenOpt::Less;
+  case OptLevel::O2:
+  case OptLevel::Os:
+  case OptLevel::Oz:
+    return llvm::CodeGenOpt::Default;
+  case OptLevel::O3:
+    return llvm::CodeGenOpt::Aggressive;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+auto ParseOptLevel(std::string_view level) -> std::optional<OptLevel>
+{
+  if (level.size() != 1) {
+    return std::nullopt;
+  }
+  switch (level[0]) {
+  case '0':
+    return OptLevel::O0;
+  case '1':
+    return OptLevel::O1;
+  case '2':
+    return OptLevel::O2;
+  case '3':
+    return OptLevel::O3;
+  case 's':
+    return OptLevel::Os;
+  case 'z':
+    return OptLevel::Oz;
+  default:
+    return std::nullopt;
+  }
+}
+
+auto ResolveCPU(CodegenOptions const& opts) -> std::pair<std::string, std::string>
+{
+  auto cpu = opts.mCPU.empty() ? std::string{"generic"} : opts.mCPU;
+  auto features = opts.mFeatures;
+  if (cpu == "native") {
+    cpu = llvm::sys::getHostCPUName().str();
+    if (llvm::StringMap<bool> hostFeatures; features.empty() && llvm::sys::getHostCPUFeatures(hostFeatures)) {
+      auto list = llvm::SubtargetFeatures{};
+      for (auto& feature : hostFeatures) {
+        list.AddFeature(feature.first(), feature.second);
+      }
+      features = list.getString();
+    }
+  }
+  return {cpu, features};
+}
+
+auto CreateTargetMachine(CodegenOptions const& opts) -> llvm::Expected<std::unique_ptr<llvm::TargetMachine>>
+{
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  llvm::InitializeNativeTargetAsmParser();
+
+  auto triple = opts.mTriple.empty() ? llvm::sys::getDefaultTargetTriple() : opts.mTriple;
+  auto error = std::string{};
+  auto target = llvm::TargetRegistry::lookupTarget(triple, error);
+  if (target == nullptr) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(), error);
+  }
+
+  auto [cpu, features] = ResolveCPU(opts);
+  auto tm = target->createTargetMachine(triple, cpu, features, llvm::TargetOptions{}, llvm::Reloc::PIC_, llvm::None,
+                                        ToCodeGenLevel(opts.mOptLevel));
+  if (tm == nullptr) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(), "cannot create target machine for " + triple);
+  }
+  return std::unique_ptr<llvm::TargetMachine>(tm);
+}
+
+auto PGOOptionsOf(CodegenOptions const& opts) -> llvm::Optional<llvm::PGOOptions>
+{
+  if (opts.mProfileGenerate) {
+    // %m keeps the profiles of different binaries apart, the runtime fills it in
+    auto path = llvm::SmallString<128>{*opts.mProfileGenerate};
+    llvm::sys::path::append(path, "default_%m.profraw");
+    return llvm::PGOOptions(path.str().str(), "", "", llvm::PGOOptions::IRInstr);
+  }
+  if (!opts.mProfileUse.empty()) {
+    return llvm::PGOOptions(opts.mProfileUse, "", "", llvm::PGOOptions::IRUse);
+  }
+  return llvm::None;
+}
+
+auto OptimizeModule(llvm::Module& module, llvm::TargetMachine& tm, OptLevel level, LTOPhase phase,
+                    llvm::ModuleSummaryIndex const* index, llvm::Optional<llvm::PGOOptions> const& pgo) -> void
+{
+  module.setTargetTriple(tm.getTargetTriple().str());
+  module.setDataLayout(tm.createDataLayout());
+
+  auto lam = llvm::LoopAnalysisManager{};
+  auto fam = llvm::FunctionAnalysisManager{};
+  auto cgam = llvm::CGSCCAnalysisManager{};
+  auto mam = llvm::ModuleAnalysisManager{};
+
+  auto pb = llvm::PassBuilder(&tm, llvm::PipelineTuningOptions{}, pgo);
+  pb.registerModuleAnalyses(mam);
+  pb.registerCGSCCAnalyses(cgam);
+  pb.registerFunctionAnalyses(fam);
+  pb.registerLoopAnalyses(lam);
+  pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+  auto mpm = llvm::ModulePassManager{};
+  if (level == OptLevel::O0) {
+    mpm = pb.buildO0DefaultPipeline(llvm::OptimizationLevel::O0, phase == LTOPhase::ThinPreLink);
+  } else if (phase == LTOPhase::ThinPreLink) {
+    mpm = pb.buildThinLTOPreLinkDefaultPipeline(ToPassBuilderLevel(level));
+  } else if (phase == LTOPhase::ThinPostLink) {
+    mpm = pb.buildThinLTODefaultPipeline(ToPassBuilderLevel(level), index);
+  } else {
+    mpm = pb.buildPerModuleDefaultPipeline(ToPassBuilderLevel(level));
+  }
+
+  auto& ctx = module.getContext();
+  ctx.setDiagnosticHandler(std::make_unique<LoopHintDiagnosticHandler>(ctx.getDiagnosticHandler()));
+  mpm.run(module, mam);
+  auto handler = ctx.getDiagnosticHandler();
+  ctx.setDiagnosticHandler(static_cast<LoopHintDiagnosticHandler&>(*handler).takeNext());
+}
+
+auto EmitModule(llvm::Module& module, llvm::TargetMachine& tm, EmitKind kind, llvm::raw_pwrite_stream& os)
+    -> llvm::Error
+{
+  switch (kind) {
+  case EmitKind::LLVMIR:
+    module.print(os, nullptr);
+    return llvm::Error::success();
+  case EmitKind::Bitcode:
+    llvm::WriteBitcodeToFile(module, os);
+    return llvm::Error::success();
+  case EmitKind::ThinBitcode: {
+    auto psi = llvm::ProfileSummaryInfo(module);
+    auto index = llvm::buildModuleSummaryIndex(module, nullptr, &psi);
+    llvm::WriteBitcodeToFile(module, os, false, &index);
+    return llvm::Error::success();
+  }
+  case EmitKind::Assembly:
+  case EmitKind::Object: {
+    // the new pass manager cannot run codegen yet in LLVM 14
+    auto pm = llvm::legacy::PassManager{};
+    auto fileType = kind == EmitKind::Assembly ? llvm::CGFT_AssemblyFile : llvm::CGFT_ObjectFile;
+    if (tm.addPassesToEmitFile(pm, os, nullptr, fileType)) {
+      return llvm::createStringError(llvm::inconvertibleErrorCode(), "target cannot emit this file type");
+    }
+    pm.run(module);
+    return llvm::Error::success();
+  }
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+auto EmitKindExtension(EmitKind kind) -> std::string_view
+{
+  switch (kind) {
+  case EmitKind::LLVMIR:
+    return ".ll";
+  case EmitKind::Bitcode:
+  case EmitKind::ThinBitcode:
+    return ".bc";
+  case EmitKind::Assembly:
+    return ".s";
+  case EmitKind::Object:
+    return ".o";
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+auto EmitObjectsParallel(llvm::Module& module, CodegenOptions const& opts, unsigned jobs)
+    -> std::vector<llvm::SmallString<0>>
+{
+  auto objects = std::vector<llvm::SmallString<0>>(jobs);
+  auto streams = std::vector<std::unique_ptr<llvm::raw_svector_ostream>>{};
+  auto outputs = std::vector<llvm::raw_pwrite_stream*>{};
+  for (auto& object : objects) {
+    outputs.push_back(streams.emplace_back(std::make_unique<llvm::raw_svector_ostream>(object)).get());
+  }
+  // the caller already created a target machine from the same options, so this cannot fail
+  auto factory = [&opts] { return llvm::cantFail(CreateTargetMachine(opts)); };
+  // locals may be promoted to hidden globals, otherwise a static function pins all its callers to one partition
+  llvm::splitCodeGen(module, outputs, {}, factory, llvm::CGFT_ObjectFile, false);
+  return objects;
+}
+
+auto WriteObjectArchive(llvm::StringRef path, llvm::StringRef memberStem, llvm::Triple const& triple,
+                        std::vector<llvm::SmallString<0>> const& objects) -> llvm::Error
+{
+  auto names = std::vector<std::string>{};
+  names.reserve(objects.size());
+  auto members = std::vector<llvm::NewArchiveMember>{};
+  for (auto i = std::size_t{0}; i < objects.size(); ++i) {
+    names.push_back((memberStem + "." + llvm::Twine(i) + ".o").str());
+    members.emplace_back(llvm::MemoryBufferRef(objects[i].str(), names.back()));
+  }
+  auto kind = triple.isOSDarwin() ? llvm::object::Archive::K_DARWIN : llvm::object::Archive::K_GNU;
+  return llvm::writeArchive(path, members, true, kind, true, false);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Frontend/common.hpp"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/ModuleSummaryIndex.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/PGOOptions.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class OptLevel { O0, O1, O2, O3, Os, Oz };
+enum class EmitKind { LLVMIR, Bitcode, ThinBitcode, Assembly, Object };
+enum class LTOPhase { None, ThinPreLink, ThinPostLink };
+
+struct CodegenOptions {
+  std::string mTriple; // host if empty
+  std::string mCPU;    // generic if empty, `native` for the host cpu
+  std::string mFeatures;
+  OptLevel mOptLevel = OptLevel::O0;
+  std::optional<std::string> mProfileGenerate; // directory for the .profraw files, instrumentation if set
+  std::string mProfileUse;                     // .profdata to optimize with, none if empty
+};
+
+// accepts the suffix of -O, i.e. 0-3, s and z
+auto ParseOptLevel(std::string_view level) -> std::optional<OptLevel>;
+
+// size levels still want the instruction selection of -O2
+auto ToCodeGenLevel(OptLevel level) -> llvm::CodeGenOpt::Level;
+
+// cpu and feature string of the options, `native` expanded to the host cpu and its features
+auto ResolveCPU(CodegenOptions const& opts) -> std::pair<std::string, std::string>;
+
+auto CreateTargetMachine(CodegenOptions const& opts) -> llvm::Expected<std::unique_ptr<llvm::TargetMachine>>;
+
+// instrumentation or profile use for the pass builder, None without -C profile-generate/profile-use
+auto PGOOptionsOf(CodegenOptions const& opts) -> llvm::Optional<llvm::PGOOptions>;
+
+// runs the default new pass manager pipeline of the level, the module gets the triple and data layout of `tm`. The
+// ThinLTO pre-link pipeline leaves the late loop passes to the post-link one, which needs the combined `index`.
+auto OptimizeModule(llvm::Module& module, llvm::TargetMachine& tm, OptLevel level, LTOPhase phase = LTOPhase::None,
+                    llvm::ModuleSummaryIndex const* index = nullptr,
+                    llvm::Optional<llvm::PGOOptions> const& pgo = llvm::None) -> void;
+
+// ThinBitcode carries the module summary index that the thin link reads
+auto EmitModule(llvm::Module& module, llvm::TargetMachine& tm, EmitKind kind, llvm::raw_pwrite_stream& os)
+    -> llvm::Error;
+
+auto EmitKindExtension(EmitKind kind) -> std::string_view;
+
+// Splits the module into `jobs` partitions and generates one object per partition, each on its own thread with its own
+// LLVMContext and TargetMachine. Linking all of them is equivalent to the object of the whole module.
+auto EmitObjectsParallel(llvm::Module& module, CodegenOptions const& opts, unsigned jobs)
+    -> std::vector<llvm::SmallString<0>>;
+
+// writes the objects into a static archive with a symbol table, members are named `<memberStem>.<index>.o`
+auto WriteObjectArchive(llvm::StringRef path, llvm::StringRef memberStem, llvm::Triple const& triple,
+                        std::vector<llvm::SmallString<0>> const& objects) -> llvm::Error;
@@ -0,0 +1,97 @@
+#include "Frontend.hpp"
+#include "Frontend/CodeGen/Pipeline.hpp"
+#include "Frontend/Sema/ConstEval.hpp"
+#include "Frontend/Sema/Layout.hpp"
+#include "Frontend/Sema/Sema.hpp"
+#include "Frontend/Transform/BoundsCheck.hpp"
+#include "Frontend/Transform/Reachability.hpp"
+#include "Frontend/Transform/Simplify.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+#include <optional>
+
+auto RunFrontend(Crate* crate, std::string_view modname, DiagnosticsEngine& diags, llvm::LLVMContext& ctx,
+                 FrontendOptions const& opts) -> std::unique_ptr<llvm::Module>
+{
+  if (diags.numErrors() != 0) {
+    return nullptr; // the parser leaves holes in the AST where it reported an error
+  }
+  auto reachability = ReachabilityAnalysis{};
+  auto numPruned = u32{0};
+  if (opts.mPruneBeforeSema || opts.mPipeline) {
+    reachability.analyze(crate, opts.mExportedSymbols);
+    if (opts.mPruneBeforeSema) {
+      numPruned += reachability.prune(crate);
+    }
+  }
+
+  auto constEval = ConstEvaluator{diags, opts.mConstEvalSteps};
+  auto simplifier = Simplifier{};
+  auto boundsChecks = BoundsCheckEliminator{};
+  auto sema = Sema{diags};
+  auto module = std::unique_ptr<llvm::Module>{};
+
+  if (opts.mPipeline && opts.mEmitIR) {
+    // reachability has to be known up front here, finish() removes what folding and simplification made unused
+    auto pipeline = CodeGenPipeline{ctx, modname, &diags.getSourceMgr()};
+    sema.setOnItemChecked([&](Item* item) {
+      if (diags.numErrors() != 0) {
+        return;
+      }
+      constEval.foldItem(item);
+      if (item->mKind != Item::Kind::Function) {
+        return; // consts and statics are lowered along with the functions using them
+      }
+      auto fn = item->as<FunctionItem>();
+      simplifier.simplifyItem(fn);
+      boundsChecks.eliminateItem(fn);
+      if (reachability.isReachable(fn)) {
+        pipeline.enqueue(fn);
+      } else {
+        ++numPruned; // left in the crate, but never lowered
+      }
+    });
+    sema.actOnCrate(crate);
+    module = pipeline.finish(opts.mExportedSymbols);
+  } else {
+    sema.actOnCrate(crate);
+    if (diags.numErrors() == 0) {
+      constEval.foldCrate(crate);
+      simplifier.simplifyCrate(crate);
+      boundsChecks.eliminateCrate(crate);
+      // simplification may have removed calls, so reachability is (re)computed right before IRGen
+      reachability.analyze(crate, opts.mExportedSymbols);
+      numPruned += reachability.prune(crate);
+      if (opts.mEmitIR && diags.numErrors() == 0) { // a const whose initializer did not fold has nothing to lower
+        auto gen = IRGen{ctx, modname};
+        gen.setSourceMgr(&diags.getSourceMgr());
+        gen.genCrate(crate);
+        module = gen.takeModule();
+      }
+    }
+  }
+
+  if (opts.mPrintTypeLayouts && diags.numErrors() == 0) {
+    for (auto& item : crate->mItems) {
+      if (item->mKind == Item::Kind::Struct) {
+        PrintStructLayout(llvm::outs(), item->as<StructItem>());
+      }
+    }
+  }
+  if (opts.mPrintStats) {
+    auto const& stats = simplifier.stats();
+    llvm::errs() << "simplify: " << stats.mPrunedBranches << " branch(es) pruned, " << stats.mDeadStmts
+                 << " dead statement(s) removed, " << stats.mUnusedLets << " unused let(s) removed\n";
+    llvm::errs() << "reachability: " << reachability.numReachable() << " function(s) reachable, " << numPruned
+                 << " unreachable item(s) removed\n";
+    llvm::errs() << "bounds checks: " << boundsChecks.stats().mEliminated << " of " << boundsChecks.stats().mChecks
+                 << " removed\n";
+  }
+  if (diags.numErrors() != 0) {
+    return nullptr;
+  }
+  if (module && llvm::verifyModule(*module, &llvm::errs())) {
+    utils::Unreachable(utils::SrcLoc::current(), "IRGen produced an invalid module for {}", modname);
+  }
+  return module;
+}
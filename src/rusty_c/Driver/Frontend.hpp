@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Frontend/Diagnostic.hpp"
+#include "Frontend/Syntax.hpp"
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+struct FrontendOptions {
+  u64 mConstEvalSteps = 1'000'000;
+  bool mPipeline = false;        // lower functions on a worker thread while Sema is running
+  bool mPruneBeforeSema = false; // unreachable functions are not even type checked
+  bool mPrintStats = false;
+  bool mPrintTypeLayouts = false; // to stdout, in crate order
+  bool mEmitIR = true; // only run the AST passes if false
+  std::vector<std::string> mExportedSymbols;
+};
+
+// Sema, const folding, simplification, reachability and IRGen over a parsed crate. Returns null if there were errors
+// or no IR was requested, the crate is left in its simplified form either way.
+auto RunFrontend(Crate* crate, std::string_view modname, DiagnosticsEngine& diags, llvm::LLVMContext& ctx,
+                 FrontendOptions const& opts) -> std::unique_ptr<llvm::Module>;
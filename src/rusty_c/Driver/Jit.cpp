@@ -0,0 +1,546 @@
+#include "Jit.hpp"
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/TargetProcess/TargetExecutionUtils.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/WithColor.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+struct MainSignature {
+  unsigned mNumParams = 0;
+  bool mReturnsVoid = false;
+};
+} // namespace
+
+// the host cpu and its features unless -C overrides them, there is no reason to be portable in-process
+static auto CreateHostBuilder(CodegenOptions const& opts) -> llvm::Expected<llvm::orc::JITTargetMachineBuilder>
+{
+  auto jtmb = llvm::orc::JITTargetMachineBuilder::detectHost();
+  if (!jtmb) {
+    return jtmb.takeError();
+  }
+  if (!opts.mCPU.empty() && opts.mCPU != "native") {
+    jtmb->setCPU(opts.mCPU);
+    jtmb->getFeatures() = llvm::SubtargetFeatures{};
+  }
+  if (!opts.mFeatures.empty()) {
+    auto features = llvm::SmallVector<llvm::StringRef>{};
+    llvm::StringRef(opts.mFeatures).split(features, ',', -1, false);
+    for (auto feature : features) {
+      jtmb->getFeatures().AddFeature(feature);
+    }
+  }
+  jtmb->setCodeGenOptLevel(ToCodeGenLevel(opts.mOptLevel));
+  return jtmb;
+}
+
+static auto ReadMainSignature(llvm::Module const& module) -> llvm::Expected<MainSignature>
+{
+  auto fn = module.getFunction("main");
+  if (fn == nullptr || fn->isDeclaration()) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(), "no `main` function to run");
+  }
+  return MainSignature{static_cast<unsigned>(fn->arg_size()), fn->getReturnType()->isVoidTy()};
+}
+
+static auto AddHostProcessSymbols(llvm::orc::LLJIT& jit) -> llvm::Error
+{
+  auto host = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit.getDataLayout().getGlobalPrefix());
+  if (!host) {
+    return host.takeError();
+  }
+  jit.getMainJITDylib().addGenerator(std::move(*host));
+  return llvm::Error::success();
+}
+
+// session errors print the symbols and dylibs they refer to, turn them into text while the session is still alive
+static auto DetachError(llvm::Error err) -> llvm::Error
+{
+  if (!err) {
+    return err;
+  }
+  return llvm::createStringError(llvm::inconvertibleErrorCode(), llvm::toString(std::move(err)));
+}
+
+// lazy stubs jump here if their function fails to materialize, the session has already reported why
+[[noreturn]] static void OnLazyCompileFailure()
+{
+  llvm::WithColor::error(llvm::errs(), "rusty_c") << "a function called from JIT code could not be compiled\n";
+  std::exit(1);
+}
+
+// a signal raised while main runs is the program failing, not the compiler: a failed bounds or range step check is a
+// trap. LLVM's handlers would print a bug report request and a stack dump of rusty_c, they are swapped out meanwhile
+namespace {
+constexpr int kProgramSignals[] = {SIGILL, SIGTRAP, SIGSEGV, SIGBUS, SIGFPE};
+constexpr auto kProgramFailureExitCode = 101; // what a Rust program that panics exits with
+
+class ProgramSignalScope {
+  struct sigaction mPrevious[std::size(kProgramSignals)];
+
+public:
+  ProgramSignalScope()
+  {
+    struct sigaction action = {};
+    action.sa_handler = &OnProgramSignal;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < std::size(kProgramSignals); ++i) {
+      sigaction(kProgramSignals[i], &action, &mPrevious[i]);
+    }
+  }
+  ~ProgramSignalScope()
+  {
+    for (size_t i = 0; i < std::size(kProgramSignals); ++i) {
+      sigaction(kProgramSignals[i], &mPrevious[i], nullptr);
+    }
+  }
+  ProgramSignalScope(ProgramSignalScope const&) = delete;
+  auto operator=(ProgramSignalScope const&) -> ProgramSignalScope& = delete;
+
+private:
+  // only async-signal-safe calls from here
+  [[noreturn]] static void OnProgramSignal(int signo)
+  {
+    auto message = "rusty_c: error: the program crashed\n";
+    switch (signo) {
+    case SIGILL:
+    case SIGTRAP:
+      message = "rusty_c: error: the program trapped, an index was out of bounds or a range step was not positive\n";
+      break;
+    case SIGFPE:
+      message = "rusty_c: error: the program divided by zero or overflowed a division\n";
+      break;
+    }
+    [[maybe_unused]] auto written = write(STDERR_FILENO, message, std::strlen(message));
+    _exit(kProgramFailureExitCode);
+  }
+};
+} // namespace
+
+static auto CallMain(llvm::JITTargetAddress address, MainSignature signature, std::vector<std::string> const& args)
+    -> int
+{
+  auto signals = ProgramSignalScope{};
+  if (signature.mReturnsVoid) {
+    llvm::jitTargetAddressToFunction<void (*)()>(address)();
+    return 0;
+  }
+  if (signature.mNumParams == 0) {
+    return llvm::jitTargetAddressToFunction<int (*)()>(address)();
+  }
+  return llvm::orc::runAsMain(llvm::jitTargetAddressToFunction<int (*)(int, char*[])>(address), args);
+}
+
+auto RunInJit(llvm::orc::ThreadSafeModule module, CodegenOptions const& opts, std::vector<std::string> const& args)
+    -> llvm::Expected<int>
+{
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+
+  auto signature = module.withModuleDo(ReadMainSignature);
+  if (!signature) {
+    return signature.takeError();
+  }
+  auto jtmb = CreateHostBuilder(opts);
+  if (!jtmb) {
+    return jtmb.takeError();
+  }
+  auto jit = llvm::orc::LLLazyJITBuilder{}
+                 .setJITTargetMachineBuilder(std::move(*jtmb))
+                 .setLazyCompileFailureAddr(llvm::pointerToJITTargetAddress(&OnLazyCompileFailure))
+                 .create();
+  if (!jit) {
+    return jit.takeError();
+  }
+  if (auto err = AddHostProcessSymbols(**jit)) {
+    return DetachError(std::move(err));
+  }
+
+  // the default partitioning of the compile-on-demand layer extracts just the requested function
+  if (auto err = (*jit)->addLazyIRModule(std::move(module))) {
+    return DetachError(std::move(err));
+  }
+  auto symbol = (*jit)->lookup("main");
+  if (!symbol) {
+    return DetachError(symbol.takeError());
+  }
+  return CallMain(symbol->getAddress(), *signature, args);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// tiered execution
+
+namespace {
+constexpr auto kTierUpCallback = "rusty.tier_up";
+constexpr auto kTierFlag = "rusty.tier";
+
+enum class TierUpReason : u32 { Calls, Backedges };
+
+// picks the codegen level from the tier flag of the module, the JIT has a single compile layer for both tiers
+class TieredCompiler : public llvm::orc::IRCompileLayer::IRCompiler {
+public:
+  explicit TieredCompiler(llvm::orc::JITTargetMachineBuilder jtmb)
+      : IRCompiler(llvm::orc::irManglingOptionsFromTargetOptions(jtmb.getOptions())), mBuilder(std::move(jtmb))
+  {
+  }
+  auto operator()(llvm::Module& module) -> llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> override
+  {
+    auto jtmb = mBuilder;
+    jtmb.setCodeGenOptLevel(module.getModuleFlag(kTierFlag) ? llvm::CodeGenOpt::Aggressive : llvm::CodeGenOpt::None);
+    auto tm = jtmb.createTargetMachine();
+    if (!tm) {
+      return tm.takeError();
+    }
+    return llvm::orc::SimpleCompiler(**tm)(module);
+  }
+
+private:
+  llvm::orc::JITTargetMachineBuilder mBuilder;
+};
+
+struct TierUpEvent {
+  std::string mName;
+  TierUpReason mReason;
+  std::chrono::microseconds mCompileTime;
+};
+
+class TieredEngine {
+public:
+  TieredEngine(std::unique_ptr<llvm::orc::LLJIT> jit, llvm::orc::JITTargetMachineBuilder jtmb,
+               TieringOptions const& opts)
+      : mJit(std::move(jit)), mBuilder(std::move(jtmb)), mOpts(opts),
+        mStubs(llvm::orc::createLocalIndirectStubsManagerBuilder(mJit->getTargetTriple())())
+  {
+  }
+  ~TieredEngine() { stop(); }
+
+  auto load(llvm::orc::ThreadSafeModule module) -> llvm::Error;
+  auto lookupMain() -> llvm::Expected<llvm::JITTargetAddress> { return findStub("main"); }
+  // waits for the promotion being compiled, the queued ones are dropped
+  auto stop() -> void;
+  auto printStats(llvm::raw_ostream& os) -> void;
+
+  // called from tier 0 code when a counter reaches its threshold
+  static auto onTierUp(TieredEngine* engine, u32 id, u32 reason) -> void;
+
+private:
+  auto instrument(llvm::Function& fn, u32 id) -> void;
+  auto findStub(llvm::StringRef name) -> llvm::Expected<llvm::JITTargetAddress>;
+  auto promote(u32 id) -> llvm::Error;
+  auto run() -> void;
+
+  std::unique_ptr<llvm::orc::LLJIT> mJit;
+  llvm::orc::JITTargetMachineBuilder mBuilder;
+  TieringOptions mOpts;
+  std::unique_ptr<llvm::orc::IndirectStubsManager> mStubs;
+  llvm::SmallVector<char, 0> mBitcode; // the module before instrumentation, source of every tier 1 compile
+  std::vector<std::string> mNames;     // function id -> name of its stub
+
+  std::mutex mMutex;
+  std::condition_variable mWakeUp;
+  std::deque<std::pair<u32, TierUpReason>> mQueue;
+  std::vector<bool> mRequested;
+  std::vector<TierUpEvent> mEvents;
+  bool mStopping = false;
+  std::thread mWorker;
+};
+} // namespace
+
+auto TieredEngine::onTierUp(TieredEngine* engine, u32 id, u32 reason) -> void
+{
+  {
+    auto lock = std::lock_guard{engine->mMutex};
+    if (engine->mStopping || engine->mRequested[id]) {
+      return;
+    }
+    engine->mRequested[id] = true;
+    engine->mQueue.emplace_back(id, static_cast<TierUpReason>(reason));
+  }
+  engine->mWakeUp.notify_one();
+}
+
+auto TieredEngine::findStub(llvm::StringRef name) -> llvm::Expected<llvm::JITTargetAddress>
+{
+  auto stub = mStubs->findStub(name, false);
+  if (!stub) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(), "no stub for `%s`", name.str().c_str());
+  }
+  return stub.getAddress();
+}
+
+// counts at the entry and on every back edge, the comparison is an equality so each counter fires once
+auto TieredEngine::instrument(llvm::Function& fn, u32 id) -> void
+{
+  auto& ctx = fn.getContext();
+  auto module = fn.getParent();
+  auto i64Ty = llvm::Type::getInt64Ty(ctx);
+  auto i32Ty = llvm::Type::getInt32Ty(ctx);
+  auto enginePtr = llvm::ConstantExpr::getIntToPtr(llvm::ConstantInt::get(i64Ty, reinterpret_cast<uintptr_t>(this)),
+                                                   llvm::Type::getInt8PtrTy(ctx));
+  auto callback = module->getOrInsertFunction(
+      kTierUpCallback, llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), {enginePtr->getType(), i32Ty, i32Ty}, false));
+
+  auto count = [&](llvm::Instruction* before, llvm::StringRef suffix, u64 threshold, TierUpReason reason) {
+    auto counter = new llvm::GlobalVariable(*module, i64Ty, false, llvm::GlobalValue::InternalLinkage,
+                                            llvm::ConstantInt::get(i64Ty, 0), fn.getName() + suffix);
+    auto builder = llvm::IRBuilder<>(before);
+    auto value = builder.CreateAdd(builder.CreateLoad(i64Ty, counter), builder.getInt64(1));
+    builder.CreateStore(value, counter);
+    auto hot = builder.CreateICmpEQ(value, builder.getInt64(threshold));
+    auto then = llvm::SplitBlockAndInsertIfThen(hot, before, false);
+    llvm::IRBuilder<>(then).CreateCall(callback, {enginePtr, builder.getInt32(id),
+                                                  builder.getInt32(static_cast<u32>(reason))});
+  };
+
+  auto backedges = llvm::SmallVector<llvm::Instruction*>{};
+  if (mOpts.mBackedgeThreshold != 0) {
+    auto domTree = llvm::DominatorTree(fn);
+    for (auto& bb : fn) {
+      auto term = bb.getTerminator();
+      for (auto succ : llvm::successors(&bb)) {
+        if (domTree.dominates(succ, &bb)) {
+          backedges.push_back(term);
+          break;
+        }
+      }
+    }
+  }
+  for (auto term : backedges) {
+    count(term, "$backedges", mOpts.mBackedgeThreshold, TierUpReason::Backedges);
+  }
+  if (mOpts.mCallThreshold != 0) {
+    // behind the allocas, they have to stay in the entry block
+    auto it = fn.getEntryBlock().begin();
+    while (llvm::isa<llvm::AllocaInst>(*it)) {
+      ++it;
+    }
+    count(&*it, "$calls", mOpts.mCallThreshold, TierUpReason::Calls);
+  }
+}
+
+auto TieredEngine::load(llvm::orc::ThreadSafeModule tsm) -> llvm::Error
+{
+  if (mStubs == nullptr) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(), "indirect stubs are not supported on %s",
+                                   mJit->getTargetTriple().str().c_str());
+  }
+  auto& dylib = mJit->getMainJITDylib();
+  auto mangle = llvm::orc::MangleAndInterner(mJit->getExecutionSession(), mJit->getDataLayout());
+  auto flags = llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable;
+
+  auto tier0Names = std::vector<std::string>{};
+  tsm.withModuleDo([&](llvm::Module& module) {
+    // every function has to be reachable through its stub, that includes nested ones
+    for (auto& fn : module) {
+      if (!fn.isDeclaration()) {
+        fn.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        mNames.push_back(fn.getName().str());
+      }
+    }
+    for (auto& global : module.globals()) {
+      if (!global.isConstant() && !global.isDeclaration()) {
+        global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+      }
+    }
+    auto os = llvm::raw_svector_ostream(mBitcode);
+    llvm::WriteBitcodeToFile(module, os);
+
+    // calls are redirected to a declaration carrying the original name, which the stub then defines
+    for (auto id = u32{0}; id < mNames.size(); ++id) {
+      auto fn = module.getFunction(mNames[id]);
+      auto decl = llvm::Function::Create(fn->getFunctionType(), llvm::GlobalValue::ExternalLinkage, "", module);
+      fn->replaceAllUsesWith(decl);
+      fn->setName(mNames[id] + "$t0");
+      decl->setName(mNames[id]);
+      tier0Names.push_back(fn->getName().str());
+      instrument(*fn, id);
+    }
+  });
+  mRequested.assign(mNames.size(), false);
+
+  // stubs start out null and are pointed at tier 0 once it is compiled, resolving tier 0 needs the stubs
+  auto inits = llvm::orc::IndirectStubsManager::StubInitsMap{};
+  for (auto& name : mNames) {
+    inits[name] = {0, flags};
+  }
+  if (auto err = mStubs->createStubs(inits)) {
+    return err;
+  }
+  auto symbols = llvm::orc::SymbolMap{};
+  for (auto& name : mNames) {
+    symbols[mangle(name)] = llvm::JITEvaluatedSymbol(mStubs->findStub(name, false).getAddress(), flags);
+  }
+  symbols[mangle(kTierUpCallback)] =
+      llvm::JITEvaluatedSymbol(llvm::pointerToJITTargetAddress(&TieredEngine::onTierUp), flags);
+  if (auto err = dylib.define(llvm::orc::absoluteSymbols(std::move(symbols)))) {
+    return err;
+  }
+
+  if (auto err = mJit->addIRModule(std::move(tsm))) {
+    return err;
+  }
+  for (auto id = u32{0}; id < mNames.size(); ++id) {
+    auto symbol = mJit->lookup(tier0Names[id]);
+    if (!symbol) {
+      return symbol.takeError();
+    }
+    if (auto err = mStubs->updatePointer(mNames[id], symbol->getAddress())) {
+      return err;
+    }
+  }
+  mWorker = std::thread(&TieredEngine::run, this);
+  return llvm::Error::success();
+}
+
+auto TieredEngine::promote(u32 id) -> llvm::Error
+{
+  auto const& name = mNames[id];
+  auto ctx = std::make_unique<llvm::LLVMContext>();
+  auto module = llvm::parseBitcodeFile(llvm::MemoryBufferRef({mBitcode.data(), mBitcode.size()}, name), *ctx);
+  if (!module) {
+    return module.takeError();
+  }
+
+  // the other bodies are only there to be inlined, their symbols still resolve to the stubs
+  for (auto& fn : **module) {
+    if (fn.isDeclaration()) {
+      continue;
+    }
+    if (fn.getName() == name) {
+      fn.setName(name + "$t1");
+    } else {
+      fn.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+    }
+  }
+  for (auto& global : (*module)->globals()) {
+    if (!global.isConstant() && !global.isDeclaration()) {
+      global.setInitializer(nullptr);
+    }
+  }
+
+  auto tm = mBuilder.createTargetMachine();
+  if (!tm) {
+    return tm.takeError();
+  }
+  OptimizeModule(**module, **tm, OptLevel::O3);
+  (*module)->addModuleFlag(llvm::Module::Warning, kTierFlag, 1);
+
+  if (auto err = mJit->addIRModule(llvm::orc::ThreadSafeModule(std::move(*module), std::move(ctx)))) {
+    return err;
+  }
+  auto symbol = mJit->lookup(name + "$t1");
+  if (!symbol) {
+    return symbol.takeError();
+  }
+  return mStubs->updatePointer(name, symbol->getAddress());
+}
+
+auto TieredEngine::run() -> void
+{
+  while (true) {
+    auto lock = std::unique_lock{mMutex};
+    mWakeUp.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+    if (mStopping) {
+      return;
+    }
+    auto [id, reason] = mQueue.front();
+    mQueue.pop_front();
+    lock.unlock();
+
+    auto start = std::chrono::steady_clock::now();
+    if (auto err = promote(id)) {
+      // tier 0 keeps running, a failed promotion only costs performance
+      llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "rusty_c: tier-up of `" + mNames[id] + "` failed: ");
+      continue;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    lock.lock();
+    mEvents.push_back({mNames[id], reason, elapsed});
+  }
+}
+
+auto TieredEngine::stop() -> void
+{
+  {
+    auto lock = std::lock_guard{mMutex};
+    mStopping = true;
+  }
+  mWakeUp.notify_one();
+  if (mWorker.joinable()) {
+    mWorker.join();
+  }
+}
+
+auto TieredEngine::printStats(llvm::raw_ostream& os) -> void
+{
+  auto lock = std::lock_guard{mMutex};
+  for (auto const& event : mEvents) {
+    os << "tier-up: `" << event.mName << "` after "
+       << (event.mReason == TierUpReason::Calls ? mOpts.mCallThreshold : mOpts.mBackedgeThreshold)
+       << (event.mReason == TierUpReason::Calls ? " call(s)" : " loop iteration(s)") << ", compiled in "
+       << event.mCompileTime.count() << "us\n";
+  }
+  os << "tiering: " << mNames.size() << " function(s), " << mEvents.size() << " promoted to tier 1\n";
+}
+
+auto RunInTieredJit(llvm::orc::ThreadSafeModule module, CodegenOptions const& opts, TieringOptions const& tiering,
+                    std::vector<std::string> const& args) -> llvm::Expected<int>
+{
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+
+  auto signature = module.withModuleDo(ReadMainSignature);
+  if (!signature) {
+    return signature.takeError();
+  }
+  auto jtmb = CreateHostBuilder(opts);
+  if (!jtmb) {
+    return jtmb.takeError();
+  }
+  auto jit = llvm::orc::LLJITBuilder{}
+                 .setJITTargetMachineBuilder(*jtmb)
+                 .setCompileFunctionCreator([](llvm::orc::JITTargetMachineBuilder jtmb)
+                                                -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+                   return std::make_unique<TieredCompiler>(std::move(jtmb));
+                 })
+                 .create();
+  if (!jit) {
+    return jit.takeError();
+  }
+  if (auto err = AddHostProcessSymbols(**jit)) {
+    return DetachError(std::move(err));
+  }
+
+  auto engine = TieredEngine(std::move(*jit), std::move(*jtmb), tiering);
+  if (auto err = engine.load(std::move(module))) {
+    return DetachError(std::move(err));
+  }
+  auto mainAddress = engine.lookupMain();
+  if (!mainAddress) {
+    return DetachError(mainAddress.takeError());
+  }
+  auto exitCode = CallMain(*mainAddress, *signature, args);
+  engine.stop();
+  if (tiering.mPrintStats) {
+    engine.printStats(llvm::errs());
+  }
+  return exitCode;
+}
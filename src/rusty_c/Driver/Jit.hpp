@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Backend.hpp"
+
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/Error.h>
+#include <string>
+#include <vector>
+
+// Runs `main` of the module in-process through ORC's LLLazyJIT. Every function sits behind a lazy stub and is only
+// compiled when it is first called, extern "C" symbols resolve against the host process. The triple of `opts` is
+// ignored, the JIT always targets the host. Returns the exit code of `main`, `args` become its argv if it takes any.
+auto RunInJit(llvm::orc::ThreadSafeModule module, CodegenOptions const& opts, std::vector<std::string> const& args)
+    -> llvm::Expected<int>;
+
+struct TieringOptions {
+  u64 mCallThreshold = 1'000;       // 0 disables promotion by calls
+  u64 mBackedgeThreshold = 100'000; // 0 disables promotion by loop iterations
+  bool mPrintStats = false;
+};
+
+// Like RunInJit, but every function is first compiled at -O0 with a call and a back-edge counter and is called through
+// an indirect stub. A function whose counter reaches its threshold is recompiled at -O3 on a background thread and the
+// stub is repointed to the new code, frames that are already running stay in tier 0.
+auto RunInTieredJit(llvm::orc::ThreadSafeModule module, CodegenOptions const& opts, TieringOptions const& tiering,
+                    std::vector<std::string> const& args) -> llvm::Expected<int>;
@@ -0,0 +1,119 @@
+#include "ObjectCache.hpp"
+#include "Frontend/CodeGen/IRGen.hpp"
+#include "Frontend/Sema/SemanticHash.hpp"
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+
+// bump whenever IRGen or the pipeline changes the code generated for the same AST
+static constexpr auto kCacheFormat = "rustyc-object-cache-2";
+
+auto ObjectCache::keyOf(FunctionItem* fn, std::string_view modname, llvm::TargetMachine& tm) const -> std::string
+{
+  auto hasher = llvm::SHA1{};
+  // the crate is part of the key as it qualifies the symbols of the statics the function uses
+  for (auto const& part : {std::string(kCacheFormat), std::string(LLVM_VERSION_STRING), tm.getTargetTriple().str(),
+                           tm.getTargetCPU().str(), tm.getTargetFeatureString().str(),
+                           mOpts.mProfileGenerate ? "profile-generate=" + *mOpts.mProfileGenerate : std::string{},
+                           mProfileHash, StaticSymbolName(modname, "")}) {
+    hasher.update(part);
+    hasher.update(llvm::StringRef("\0", 1));
+  }
+  hasher.update(llvm::ArrayRef<u8>(static_cast<u8>(mOpts.mOptLevel)));
+  hasher.update(SemanticHash(fn));
+  return llvm::toHex(hasher.final(), true);
+}
+
+auto ObjectCache::compileFunction(FunctionItem* fn, std::string_view modname, llvm::TargetMachine& tm)
+    -> llvm::Expected<llvm::SmallString<0>>
+{
+  auto ctx = llvm::LLVMContext{};
+  auto gen = IRGen{ctx, modname};
+  gen.genItem(fn);
+  auto module = gen.takeModule();
+  if (llvm::verifyModule(*module, &llvm::errs())) {
+    utils::Unreachable(utils::SrcLoc::current(), "IRGen produced an invalid module for {}", fn->mName);
+  }
+  OptimizeModule(*module, tm, mOpts.mOptLevel, LTOPhase::None, nullptr, PGOOptionsOf(mOpts));
+
+  auto object = llvm::SmallString<0>{};
+  auto os = llvm::raw_svector_ostream(object);
+  if (auto err = EmitModule(*module, tm, EmitKind::Object, os)) {
+    return std::move(err);
+  }
+  return object;
+}
+
+// written to a temporary first, a concurrent build never sees half an object
+auto ObjectCache::store(llvm::StringRef path, llvm::StringRef object) const -> llvm::Error
+{
+  auto fd = 0;
+  auto tmpPath = llvm::SmallString<128>{};
+  if (auto ec = llvm::sys::fs::createUniqueFile(path + "-%%%%%%.tmp", fd, tmpPath)) {
+    return llvm::errorCodeToError(ec);
+  }
+  {
+    auto os = llvm::raw_fd_ostream(fd, true);
+    os << object;
+    if (os.has_error()) {
+      auto ec = os.error();
+      os.clear_error();
+      llvm::sys::fs::remove(tmpPath);
+      return llvm::errorCodeToError(ec);
+    }
+  }
+  if (auto ec = llvm::sys::fs::rename(tmpPath, path)) {
+    llvm::sys::fs::remove(tmpPath);
+    return llvm::errorCodeToError(ec);
+  }
+  return llvm::Error::success();
+}
+
+auto ObjectCache::compileCrate(Crate* crate, std::string_view modname, llvm::TargetMachine& tm)
+    -> llvm::Expected<std::vector<llvm::SmallString<0>>>
+{
+  if (auto ec = llvm::sys::fs::create_directories(mDir)) {
+    return llvm::createStringError(ec, "cannot create cache directory '%s'", mDir.c_str());
+  }
+  // a new profile may change the code of any function
+  if (!mOpts.mProfileUse.empty()) {
+    auto profile = llvm::MemoryBuffer::getFile(mOpts.mProfileUse);
+    if (!profile) {
+      return llvm::createFileError(mOpts.mProfileUse, profile.getError());
+    }
+    mProfileHash = llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef((*profile)->getBuffer())), true);
+  }
+
+  auto objects = std::vector<llvm::SmallString<0>>{};
+  for (auto& item : crate->mItems) {
+    // extern blocks only declare, their callers bring the declarations along
+    if (item->mKind != Item::Kind::Function || item->as<FunctionItem>()->isDeclaration()) {
+      continue;
+    }
+    auto fn = item->as<FunctionItem>();
+    auto path = llvm::SmallString<128>{mDir};
+    llvm::sys::path::append(path, keyOf(fn, modname, tm) + ".o");
+
+    if (auto cached = llvm::MemoryBuffer::getFile(path)) {
+      ++mStats.mHits;
+      objects.emplace_back((*cached)->getBuffer());
+      continue;
+    }
+    ++mStats.mMisses;
+    auto object = compileFunction(fn, modname, tm);
+    if (!object) {
+      return object.takeError();
+    }
+    if (auto err = store(path, *object)) {
+      return llvm::joinErrors(llvm::createStringError(llvm::inconvertibleErrorCode(), "cannot write '%s'", path.c_str()),
+                              std::move(err));
+    }
+    objects.push_back(std::move(*object));
+  }
+  return objects;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Backend.hpp"
+#include "Frontend/Syntax.hpp"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/Error.h>
+#include <string>
+#include <vector>
+
+struct ObjectCacheStats {
+  u32 mHits = 0;
+  u32 mMisses = 0;
+};
+
+// Content-addressed cache of per-function objects in a local directory. A top-level function is lowered, optimized
+// and compiled on its own and stored under the semantic hash of the function salted with the codegen options, so a
+// rebuild only compiles the functions whose key changed. Functions are optimized one at a time, there is no inlining
+// across top-level functions in this mode. Entries are never evicted.
+class ObjectCache {
+  std::string mDir;
+  CodegenOptions mOpts;
+  std::string mProfileHash; // of the -C profile-use file
+  ObjectCacheStats mStats;
+
+public:
+  ObjectCache(std::string dir, CodegenOptions const& opts) : mDir(std::move(dir)), mOpts(opts) {}
+
+  // one object per top-level function of a checked and simplified crate, in crate order
+  auto compileCrate(Crate* crate, std::string_view modname, llvm::TargetMachine& tm)
+      -> llvm::Expected<std::vector<llvm::SmallString<0>>>;
+
+  auto stats() const -> ObjectCacheStats const& { return mStats; }
+
+private:
+  auto keyOf(FunctionItem* fn, std::string_view modname, llvm::TargetMachine& tm) const -> std::string;
+  auto compileFunction(FunctionItem* fn, std::string_view modname, llvm::TargetMachine& tm)
+      -> llvm::Expected<llvm::SmallString<0>>;
+  auto store(llvm::StringRef path, llvm::StringRef object) const -> llvm::Error;
+};
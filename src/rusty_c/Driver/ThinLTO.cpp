@@ -0,0 +1,183 @@
+#include "ThinLTO.hpp"
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Transforms/IPO/FunctionImport.h>
+#include <llvm/Transforms/Utils/FunctionImportUtils.h>
+
+#include <mutex>
+
+namespace {
+struct ThinInput {
+  std::string mPath; // also the module path in the combined index
+  std::unique_ptr<llvm::MemoryBuffer> mBuffer;
+  llvm::BitcodeModule mModule;
+};
+
+// what the thin link decided, read-only while the backends run
+struct ThinLinkResult {
+  llvm::ModuleSummaryIndex mIndex{false};
+  llvm::StringMap<llvm::GVSummaryMapTy> mDefined;
+  llvm::StringMap<llvm::FunctionImporter::ImportMapTy> mImports;
+  llvm::StringMap<llvm::FunctionImporter::ExportSetTy> mExports;
+};
+} // namespace
+
+static auto ReadThinInput(std::string const& path) -> llvm::Expected<ThinInput>
+{
+  auto buffer = llvm::MemoryBuffer::getFile(path);
+  if (!buffer) {
+    return llvm::createFileError(path, buffer.getError());
+  }
+  auto modules = llvm::getBitcodeModuleList((*buffer)->getMemBufferRef());
+  if (!modules) {
+    return llvm::createFileError(path, modules.takeError());
+  }
+  if (modules->size() != 1) {
+    return llvm::createFileError(path, llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                                               "expected exactly one module in the bitcode file"));
+  }
+  auto module = modules->front();
+  auto info = module.getLTOInfo();
+  if (!info) {
+    return llvm::createFileError(path, info.takeError());
+  }
+  if (!info->IsThinLTO) {
+    return llvm::createFileError(path, llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                                               "no ThinLTO summary, compile it with --emit=thin-bc"));
+  }
+  return ThinInput{path, std::move(*buffer), module};
+}
+
+// The linker's job otherwise: there is no weak linkage in the language, so every definition must be unique and
+// prevails. Anything that is neither a root nor imported by another module is internalized.
+static auto RunThinLink(std::vector<ThinInput>& inputs, std::vector<std::string> const& exported, ThinLinkResult& link)
+    -> llvm::Error
+{
+  for (auto i = std::size_t{0}; i < inputs.size(); ++i) {
+    if (auto err = inputs[i].mModule.readSummary(link.mIndex, inputs[i].mPath, i)) {
+      return llvm::createFileError(inputs[i].mPath, std::move(err));
+    }
+  }
+  for (auto const& [guid, info] : link.mIndex) {
+    auto first = static_cast<llvm::GlobalValueSummary const*>(nullptr);
+    for (auto const& summary : info.SummaryList) {
+      if (llvm::GlobalValue::isLocalLinkage(summary->linkage())) {
+        continue;
+      }
+      if (first != nullptr) {
+        return llvm::createStringError(llvm::inconvertibleErrorCode(), "%s and %s define the same symbol",
+                                       first->modulePath().str().c_str(), summary->modulePath().str().c_str());
+      }
+      first = summary.get();
+    }
+  }
+
+  auto roots = llvm::DenseSet<llvm::GlobalValue::GUID>{};
+  roots.insert(llvm::GlobalValue::getGUID("main"));
+  for (auto const& name : exported) {
+    roots.insert(llvm::GlobalValue::getGUID(name));
+  }
+  llvm::computeDeadSymbolsWithConstProp(
+      link.mIndex, roots, [](llvm::GlobalValue::GUID) { return llvm::PrevailingType::Yes; }, true);
+
+  link.mIndex.collectDefinedGVSummariesPerModule(link.mDefined);
+  llvm::ComputeCrossModuleImport(link.mIndex, link.mDefined, link.mImports, link.mExports);
+
+  // exported locals become external and get promoted by renameModuleForThinLTO, the rest is internalized
+  for (auto& [guid, info] : link.mIndex) {
+    auto vi = link.mIndex.getValueInfo(guid);
+    for (auto& summary : info.SummaryList) {
+      auto isExported = roots.contains(guid) || link.mExports[summary->modulePath()].contains(vi);
+      if (isExported) {
+        if (llvm::GlobalValue::isLocalLinkage(summary->linkage())) {
+          summary->setLinkage(llvm::GlobalValue::ExternalLinkage);
+        }
+      } else if (!llvm::GlobalValue::isLocalLinkage(summary->linkage())) {
+        summary->setLinkage(llvm::GlobalValue::InternalLinkage);
+      }
+    }
+  }
+  return llvm::Error::success();
+}
+
+static auto RunThinBackend(std::vector<ThinInput>& inputs, ThinInput& input, ThinLinkResult const& link,
+                           CodegenOptions const& opts) -> llvm::Expected<llvm::SmallString<0>>
+{
+  auto ctx = llvm::LLVMContext{};
+  auto module = input.mModule.parseModule(ctx);
+  if (!module) {
+    return module.takeError();
+  }
+  auto tm = CreateTargetMachine(opts);
+  if (!tm) {
+    return tm.takeError();
+  }
+
+  renameModuleForThinLTO(**module, link.mIndex, false);
+  auto const& defined = link.mDefined.lookup(input.mPath);
+  llvm::thinLTOFinalizeInModule(**module, defined, true);
+  llvm::thinLTOInternalizeModule(**module, defined);
+
+  auto loader = [&inputs, &ctx](llvm::StringRef path) -> llvm::Expected<std::unique_ptr<llvm::Module>> {
+    auto source = llvm::find_if(inputs, [path](ThinInput const& input) { return input.mPath == path; });
+    return source->mModule.getLazyModule(ctx, true, true);
+  };
+  auto importer = llvm::FunctionImporter(link.mIndex, loader, false);
+  if (auto imported = importer.importFunctions(**module, link.mImports.lookup(input.mPath)); !imported) {
+    return imported.takeError();
+  }
+
+  OptimizeModule(**module, **tm, opts.mOptLevel, LTOPhase::ThinPostLink, &link.mIndex, PGOOptionsOf(opts));
+  auto object = llvm::SmallString<0>{};
+  auto os = llvm::raw_svector_ostream(object);
+  if (auto err = EmitModule(**module, **tm, EmitKind::Object, os)) {
+    return std::move(err);
+  }
+  return object;
+}
+
+auto ThinLTOLink(std::vector<std::string> const& inputs, CodegenOptions const& opts, unsigned jobs,
+                 std::vector<std::string> const& exported) -> llvm::Expected<std::vector<llvm::SmallString<0>>>
+{
+  auto thinInputs = std::vector<ThinInput>{};
+  for (auto const& path : inputs) {
+    auto input = ReadThinInput(path);
+    if (!input) {
+      return input.takeError();
+    }
+    thinInputs.push_back(std::move(*input));
+  }
+
+  auto link = ThinLinkResult{};
+  if (auto err = RunThinLink(thinInputs, exported, link)) {
+    return std::move(err);
+  }
+
+  // each backend has its own context and target machine, they only share the read-only link result
+  auto objects = std::vector<llvm::SmallString<0>>(thinInputs.size());
+  auto errors = llvm::Error(llvm::Error::success());
+  auto errorsMutex = std::mutex{};
+  {
+    auto pool = llvm::ThreadPool(llvm::heavyweight_hardware_concurrency(jobs));
+    for (auto i = std::size_t{0}; i < thinInputs.size(); ++i) {
+      pool.async([&, i] {
+        auto object = RunThinBackend(thinInputs, thinInputs[i], link, opts);
+        if (!object) {
+          auto lock = std::lock_guard{errorsMutex};
+          errors = llvm::joinErrors(std::move(errors), llvm::createFileError(thinInputs[i].mPath, object.takeError()));
+          return;
+        }
+        objects[i] = std::move(*object);
+      });
+    }
+    pool.wait();
+  }
+  if (errors) {
+    return std::move(errors);
+  }
+  return objects;
+}
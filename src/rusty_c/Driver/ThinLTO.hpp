@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Backend.hpp"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/Error.h>
+#include <string>
+#include <vector>
+
+// Links bitcode files written with --emit=thin-bc: the combined summary decides what gets imported across modules,
+// then the ThinLTO backends optimize and compile every module in-process on `jobs` threads. Definitions other than
+// `main` and the `exported` ones are internalized. Returns one object per module.
+auto ThinLTOLink(std::vector<std::string> const& inputs, CodegenOptions const& opts, unsigned jobs,
+                 std::vector<std::string> const& exported) -> llvm::Expected<std::vector<llvm::SmallString<0>>>;
@@ -0,0 +1,259 @@
+#include "CopyElision.hpp"
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+// the local an expression names, consts and statics are not locals
+static auto AsIdentifier(Expr const* expr) -> std::optional<std::string>
+{
+  while (expr != nullptr && expr->mType == Expr::Type::WithoutBlock &&
+         expr->as<ExprWithoutBlock>()->mType == ExprWithoutBlock::Type::Grouped) {
+    expr = expr->as<ExprWithoutBlock>()->as<GroupedExpr>()->mExpr.get();
+  }
+  if (expr == nullptr || expr->mType != Expr::Type::WithoutBlock) {
+    return std::nullopt;
+  }
+  auto e = expr->as<ExprWithoutBlock>();
+  if (e->mType != ExprWithoutBlock::Type::Literal || e->as<LiteralExpr>()->mKind != LiteralExpr::Kind::Identifier ||
+      e->as<LiteralExpr>()->mItem != nullptr) {
+    return std::nullopt;
+  }
+  return std::get<std::string>(e->as<LiteralExpr>()->mValue);
+}
+
+// the local `&x`, `&x.field` or `&x[i]` borrows from
+static auto BorrowedLocal(Expr const* expr) -> std::optional<std::string>
+{
+  while (expr->mType == Expr::Type::WithoutBlock) {
+    auto e = expr->as<ExprWithoutBlock>();
+    if (e->mType == ExprWithoutBlock::Type::Grouped) {
+      expr = e->as<GroupedExpr>()->mExpr.get();
+    } else if (e->mType == ExprWithoutBlock::Type::Field) {
+      expr = e->as<FieldExpr>()->mBase.get();
+    } else if (e->mType == ExprWithoutBlock::Type::Index) {
+      expr = e->as<IndexExpr>()->mBase.get();
+    } else {
+      break;
+    }
+  }
+  return AsIdentifier(expr);
+}
+
+auto CopyElisionAnalysis::analyze(FunctionItem const* fn) -> void
+{
+  mLastUses.clear();
+  mBorrowed.clear();
+  mReturned.clear();
+  mNamedReturn = nullptr;
+  if (fn->isDeclaration()) {
+    return;
+  }
+  auto live = Live{};
+  visitBlockExpr(fn->mBody.get(), live);
+  // a pointer to a borrowed local may still be used after what looks like its last use
+  std::erase_if(mLastUses, [&](auto const& use) { return mBorrowed.contains(use.second); });
+  mNamedReturn = findNamedReturn(fn->mBody.get());
+}
+
+// an earlier `return` of the same name may still refer to another local, that one is simply copied
+auto CopyElisionAnalysis::findNamedReturn(BlockExpr const* body) -> LetStmt const*
+{
+  auto name = AsIdentifier(body->mReturn.get());
+  if (!name || std::any_of(mReturned.begin(), mReturned.end(), [&](auto expr) { return AsIdentifier(expr) != name; })) {
+    return nullptr;
+  }
+  for (auto it = body->mStmts.rbegin(); it != body->mStmts.rend(); ++it) {
+    if (auto stmt = it->get(); stmt != nullptr && stmt->mType == Stmt::Type::Let) {
+      if (auto let = stmt->as<LetStmt>(); !let->mPattern && let->mName == *name) {
+        return let;
+      }
+    }
+  }
+  return nullptr;
+}
+
+// `live` holds the names live after the expression on entry and those live before it on return, so everything is
+// visited in reverse evaluation order
+
+auto CopyElisionAnalysis::visitBlockExpr(BlockExpr const* expr, Live& live) -> void
+{
+  auto const outer = live;
+  visitExpr(expr->mReturn.get(), live);
+  for (auto it = expr->mStmts.rbegin(); it != expr->mStmts.rend(); ++it) {
+    auto stmt = it->get();
+    if (stmt == nullptr) {
+      continue;
+    }
+    if (stmt->mType == Stmt::Type::Expression) {
+      visitExpr(stmt->as<ExprStmt>()->mExpr.get(), live);
+      continue;
+    }
+    auto let = stmt->as<LetStmt>();
+    for (auto const& name : let->boundNames()) {
+      if (!outer.contains(name)) {
+        live.erase(name);
+      }
+    }
+    visitExpr(let->mExpr.get(), live);
+  }
+}
+
+// the body of an infinite loop is followed by itself, that of a `while` by the condition and that of a `for` by
+// itself or what follows the loop. The range of a `for` is evaluated once before the loop
+auto CopyElisionAnalysis::visitLoop(LoopExpr const* expr, Live& live) -> void
+{
+  auto const after = live;
+  auto walk = [&](Live head) {
+    switch (expr->mType) {
+    case LoopExpr::Type::InfiniteLoop:
+      visitBlockExpr(expr->as<InfiniteLoopExpr>()->mExpr.get(), head);
+      return head;
+    case LoopExpr::Type::PredicateLoop: {
+      auto loop = expr->as<PredicateLoopExpr>();
+      visitBlockExpr(loop->mExpr.get(), head);
+      head.insert(after.begin(), after.end());
+      visitExpr(loop->mCond.get(), head);
+      return head;
+    }
+    case LoopExpr::Type::IteratorLoop: {
+      auto loop = expr->as<IteratorLoopExpr>();
+      visitBlockExpr(loop->mExpr.get(), head);
+      if (!after.contains(loop->mName)) {
+        head.erase(loop->mName);
+      }
+      head.insert(after.begin(), after.end());
+      return head;
+    }
+    }
+    utils::Unreachable(utils::SrcLoc::current());
+  };
+  auto record = std::exchange(mRecord, false);
+  auto head = walk(after);
+  mRecord = record;
+  head.insert(after.begin(), after.end());
+  live = walk(head);
+  if (expr->mType == LoopExpr::Type::IteratorLoop) {
+    auto loop = expr->as<IteratorLoopExpr>();
+    visitExpr(loop->mStep.get(), live);
+    visitExpr(loop->mEnd.get(), live);
+    visitExpr(loop->mStart.get(), live);
+  }
+}
+
+auto CopyElisionAnalysis::visitExpr(Expr const* expr, Live& live) -> void
+{
+  if (expr == nullptr) {
+    return;
+  }
+
+  if (expr->mType == Expr::Type::WithBlock) {
+    auto e = expr->as<ExprWithBlock>();
+    switch (e->mType) {
+    case ExprWithBlock::Type::Block:
+      return visitBlockExpr(e->as<BlockExpr>(), live);
+    case ExprWithBlock::Type::If: {
+      auto ifExpr = e->as<IfExpr>();
+      auto elseLive = live;
+      visitExpr(ifExpr->mElse.get(), elseLive);
+      visitBlockExpr(ifExpr->mThen.get(), live);
+      live.insert(elseLive.begin(), elseLive.end());
+      return visitExpr(ifExpr->mCond.get(), live);
+    }
+    case ExprWithBlock::Type::Loop:
+      return visitLoop(e->as<LoopExpr>(), live);
+    case ExprWithBlock::Type::IfLet:
+    case ExprWithBlock::Type::Match:
+      utils::Unimplemented(utils::SrcLoc::current());
+    }
+    utils::Unreachable(utils::SrcLoc::current());
+  }
+
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    if (auto literal = e->as<LiteralExpr>();
+        literal->mKind == LiteralExpr::Kind::Identifier && literal->mItem == nullptr) {
+      auto const& name = std::get<std::string>(literal->mValue);
+      if (live.insert(name).second && mRecord) {
+        mLastUses.emplace(literal, name);
+      }
+    }
+    return;
+  case ExprWithoutBlock::Type::Grouped:
+    return visitExpr(e->as<GroupedExpr>()->mExpr.get(), live);
+  case ExprWithoutBlock::Type::Operator: {
+    auto op = e->as<OperatorExpr>();
+    if (auto unary = op->mType == OperatorExpr::Type::Unary ? op->as<UnaryExpr>() : nullptr) {
+      if (auto name = BorrowedLocal(unary->mRight.get());
+          name && (unary->mKind == UnaryExpr::Kind::Ref || unary->mKind == UnaryExpr::Kind::RefMut)) {
+        mBorrowed.insert(*name);
+      }
+      return visitExpr(unary->mRight.get(), live);
+    }
+    auto bin = op->as<BinaryExpr>();
+    if (bin->mKind != BinaryExpr::Kind::Assignment) {
+      visitExpr(bin->mRight.get(), live);
+      return visitExpr(bin->mLeft.get(), live);
+    }
+    // the right side is evaluated first, storing to a whole local ends the liveness of its old value
+    auto lhs = bin->mLeft.get();
+    while (lhs->mType == Expr::Type::WithoutBlock &&
+           lhs->as<ExprWithoutBlock>()->mType == ExprWithoutBlock::Type::Grouped) {
+      lhs = lhs->as<ExprWithoutBlock>()->as<GroupedExpr>()->mExpr.get();
+    }
+    if (lhs->mType == Expr::Type::WithoutBlock && lhs->as<ExprWithoutBlock>()->mType == ExprWithoutBlock::Type::Literal) {
+      live.erase(std::get<std::string>(lhs->as<ExprWithoutBlock>()->as<LiteralExpr>()->mValue));
+    } else {
+      visitExpr(lhs, live);
+    }
+    return visitExpr(bin->mRight.get(), live);
+  }
+  case ExprWithoutBlock::Type::Call: {
+    auto& args = e->as<CallExpr>()->mArgs;
+    for (auto it = args.rbegin(); it != args.rend(); ++it) {
+      visitExpr(it->get(), live);
+    }
+    return;
+  }
+  case ExprWithoutBlock::Type::Return:
+    mReturned.push_back(e->as<ReturnExpr>()->mExpr.get());
+    live.clear();
+    return visitExpr(e->as<ReturnExpr>()->mExpr.get(), live);
+  case ExprWithoutBlock::Type::Index:
+    visitExpr(e->as<IndexExpr>()->mIndex.get(), live);
+    return visitExpr(e->as<IndexExpr>()->mBase.get(), live);
+  case ExprWithoutBlock::Type::MethodCall: {
+    auto call = e->as<MethodCallExpr>();
+    for (auto it = call->mArgs.rbegin(); it != call->mArgs.rend(); ++it) {
+      visitExpr(it->get(), live);
+    }
+    return visitExpr(call->mReceiver.get(), live);
+  }
+  case ExprWithoutBlock::Type::Array: {
+    auto& elems = e->as<ArrayExpr>()->mElems;
+    for (auto it = elems.rbegin(); it != elems.rend(); ++it) {
+      visitExpr(it->get(), live);
+    }
+    return;
+  }
+  case ExprWithoutBlock::Type::Struct: {
+    auto& fields = e->as<StructExpr>()->mFields;
+    for (auto it = fields.rbegin(); it != fields.rend(); ++it) {
+      visitExpr(it->mValue.get(), live);
+    }
+    return;
+  }
+  case ExprWithoutBlock::Type::Field:
+    return visitExpr(e->as<FieldExpr>()->mBase.get(), live);
+  case ExprWithoutBlock::Type::Tuple: {
+    auto& elems = e->as<TupleExpr>()->mElems;
+    for (auto it = elems.rbegin(); it != elems.rend(); ++it) {
+      visitExpr(it->get(), live);
+    }
+    return;
+  }
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Frontend/Syntax.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// What IRGen needs to avoid copying aggregates within one function, the AST is only read.
+//
+// The last uses of locals, after which the local is dead on every path, so an aggregate may be handed over to a
+// callee instead of copied. A backward liveness walk, loops are walked twice to reach the fixpoint. Locals are tracked
+// by name, a `let` in a block does not end the liveness of a name that is still live after the block, which only errs
+// on the side of copying. A local that is borrowed anywhere is never handed over.
+//
+// The named return value: a local bound by a `let` directly in the body that is the tail of the body and the operand
+// of every `return`. It can be built right where the caller wants the result.
+class CopyElisionAnalysis {
+  using Live = std::unordered_set<std::string>;
+
+  std::unordered_map<LiteralExpr const*, std::string> mLastUses;
+  std::unordered_set<std::string> mBorrowed;
+  std::vector<Expr const*> mReturned;
+  LetStmt const* mNamedReturn = nullptr;
+  bool mRecord = true; // off for the first walk over a loop, whose live-out is not known yet
+
+public:
+  CopyElisionAnalysis() = default;
+
+  auto analyze(FunctionItem const* fn) -> void;
+  auto isLastUse(LiteralExpr const* identifier) const -> bool { return mLastUses.contains(identifier); }
+  auto namedReturn() const -> LetStmt const* { return mNamedReturn; }
+
+private:
+  auto findNamedReturn(BlockExpr const* body) -> LetStmt const*;
+  auto visitBlockExpr(BlockExpr const* expr, Live& live) -> void;
+  auto visitLoop(LoopExpr const* expr, Live& live) -> void;
+  auto visitExpr(Expr const* expr, Live& live) -> void;
+};
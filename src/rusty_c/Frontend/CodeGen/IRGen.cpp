@@ -1,13 +1,587 @@
 #include "IRGen.hpp"
+#include "../Sema/Layout.hpp"
+
+#include <llvm/IR/DIBuilder.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/Support/Path.h>
 
 static auto GenLLVMType(TypeBase const* ty, llvm::LLVMContext& ctx) -> llvm::Type*;
 
+// the lane type of a vector, any other type as is
+static auto ScalarOf(TypeBase const* ty) -> TypeBase const*
+{
+  return ty->mKind == TypeBase::Kind::Vector ? ty->as<VectorType>()->mElem.get() : ty;
+}
+static auto IsSigned(TypeBase const* ty) -> bool
+{
+  ty = ScalarOf(ty);
+  return ty->mKind == TypeBase::Kind::I8 || ty->mKind == TypeBase::Kind::I16 || ty->mKind == TypeBase::Kind::I32 ||
+         ty->mKind == TypeBase::Kind::I64;
+}
+static auto IsFloat(TypeBase const* ty) -> bool
+{
+  ty = ScalarOf(ty);
+  return ty->mKind == TypeBase::Kind::F32 || ty->mKind == TypeBase::Kind::F64;
+}
+static auto IsNever(Expr const* expr) -> bool
+{
+  return expr->getType() != nullptr && expr->getType()->mKind == TypeBase::Kind::Never;
+}
+// the `*p` an expression is, if it is one
+static auto AsDeref(ExprWithoutBlock* expr) -> UnaryExpr*
+{
+  if (expr->mType != ExprWithoutBlock::Type::Operator) {
+    return nullptr;
+  }
+  auto op = expr->as<OperatorExpr>();
+  if (op->mType != OperatorExpr::Type::Unary || op->as<UnaryExpr>()->mKind != UnaryExpr::Kind::Deref) {
+    return nullptr;
+  }
+  return op->as<UnaryExpr>();
+}
+static auto IsArray(TypeBase const* ty) -> bool { return ty != nullptr && ty->mKind == TypeBase::Kind::Array; }
+// array and struct values live in memory, an expression of such a type yields the address of the value
+static auto IsAggregate(TypeBase const* ty) -> bool
+{
+  return IsArray(ty) || (ty != nullptr && ty->mKind == TypeBase::Kind::Struct);
+}
+// lowered structs are packed, the alignment of a value in memory always comes from Sema's layout
+static auto AlignOf(TypeBase const* ty) -> llvm::Align { return llvm::Align(LayoutOf(ty).mAlign); }
+static auto PlaceAlign(Expr const* expr) -> llvm::Align;
+// scalars keep the alignment LLVM gives their slot, aggregates and tuples get the one of their layout
+static auto SlotAlign(TypeBase const* ty) -> llvm::MaybeAlign
+{
+  return IsAggregate(ty) || ty->mKind == TypeBase::Kind::Tuple ? llvm::MaybeAlign(AlignOf(ty)) : llvm::MaybeAlign();
+}
+// elements of a slice are naturally aligned, those of an array no more than the array itself
+static auto ElementAlign(Expr const* base) -> llvm::Align
+{
+  auto type = base->getType();
+  if (type->mKind == TypeBase::Kind::Slice) {
+    return AlignOf(type->as<SliceType>()->mElem.get());
+  }
+  return std::min(AlignOf(type->as<ArrayType>()->mElem.get()), PlaceAlign(base));
+}
+static auto IsZeroSized(TypeBase const* ty) -> bool { return LayoutOf(ty).mSize == 0; }
+static auto IsUnit(TypeBase const* ty) -> bool
+{
+  return ty->mKind == TypeBase::Kind::Tuple && ty->as<TupleType>()->isUnit();
+}
+// alignment known for the address of a place, a field of a packed struct or one of a tuple holding a struct may sit
+// below that of its type
+static auto PlaceAlign(Expr const* expr) -> llvm::Align
+{
+  auto align = AlignOf(expr->getType());
+  if (expr->mType != Expr::Type::WithoutBlock) {
+    return align;
+  }
+  auto exprWithoutBlock = expr->as<ExprWithoutBlock>();
+  switch (exprWithoutBlock->mType) {
+  case ExprWithoutBlock::Type::Grouped:
+    return PlaceAlign(exprWithoutBlock->as<GroupedExpr>()->mExpr.get());
+  case ExprWithoutBlock::Type::Field: {
+    auto fieldExpr = exprWithoutBlock->as<FieldExpr>();
+    auto base = fieldExpr->mBase.get();
+    if (auto type = base->getType(); type->mKind == TypeBase::Kind::Tuple) {
+      auto offset = TupleElementOffset(type->as<TupleType>(), fieldExpr->mIndex);
+      return std::min(align, llvm::commonAlignment(PlaceAlign(base), offset));
+    }
+    return base->getType()->as<StructType>()->mItem->mPacked ? llvm::Align(1) : std::min(align, PlaceAlign(base));
+  }
+  case ExprWithoutBlock::Type::Index:
+    return ElementAlign(exprWithoutBlock->as<IndexExpr>()->mBase.get());
+  default:
+    return align;
+  }
+}
+// the element of the lowered struct holding a field, fields follow the memory order with an `[N x i8]` in each hole
+static auto StructElementIndex(StructItem const* item, u32 field) -> u32
+{
+  auto const& layout = item->mLayout;
+  auto index = u32{0};
+  auto offset = u64{0};
+  for (auto i : layout.mMemoryOrder) {
+    if (layout.mOffsets[i] > offset) {
+      ++index;
+    }
+    if (i == field) {
+      return index;
+    }
+    ++index;
+    offset = layout.mOffsets[i] + LayoutOf(item->mFields[i].mType.get()).mSize;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+// larger aggregates are passed and returned through a pointer, as x86-64 does with anything that needs more than two
+// registers. A smaller one is a first class aggregate, which the backend splits into registers
+static constexpr auto kIndirectAggregateBytes = 16;
+static auto IsIndirect(TypeBase const* ty) -> bool
+{
+  return IsAggregate(ty) && LayoutOf(ty).mSize > kIndirectAggregateBytes;
+}
+static auto HasReturnSlot(FunctionType const* fnTy) -> bool { return IsIndirect(fnTy->mRet.get()); }
+
+// the parameters that are passed to the lowered function, unit typed ones are left out
+static auto LoweredParams(FunctionItem const* functionItem) -> std::vector<u32>
+{
+  auto indices = std::vector<u32>{};
+  for (u32 i = 0; i < functionItem->mFnType->mParams.size(); ++i) {
+    if (!IsUnit(functionItem->mFnType->mParams[i].get())) {
+      indices.push_back(i);
+    }
+  }
+  return indices;
+}
+// a tuple is lowered to a plain LLVM struct of its sized elements. Only where LLVM would place one below Sema's offset,
+// as lowered structs are packed, an `[N x i8]` goes before it. The last entry is the tail padding
+static auto TuplePadding(TupleType const* tuple) -> std::vector<u64>
+{
+  auto padding = std::vector<u64>{};
+  auto offset = u64{0};
+  for (u32 i = 0; i < tuple->mTypes.size(); ++i) {
+    auto type = tuple->mTypes[i].get();
+    auto target = TupleElementOffset(tuple, i);
+    auto natural = IsZeroSized(type) ? offset : llvm::alignTo(offset, LoweredAlign(type));
+    padding.push_back(natural == target ? 0 : target - offset);
+    offset = IsZeroSized(type) ? offset : target + LayoutOf(type).mSize;
+  }
+  auto size = LayoutOf(tuple).mSize;
+  padding.push_back(llvm::alignTo(offset, LoweredAlign(tuple)) == size ? 0 : size - offset);
+  return padding;
+}
+// the element of the lowered tuple holding an element
+static auto TupleElementIndex(TupleType const* tuple, u32 elem) -> u32
+{
+  auto padding = TuplePadding(tuple);
+  auto index = u32{0};
+  for (u32 i = 0; i < elem; ++i) {
+    index += (padding[i] != 0) + !IsZeroSized(tuple->mTypes[i].get());
+  }
+  return index + (padding[elem] != 0);
+}
+
+// up to this size an array is initialized element by element, which SROA splits into scalars
+static constexpr auto kInlineArrayInitBytes = 64;
+
+// operators a branchless `&&`, `||` or if-expression may evaluate that the branchy one would have skipped
+static constexpr auto kSpeculationBudget = 4;
+// safe and cheap to evaluate whether or not the value is needed. Locals, fields of them, consts and statics can always
+// be read. Calls, element accesses, dereferences and divisions may trap or have effects and are left to a branch
+static auto IsSpeculatable(Expr const* expr, i32& budget) -> bool
+{
+  if (expr->mType != Expr::Type::WithoutBlock) {
+    return false;
+  }
+  switch (auto e = expr->as<ExprWithoutBlock>(); e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    return e->as<LiteralExpr>()->mKind != LiteralExpr::Kind::String;
+  case ExprWithoutBlock::Type::Grouped:
+    return IsSpeculatable(e->as<GroupedExpr>()->mExpr.get(), budget);
+  case ExprWithoutBlock::Type::Field:
+    return IsSpeculatable(e->as<FieldExpr>()->mBase.get(), budget);
+  case ExprWithoutBlock::Type::Operator:
+    if (auto op = e->as<OperatorExpr>(); op->mType == OperatorExpr::Type::Unary) {
+      auto unary = op->as<UnaryExpr>();
+      return (unary->mKind == UnaryExpr::Kind::Neg || unary->mKind == UnaryExpr::Kind::Not) && --budget >= 0 &&
+             IsSpeculatable(unary->mRight.get(), budget);
+    } else {
+      auto binary = op->as<BinaryExpr>();
+      return binary->mKind != BinaryExpr::Kind::Assignment && binary->mKind != BinaryExpr::Kind::Div &&
+             binary->mKind != BinaryExpr::Kind::Rem && --budget >= 0 &&
+             IsSpeculatable(binary->mLeft.get(), budget) && IsSpeculatable(binary->mRight.get(), budget);
+    }
+  default:
+    return false;
+  }
+}
+// `if c { a } else { b }` whose arms are single speculatable values, an `else if` chain is lowered to nested selects
+// so its conditions have to be speculatable as well
+static auto IsSelectable(IfExpr const* ifExpr, i32& budget) -> bool
+{
+  auto isSelectableArm = [&](BlockExpr const* block) {
+    return block->mItems.empty() && block->mStmts.empty() && block->mReturn != nullptr &&
+           IsSpeculatable(block->mReturn.get(), budget);
+  };
+  auto type = ifExpr->getType();
+  if (ifExpr->mElse == nullptr || IsAggregate(type) || IsUnit(type) || type->mKind == TypeBase::Kind::Never ||
+      !isSelectableArm(ifExpr->mThen.get())) {
+    return false;
+  }
+  if (auto elseExpr = ifExpr->mElse.get(); elseExpr->mType == ExprWithBlock::Type::Block) {
+    return isSelectableArm(elseExpr->as<BlockExpr>());
+  } else if (elseExpr->mType == ExprWithBlock::Type::If) {
+    auto elseIf = elseExpr->as<IfExpr>();
+    return IsSpeculatable(elseIf->mCond.get(), budget) && IsSelectable(elseIf, budget);
+  }
+  return false;
+}
+
+static auto AddFunctionAttributes(llvm::Function* fn, FunctionItem const* functionItem) -> void
+{
+  switch (functionItem->mInline) {
+  case FunctionItem::InlineHint::None:
+    break;
+  case FunctionItem::InlineHint::Inline:
+    fn->addFnAttr(llvm::Attribute::InlineHint);
+    break;
+  case FunctionItem::InlineHint::Always:
+    fn->addFnAttr(llvm::Attribute::AlwaysInline);
+    break;
+  case FunctionItem::InlineHint::Never:
+    fn->addFnAttr(llvm::Attribute::NoInline);
+    break;
+  }
+  switch (functionItem->mTemperature) {
+  case FunctionItem::Temperature::None:
+    break;
+  case FunctionItem::Temperature::Hot:
+    fn->addFnAttr(llvm::Attribute::Hot);
+    break;
+  case FunctionItem::Temperature::Cold:
+    fn->addFnAttr(llvm::Attribute::Cold);
+    break;
+  }
+}
+
+// The x86-64 System V classification of a value crossing an extern "C" call. An aggregate of at most 16 bytes whose
+// scalars are all aligned goes in one register per eightbyte: an SSE one if it holds only floats, a general purpose one
+// otherwise. It is in memory if it is larger, has an unaligned scalar, or if its registers are not all available any
+// more; the whole aggregate then goes on the stack. SIMD vectors inside aggregates are rejected by Sema
+namespace {
+struct CPassing {
+  enum class Kind { Direct, Coerced, Memory };
+  Kind mKind = Kind::Direct;
+  llvm::Type* mCoerced = nullptr; // one scalar per eightbyte, a struct of them if there are two
+  u32 mIntRegs = 0;
+  u32 mSseRegs = 0;
+};
+struct CSignature {
+  CPassing mRet;
+  std::vector<CPassing> mParams; // one per lowered parameter
+};
+} // namespace
+
+static constexpr auto kCIntArgRegs = 6u;
+static constexpr auto kCSseArgRegs = 8u;
+
+// the scalars of a value and their offsets, false if it holds something the classification does not cover
+static auto CollectCScalars(TypeBase const* type, u64 offset, std::vector<std::pair<u64, TypeBase const*>>& scalars)
+    -> bool
+{
+  switch (type->mKind) {
+  case TypeBase::Kind::Struct: {
+    auto item = type->as<StructType>()->mItem;
+    for (u32 i = 0; i < item->mFields.size(); ++i) {
+      if (!CollectCScalars(item->mFields[i].mType.get(), offset + item->mLayout.mOffsets[i], scalars)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  case TypeBase::Kind::Tuple: {
+    auto tuple = type->as<TupleType>();
+    for (u32 i = 0; i < tuple->mTypes.size(); ++i) {
+      if (!CollectCScalars(tuple->mTypes[i].get(), offset + TupleElementOffset(tuple, i), scalars)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  case TypeBase::Kind::Array: {
+    auto array = type->as<ArrayType>();
+    auto stride = LayoutOf(array->mElem.get()).mSize;
+    for (u64 i = 0; i < array->mLen; ++i) {
+      if (!CollectCScalars(array->mElem.get(), offset + i * stride, scalars)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  case TypeBase::Kind::Slice: {
+    static auto const len = U64{};
+    scalars.emplace_back(offset, &len); // the data pointer classifies the same as the length
+    scalars.emplace_back(offset + 8, &len);
+    return true;
+  }
+  case TypeBase::Kind::Vector:
+    return false;
+  default:
+    if (!IsZeroSized(type)) {
+      scalars.emplace_back(offset, type);
+    }
+    return true;
+  }
+}
+
+static auto ClassifyCAggregate(TypeBase const* type, llvm::LLVMContext& ctx) -> CPassing
+{
+  auto size = LayoutOf(type).mSize;
+  auto scalars = std::vector<std::pair<u64, TypeBase const*>>{};
+  if (size > kIndirectAggregateBytes || !CollectCScalars(type, 0, scalars)) {
+    return {CPassing::Kind::Memory};
+  }
+  enum class Class { None, Integer, Sse };
+  Class classes[2] = {Class::None, Class::None};
+  bool doubles[2] = {false, false};
+  for (auto [offset, scalar] : scalars) {
+    if (offset % LayoutOf(scalar).mAlign != 0) {
+      return {CPassing::Kind::Memory};
+    }
+    auto& cls = classes[offset / 8];
+    cls = IsFloat(scalar) && cls != Class::Integer ? Class::Sse : Class::Integer;
+    doubles[offset / 8] |= LayoutOf(scalar).mSize == 8;
+  }
+  auto result = CPassing{CPassing::Kind::Coerced};
+  auto parts = llvm::SmallVector<llvm::Type*, 2>{};
+  for (u64 i = 0; i * 8 < size; ++i) {
+    auto bytes = std::min<u64>(8, size - i * 8);
+    if (classes[i] == Class::Sse) {
+      auto f32 = llvm::Type::getFloatTy(ctx);
+      parts.push_back(doubles[i] ? llvm::Type::getDoubleTy(ctx)
+                      : bytes <= 4 ? f32
+                                   : static_cast<llvm::Type*>(llvm::FixedVectorType::get(f32, 2)));
+      ++result.mSseRegs;
+    } else {
+      parts.push_back(llvm::IntegerType::get(ctx, bytes * 8)); // padding only travels in a general purpose register
+      ++result.mIntRegs;
+    }
+  }
+  result.mCoerced = parts.size() == 1 ? parts.front() : llvm::StructType::get(ctx, parts);
+  return result;
+}
+
+// tuples and slices are first-class values elsewhere, but C sees them as structs like any other aggregate
+static auto IsCAggregate(TypeBase const* type) -> bool
+{
+  return IsAggregate(type) || type->mKind == TypeBase::Kind::Slice ||
+         (type->mKind == TypeBase::Kind::Tuple && !type->as<TupleType>()->isUnit());
+}
+
+static auto ClassifyCSignature(FunctionItem const* functionItem, llvm::LLVMContext& ctx) -> CSignature
+{
+  auto sig = CSignature{};
+  auto fnType = functionItem->mFnType.get();
+  auto intRegs = 0u;
+  auto sseRegs = 0u;
+  if (auto retType = fnType->mRet.get(); IsCAggregate(retType)) {
+    sig.mRet = ClassifyCAggregate(retType, ctx);
+    intRegs += sig.mRet.mKind == CPassing::Kind::Memory; // the address of the result
+  }
+  for (auto index : LoweredParams(functionItem)) {
+    auto type = fnType->mParams[index].get();
+    if (!IsCAggregate(type)) {
+      ++(IsFloat(type) || type->mKind == TypeBase::Kind::Vector ? sseRegs : intRegs);
+      sig.mParams.emplace_back();
+      continue;
+    }
+    auto passing = ClassifyCAggregate(type, ctx);
+    if (passing.mKind == CPassing::Kind::Coerced &&
+        (intRegs + passing.mIntRegs > kCIntArgRegs || sseRegs + passing.mSseRegs > kCSseArgRegs)) {
+      passing = {CPassing::Kind::Memory};
+    }
+    intRegs += passing.mIntRegs;
+    sseRegs += passing.mSseRegs;
+    sig.mParams.push_back(passing);
+  }
+  return sig;
+}
+
+static auto GenCFunctionType(FunctionItem const* functionItem, CSignature const& sig, llvm::LLVMContext& ctx)
+    -> llvm::FunctionType*
+{
+  auto fnType = functionItem->mFnType.get();
+  auto retTy = static_cast<llvm::Type*>(nullptr);
+  auto paramTys = std::vector<llvm::Type*>{};
+  switch (sig.mRet.mKind) {
+  case CPassing::Kind::Direct:
+    retTy = GenLLVMType(fnType->mRet.get(), ctx);
+    break;
+  case CPassing::Kind::Coerced:
+    retTy = sig.mRet.mCoerced;
+    break;
+  case CPassing::Kind::Memory:
+    retTy = llvm::Type::getVoidTy(ctx);
+    paramTys.push_back(llvm::PointerType::getUnqual(GenLLVMType(fnType->mRet.get(), ctx)));
+    break;
+  }
+  for (auto [passing, index] : llvm::zip(sig.mParams, LoweredParams(functionItem))) {
+    auto lowered = GenLLVMType(fnType->mParams[index].get(), ctx);
+    switch (passing.mKind) {
+    case CPassing::Kind::Direct:
+      paramTys.push_back(lowered);
+      break;
+    case CPassing::Kind::Coerced:
+      paramTys.push_back(passing.mCoerced);
+      break;
+    case CPassing::Kind::Memory:
+      paramTys.push_back(llvm::PointerType::getUnqual(lowered));
+      break;
+    }
+  }
+  return llvm::FunctionType::get(retTy, paramTys, false);
+}
+
+// The return slot is `sret`. An indirect parameter of a function defined in the crate points to a copy the callee owns,
+// so it is `noalias`, while one of an extern function is `byval` as the C ABI puts it on the stack.
+//
+// A reference is never null and points to a live value of its type, and nothing writes through a `&T` so it is
+// `readonly` too. References are not `noalias`: Sema does not check that a `&mut T` is the only way to reach its
+// pointee, a `&T` and a `&mut T` to the same value may be passed together. Raw pointers promise nothing
+static auto AddReferenceAttributes(llvm::AttrBuilder& attrs, TypeBase const* type) -> void
+{
+  auto pointee = PointeeType(type);
+  attrs.addAttribute(llvm::Attribute::NonNull);
+  attrs.addAlignmentAttr(AlignOf(pointee));
+  if (auto size = LayoutOf(pointee).mSize; size != 0) {
+    attrs.addDereferenceableAttr(size);
+  }
+}
+static auto AddABIAttributes(llvm::Function* fn, FunctionItem const* functionItem) -> void
+{
+  auto& ctx = fn->getContext();
+  auto addPointerAttributes = [&](u32 argNo, TypeBase const* type) {
+    fn->addParamAttr(argNo, llvm::Attribute::getWithAlignment(ctx, AlignOf(type)));
+    fn->addParamAttr(argNo, llvm::Attribute::getWithDereferenceableBytes(ctx, LayoutOf(type).mSize));
+    fn->addParamAttr(argNo, llvm::Attribute::NoAlias);
+    fn->addParamAttr(argNo, llvm::Attribute::NoCapture);
+  };
+  auto fnType = functionItem->mFnType.get();
+  auto sig = functionItem->isDeclaration() ? std::optional(ClassifyCSignature(functionItem, ctx)) : std::nullopt;
+  auto hasReturnSlot = sig ? sig->mRet.mKind == CPassing::Kind::Memory : HasReturnSlot(fnType);
+  if (hasReturnSlot) {
+    auto retType = fnType->mRet.get();
+    addPointerAttributes(0, retType);
+    fn->addParamAttr(0, llvm::Attribute::getWithStructRetType(ctx, GenLLVMType(retType, ctx)));
+  }
+  if (auto retType = fnType->mRet.get(); retType->mKind == TypeBase::Kind::Reference) {
+    auto attrs = llvm::AttrBuilder(ctx);
+    AddReferenceAttributes(attrs, retType);
+    fn->addRetAttrs(attrs);
+  }
+  auto params = LoweredParams(functionItem);
+  for (u32 i = 0; i < params.size(); ++i) {
+    auto& arg = *fn->getArg(i + hasReturnSlot);
+    auto type = fnType->mParams[params[i]].get();
+    if (type->mKind == TypeBase::Kind::Reference) {
+      auto attrs = llvm::AttrBuilder(ctx);
+      AddReferenceAttributes(attrs, type);
+      if (!type->as<ReferenceType>()->mMutable) {
+        attrs.addAttribute(llvm::Attribute::ReadOnly);
+      }
+      fn->addParamAttrs(arg.getArgNo(), attrs);
+      continue;
+    }
+    if (sig ? sig->mParams[i].mKind != CPassing::Kind::Memory : !IsIndirect(type)) {
+      continue;
+    }
+    if (sig) {
+      fn->addParamAttr(arg.getArgNo(), llvm::Attribute::getWithAlignment(ctx, AlignOf(type)));
+      fn->addParamAttr(arg.getArgNo(), llvm::Attribute::getWithByValType(ctx, GenLLVMType(type, ctx)));
+    } else {
+      addPointerAttributes(arg.getArgNo(), type);
+    }
+  }
+}
+// `sret` and `byval` have to be repeated on the call
+static auto CallAttributes(llvm::Function* callee) -> llvm::AttributeList
+{
+  auto params = llvm::SmallVector<llvm::AttributeSet>{};
+  for (auto const& arg : callee->args()) {
+    params.push_back(callee->getAttributes().getParamAttrs(arg.getArgNo()));
+  }
+  return llvm::AttributeList::get(callee->getContext(), {}, {}, params);
+}
+
+// the loop id is distinct and refers to itself, followed by one node per hint
+static auto GenLoopID(LoopExpr::Hints const& hints, llvm::DILocation* loc, llvm::LLVMContext& ctx) -> llvm::MDNode*
+{
+  auto ops = llvm::SmallVector<llvm::Metadata*, 4>{nullptr};
+  if (loc != nullptr) {
+    ops.push_back(loc); // the loop's start location, see llvm::Loop::getStartLoc
+  }
+  auto addFlag = [&](llvm::StringRef name) { ops.push_back(llvm::MDNode::get(ctx, llvm::MDString::get(ctx, name))); };
+  auto addValue = [&](llvm::StringRef name, llvm::Constant* value) {
+    ops.push_back(llvm::MDNode::get(ctx, {llvm::MDString::get(ctx, name), llvm::ConstantAsMetadata::get(value)}));
+  };
+  auto i32Ty = llvm::Type::getInt32Ty(ctx);
+
+  if (auto unroll = hints.mUnroll) {
+    if (*unroll == 0) {
+      addFlag("llvm.loop.unroll.enable");
+    } else if (*unroll == 1) {
+      addFlag("llvm.loop.unroll.disable");
+    } else {
+      addValue("llvm.loop.unroll.count", llvm::ConstantInt::get(i32Ty, *unroll));
+    }
+  }
+  // a width of 1 keeps the loop scalar but still allows interleaving
+  if (auto width = hints.mVectorizeWidth) {
+    if (*width != 1) {
+      addValue("llvm.loop.vectorize.enable", llvm::ConstantInt::getTrue(ctx));
+    }
+    if (*width != 0) {
+      addValue("llvm.loop.vectorize.width", llvm::ConstantInt::get(i32Ty, *width));
+    }
+  }
+  if (auto interleave = hints.mInterleave) {
+    addValue("llvm.loop.interleave.count", llvm::ConstantInt::get(i32Ty, *interleave));
+  }
+
+  if (ops.size() == (loc != nullptr ? 2 : 1)) {
+    return nullptr;
+  }
+  auto id = llvm::MDNode::getDistinct(ctx, ops);
+  id->replaceOperandWith(0, id);
+  return id;
+}
+
+// allocas all go to the entry block so that mem2reg and SROA can promote them
+auto IRGen::createEntryAlloca(llvm::Type* type, llvm::StringRef name, llvm::MaybeAlign align) -> llvm::AllocaInst*
+{
+  auto& entry = currentFunction()->getEntryBlock();
+  auto builder = llvm::IRBuilder<>(&entry, entry.getFirstInsertionPt());
+  auto slot = builder.CreateAlloca(type, nullptr, name);
+  if (align) {
+    slot->setAlignment(*align);
+  }
+  return slot;
+}
+// false once control flow can no longer reach the insert point, e.g. after `return`
+auto IRGen::hasLiveInsertPoint() -> bool
+{
+  auto block = mBuilder.GetInsertBlock();
+  return block->getTerminator() == nullptr && (block->isEntryBlock() || !llvm::pred_empty(block));
+}
+// branches to `dest` unless control flow already left the current block, dead blocks are closed off instead
+auto IRGen::branchIfLive(llvm::BasicBlock* dest) -> bool
+{
+  if (hasLiveInsertPoint()) {
+    mBuilder.CreateBr(dest);
+    return true;
+  }
+  if (mBuilder.GetInsertBlock()->getTerminator() == nullptr) {
+    mBuilder.CreateUnreachable();
+  }
+  return false;
+}
+// code following an expression of type `!` still needs somewhere to go, the block is removed by the optimizer
+auto IRGen::startDeadBlock() -> void
+{
+  if (mBuilder.GetInsertBlock()->getTerminator() == nullptr) {
+    mBuilder.CreateUnreachable();
+  }
+  mBuilder.SetInsertPoint(llvm::BasicBlock::Create(mCtx, "dead", currentFunction()));
+}
+
 auto IRGen::genCrate(Crate* crate) -> void
 {
   auto guard = enterScope();
   for (auto& item : crate->mItems) {
     genItem(item.get());
   }
+  InternalizeStatics(*mModule);
 }
 auto IRGen::genStmt(Stmt* stmt) -> void
 {
@@ -20,13 +594,16 @@ auto IRGen::genStmt(Stmt* stmt) -> void
     utils::Unimplemented(utils::SrcLoc::current());
   }
 }
-auto IRGen::genBlockExpr(BlockExpr* blockExpr) -> llvm::Value*
+// an aggregate result is evaluated into `dest` when there is one
+auto IRGen::genBlockExpr(BlockExpr* blockExpr, llvm::Value* dest) -> llvm::Value*
 {
-
   auto guard = enterScope();
-  auto BB = llvm::BasicBlock::Create(mModule->getContext(), "entry", currentFunction());
-  mBuilder.SetInsertPoint(BB);
-
+  // declared up front so that nested functions may call each other regardless of order
+  for (auto& item : blockExpr->mItems) {
+    if (item->mKind == Item::Kind::Function) {
+      declareNestedFunction(item->as<FunctionItem>());
+    }
+  }
   for (auto& item : blockExpr->mItems) {
     genItem(item.get());
   }
@@ -34,56 +611,298 @@ auto IRGen::genBlockExpr(BlockExpr* blockExpr) -> llvm::Value*
     genStmt(stmt.get());
   }
 
-  if (blockExpr->mReturn) {
+  if (blockExpr->mReturn && dest != nullptr && IsAggregate(blockExpr->mReturn->getType())) {
+    return genAggregateInto(blockExpr->mReturn.get(), dest);
+  } else if (blockExpr->mReturn) {
     return genExpr(blockExpr->mReturn.get());
   } else {
     return nullptr;
   }
 }
 auto IRGen::genExprStmt(ExprStmt* exprStmt) -> void { genExpr(exprStmt->mExpr.get()); }
+// a pattern takes the elements of the tuple apart, each into a slot of its own
 auto IRGen::genLetStmt(LetStmt* letStmt) -> void
 {
+  if (letStmt->mPattern) {
+    auto const& names = *letStmt->mPattern;
+    auto tuple = letStmt->mExpr->getType()->as<TupleType>();
+    auto value = genExpr(letStmt->mExpr.get());
+    for (u32 i = 0; i < names.size(); ++i) {
+      auto type = tuple->mTypes[i].get();
+      if (value == nullptr || (IsZeroSized(type) && !IsAggregate(type))) {
+        mValues.insertValue(names[i], nullptr);
+        continue;
+      }
+      auto slot = createEntryAlloca(GenLLVMType(type, mCtx), names[i], AlignOf(type));
+      if (!IsZeroSized(type)) {
+        auto elem = mBuilder.CreateExtractValue(value, TupleElementIndex(tuple, i), names[i]);
+        mBuilder.CreateAlignedStore(elem, slot, AlignOf(type));
+      }
+      mValues.insertValue(names[i], slot);
+    }
+    return;
+  }
+  if (auto type = letStmt->mExpr->getType(); IsAggregate(type)) {
+    auto& state = currentState();
+    auto slot = letStmt == state.mNamedReturn ? state.mReturnSlot
+                                              : createEntryAlloca(GenLLVMType(type, mCtx), letStmt->mName, AlignOf(type));
+    if (auto value = genAggregateInto(letStmt->mExpr.get(), slot); value == nullptr) {
+      slot = nullptr;
+    }
+    mValues.insertValue(letStmt->mName, slot);
+    return;
+  }
   auto value = genExpr(letStmt->mExpr.get());
-  // assert(mValueScopes.insertValue(letStmt->mName, value));
+  if (value == nullptr) { // unit or diverging
+    mValues.insertValue(letStmt->mName, nullptr);
+    return;
+  }
+  auto slot = createEntryAlloca(value->getType(), letStmt->mName, SlotAlign(letStmt->mExpr->getType()));
+  mBuilder.CreateAlignedStore(value, slot, slot->getAlign());
+  mValues.insertValue(letStmt->mName, slot);
 }
 auto IRGen::genItem(Item* item) -> void
 {
   switch (item->mKind) {
   case Item::Kind::Function:
     return genFunctionItem(item->as<FunctionItem>());
+  case Item::Kind::ExternBlock:
+    return genExternalBlockItem(item->as<ExternalBlockItem>());
+  case Item::Kind::Struct: // lowered on first use of the type
+  case Item::Kind::ConstantItem: // inlined where it is used
+    return;
+  case Item::Kind::StaticItem:
+    declareStatic(item->as<StaticItem>());
+    return;
   case Item::Kind::Module:
   case Item::Kind::ExternCrate:
   case Item::Kind::UseDeclaration:
   case Item::Kind::TypeAlias:
-  case Item::Kind::Struct:
   case Item::Kind::Enumeration:
   case Item::Kind::Union:
-  case Item::Kind::ConstantItem:
-  case Item::Kind::StaticItem:
   case Item::Kind::Trait:
   case Item::Kind::Implementation:
-  case Item::Kind::ExternBlock:
   case Item::Kind::SIZE:
     utils::Unimplemented(utils::SrcLoc::current());
     break;
   }
 }
+auto IRGen::declareFunction(FunctionItem const* functionItem) -> llvm::Function*
+{
+  if (auto it = mNestedFunctions.find(functionItem); it != mNestedFunctions.end()) {
+    return it->second;
+  }
+  if (auto fn = mModule->getFunction(functionItem->mName)) {
+    return fn;
+  }
+  // an extern function follows the C calling convention, which passes small aggregates differently
+  auto sig = functionItem->isDeclaration() ? std::optional(ClassifyCSignature(functionItem, mCtx)) : std::nullopt;
+  auto fnTy = sig ? GenCFunctionType(functionItem, *sig, mCtx)
+                  : llvm::dyn_cast<llvm::FunctionType>(GenLLVMType(functionItem->mFnType.get(), mCtx));
+  auto fn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, functionItem->mName, mModule.get());
+  auto hasReturnSlot = sig ? sig->mRet.mKind == CPassing::Kind::Memory : HasReturnSlot(functionItem->mFnType.get());
+  for (auto [arg, index] : llvm::zip(llvm::drop_begin(fn->args(), hasReturnSlot), LoweredParams(functionItem))) {
+    arg.setName(functionItem->mParamNames[index]);
+  }
+  AddFunctionAttributes(fn, functionItem);
+  AddABIAttributes(fn, functionItem);
+  return fn;
+}
+// nested items are only visible to the enclosing function, the name is qualified by it to stay unique in the module
+auto IRGen::declareNestedFunction(FunctionItem const* functionItem) -> llvm::Function*
+{
+  auto fnTy = llvm::dyn_cast<llvm::FunctionType>(GenLLVMType(functionItem->mFnType.get(), mCtx));
+  auto name = (currentFunction()->getName() + "::" + functionItem->mName).str();
+  auto fn = llvm::Function::Create(fnTy, llvm::Function::InternalLinkage, name, mModule.get());
+  auto hasReturnSlot = HasReturnSlot(functionItem->mFnType.get());
+  for (auto [arg, index] : llvm::zip(llvm::drop_begin(fn->args(), hasReturnSlot), LoweredParams(functionItem))) {
+    arg.setName(functionItem->mParamNames[index]);
+  }
+  AddFunctionAttributes(fn, functionItem);
+  AddABIAttributes(fn, functionItem);
+  mNestedFunctions[functionItem] = fn;
+  return fn;
+}
+// every module using a static carries its definition, the linker keeps one of them like it does for a C++ inline
+// variable. Null for a unit typed one, which has no storage
+// Every module a function using a static is generated into carries the definition as `linkonce_odr`, so modules of
+// the same crate share one variable once combined or linked. The name is qualified by the crate so that another crate's
+// static or a C symbol of the same name is never merged with it. Once a module holds the whole crate the statics are
+// made internal, see InternalizeStatics
+auto StaticSymbolName(llvm::StringRef modname, llvm::StringRef name) -> std::string
+{
+  return (llvm::sys::path::stem(modname) + "::" + name).str();
+}
+auto InternalizeStatics(llvm::Module& module) -> void
+{
+  for (auto& gv : module.globals()) {
+    if (gv.getLinkage() == llvm::GlobalValue::LinkOnceODRLinkage) { // only statics are linkonce_odr
+      gv.setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+  }
+}
+auto IRGen::declareStatic(StaticItem const* staticItem) -> llvm::GlobalVariable*
+{
+  auto type = staticItem->mType.get();
+  if (IsUnit(type)) {
+    return nullptr;
+  }
+  auto name = StaticSymbolName(mModule->getModuleIdentifier(), staticItem->mName);
+  if (auto gv = mModule->getNamedGlobal(name)) {
+    return gv;
+  }
+  auto ty = GenLLVMType(type, mCtx);
+  auto init = genConstant(staticItem->mExpr.get());
+  auto gv = new llvm::GlobalVariable(*mModule, ty, !staticItem->mMutable, llvm::GlobalValue::LinkOnceODRLinkage,
+                                     init != nullptr ? init : llvm::Constant::getNullValue(ty), name);
+  gv->setAlignment(AlignOf(type));
+  return gv;
+}
+// an aggregate const that is used in place gets a private copy in each module
+auto IRGen::genConstantAddress(ConstantItem const* constantItem) -> llvm::GlobalVariable*
+{
+  if (auto it = mConstants.find(constantItem); it != mConstants.end()) {
+    return it->second;
+  }
+  auto type = constantItem->mType.get();
+  auto gv = new llvm::GlobalVariable(*mModule, GenLLVMType(type, mCtx), true, llvm::GlobalValue::PrivateLinkage,
+                                     genConstant(constantItem->mExpr.get()), constantItem->mName);
+  gv->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+  gv->setAlignment(AlignOf(type));
+  mConstants[constantItem] = gv;
+  return gv;
+}
+// the initializer of a const or static, ConstEval made sure it is made of literals and consts only. Holes and zero
+// sized elements stay zero, null for unit
+auto IRGen::genConstant(Expr* expr) -> llvm::Constant*
+{
+  auto type = expr->getType();
+  if (IsUnit(type)) {
+    return nullptr;
+  }
+  auto ty = GenLLVMType(type, mCtx);
+  auto elems = std::vector<llvm::Constant*>{};
+  auto setElem = [&](u32 index, Expr* elem) {
+    if (auto value = genConstant(elem)) {
+      elems[index] = value;
+    }
+  };
+  switch (auto e = expr->as<ExprWithoutBlock>(); e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    if (auto literal = e->as<LiteralExpr>(); literal->mItem != nullptr) {
+      return genConstant(literal->mItem->as<ConstantItem>()->mExpr.get());
+    } else {
+      return llvm::cast<llvm::Constant>(genLiteralExpr(literal));
+    }
+  case ExprWithoutBlock::Type::Grouped:
+    return genConstant(e->as<GroupedExpr>()->mExpr.get());
+  case ExprWithoutBlock::Type::Array: {
+    auto arrayExpr = e->as<ArrayExpr>();
+    auto arrayTy = llvm::cast<llvm::ArrayType>(ty);
+    elems.assign(arrayTy->getNumElements(), llvm::Constant::getNullValue(arrayTy->getElementType()));
+    for (u32 i = 0; i < elems.size(); ++i) {
+      setElem(i, arrayExpr->mElems[arrayExpr->mRepeat ? 0 : i].get());
+    }
+    return llvm::ConstantArray::get(arrayTy, elems);
+  }
+  case ExprWithoutBlock::Type::Struct: {
+    auto structExpr = e->as<StructExpr>();
+    auto structTy = llvm::cast<llvm::StructType>(ty);
+    for (auto elemTy : structTy->elements()) {
+      elems.push_back(llvm::Constant::getNullValue(elemTy));
+    }
+    for (auto& init : structExpr->mFields) {
+      setElem(StructElementIndex(structExpr->mItem, init.mIndex), init.mValue.get());
+    }
+    return llvm::ConstantStruct::get(structTy, elems);
+  }
+  case ExprWithoutBlock::Type::Tuple: {
+    auto tuple = type->as<TupleType>();
+    auto structTy = llvm::cast<llvm::StructType>(ty);
+    for (auto elemTy : structTy->elements()) {
+      elems.push_back(llvm::Constant::getNullValue(elemTy));
+    }
+    for (u32 i = 0; i < tuple->mTypes.size(); ++i) {
+      if (!IsZeroSized(tuple->mTypes[i].get())) {
+        setElem(TupleElementIndex(tuple, i), e->as<TupleExpr>()->mElems[i].get());
+      }
+    }
+    return llvm::ConstantStruct::get(structTy, elems);
+  }
+  default:
+    utils::Unreachable(utils::SrcLoc::current(), "initializer is not constant");
+  }
+}
 auto IRGen::genFunctionItem(FunctionItem* functionItem) -> void
 {
+  auto fn = declareFunction(functionItem);
+  if (functionItem->isDeclaration()) {
+    return;
+  }
+  assert(fn->empty() && "function defined twice");
+
+  auto insertGuard = llvm::IRBuilderBase::InsertPointGuard(mBuilder);
   auto guard = enterScope();
-  {
-    auto fn = mModule->getFunction(functionItem->mName);
-    if (!fn) { // if not exists, create a external linkage
-      auto fnTy = llvm::dyn_cast<llvm::FunctionType>(GenLLVMType(functionItem->mFnType.get(), mCtx));
-      fn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, functionItem->mName, mModule.get());
+  mBuilder.SetInsertPoint(llvm::BasicBlock::Create(mCtx, "entry", fn));
+  auto& state = pushFunction(fn);
+  auto hasReturnSlot = HasReturnSlot(functionItem->mFnType.get());
+  state.mElision.analyze(functionItem);
+  if (hasReturnSlot) {
+    state.mReturnSlot = fn->getArg(0);
+    state.mReturnSlot->setName("ret");
+    state.mNamedReturn = state.mElision.namedReturn();
+  }
+  for (auto const& name : functionItem->mParamNames) {
+    mValues.insertValue(name, nullptr); // unit typed
+  }
+  for (auto [arg, index] : llvm::zip(llvm::drop_begin(fn->args(), hasReturnSlot), LoweredParams(functionItem))) {
+    auto type = functionItem->mFnType->mParams[index].get();
+    if (IsIndirect(type)) { // the copy belongs to this function already
+      mValues.insertValue(functionItem->mParamNames[index], &arg);
+      continue;
+    }
+    auto slot = createEntryAlloca(arg.getType(), functionItem->mParamNames[index], SlotAlign(type));
+    mBuilder.CreateAlignedStore(&arg, slot, slot->getAlign());
+    mValues.insertValue(functionItem->mParamNames[index], slot);
+  }
+
+  auto body = genBlockExpr(functionItem->mBody.get(), state.mReturnSlot);
+  if (mBuilder.GetInsertBlock()->getTerminator() == nullptr) {
+    if (!hasLiveInsertPoint()) {
+      mBuilder.CreateUnreachable();
+    } else if (fn->getReturnType()->isVoidTy() && (!hasReturnSlot || body != nullptr)) {
+      mBuilder.CreateRetVoid();
+    } else if (body != nullptr) {
+      mBuilder.CreateRet(loadIfAggregate(body, functionItem->mFnType->mRet.get()));
+    } else {
+      mBuilder.CreateUnreachable();
     }
-    assert(fn != nullptr && !fn->empty());
-    pushFunction(fn);
-    auto body = genBlockExpr(functionItem->mBody.get());
-    popFunction();
+  }
+  popFunction();
+}
+auto IRGen::genExpr(Expr* expr) -> llvm::Value*
+{
+  auto value = expr->mType == Expr::Type::WithBlock ? genExprWithBlock(expr->as<ExprWithBlock>())
+                                                    : genExprWithoutBlock(expr->as<ExprWithoutBlock>());
+  if (IsNever(expr)) {
+    startDeadBlock();
+    return nullptr;
+  }
+  return value;
+}
+auto IRGen::genExprWithBlock(ExprWithBlock* exprWithBlock) -> llvm::Value*
+{
+  switch (exprWithBlock->mType) {
+  case ExprWithBlock::Type::Block:
+    return genBlockExpr(exprWithBlock->as<BlockExpr>());
+  case ExprWithBlock::Type::If:
+    return genIfExpr(exprWithBlock->as<IfExpr>());
+  case ExprWithBlock::Type::Loop:
+    return genLoopExpr(exprWithBlock->as<LoopExpr>());
+  default:
+    utils::Unimplemented(utils::SrcLoc::current());
   }
 }
-auto IRGen::genExpr(Expr* expr) -> llvm::Value* {}
 auto IRGen::genLiteralExpr(LiteralExpr* literalExpr) -> llvm::Value*
 {
   switch (literalExpr->mKind) {
@@ -113,10 +932,26 @@ auto IRGen::genLiteralExpr(LiteralExpr* literalExpr) -> llvm::Value*
     utils::Unimplemented(utils::SrcLoc::current());
   case LiteralExpr::Kind::Identifier: {
     assert(std::holds_alternative<std::string>(literalExpr->mValue));
-    auto ty = lookupIdentifier(std::get<std::string>(literalExpr->mValue));
-    // return ;
+    auto& name = std::get<std::string>(literalExpr->mValue);
+    auto type = literalExpr->getType();
+    if (auto item = literalExpr->mItem; item != nullptr && item->mKind == Item::Kind::ConstantItem) {
+      return IsAggregate(type) ? genConstantAddress(item->as<ConstantItem>())
+                               : genConstant(item->as<ConstantItem>()->mExpr.get());
+    } else if (item != nullptr) {
+      auto gv = declareStatic(item->as<StaticItem>());
+      if (gv == nullptr || IsAggregate(type)) {
+        return gv;
+      }
+      return mBuilder.CreateAlignedLoad(gv->getValueType(), gv, AlignOf(type), name);
+    }
+    auto slot = mValues.lookupValue(name);
+    if (slot == nullptr || IsAggregate(literalExpr->getType())) {
+      return slot;
+    }
+    return mBuilder.CreateLoad(llvm::cast<llvm::AllocaInst>(slot)->getAllocatedType(), slot, name);
   }
   }
+  utils::Unreachable(utils::SrcLoc::current());
 }
 auto IRGen::genGroupedExpr(GroupedExpr* groupedExpr) -> llvm::Value* { return genExpr(groupedExpr->mExpr.get()); }
 auto IRGen::genOperatorExpr(OperatorExpr* operatorExpr) -> llvm::Value*
@@ -127,67 +962,1059 @@ auto IRGen::genOperatorExpr(OperatorExpr* operatorExpr) -> llvm::Value*
   case OperatorExpr::Type::Binary:
     return genBinaryExpr(operatorExpr->as<BinaryExpr>());
   }
+  utils::Unreachable(utils::SrcLoc::current());
 }
 auto IRGen::genBinaryExpr(BinaryExpr* binaryExpr) -> llvm::Value*
 {
+  if (binaryExpr->mKind == BinaryExpr::Kind::Assignment) {
+    return genAssignment(binaryExpr);
+  }
+  if (binaryExpr->mKind == BinaryExpr::Kind::LogicalAnd || binaryExpr->mKind == BinaryExpr::Kind::LogicalOr) {
+    return genLogicalExpr(binaryExpr);
+  }
   auto lhs = genExpr(binaryExpr->mLeft.get());
   auto rhs = genExpr(binaryExpr->mRight.get());
+  auto ty = binaryExpr->mLeft->getType();
+
+  if (IsFloat(ty)) {
+    switch (binaryExpr->mKind) {
+    case BinaryExpr::Kind::Add:
+      return mBuilder.CreateFAdd(lhs, rhs, "addtmp");
+    case BinaryExpr::Kind::Sub:
+      return mBuilder.CreateFSub(lhs, rhs, "subtmp");
+    case BinaryExpr::Kind::Mul:
+      return mBuilder.CreateFMul(lhs, rhs, "multmp");
+    case BinaryExpr::Kind::Div:
+      return mBuilder.CreateFDiv(lhs, rhs, "divtmp");
+    case BinaryExpr::Kind::Rem:
+      return mBuilder.CreateFRem(lhs, rhs, "remtmp");
+    case BinaryExpr::Kind::Eq:
+      return mBuilder.CreateFCmpOEQ(lhs, rhs, "cmptmp");
+    case BinaryExpr::Kind::Ne:
+      return mBuilder.CreateFCmpUNE(lhs, rhs, "cmptmp");
+    case BinaryExpr::Kind::Gt:
+      return mBuilder.CreateFCmpOGT(lhs, rhs, "cmptmp");
+    case BinaryExpr::Kind::Lt:
+      return mBuilder.CreateFCmpOLT(lhs, rhs, "cmptmp");
+    case BinaryExpr::Kind::Ge:
+      return mBuilder.CreateFCmpOGE(lhs, rhs, "cmptmp");
+    case BinaryExpr::Kind::Le:
+      return mBuilder.CreateFCmpOLE(lhs, rhs, "cmptmp");
+    default:
+      utils::Unreachable(utils::SrcLoc::current());
+    }
+  }
 
+  auto isSigned = IsSigned(ty);
   switch (binaryExpr->mKind) {
   case BinaryExpr::Kind::Add:
-
+    return mBuilder.CreateAdd(lhs, rhs, "addtmp");
   case BinaryExpr::Kind::Sub:
+    return mBuilder.CreateSub(lhs, rhs, "subtmp");
   case BinaryExpr::Kind::Mul:
+    return mBuilder.CreateMul(lhs, rhs, "multmp");
   case BinaryExpr::Kind::Div:
+    return isSigned ? mBuilder.CreateSDiv(lhs, rhs, "divtmp") : mBuilder.CreateUDiv(lhs, rhs, "divtmp");
   case BinaryExpr::Kind::Rem:
+    return isSigned ? mBuilder.CreateSRem(lhs, rhs, "remtmp") : mBuilder.CreateURem(lhs, rhs, "remtmp");
   case BinaryExpr::Kind::BitAnd:
+    return mBuilder.CreateAnd(lhs, rhs, "andtmp");
   case BinaryExpr::Kind::BitOr:
+    return mBuilder.CreateOr(lhs, rhs, "ortmp");
   case BinaryExpr::Kind::BitXor:
+    return mBuilder.CreateXor(lhs, rhs, "xortmp");
   case BinaryExpr::Kind::Shl:
+    return mBuilder.CreateShl(lhs, rhs, "shltmp");
   case BinaryExpr::Kind::Shr:
+    return isSigned ? mBuilder.CreateAShr(lhs, rhs, "shrtmp") : mBuilder.CreateLShr(lhs, rhs, "shrtmp");
   case BinaryExpr::Kind::Eq:
+    return mBuilder.CreateICmpEQ(lhs, rhs, "cmptmp");
   case BinaryExpr::Kind::Ne:
+    return mBuilder.CreateICmpNE(lhs, rhs, "cmptmp");
   case BinaryExpr::Kind::Gt:
+    return isSigned ? mBuilder.CreateICmpSGT(lhs, rhs, "cmptmp") : mBuilder.CreateICmpUGT(lhs, rhs, "cmptmp");
   case BinaryExpr::Kind::Lt:
+    return isSigned ? mBuilder.CreateICmpSLT(lhs, rhs, "cmptmp") : mBuilder.CreateICmpULT(lhs, rhs, "cmptmp");
   case BinaryExpr::Kind::Ge:
+    return isSigned ? mBuilder.CreateICmpSGE(lhs, rhs, "cmptmp") : mBuilder.CreateICmpUGE(lhs, rhs, "cmptmp");
   case BinaryExpr::Kind::Le:
+    return isSigned ? mBuilder.CreateICmpSLE(lhs, rhs, "cmptmp") : mBuilder.CreateICmpULE(lhs, rhs, "cmptmp");
+  case BinaryExpr::Kind::LogicalAnd:
+  case BinaryExpr::Kind::LogicalOr:
   case BinaryExpr::Kind::Assignment:
   case BinaryExpr::Kind::SIZE:
     break;
   }
+  utils::Unreachable(utils::SrcLoc::current());
 }
-auto IRGen::genUnaryExpr(UnaryExpr* unaryExpr) -> llvm::Value* {}
-auto IRGen::genCallExpr(CallExpr* callExpr) -> llvm::Value*
+// a cheap right operand is evaluated anyway and combined with a select, which keeps data dependent conditions from
+// turning into branches that mispredict. Any other one is only evaluated when the left operand does not decide
+auto IRGen::genLogicalExpr(BinaryExpr* binaryExpr) -> llvm::Value*
 {
-  auto callee = mModule->getFunction(callExpr->mCallee);
+  auto isAnd = binaryExpr->mKind == BinaryExpr::Kind::LogicalAnd;
+  auto lhs = genExpr(binaryExpr->mLeft.get());
+  if (lhs == nullptr) {
+    return nullptr;
+  }
+  if (auto budget = kSpeculationBudget; IsSpeculatable(binaryExpr->mRight.get(), budget)) {
+    auto rhs = genExpr(binaryExpr->mRight.get());
+    return isAnd ? mBuilder.CreateLogicalAnd(lhs, rhs, "andtmp") : mBuilder.CreateLogicalOr(lhs, rhs, "ortmp");
+  }
+
+  auto fn = currentFunction();
+  auto lhsBB = mBuilder.GetInsertBlock();
+  auto rhsBB = llvm::BasicBlock::Create(mCtx, isAnd ? "and.rhs" : "or.rhs", fn);
+  auto endBB = llvm::BasicBlock::Create(mCtx, isAnd ? "and.end" : "or.end");
+  mBuilder.CreateCondBr(lhs, isAnd ? rhsBB : endBB, isAnd ? endBB : rhsBB);
+  mBuilder.SetInsertPoint(rhsBB);
+  auto rhs = genExpr(binaryExpr->mRight.get());
+  auto rhsEndBB = mBuilder.GetInsertBlock();
+  auto rhsLive = branchIfLive(endBB);
+
+  endBB->insertInto(fn);
+  mBuilder.SetInsertPoint(endBB);
+  auto decided = mBuilder.getInt1(!isAnd);
+  if (!rhsLive) {
+    return decided;
+  }
+  auto phi = mBuilder.CreatePHI(mBuilder.getInt1Ty(), 2, isAnd ? "andtmp" : "ortmp");
+  phi->addIncoming(decided, lhsBB);
+  phi->addIncoming(rhs, rhsEndBB);
+  return phi;
+}
+auto IRGen::genAssignment(BinaryExpr* binaryExpr) -> llvm::Value*
+{
+  auto lhs = binaryExpr->mLeft.get();
+  while (lhs->mType == Expr::Type::WithoutBlock && lhs->as<ExprWithoutBlock>()->mType == ExprWithoutBlock::Type::Grouped) {
+    lhs = lhs->as<ExprWithoutBlock>()->as<GroupedExpr>()->mExpr.get();
+  }
+  if (lhs->mType == Expr::Type::WithoutBlock && lhs->as<ExprWithoutBlock>()->mType == ExprWithoutBlock::Type::Index) {
+    auto indexExpr = lhs->as<ExprWithoutBlock>()->as<IndexExpr>();
+    auto rhs = genExpr(binaryExpr->mRight.get());
+    auto address = genElementAddress(indexExpr->mBase.get(), indexExpr->mIndex.get(), indexExpr->mChecked);
+    if (rhs != nullptr && address != nullptr) {
+      storeValue(address, rhs, indexExpr->getType(), PlaceAlign(indexExpr));
+    }
+    return nullptr;
+  }
+  if (lhs->mType == Expr::Type::WithoutBlock && lhs->as<ExprWithoutBlock>()->mType == ExprWithoutBlock::Type::Field) {
+    auto fieldExpr = lhs->as<ExprWithoutBlock>()->as<FieldExpr>();
+    auto rhs = genExpr(binaryExpr->mRight.get());
+    auto address = genFieldAddress(fieldExpr);
+    if (rhs != nullptr && address != nullptr) {
+      storeValue(address, rhs, fieldExpr->getType(), PlaceAlign(fieldExpr));
+    }
+    return nullptr;
+  }
+  if (auto derefExpr = lhs->mType == Expr::Type::WithoutBlock ? AsDeref(lhs->as<ExprWithoutBlock>()) : nullptr) {
+    auto rhs = genExpr(binaryExpr->mRight.get());
+    auto address = genExpr(derefExpr->mRight.get());
+    if (rhs != nullptr && address != nullptr) {
+      storeValue(address, rhs, derefExpr->getType(), PlaceAlign(derefExpr));
+    }
+    return nullptr;
+  }
+  if (lhs->mType != Expr::Type::WithoutBlock || lhs->as<ExprWithoutBlock>()->mType != ExprWithoutBlock::Type::Literal ||
+      lhs->as<ExprWithoutBlock>()->as<LiteralExpr>()->mKind != LiteralExpr::Kind::Identifier) {
+    utils::Unimplemented(utils::SrcLoc::current(), "assignment to a place other than a local, element, field or pointee");
+  }
+  auto rhs = genExpr(binaryExpr->mRight.get());
+  if (auto slot = genPlaceAddress(lhs); slot != nullptr && rhs != nullptr) {
+    storeValue(slot, rhs, lhs->getType());
+  }
+  return nullptr;
+}
+auto IRGen::genUnaryExpr(UnaryExpr* unaryExpr) -> llvm::Value*
+{
+  auto operand = unaryExpr->mRight.get();
+  switch (unaryExpr->mKind) {
+  case UnaryExpr::Kind::Ref:
+  case UnaryExpr::Kind::RefMut: {
+    // a zero sized place has no slot, any aligned address will do for it
+    auto address = genPlaceAddress(operand);
+    if (address == nullptr && IsZeroSized(operand->getType()) && hasLiveInsertPoint()) {
+      auto i64 = llvm::Type::getInt64Ty(mCtx);
+      auto ptrTy = GenLLVMType(unaryExpr->getType(), mCtx);
+      return llvm::ConstantExpr::getIntToPtr(llvm::ConstantInt::get(i64, LayoutOf(operand->getType()).mAlign), ptrTy);
+    }
+    return address;
+  }
+  case UnaryExpr::Kind::Deref: {
+    auto address = genExpr(operand);
+    if (address == nullptr || IsZeroSized(unaryExpr->getType())) {
+      return nullptr;
+    }
+    return loadPlace(address, unaryExpr->getType(), PlaceAlign(unaryExpr), "deref");
+  }
+  case UnaryExpr::Kind::Unsize: {
+    // the address of the first element and the length of the array
+    auto address = genExpr(operand);
+    if (address == nullptr) {
+      return nullptr;
+    }
+    auto arrayTy = PointeeType(operand->getType())->as<ArrayType>();
+    auto data = mBuilder.CreateConstInBoundsGEP2_64(GenLLVMType(arrayTy, mCtx), address, 0, 0, "data");
+    auto slice = static_cast<llvm::Value*>(llvm::UndefValue::get(GenLLVMType(unaryExpr->getType(), mCtx)));
+    slice = mBuilder.CreateInsertValue(slice, data, 0);
+    return mBuilder.CreateInsertValue(slice, mBuilder.getInt64(arrayTy->mLen), 1, "slice");
+  }
+  default:
+    break;
+  }
+  auto value = genExpr(operand);
+  if (value == nullptr) {
+    return nullptr;
+  }
+  switch (unaryExpr->mKind) {
+  case UnaryExpr::Kind::Neg:
+    return IsFloat(operand->getType()) ? mBuilder.CreateFNeg(value, "negtmp") : mBuilder.CreateNeg(value, "negtmp");
+  case UnaryExpr::Kind::Not:
+    return mBuilder.CreateNot(value, "nottmp");
+  default:
+    break;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+// a large aggregate result is written to `dest` directly, or a temporary when there is none
+auto IRGen::genCallExpr(CallExpr* callExpr, llvm::Value* dest) -> llvm::Value*
+{
+  if (callExpr->mBuiltin != CallExpr::Builtin::None) {
+    return genVectorCallExpr(callExpr);
+  }
+  // callees defined in another module are declared on first use
+  auto callee = callExpr->mFnItem ? declareFunction(callExpr->mFnItem) : mModule->getFunction(callExpr->mCallee);
   assert(callee);
+  if (callExpr->mFnItem != nullptr && callExpr->mFnItem->isDeclaration()) {
+    return genCCallExpr(callExpr, callee, dest);
+  }
 
-  assert(callee->arg_size() == callExpr->mArgs.size());
+  auto type = callExpr->getType();
+  auto returnSlot = static_cast<llvm::Value*>(nullptr);
   std::vector<llvm::Value*> args{};
+  if (IsIndirect(type)) {
+    returnSlot = dest != nullptr ? dest
+                                 : createEntryAlloca(GenLLVMType(type, mCtx), IsArray(type) ? "arraytmp" : "structtmp",
+                                                     AlignOf(type));
+    args.push_back(returnSlot);
+  }
   for (i32 i = 0; i < callExpr->mArgs.size(); ++i) {
-    args.push_back(genExpr(callExpr->mArgs[i].get()));
+    auto arg = genArgument(callExpr->mArgs[i].get(), callExpr->mFnItem);
+    if (IsUnit(callExpr->mArgs[i]->getType())) {
+      continue;
+    }
+    if (arg == nullptr) {
+      return nullptr;
+    }
+    args.push_back(arg);
+  }
+  assert(callee->arg_size() == args.size());
+  if (callee->getReturnType()->isVoidTy()) {
+    auto call = mBuilder.CreateCall(callee, args);
+    call->setAttributes(CallAttributes(callee));
+    return returnSlot;
+  }
+  auto result = mBuilder.CreateCall(callee, args, "calltmp");
+  result->setAttributes(CallAttributes(callee));
+  if (IsAggregate(type)) {
+    auto slot = dest != nullptr ? dest
+                                : createEntryAlloca(result->getType(), IsArray(type) ? "arraytmp" : "structtmp",
+                                                    AlignOf(type));
+    mBuilder.CreateAlignedStore(result, slot, AlignOf(type));
+    return slot;
+  }
+  return result;
+}
+// a call to an extern function, which takes and returns aggregates the way ClassifyCSignature decided
+auto IRGen::genCCallExpr(CallExpr* callExpr, llvm::Function* callee, llvm::Value* dest) -> llvm::Value*
+{
+  auto sig = ClassifyCSignature(callExpr->mFnItem, mCtx);
+  auto type = callExpr->getType();
+  auto args = std::vector<llvm::Value*>{};
+  auto returnSlot = static_cast<llvm::Value*>(nullptr);
+  if (sig.mRet.mKind == CPassing::Kind::Memory) {
+    returnSlot = IsAggregate(type) && dest != nullptr ? dest : createEntryAlloca(GenLLVMType(type, mCtx), "ctmp", AlignOf(type));
+    args.push_back(returnSlot);
+  }
+  auto passing = sig.mParams.begin();
+  for (auto& arg : callExpr->mArgs) {
+    auto argType = arg->getType();
+    auto value = genExpr(arg.get());
+    if (IsUnit(argType)) {
+      continue;
+    }
+    if (value == nullptr) {
+      return nullptr;
+    }
+    switch ((passing++)->mKind) {
+    case CPassing::Kind::Direct:
+      args.push_back(value);
+      break;
+    case CPassing::Kind::Coerced:
+      args.push_back(coerceToC(value, argType, std::prev(passing)->mCoerced));
+      break;
+    case CPassing::Kind::Memory: // `byval`, the callee gets a copy on the stack
+      args.push_back(IsAggregate(argType) ? value : spillValue(value, argType));
+      break;
+    }
+  }
+  assert(callee->arg_size() == args.size());
+  auto call = mBuilder.CreateCall(callee, args);
+  call->setAttributes(CallAttributes(callee));
+  switch (sig.mRet.mKind) {
+  case CPassing::Kind::Direct:
+    return callee->getReturnType()->isVoidTy() ? nullptr : call;
+  case CPassing::Kind::Coerced:
+    return coerceFromC(call, type, sig.mRet.mCoerced, dest);
+  case CPassing::Kind::Memory:
+    return IsAggregate(type) ? returnSlot : loadPlace(returnSlot, type, AlignOf(type), "cret");
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+// the registers of a C aggregate hold its bytes, it goes through memory to be reinterpreted. Tuples and slices are
+// values rather than addresses
+auto IRGen::spillValue(llvm::Value* value, TypeBase const* type) -> llvm::Value*
+{
+  auto slot = createEntryAlloca(GenLLVMType(type, mCtx), "spill", AlignOf(type));
+  mBuilder.CreateAlignedStore(value, slot, AlignOf(type));
+  return slot;
+}
+auto IRGen::coerceToC(llvm::Value* value, TypeBase const* type, llvm::Type* coerced) -> llvm::Value*
+{
+  auto address = IsAggregate(type) ? value : spillValue(value, type);
+  auto tmp = createEntryAlloca(coerced, "coerce", llvm::Align(8));
+  mBuilder.CreateMemCpy(tmp, llvm::Align(8), address, AlignOf(type), LayoutOf(type).mSize);
+  return mBuilder.CreateAlignedLoad(coerced, tmp, llvm::Align(8));
+}
+auto IRGen::coerceFromC(llvm::Value* value, TypeBase const* type, llvm::Type* coerced, llvm::Value* dest) -> llvm::Value*
+{
+  auto tmp = createEntryAlloca(coerced, "coerce", llvm::Align(8));
+  mBuilder.CreateAlignedStore(value, tmp, llvm::Align(8));
+  auto slot = IsAggregate(type) && dest != nullptr ? dest : createEntryAlloca(GenLLVMType(type, mCtx), "cret", AlignOf(type));
+  mBuilder.CreateMemCpy(slot, AlignOf(type), tmp, llvm::Align(8), LayoutOf(type).mSize);
+  return IsAggregate(type) ? slot : loadPlace(slot, type, AlignOf(type), "cret");
+}
+// A large aggregate is passed by address. The callee owns the memory, a temporary or a local at its last use is handed
+// over, anything else is copied first
+auto IRGen::genArgument(Expr* arg, FunctionItem const* callee) -> llvm::Value*
+{
+  auto type = arg->getType();
+  auto value = genExpr(arg);
+  if (value == nullptr || !IsIndirect(type)) {
+    return value == nullptr ? nullptr : loadIfAggregate(value, type);
+  }
+  while (arg->mType == Expr::Type::WithoutBlock && arg->as<ExprWithoutBlock>()->mType == ExprWithoutBlock::Type::Grouped) {
+    arg = arg->as<ExprWithoutBlock>()->as<GroupedExpr>()->mExpr.get();
+  }
+  if (arg->mType == Expr::Type::WithoutBlock) {
+    switch (arg->as<ExprWithoutBlock>()->mType) {
+    case ExprWithoutBlock::Type::Call:
+    case ExprWithoutBlock::Type::Array:
+    case ExprWithoutBlock::Type::Struct:
+      return value;
+    case ExprWithoutBlock::Type::Literal: {
+      auto& state = currentState();
+      if (state.mElision.isLastUse(arg->as<ExprWithoutBlock>()->as<LiteralExpr>()) && value != state.mReturnSlot) {
+        return value;
+      }
+    } break;
+    default:
+      break;
+    }
+  }
+  auto copy = createEntryAlloca(GenLLVMType(type, mCtx), "argtmp", AlignOf(type));
+  storeValue(copy, value, type);
+  return copy;
+}
+auto IRGen::genReturnExpr(ReturnExpr* returnExpr) -> llvm::Value*
+{
+  if (auto slot = currentState().mReturnSlot) {
+    if (genAggregateInto(returnExpr->mExpr.get(), slot) != nullptr && hasLiveInsertPoint()) {
+      mBuilder.CreateRetVoid();
+    }
+    return nullptr;
+  }
+  auto value = returnExpr->mExpr ? genExpr(returnExpr->mExpr.get()) : nullptr;
+  if (!hasLiveInsertPoint()) {
+    return nullptr;
+  }
+  if (value != nullptr) {
+    mBuilder.CreateRet(loadIfAggregate(value, returnExpr->mExpr->getType()));
+  } else {
+    mBuilder.CreateRetVoid();
+  }
+  return nullptr; // typed `!`, genExpr starts a dead block
+}
+// one trap block per function, every failed check branches to it
+auto IRGen::trapBlock() -> llvm::BasicBlock*
+{
+  auto fn = currentFunction();
+  auto& block = mTrapBlocks[fn];
+  if (block == nullptr) {
+    block = llvm::BasicBlock::Create(mCtx, "trap", fn);
+    auto builder = llvm::IRBuilder<>(block);
+    builder.CreateCall(llvm::Intrinsic::getDeclaration(mModule.get(), llvm::Intrinsic::trap));
+    builder.CreateUnreachable();
+  }
+  return block;
+}
+// a slice is `{ ptr, len }` and an array the address of its storage. The index is widened to 64 bits so a negative
+// one fails the unsigned compare. With a `count` the elements `index..index + count` are checked as a whole
+auto IRGen::genElementAddress(Expr* base, Expr* index, bool checked, u32 count) -> llvm::Value*
+{
+  auto isArray = IsArray(base->getType());
+  auto baseValue = isArray ? genPlaceAddress(base) : genExpr(base);
+  auto indexValue = genExpr(index);
+  if (baseValue == nullptr || indexValue == nullptr) {
+    return nullptr;
+  }
+  auto i64 = llvm::Type::getInt64Ty(mCtx);
+  indexValue = IsSigned(index->getType()) ? mBuilder.CreateSExtOrTrunc(indexValue, i64, "idx")
+                                          : mBuilder.CreateZExtOrTrunc(indexValue, i64, "idx");
+  if (checked) {
+    auto len = isArray ? llvm::ConstantInt::get(i64, base->getType()->as<ArrayType>()->mLen)
+                       : mBuilder.CreateExtractValue(baseValue, 1, "len");
+    auto inBounds = static_cast<llvm::Value*>(nullptr);
+    if (count == 1) {
+      inBounds = mBuilder.CreateICmpULT(indexValue, len, "inbounds");
+    } else { // index <= len - count, guarded so the subtraction can't wrap
+      auto countValue = llvm::ConstantInt::get(i64, count);
+      auto last = mBuilder.CreateSub(len, countValue);
+      inBounds = mBuilder.CreateAnd(mBuilder.CreateICmpUGE(len, countValue), mBuilder.CreateICmpULE(indexValue, last),
+                                    "inbounds");
+    }
+    auto okBB = llvm::BasicBlock::Create(mCtx, "bounds.ok", currentFunction());
+    auto weights = llvm::MDBuilder(mCtx).createBranchWeights(1 << 20, 1);
+    mBuilder.CreateCondBr(inBounds, okBB, trapBlock(), weights);
+    mBuilder.SetInsertPoint(okBB);
+  }
+  if (isArray) {
+    return mBuilder.CreateInBoundsGEP(GenLLVMType(base->getType(), mCtx), baseValue,
+                                      {llvm::ConstantInt::get(i64, 0), indexValue}, "elem");
+  }
+  auto elemTy = GenLLVMType(base->getType()->as<SliceType>()->mElem.get(), mCtx);
+  return mBuilder.CreateInBoundsGEP(elemTy, mBuilder.CreateExtractValue(baseValue, 0, "ptr"), indexValue, "elem");
+}
+auto IRGen::genIndexExpr(IndexExpr* indexExpr) -> llvm::Value*
+{
+  auto address = genElementAddress(indexExpr->mBase.get(), indexExpr->mIndex.get(), indexExpr->mChecked);
+  return address == nullptr ? nullptr : loadPlace(address, indexExpr->getType(), PlaceAlign(indexExpr), "elemtmp");
+}
+// copies `value` of the given type to `dest`, aggregates by memcpy. `destAlign` is for places below the natural
+// alignment, the source of a copy always has it
+auto IRGen::storeValue(llvm::Value* dest, llvm::Value* value, TypeBase const* type, llvm::MaybeAlign destAlign) -> void
+{
+  auto align = AlignOf(type);
+  if (!IsAggregate(type)) {
+    mBuilder.CreateAlignedStore(value, dest, destAlign.getValueOr(align));
+    return;
+  }
+  mBuilder.CreateMemCpy(dest, destAlign.getValueOr(align), value, align, LayoutOf(type).mSize);
+}
+// first class aggregate of an array or struct for calls and returns, any other value as is
+auto IRGen::loadIfAggregate(llvm::Value* value, TypeBase const* type) -> llvm::Value*
+{
+  if (!IsAggregate(type)) {
+    return value;
+  }
+  auto name = IsArray(type) ? "arrayval" : "structval";
+  return mBuilder.CreateAlignedLoad(GenLLVMType(type, mCtx), value, AlignOf(type), name);
+}
+// evaluates an aggregate typed expression into `dest`, literals, calls and block results are built in place. Null if
+// it does not produce a value
+auto IRGen::genAggregateInto(Expr* expr, llvm::Value* dest) -> llvm::Value*
+{
+  if (expr->mType == Expr::Type::WithoutBlock) {
+    switch (expr->as<ExprWithoutBlock>()->mType) {
+    case ExprWithoutBlock::Type::Array:
+      return genArrayExpr(expr->as<ExprWithoutBlock>()->as<ArrayExpr>(), dest);
+    case ExprWithoutBlock::Type::Struct:
+      return genStructExpr(expr->as<ExprWithoutBlock>()->as<StructExpr>(), dest);
+    case ExprWithoutBlock::Type::Call:
+      return genCallExpr(expr->as<ExprWithoutBlock>()->as<CallExpr>(), dest);
+    default:
+      break;
+    }
+  } else if (expr->as<ExprWithBlock>()->mType == ExprWithBlock::Type::Block) {
+    return genBlockExpr(expr->as<ExprWithBlock>()->as<BlockExpr>(), dest);
+  }
+  auto value = genExpr(expr);
+  if (value == nullptr) {
+    return nullptr;
+  }
+  if (value != dest) { // the named return value already lives in the return slot
+    storeValue(dest, value, expr->getType());
+  }
+  return dest;
+}
+// Small arrays get one store per element. A large repeat literal of a zero or byte value becomes a memset, any other
+// is filled by a loop
+auto IRGen::genArrayExpr(ArrayExpr* arrayExpr, llvm::Value* dest) -> llvm::Value*
+{
+  auto arrayTy = llvm::cast<llvm::ArrayType>(GenLLVMType(arrayExpr->getType(), mCtx));
+  auto elemType = arrayExpr->getType()->as<ArrayType>()->mElem.get();
+  auto i64 = llvm::Type::getInt64Ty(mCtx);
+  if (dest == nullptr) {
+    dest = createEntryAlloca(arrayTy, "arraytmp", AlignOf(arrayExpr->getType()));
+  }
+  auto elementAt = [&](llvm::Value* index) {
+    return mBuilder.CreateInBoundsGEP(arrayTy, dest, {llvm::ConstantInt::get(i64, 0), index}, "elem");
+  };
+
+  if (!arrayExpr->mRepeat) {
+    for (size_t i = 0; i < arrayExpr->mElems.size(); ++i) {
+      auto value = genExpr(arrayExpr->mElems[i].get());
+      if (value == nullptr) {
+        return nullptr;
+      }
+      storeValue(elementAt(llvm::ConstantInt::get(i64, i)), value, elemType);
+    }
+    return dest;
+  }
+
+  auto value = genExpr(arrayExpr->mElems.front().get());
+  if (value == nullptr) {
+    return nullptr;
+  }
+  auto len = arrayTy->getNumElements();
+  auto const& layout = mModule->getDataLayout();
+  auto bytes = layout.getTypeAllocSize(arrayTy).getFixedSize();
+  if (len == 0) {
+    return dest;
+  }
+  if (bytes <= kInlineArrayInitBytes) {
+    for (u64 i = 0; i < len; ++i) {
+      storeValue(elementAt(llvm::ConstantInt::get(i64, i)), value, elemType);
+    }
+    return dest;
+  }
+  if (auto constant = llvm::dyn_cast<llvm::Constant>(value);
+      constant != nullptr && (constant->isNullValue() || constant->getType()->isIntegerTy(8))) {
+    auto byte = constant->isNullValue() ? mBuilder.getInt8(0) : constant;
+    mBuilder.CreateMemSet(dest, byte, bytes, AlignOf(arrayExpr->getType()));
+    return dest;
+  }
+
+  auto fn = currentFunction();
+  auto entryBB = mBuilder.GetInsertBlock();
+  auto bodyBB = llvm::BasicBlock::Create(mCtx, "array.init", fn);
+  auto endBB = llvm::BasicBlock::Create(mCtx, "array.init.end", fn);
+  mBuilder.CreateBr(bodyBB);
+  mBuilder.SetInsertPoint(bodyBB);
+  auto index = mBuilder.CreatePHI(i64, 2, "i");
+  index->addIncoming(llvm::ConstantInt::get(i64, 0), entryBB);
+  storeValue(elementAt(index), value, elemType);
+  auto next = mBuilder.CreateAdd(index, llvm::ConstantInt::get(i64, 1), "i.next", true, true);
+  index->addIncoming(next, bodyBB);
+  mBuilder.CreateCondBr(mBuilder.CreateICmpEQ(next, llvm::ConstantInt::get(i64, len)), endBB, bodyBB);
+  mBuilder.SetInsertPoint(endBB);
+  return dest;
+}
+// fields are stored in the order they are written, a packed struct only promises byte alignment for them
+auto IRGen::genStructExpr(StructExpr* structExpr, llvm::Value* dest) -> llvm::Value*
+{
+  auto type = structExpr->getType();
+  auto structTy = GenLLVMType(type, mCtx);
+  auto item = structExpr->mItem;
+  if (dest == nullptr) {
+    dest = createEntryAlloca(structTy, "structtmp", AlignOf(type));
+  }
+  for (auto& init : structExpr->mFields) {
+    auto value = genExpr(init.mValue.get());
+    if (value == nullptr) {
+      return nullptr;
+    }
+    auto fieldType = item->mFields[init.mIndex].mType.get();
+    auto address = mBuilder.CreateStructGEP(structTy, dest, StructElementIndex(item, init.mIndex), init.mName);
+    storeValue(address, value, fieldType, item->mPacked ? llvm::Align(1) : AlignOf(fieldType));
+  }
+  return dest;
+}
+// a tuple is an SSA value, its elements are extracted unless a place is needed anyway. Only aggregate elements are
+// used in place, like the fields of a struct
+auto IRGen::genTupleExpr(TupleExpr* tupleExpr) -> llvm::Value*
+{
+  auto tuple = tupleExpr->getType()->as<TupleType>();
+  auto elems = std::vector<llvm::Value*>{};
+  for (auto& elem : tupleExpr->mElems) {
+    elems.push_back(genExpr(elem.get()));
+    if (IsNever(elem.get())) {
+      return nullptr;
+    }
+  }
+  if (tuple->isUnit()) {
+    return nullptr;
+  }
+  auto value = static_cast<llvm::Value*>(llvm::UndefValue::get(GenLLVMType(tuple, mCtx)));
+  for (u32 i = 0; i < elems.size(); ++i) {
+    if (auto type = tuple->mTypes[i].get(); !IsZeroSized(type)) {
+      auto elem = loadIfAggregate(elems[i], type);
+      value = mBuilder.CreateInsertValue(value, elem, TupleElementIndex(tuple, i), "tuple");
+    }
+  }
+  return value;
+}
+auto IRGen::genFieldAddress(FieldExpr* fieldExpr) -> llvm::Value*
+{
+  auto baseType = fieldExpr->mBase->getType();
+  if (baseType->mKind == TypeBase::Kind::Tuple && IsZeroSized(fieldExpr->getType())) {
+    genExpr(fieldExpr->mBase.get());
+    return IsAggregate(fieldExpr->getType())
+               ? createEntryAlloca(GenLLVMType(fieldExpr->getType(), mCtx), fieldExpr->mField)
+               : nullptr;
+  }
+  auto base = genPlaceAddress(fieldExpr->mBase.get());
+  if (base == nullptr) {
+    return nullptr;
+  }
+  auto index = baseType->mKind == TypeBase::Kind::Tuple
+                   ? TupleElementIndex(baseType->as<TupleType>(), fieldExpr->mIndex)
+                   : StructElementIndex(baseType->as<StructType>()->mItem, fieldExpr->mIndex);
+  return mBuilder.CreateStructGEP(GenLLVMType(baseType, mCtx), base, index, fieldExpr->mField);
+}
+auto IRGen::genFieldExpr(FieldExpr* fieldExpr) -> llvm::Value*
+{
+  if (auto tuple = fieldExpr->mBase->getType(); tuple->mKind == TypeBase::Kind::Tuple &&
+                                                 !IsAggregate(fieldExpr->getType()) &&
+                                                 !IsZeroSized(fieldExpr->getType())) {
+    auto base = genExpr(fieldExpr->mBase.get());
+    if (base == nullptr) {
+      return nullptr;
+    }
+    auto index = TupleElementIndex(tuple->as<TupleType>(), fieldExpr->mIndex);
+    return mBuilder.CreateExtractValue(base, index, fieldExpr->mField);
+  }
+  auto address = genFieldAddress(fieldExpr);
+  if (address == nullptr) {
+    return nullptr;
+  }
+  return loadPlace(address, fieldExpr->getType(), PlaceAlign(fieldExpr), fieldExpr->mField);
+}
+// the value at a place, an aggregate is used in place unless it sits below its alignment. Then it is copied out so
+// everything else may assume aggregates are naturally aligned
+auto IRGen::loadPlace(llvm::Value* address, TypeBase const* type, llvm::Align align, llvm::StringRef name)
+    -> llvm::Value*
+{
+  if (!IsAggregate(type)) {
+    return mBuilder.CreateAlignedLoad(GenLLVMType(type, mCtx), address, align, name);
+  }
+  if (align >= AlignOf(type)) {
+    return address;
+  }
+  auto copy = createEntryAlloca(GenLLVMType(type, mCtx), "aggtmp", AlignOf(type));
+  mBuilder.CreateMemCpy(copy, AlignOf(type), address, align, LayoutOf(type).mSize);
+  return copy;
+}
+// the address of the value of an expression. Locals, fields and elements are addressed in place even where loadPlace
+// would copy them out, any other value that is not an aggregate is spilled to a temporary
+auto IRGen::genPlaceAddress(Expr* expr) -> llvm::Value*
+{
+  if (expr->mType == Expr::Type::WithoutBlock) {
+    switch (auto exprWithoutBlock = expr->as<ExprWithoutBlock>(); exprWithoutBlock->mType) {
+    case ExprWithoutBlock::Type::Grouped:
+      return genPlaceAddress(exprWithoutBlock->as<GroupedExpr>()->mExpr.get());
+    case ExprWithoutBlock::Type::Literal:
+      if (auto literalExpr = exprWithoutBlock->as<LiteralExpr>(); literalExpr->mItem != nullptr) {
+        if (literalExpr->mItem->mKind == Item::Kind::StaticItem) {
+          return declareStatic(literalExpr->mItem->as<StaticItem>());
+        }
+        break; // a const is a value, only an aggregate one has an address
+      } else if (literalExpr->mKind == LiteralExpr::Kind::Identifier) {
+        return mValues.lookupValue(std::get<std::string>(literalExpr->mValue));
+      }
+      break;
+    case ExprWithoutBlock::Type::Field:
+      return genFieldAddress(exprWithoutBlock->as<FieldExpr>());
+    case ExprWithoutBlock::Type::Index: {
+      auto indexExpr = exprWithoutBlock->as<IndexExpr>();
+      return genElementAddress(indexExpr->mBase.get(), indexExpr->mIndex.get(), indexExpr->mChecked);
+    }
+    case ExprWithoutBlock::Type::Operator:
+      if (auto unaryExpr = AsDeref(exprWithoutBlock)) {
+        return genExpr(unaryExpr->mRight.get());
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  auto value = genExpr(expr);
+  if (value == nullptr || IsAggregate(expr->getType())) {
+    return value;
+  }
+  auto slot = createEntryAlloca(value->getType(), "tupletmp", AlignOf(expr->getType()));
+  mBuilder.CreateAlignedStore(value, slot, AlignOf(expr->getType()));
+  return slot;
+}
+auto IRGen::genMethodCallExpr(MethodCallExpr* methodCallExpr) -> llvm::Value*
+{
+  switch (methodCallExpr->mBuiltin) {
+  case MethodCallExpr::Builtin::Len: {
+    auto receiver = genExpr(methodCallExpr->mReceiver.get());
+    if (receiver == nullptr) {
+      return nullptr;
+    }
+    if (auto type = methodCallExpr->mReceiver->getType(); IsArray(type)) {
+      return llvm::ConstantInt::get(llvm::Type::getInt64Ty(mCtx), type->as<ArrayType>()->mLen);
+    }
+    return mBuilder.CreateExtractValue(receiver, 1, "len");
+  }
+  case MethodCallExpr::Builtin::GetUnchecked: {
+    auto address = genElementAddress(methodCallExpr->mReceiver.get(), methodCallExpr->mArgs.front().get(), false);
+    auto align = ElementAlign(methodCallExpr->mReceiver.get());
+    return address == nullptr ? nullptr : loadPlace(address, methodCallExpr->getType(), align, "elemtmp");
+  }
+  case MethodCallExpr::Builtin::Unresolved:
+    break;
+  default:
+    return genVectorMethodCallExpr(methodCallExpr);
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+// lanes of a vector access in memory, unaligned ones only assume the alignment of a lane
+auto IRGen::genVectorAddress(Expr* memory, Expr* index, llvm::FixedVectorType* vecTy, bool aligned)
+    -> std::pair<llvm::Value*, llvm::Align>
+{
+  auto address = genElementAddress(memory, index, true, vecTy->getNumElements());
+  if (address == nullptr) {
+    return {nullptr, llvm::Align()};
+  }
+  auto const& layout = mModule->getDataLayout();
+  auto align = aligned ? llvm::Align(layout.getTypeStoreSize(vecTy).getFixedSize()) : ElementAlign(memory);
+  return {mBuilder.CreatePointerCast(address, vecTy->getPointerTo(), "lanes"), align};
+}
+auto IRGen::genVectorCallExpr(CallExpr* callExpr) -> llvm::Value*
+{
+  auto vecTy = llvm::cast<llvm::FixedVectorType>(GenLLVMType(callExpr->getType(), mCtx));
+  switch (callExpr->mBuiltin) {
+  case CallExpr::Builtin::Splat: {
+    auto value = genExpr(callExpr->mArgs.front().get());
+    return value == nullptr ? nullptr : mBuilder.CreateVectorSplat(vecTy->getNumElements(), value, "splat");
+  }
+  case CallExpr::Builtin::Load:
+  case CallExpr::Builtin::LoadAligned: {
+    auto aligned = callExpr->mBuiltin == CallExpr::Builtin::LoadAligned;
+    auto [address, align] = genVectorAddress(callExpr->mArgs[0].get(), callExpr->mArgs[1].get(), vecTy, aligned);
+    return address == nullptr ? nullptr : mBuilder.CreateAlignedLoad(vecTy, address, align, "vload");
+  }
+  case CallExpr::Builtin::None:
+    break;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+// float reductions may reassociate, the lanes are combined as a tree rather than in order
+auto IRGen::genVectorMethodCallExpr(MethodCallExpr* methodCallExpr) -> llvm::Value*
+{
+  using Builtin = MethodCallExpr::Builtin;
+  auto vecType = methodCallExpr->mReceiver->getType();
+  auto vector = genExpr(methodCallExpr->mReceiver.get());
+  if (vector == nullptr) {
+    return nullptr;
+  }
+  if (methodCallExpr->mBuiltin == Builtin::Store || methodCallExpr->mBuiltin == Builtin::StoreAligned) {
+    auto vecTy = llvm::cast<llvm::FixedVectorType>(vector->getType());
+    auto aligned = methodCallExpr->mBuiltin == Builtin::StoreAligned;
+    auto [address, align] =
+        genVectorAddress(methodCallExpr->mArgs[0].get(), methodCallExpr->mArgs[1].get(), vecTy, aligned);
+    if (address != nullptr) {
+      mBuilder.CreateAlignedStore(vector, address, align);
+    }
+    return nullptr;
+  }
+  auto args = std::vector<llvm::Value*>{};
+  for (auto& arg : methodCallExpr->mArgs) {
+    if (methodCallExpr->mBuiltin == Builtin::Shuffle && arg == methodCallExpr->mArgs.back()) {
+      break; // the lanes are taken from Sema
+    }
+    args.push_back(genExpr(arg.get()));
     if (args.back() == nullptr) {
       return nullptr;
     }
   }
-  return mBuilder.CreateCall(callee, args, "calltmp");
+  auto reassoc = [](llvm::Value* value) {
+    llvm::cast<llvm::Instruction>(value)->setHasAllowReassoc(true);
+    return value;
+  };
+  auto isFloat = IsFloat(vecType);
+  auto laneTy = vector->getType()->getScalarType();
+  switch (methodCallExpr->mBuiltin) {
+  case Builtin::Extract:
+    return mBuilder.CreateExtractElement(vector, args[0], "lane");
+  case Builtin::Insert:
+    return mBuilder.CreateInsertElement(vector, args[1], args[0], "insert");
+  case Builtin::Shuffle: {
+    auto mask = std::vector<int>(methodCallExpr->mShuffle.begin(), methodCallExpr->mShuffle.end());
+    return args.empty() ? mBuilder.CreateShuffleVector(vector, mask, "shuffle")
+                        : mBuilder.CreateShuffleVector(vector, args[0], mask, "shuffle");
+  }
+  case Builtin::ReduceAdd:
+    return isFloat ? reassoc(mBuilder.CreateFAddReduce(llvm::ConstantFP::getNegativeZero(laneTy), vector))
+                   : mBuilder.CreateAddReduce(vector);
+  case Builtin::ReduceMul:
+    return isFloat ? reassoc(mBuilder.CreateFMulReduce(llvm::ConstantFP::get(laneTy, 1.0), vector))
+                   : mBuilder.CreateMulReduce(vector);
+  case Builtin::ReduceMin:
+    return isFloat ? mBuilder.CreateFPMinReduce(vector) : mBuilder.CreateIntMinReduce(vector, IsSigned(vecType));
+  case Builtin::ReduceMax:
+    return isFloat ? mBuilder.CreateFPMaxReduce(vector) : mBuilder.CreateIntMaxReduce(vector, IsSigned(vecType));
+  case Builtin::Select:
+    return mBuilder.CreateSelect(vector, args[0], args[1], "select");
+  case Builtin::Any:
+    return mBuilder.CreateOrReduce(vector);
+  case Builtin::All:
+    return mBuilder.CreateAndReduce(vector);
+  default:
+    break;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+auto IRGen::genExprWithoutBlock(ExprWithoutBlock* exprWithoutBlock) -> llvm::Value*
+{
+  switch (exprWithoutBlock->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    return genLiteralExpr(exprWithoutBlock->as<LiteralExpr>());
+  case ExprWithoutBlock::Type::Grouped:
+    return genGroupedExpr(exprWithoutBlock->as<GroupedExpr>());
+  case ExprWithoutBlock::Type::Operator:
+    return genOperatorExpr(exprWithoutBlock->as<OperatorExpr>());
+  case ExprWithoutBlock::Type::Call:
+    return genCallExpr(exprWithoutBlock->as<CallExpr>());
+  case ExprWithoutBlock::Type::Return:
+    return genReturnExpr(exprWithoutBlock->as<ReturnExpr>());
+  case ExprWithoutBlock::Type::Index:
+    return genIndexExpr(exprWithoutBlock->as<IndexExpr>());
+  case ExprWithoutBlock::Type::MethodCall:
+    return genMethodCallExpr(exprWithoutBlock->as<MethodCallExpr>());
+  case ExprWithoutBlock::Type::Array:
+    return genArrayExpr(exprWithoutBlock->as<ArrayExpr>());
+  case ExprWithoutBlock::Type::Struct:
+    return genStructExpr(exprWithoutBlock->as<StructExpr>());
+  case ExprWithoutBlock::Type::Field:
+    return genFieldExpr(exprWithoutBlock->as<FieldExpr>());
+  case ExprWithoutBlock::Type::Tuple:
+    return genTupleExpr(exprWithoutBlock->as<TupleExpr>());
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+// the value of an if expression is merged with a PHI from the arms that fall through
+auto IRGen::genIfExpr(IfExpr* ifExpr) -> llvm::Value*
+{
+  if (auto budget = kSpeculationBudget; IsSelectable(ifExpr, budget)) {
+    return genSelectExpr(ifExpr);
+  }
+  auto cond = genExpr(ifExpr->mCond.get());
+  auto fn = currentFunction();
+  auto thenBB = llvm::BasicBlock::Create(mCtx, "if.then", fn);
+  auto elseBB = ifExpr->mElse ? llvm::BasicBlock::Create(mCtx, "if.else", fn) : nullptr;
+  auto mergeBB = llvm::BasicBlock::Create(mCtx, "if.end");
+  mBuilder.CreateCondBr(cond, thenBB, elseBB ? elseBB : mergeBB);
+
+  auto incoming = std::vector<std::pair<llvm::Value*, llvm::BasicBlock*>>{};
+  auto valueless = false;
+  auto genArm = [&](auto genBody) {
+    auto value = genBody();
+    auto block = mBuilder.GetInsertBlock();
+    if (branchIfLive(mergeBB)) {
+      incoming.emplace_back(value, block);
+      valueless |= value == nullptr;
+    }
+  };
+  mBuilder.SetInsertPoint(thenBB);
+  genArm([&] { return genBlockExpr(ifExpr->mThen.get()); });
+  if (elseBB) {
+    mBuilder.SetInsertPoint(elseBB);
+    genArm([&] { return genExprWithBlock(ifExpr->mElse.get()); });
+  } else {
+    valueless = true;
+  }
+
+  mergeBB->insertInto(fn);
+  mBuilder.SetInsertPoint(mergeBB);
+  if (valueless || incoming.empty()) {
+    return nullptr;
+  }
+  if (incoming.size() == 1) {
+    return incoming.front().first;
+  }
+  auto phi = mBuilder.CreatePHI(incoming.front().first->getType(), incoming.size(), "iftmp");
+  for (auto [value, block] : incoming) {
+    phi->addIncoming(value, block);
+  }
+  return phi;
+}
+// both arms are evaluated and the condition picks one, see IsSelectable
+auto IRGen::genSelectExpr(IfExpr* ifExpr) -> llvm::Value*
+{
+  auto cond = genExpr(ifExpr->mCond.get());
+  auto thenValue = genExpr(ifExpr->mThen->mReturn.get());
+  auto elseExpr = ifExpr->mElse.get();
+  auto elseValue = elseExpr->mType == ExprWithBlock::Type::If ? genSelectExpr(elseExpr->as<IfExpr>())
+                                                              : genExpr(elseExpr->as<BlockExpr>()->mReturn.get());
+  if (cond == nullptr) {
+    return nullptr;
+  }
+  return mBuilder.CreateSelect(cond, thenValue, elseValue, "iftmp");
+}
+auto IRGen::genLoopExpr(LoopExpr* loopExpr) -> llvm::Value*
+{
+  switch (loopExpr->mType) {
+  case LoopExpr::Type::InfiniteLoop:
+    return genInfiniteLoopExpr(loopExpr->as<InfiniteLoopExpr>());
+  case LoopExpr::Type::PredicateLoop:
+    return genPredicateLoopExpr(loopExpr->as<PredicateLoopExpr>());
+  case LoopExpr::Type::IteratorLoop:
+    return genIteratorLoopExpr(loopExpr->as<IteratorLoopExpr>());
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+// without `break` the loop has no exit, it is typed `!` and genExpr continues in a dead block
+auto IRGen::genInfiniteLoopExpr(InfiniteLoopExpr* infiniteLoopExpr) -> llvm::Value*
+{
+  auto bodyBB = llvm::BasicBlock::Create(mCtx, "loop.body", currentFunction());
+  mBuilder.CreateBr(bodyBB);
+  mBuilder.SetInsertPoint(bodyBB);
+  genBlockExpr(infiniteLoopExpr->mExpr.get());
+  if (branchIfLive(bodyBB)) {
+    setLoopHints(infiniteLoopExpr);
+  }
+  return nullptr;
+}
+// the hints go on the latch branch that was just emitted
+auto IRGen::setLoopHints(LoopExpr const* loopExpr) -> void
+{
+  if (auto id = GenLoopID(loopExpr->mHints, genLoopLocation(loopExpr), mCtx)) {
+    mBuilder.GetInsertBlock()->getTerminator()->setMetadata(llvm::LLVMContext::MD_loop, id);
+  }
+}
+// The location of the loop, or of its first attribute for a `loop` which keeps none. Like clang without -g, it lives in a compile unit that emits no debug
+// info, and its subprogram is not attached to the function, so the calls in it need no locations of their own. Lines
+// are counted here rather than by the SourceMgr, whose line cache is not safe to fill from the codegen worker
+auto IRGen::genLoopLocation(LoopExpr const* loopExpr) -> llvm::DILocation*
+{
+  if (mSrcMgr == nullptr || loopExpr->mAttrs.empty()) {
+    return nullptr;
+  }
+  auto loc = llvm::SMLoc::getFromPointer(loopExpr->mAttrs.front().mLoc);
+  if (loopExpr->mType == LoopExpr::Type::PredicateLoop) {
+    loc = llvm::SMLoc::getFromPointer(loopExpr->as<PredicateLoopExpr>()->getLoc());
+  } else if (loopExpr->mType == LoopExpr::Type::IteratorLoop) {
+    loc = llvm::SMLoc::getFromPointer(loopExpr->as<IteratorLoopExpr>()->getLoc());
+  }
+  auto bufferId = mSrcMgr->FindBufferContainingLoc(loc);
+  if (bufferId == 0) {
+    return nullptr;
+  }
+  auto buffer = mSrcMgr->getMemoryBuffer(bufferId);
+  auto before = llvm::StringRef(buffer->getBufferStart(), loc.getPointer() - buffer->getBufferStart());
+  auto line = static_cast<u32>(before.count('\n') + 1);
+  auto lineStart = before.rfind('\n');
+  auto column = static_cast<u32>(lineStart == llvm::StringRef::npos ? before.size() + 1 : before.size() - lineStart);
+
+  auto file = llvm::DIFile::get(mCtx, buffer->getBufferIdentifier(), "");
+  if (mLocationUnit == nullptr) {
+    auto builder = llvm::DIBuilder(*mModule);
+    mLocationUnit = builder.createCompileUnit(llvm::dwarf::DW_LANG_C, file, "rusty_c", true, "", 0, "",
+                                              llvm::DICompileUnit::NoDebug);
+    builder.finalize();
+    mModule->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+  }
+  auto& scope = mLoopScopes[currentFunction()];
+  if (scope == nullptr) {
+    auto name = currentFunction()->getName();
+    scope = llvm::DISubprogram::getDistinct(mCtx, file, name, name, file, line, nullptr, line, nullptr, 0, 0,
+                                            llvm::DINode::FlagZero, llvm::DISubprogram::SPFlagDefinition,
+                                            mLocationUnit);
+  }
+  return llvm::DILocation::get(mCtx, line, column, scope);
+}
+// header evaluates the condition, the end of the body is the latch branching back to it
+auto IRGen::genPredicateLoopExpr(PredicateLoopExpr* predicateExpr) -> llvm::Value*
+{
+  auto fn = currentFunction();
+  auto condBB = llvm::BasicBlock::Create(mCtx, "while.cond", fn);
+  auto bodyBB = llvm::BasicBlock::Create(mCtx, "while.body", fn);
+  auto endBB = llvm::BasicBlock::Create(mCtx, "while.end", fn);
+  mBuilder.CreateBr(condBB);
+
+  mBuilder.SetInsertPoint(condBB);
+  mBuilder.CreateCondBr(genExpr(predicateExpr->mCond.get()), bodyBB, endBB);
+
+  mBuilder.SetInsertPoint(bodyBB);
+  genBlockExpr(predicateExpr->mExpr.get());
+  if (branchIfLive(condBB)) {
+    setLoopHints(predicateExpr);
+  }
+  mBuilder.SetInsertPoint(endBB);
+  return nullptr;
+}
+// A counted loop in the shape LLVM's own loops have: the trip count is computed once in the preheader, a guard skips
+// an empty range and the only induction variable counts from 0 up to the trip count, so the trip count is known to
+// SCEV. The loop variable `start + n * step` is stored to a slot of its own every iteration, assigning it in the body
+// does not change the iteration. A step that is not positive traps
+auto IRGen::genIteratorLoopExpr(IteratorLoopExpr* iteratorExpr) -> llvm::Value*
+{
+  auto type = iteratorExpr->mStart->getType();
+  auto start = genExpr(iteratorExpr->mStart.get());
+  auto end = start == nullptr ? nullptr : genExpr(iteratorExpr->mEnd.get());
+  auto step = end == nullptr || iteratorExpr->mStep == nullptr ? nullptr : genExpr(iteratorExpr->mStep.get());
+  if (end == nullptr || (iteratorExpr->mStep != nullptr && step == nullptr)) {
+    return nullptr;
+  }
+  auto fn = currentFunction();
+  auto isSigned = IsSigned(type);
+  auto zero = llvm::ConstantInt::get(start->getType(), 0);
+  auto one = llvm::ConstantInt::get(start->getType(), 1);
+  if (step != nullptr) {
+    auto positive =
+        isSigned ? mBuilder.CreateICmpSGT(step, zero, "step.ok") : mBuilder.CreateICmpNE(step, zero, "step.ok");
+    auto okBB = llvm::BasicBlock::Create(mCtx, "for.step", fn);
+    mBuilder.CreateCondBr(positive, okBB, trapBlock(), llvm::MDBuilder(mCtx).createBranchWeights(1 << 20, 1));
+    mBuilder.SetInsertPoint(okBB);
+  }
+  auto preheaderBB = llvm::BasicBlock::Create(mCtx, "for.preheader", fn);
+  auto bodyBB = llvm::BasicBlock::Create(mCtx, "for.body", fn);
+  auto endBB = llvm::BasicBlock::Create(mCtx, "for.end", fn);
+  auto nonEmpty =
+      isSigned ? mBuilder.CreateICmpSLT(start, end, "for.guard") : mBuilder.CreateICmpULT(start, end, "for.guard");
+  mBuilder.CreateCondBr(nonEmpty, preheaderBB, endBB);
+
+  // `end - start` is taken unsigned, it cannot wrap once `start < end`
+  mBuilder.SetInsertPoint(preheaderBB);
+  auto distance = mBuilder.CreateSub(end, start, "distance", !isSigned);
+  auto tripCount = distance;
+  if (step != nullptr) {
+    auto last = mBuilder.CreateUDiv(mBuilder.CreateNUWSub(distance, one), step);
+    tripCount = mBuilder.CreateNUWAdd(last, one, "trip.count");
+  }
+  auto slot = createEntryAlloca(start->getType(), iteratorExpr->mName);
+  mBuilder.CreateBr(bodyBB);
+
+  mBuilder.SetInsertPoint(bodyBB);
+  auto index = mBuilder.CreatePHI(start->getType(), 2, "for.index");
+  index->addIncoming(zero, preheaderBB);
+  auto offset = step == nullptr ? static_cast<llvm::Value*>(index) : mBuilder.CreateNUWMul(index, step);
+  mBuilder.CreateStore(mBuilder.CreateAdd(start, offset, iteratorExpr->mName, !isSigned), slot);
+  {
+    auto guard = enterScope();
+    mValues.insertValue(iteratorExpr->mName, slot);
+    genBlockExpr(iteratorExpr->mExpr.get());
+  }
+  if (hasLiveInsertPoint()) {
+    auto next = mBuilder.CreateNUWAdd(index, one, "for.next");
+    index->addIncoming(next, mBuilder.GetInsertBlock());
+    mBuilder.CreateCondBr(mBuilder.CreateICmpNE(next, tripCount, "for.cond"), bodyBB, endBB);
+    setLoopHints(iteratorExpr);
+  } else if (mBuilder.GetInsertBlock()->getTerminator() == nullptr) {
+    mBuilder.CreateUnreachable();
+  }
+  mBuilder.SetInsertPoint(endBB);
+  return nullptr;
 }
-auto IRGen::genReturnExpr(ReturnExpr* returnExpr) -> llvm::Value* {}
-auto IRGen::genExprWithoutBlock(ExprWithoutBlock* exprWithoutBlock) -> llvm::Value* {}
-auto IRGen::genIfExpr(IfExpr* ifExpr) -> llvm::Value* {}
-auto IRGen::genLoopExpr(LoopExpr* loopExpr) -> llvm::Value* {}
-auto IRGen::genInfiniteLoopExpr(InfiniteLoopExpr* infiniteLoopExpr) -> llvm::Value* {}
-auto IRGen::genPredicateLoopExpr(PredicateLoopExpr* predicateExpr) -> llvm::Value* {}
 
 auto IRGen::genExternalBlockItem(ExternalBlockItem* externalBlockItem) -> void
 {
   for (auto& item : externalBlockItem->mItems) {
     assert(item->isDeclaration());
-    auto llvmFnTy = llvm::dyn_cast<llvm::FunctionType>(GenLLVMType(item->mFnType.get(), mCtx));
-    auto llvmFn = llvm::Function::Create(llvmFnTy, llvm::Function::ExternalLinkage, item->mName, mModule.get());
-    for (auto& arg : llvmFn->args()) {
-      arg.setName(item->mParamNames[arg.getArgNo()]);
-    }
+    declareFunction(item.get());
   }
 }
 
@@ -217,34 +2044,95 @@ static auto GenLLVMType(TypeBase const* ty, llvm::LLVMContext& ctx) -> llvm::Typ
   case TypeBase::Kind::F64:
     return llvm::Type::getDoubleTy(ctx);
   case TypeBase::Kind::Functions: {
+    // large aggregates go by pointer, the result to a slot of the caller passed first
     auto fnTy = ty->as<FunctionType>();
     auto retTy = GenLLVMType(fnTy->mRet.get(), ctx);
     auto paramTys = std::vector<llvm::Type*>{};
+    if (HasReturnSlot(fnTy)) {
+      paramTys.push_back(llvm::PointerType::getUnqual(retTy));
+      retTy = llvm::Type::getVoidTy(ctx);
+    }
     for (auto& paramTy : fnTy->mParams) {
-      paramTys.push_back(GenLLVMType(paramTy.get(), ctx));
+      if (IsUnit(paramTy.get())) {
+        continue;
+      }
+      auto lowered = GenLLVMType(paramTy.get(), ctx);
+      paramTys.push_back(IsIndirect(paramTy.get()) ? llvm::PointerType::getUnqual(lowered) : lowered);
     }
     return llvm::FunctionType::get(retTy, paramTys, false);
   }
   case TypeBase::Kind::Tuple: {
+    // a small one is returned in registers, a large one through a hidden pointer by the backend
     auto tupleTy = ty->as<TupleType>();
     if (tupleTy->isUnit()) {
       return llvm::Type::getVoidTy(ctx);
-    } else {
-      utils::Unimplemented(utils::SrcLoc::current());
     }
+    auto i8 = llvm::Type::getInt8Ty(ctx);
+    auto padding = TuplePadding(tupleTy);
+    auto elems = std::vector<llvm::Type*>{};
+    for (u32 i = 0; i < tupleTy->mTypes.size(); ++i) {
+      if (padding[i] != 0) {
+        elems.push_back(llvm::ArrayType::get(i8, padding[i]));
+      }
+      if (!IsZeroSized(tupleTy->mTypes[i].get())) {
+        elems.push_back(GenLLVMType(tupleTy->mTypes[i].get(), ctx));
+      }
+    }
+    if (padding.back() != 0) {
+      elems.push_back(llvm::ArrayType::get(i8, padding.back()));
+    }
+    return llvm::StructType::get(ctx, elems);
+  }
+  case TypeBase::Kind::Never: // only as a return type, calls are followed by `unreachable`
+    return llvm::Type::getVoidTy(ctx);
+  case TypeBase::Kind::Slice: {
+    auto elemTy = GenLLVMType(ty->as<SliceType>()->mElem.get(), ctx);
+    return llvm::StructType::get(ctx, {elemTy->getPointerTo(), llvm::Type::getInt64Ty(ctx)});
+  }
+  case TypeBase::Kind::Array: {
+    auto arrayTy = ty->as<ArrayType>();
+    return llvm::ArrayType::get(GenLLVMType(arrayTy->mElem.get(), ctx), arrayTy->mLen);
+  }
+  case TypeBase::Kind::Vector: {
+    auto vecTy = ty->as<VectorType>();
+    return llvm::FixedVectorType::get(GenLLVMType(vecTy->mElem.get(), ctx), vecTy->mLanes);
+  }
+  case TypeBase::Kind::Struct: {
+    // packed with explicit padding so the offsets are the ones Sema chose, named as a field may be a slice of the
+    // struct itself
+    auto item = ty->as<StructType>()->mItem;
+    if (auto structTy = llvm::StructType::getTypeByName(ctx, item->mName)) {
+      return structTy;
+    }
+    auto structTy = llvm::StructType::create(ctx, item->mName);
+    auto i8 = llvm::Type::getInt8Ty(ctx);
+    auto elems = std::vector<llvm::Type*>{};
+    auto offset = u64{0};
+    for (auto i : item->mLayout.mMemoryOrder) {
+      auto fieldType = item->mFields[i].mType.get();
+      if (auto hole = item->mLayout.mOffsets[i] - offset; hole != 0) {
+        elems.push_back(llvm::ArrayType::get(i8, hole));
+      }
+      elems.push_back(GenLLVMType(fieldType, ctx));
+      offset = item->mLayout.mOffsets[i] + LayoutOf(fieldType).mSize;
+    }
+    if (auto tail = item->mLayout.mSize - offset; tail != 0) {
+      elems.push_back(llvm::ArrayType::get(i8, tail));
+    }
+    structTy->setBody(elems, true);
+    return structTy;
+  }
+  case TypeBase::Kind::Reference:
+  case TypeBase::Kind::RawPointer: {
+    // a pointer to nothing sized still needs a pointee type
+    auto pointeeTy = GenLLVMType(PointeeType(ty), ctx);
+    return llvm::PointerType::getUnqual(pointeeTy->isVoidTy() ? llvm::Type::getInt8Ty(ctx) : pointeeTy);
   }
   case TypeBase::Kind::Char:
   case TypeBase::Kind::Str:
-  case TypeBase::Kind::Never:
-  case TypeBase::Kind::Array:
-  case TypeBase::Kind::Slice:
-  case TypeBase::Kind::Struct:
   case TypeBase::Kind::Enum:
   case TypeBase::Kind::Union:
-
   case TypeBase::Kind::Closures:
-  case TypeBase::Kind::Reference:
-  case TypeBase::Kind::RawPointer:
   case TypeBase::Kind::FunctionPointer:
   case TypeBase::Kind::TraitObjects:
   case TypeBase::Kind::ImplTrait:
@@ -253,4 +2141,5 @@ static auto GenLLVMType(TypeBase const* ty, llvm::LLVMContext& ctx) -> llvm::Typ
     utils::Unimplemented(utils::SrcLoc::current());
     break;
   }
-}
\ No newline at end of file
+  utils::Unreachable(utils::SrcLoc::current());
+}
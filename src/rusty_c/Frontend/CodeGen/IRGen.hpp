@@ -1,10 +1,14 @@
+#pragma once
+
 #include "../Sema/Scope.hpp"
 #include "../common.hpp"
+#include "CopyElision.hpp"
 
 #include <llvm/ADT/APFloat.h>
 #include <llvm/ADT/STLExtras.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Constants.h>
+#include <llvm/IR/DebugInfoMetadata.h>
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/IRBuilder.h>
@@ -12,55 +16,143 @@
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Support/SourceMgr.h>
 #include <stack>
+#include <unordered_map>
+
+// stack slots of the locals of the function being generated, null for unit typed ones. An aggregate passed or returned
+// through a pointer uses the memory behind it as its slot. Types come from the AST so nothing of Sema's scopes is needed
+class ValueScopes {
+  std::vector<std::unordered_map<std::string, llvm::Value*>> mScopes;
+
+public:
+  auto enterScope() -> void { mScopes.emplace_back(); }
+  auto leaveScope() -> void { mScopes.pop_back(); }
+  auto insertValue(std::string const& name, llvm::Value* slot) -> void { mScopes.back()[name] = slot; }
+  auto lookupValue(std::string const& name) const -> llvm::Value*
+  {
+    for (auto it = mScopes.rbegin(); it != mScopes.rend(); ++it) {
+      if (auto found = it->find(name); found != it->end()) {
+        return found->second;
+      }
+    }
+    return nullptr;
+  }
+};
+
+// the symbol of a static of the crate `modname` was generated from, and giving the statics of a module holding the whole
+// crate internal linkage
+auto StaticSymbolName(llvm::StringRef modname, llvm::StringRef name) -> std::string;
+auto InternalizeStatics(llvm::Module& module) -> void;
 
 class IRGen {
+  // per function being generated, nested functions are generated in the middle of their parent
+  struct FunctionState {
+    llvm::Function* mFn;
+    llvm::Value* mReturnSlot = nullptr;    // the `sret` argument
+    LetStmt const* mNamedReturn = nullptr; // built right in the return slot
+    CopyElisionAnalysis mElision;
+  };
+
   llvm::LLVMContext& mCtx;
   llvm::IRBuilder<> mBuilder;
   std::unique_ptr<llvm::Module> mModule;
+  llvm::SourceMgr const* mSrcMgr = nullptr; // to locate loop hints, the optimizer reports unhonoured ones there
+  llvm::DICompileUnit* mLocationUnit = nullptr; // created with the first located loop, emits no debug info
 
-  ScopeRecord mRecord;
+  ValueScopes mValues;
+  std::unordered_map<FunctionItem const*, llvm::Function*> mNestedFunctions;
+  std::unordered_map<llvm::Function*, llvm::BasicBlock*> mTrapBlocks;
+  std::unordered_map<ConstantItem const*, llvm::GlobalVariable*> mConstants; // the aggregate consts used in the module
+  std::unordered_map<llvm::Function*, llvm::DISubprogram*> mLoopScopes;
 
-  std::stack<llvm::Function*> mFunctionStack;
+  std::stack<FunctionState> mFunctionStack;
 
 public:
-  IRGen(llvm::LLVMContext& ctx, std::string_view modname, ScopeRecord&& record)
-      : mCtx(ctx), mBuilder(ctx), mModule(std::make_unique<llvm::Module>(modname, ctx)), mRecord(std::move(record))
+  IRGen(llvm::LLVMContext& ctx, std::string_view modname)
+      : mCtx(ctx), mBuilder(ctx), mModule(std::make_unique<llvm::Module>(modname, ctx))
   {
   }
   ~IRGen() = default;
 
   auto genCrate(Crate* crate) -> void;
+  // generates a single item into the module, callees are only declared
+  auto genItem(Item* item) -> void;
+
+  auto setSourceMgr(llvm::SourceMgr const* srcMgr) -> void { mSrcMgr = srcMgr; }
+  auto getModule() -> llvm::Module* { return mModule.get(); }
+  auto takeModule() -> std::unique_ptr<llvm::Module> { return std::move(mModule); }
 
 private:
   auto genStmt(Stmt* stmt) -> void;
   auto genExprStmt(ExprStmt* exprStmt) -> void;
   auto genLetStmt(LetStmt* letStmt) -> void;
 
-  auto genItem(Item* item) -> void;
   auto genFunctionItem(FunctionItem* functionItem) -> void;
   auto genExternalBlockItem(ExternalBlockItem* externalBlockItem) -> void;
+  auto declareFunction(FunctionItem const* functionItem) -> llvm::Function*;
+  auto declareNestedFunction(FunctionItem const* functionItem) -> llvm::Function*;
+  auto declareStatic(StaticItem const* staticItem) -> llvm::GlobalVariable*;
+  auto genConstantAddress(ConstantItem const* constantItem) -> llvm::GlobalVariable*;
+  auto genConstant(Expr* expr) -> llvm::Constant*;
+
+  auto createEntryAlloca(llvm::Type* type, llvm::StringRef name, llvm::MaybeAlign align = {}) -> llvm::AllocaInst*;
+  auto hasLiveInsertPoint() -> bool;
+  auto branchIfLive(llvm::BasicBlock* dest) -> bool;
+  auto setLoopHints(LoopExpr const* loopExpr) -> void;
+  auto genLoopLocation(LoopExpr const* loopExpr) -> llvm::DILocation*;
+  auto startDeadBlock() -> void;
 
   auto genExpr(Expr* expr) -> llvm::Value*;
-  auto genBlockExpr(BlockExpr* blockExpr) -> llvm::Value*;
+  auto genExprWithBlock(ExprWithBlock* exprWithBlock) -> llvm::Value*;
+  auto genBlockExpr(BlockExpr* blockExpr, llvm::Value* dest = nullptr) -> llvm::Value*;
   auto genLiteralExpr(LiteralExpr* literalExpr) -> llvm::Value*;
   auto genGroupedExpr(GroupedExpr* groupedExpr) -> llvm::Value*;
   auto genOperatorExpr(OperatorExpr* operatorExpr) -> llvm::Value*;
   auto genBinaryExpr(BinaryExpr* binaryExpr) -> llvm::Value*;
   auto genUnaryExpr(UnaryExpr* unaryExpr) -> llvm::Value*;
-  auto genCallExpr(CallExpr* callExpr) -> llvm::Value*;
+  auto genAssignment(BinaryExpr* binaryExpr) -> llvm::Value*;
+  auto genLogicalExpr(BinaryExpr* binaryExpr) -> llvm::Value*;
+  auto genCallExpr(CallExpr* callExpr, llvm::Value* dest = nullptr) -> llvm::Value*;
+  auto genArgument(Expr* arg, FunctionItem const* callee) -> llvm::Value*;
+  auto genCCallExpr(CallExpr* callExpr, llvm::Function* callee, llvm::Value* dest) -> llvm::Value*;
+  auto spillValue(llvm::Value* value, TypeBase const* type) -> llvm::Value*;
+  auto coerceToC(llvm::Value* value, TypeBase const* type, llvm::Type* coerced) -> llvm::Value*;
+  auto coerceFromC(llvm::Value* value, TypeBase const* type, llvm::Type* coerced, llvm::Value* dest) -> llvm::Value*;
   auto genReturnExpr(ReturnExpr* returnExpr) -> llvm::Value*;
+  auto genIndexExpr(IndexExpr* indexExpr) -> llvm::Value*;
+  auto genMethodCallExpr(MethodCallExpr* methodCallExpr) -> llvm::Value*;
+  auto genElementAddress(Expr* base, Expr* index, bool checked, u32 count = 1) -> llvm::Value*;
+  auto genVectorAddress(Expr* memory, Expr* index, llvm::FixedVectorType* vecTy, bool aligned)
+      -> std::pair<llvm::Value*, llvm::Align>;
+  auto genVectorCallExpr(CallExpr* callExpr) -> llvm::Value*;
+  auto genVectorMethodCallExpr(MethodCallExpr* methodCallExpr) -> llvm::Value*;
+  auto genArrayExpr(ArrayExpr* arrayExpr, llvm::Value* dest = nullptr) -> llvm::Value*;
+  auto genStructExpr(StructExpr* structExpr, llvm::Value* dest = nullptr) -> llvm::Value*;
+  auto genFieldAddress(FieldExpr* fieldExpr) -> llvm::Value*;
+  auto genFieldExpr(FieldExpr* fieldExpr) -> llvm::Value*;
+  auto genTupleExpr(TupleExpr* tupleExpr) -> llvm::Value*;
+  auto genPlaceAddress(Expr* expr) -> llvm::Value*;
+  auto loadPlace(llvm::Value* address, TypeBase const* type, llvm::Align align, llvm::StringRef name) -> llvm::Value*;
+  auto genAggregateInto(Expr* expr, llvm::Value* dest) -> llvm::Value*;
+  auto storeValue(llvm::Value* dest, llvm::Value* value, TypeBase const* type, llvm::MaybeAlign destAlign = {}) -> void;
+  auto loadIfAggregate(llvm::Value* value, TypeBase const* type) -> llvm::Value*;
+  auto trapBlock() -> llvm::BasicBlock*;
   auto genExprWithoutBlock(ExprWithoutBlock* exprWithoutBlock) -> llvm::Value*;
   auto genIfExpr(IfExpr* ifExpr) -> llvm::Value*;
+  auto genSelectExpr(IfExpr* ifExpr) -> llvm::Value*;
   auto genLoopExpr(LoopExpr* loopExpr) -> llvm::Value*;
   auto genInfiniteLoopExpr(InfiniteLoopExpr* infiniteLoopExpr) -> llvm::Value*;
   auto genPredicateLoopExpr(PredicateLoopExpr* predicateExpr) -> llvm::Value*;
+  auto genIteratorLoopExpr(IteratorLoopExpr* iteratorExpr) -> llvm::Value*;
 
-  auto lookupIdentifier(std::string const& name) -> TypeBase* { return mRecord.lookupIdentifier(name); }
-  auto lookupItem(std::string const& name) -> Item* { return mRecord.lookupItem(name); };
-
-  auto pushFunction(llvm::Function* func) -> void { mFunctionStack.push(func); }
+  auto pushFunction(llvm::Function* func) -> FunctionState&
+  {
+    mFunctionStack.push({func});
+    return mFunctionStack.top();
+  }
   auto popFunction() -> void { mFunctionStack.pop(); }
-  auto currentFunction() -> llvm::Function* { return mFunctionStack.top(); }
-  auto enterScope() -> ScopeGuard<ScopeRecord> { return ScopeGuard(mRecord); }
-};
\ No newline at end of file
+  auto currentFunction() -> llvm::Function* { return mFunctionStack.top().mFn; }
+  auto currentState() -> FunctionState& { return mFunctionStack.top(); }
+  auto enterScope() -> ScopeGuard<ValueScopes> { return ScopeGuard(mValues); }
+};
@@ -0,0 +1,151 @@
+#include "Pipeline.hpp"
+#include "utils/utils.hpp"
+
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/Linker/Linker.h>
+
+CodeGenPipeline::CodeGenPipeline(llvm::LLVMContext& ctx, std::string_view modname, llvm::SourceMgr const* srcMgr)
+    : mCtx(ctx), mModuleName(modname), mSrcMgr(srcMgr), mWorker([this] { run(); })
+{
+}
+
+CodeGenPipeline::~CodeGenPipeline()
+{
+  close();
+  if (mWorker.joinable()) {
+    mWorker.join();
+  }
+}
+
+auto CodeGenPipeline::enqueue(Item* item) -> void
+{
+  {
+    auto lock = std::lock_guard(mMutex);
+    assert(!mClosed && "enqueue after finish");
+    mQueue.push_back(item);
+  }
+  mCond.notify_one();
+}
+
+auto CodeGenPipeline::close() -> void
+{
+  {
+    auto lock = std::lock_guard(mMutex);
+    mClosed = true;
+  }
+  mCond.notify_one();
+}
+
+auto CodeGenPipeline::run() -> void
+{
+  while (true) {
+    Item* item = nullptr;
+    {
+      auto lock = std::unique_lock(mMutex);
+      mCond.wait(lock, [this] { return mClosed || !mQueue.empty(); });
+      if (mQueue.empty()) {
+        return;
+      }
+      item = mQueue.front();
+      mQueue.pop_front();
+    }
+    // named after the crate, which qualifies the names of statics
+    auto gen = IRGen{mCtx, mModuleName};
+    gen.setSourceMgr(mSrcMgr);
+    gen.genItem(item);
+    gen.getModule()->setModuleIdentifier(utils::format("{}.{}", mModuleName, mModules.size()));
+    mModules.push_back(gen.takeModule());
+  }
+}
+
+// marks everything reachable from the roots the way ReachabilityAnalysis does on the crate, every top-level function
+// is a root if there is no `main`. Unmarked functions and globals are removed, along with declarations nothing uses
+static auto RemoveUnreachable(llvm::Module& module, std::vector<std::string> const& exported) -> void
+{
+  auto live = llvm::SmallPtrSet<llvm::GlobalValue*, 32>{};
+  auto worklist = std::vector<llvm::GlobalValue*>{};
+  auto markConstant = [&](llvm::Constant* root) {
+    auto constants = std::vector<llvm::Constant*>{root};
+    while (!constants.empty()) {
+      auto c = constants.back();
+      constants.pop_back();
+      if (auto gv = llvm::dyn_cast<llvm::GlobalValue>(c)) {
+        if (live.insert(gv).second) {
+          worklist.push_back(gv);
+        }
+        continue;
+      }
+      for (auto& op : c->operands()) {
+        constants.push_back(llvm::cast<llvm::Constant>(op));
+      }
+    }
+  };
+
+  auto main = module.getFunction("main");
+  for (auto& fn : module) {
+    auto isRoot = main != nullptr && !main->isDeclaration()
+                      ? &fn == main || llvm::is_contained(exported, fn.getName())
+                      : fn.hasExternalLinkage();
+    if (isRoot && !fn.isDeclaration()) {
+      markConstant(&fn);
+    }
+  }
+  for (auto& gv : module.global_values()) {
+    if (gv.getName().startswith("llvm.")) {
+      markConstant(&gv);
+    }
+  }
+  while (!worklist.empty()) {
+    auto gv = worklist.back();
+    worklist.pop_back();
+    if (auto var = llvm::dyn_cast<llvm::GlobalVariable>(gv); var && var->hasInitializer()) {
+      markConstant(var->getInitializer());
+    } else if (auto fn = llvm::dyn_cast<llvm::Function>(gv)) {
+      for (auto& inst : llvm::instructions(fn)) {
+        for (auto& op : inst.operands()) {
+          if (auto c = llvm::dyn_cast<llvm::Constant>(op)) {
+            markConstant(c);
+          }
+        }
+      }
+    }
+  }
+
+  // dead values may refer to each other, drop every reference before erasing any of them
+  auto dead = std::vector<llvm::GlobalValue*>{};
+  for (auto& gv : module.global_values()) {
+    if (live.contains(&gv)) {
+      continue;
+    }
+    if (auto fn = llvm::dyn_cast<llvm::Function>(&gv)) {
+      fn->dropAllReferences();
+    } else if (auto var = llvm::dyn_cast<llvm::GlobalVariable>(&gv)) {
+      var->setInitializer(nullptr);
+    }
+    dead.push_back(&gv);
+  }
+  for (auto gv : dead) {
+    gv->removeDeadConstantUsers();
+    gv->eraseFromParent();
+  }
+}
+
+auto CodeGenPipeline::finish(std::vector<std::string> const& exported) -> std::unique_ptr<llvm::Module>
+{
+  close();
+  mWorker.join();
+
+  auto result = std::make_unique<llvm::Module>(mModuleName, mCtx);
+  auto linker = llvm::Linker(*result);
+  for (auto& module : mModules) {
+    if (linker.linkInModule(std::move(module))) {
+      utils::Unreachable(utils::SrcLoc::current(), "failed to link module of {}", mModuleName);
+    }
+  }
+  mModules.clear();
+  InternalizeStatics(*result);
+  RemoveUnreachable(*result, exported);
+  return result;
+}
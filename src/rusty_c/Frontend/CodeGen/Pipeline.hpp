@@ -0,0 +1,38 @@
+#pragma once
+
+#include "IRGen.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Lowers functions on a worker thread while Sema is still checking the rest of the crate. Each queued item gets a
+// module of its own, the modules are linked in queue order by finish(). The context belongs to the worker until then.
+class CodeGenPipeline {
+  llvm::LLVMContext& mCtx;
+  std::string mModuleName;
+  llvm::SourceMgr const* mSrcMgr;
+
+  std::mutex mMutex;
+  std::condition_variable mCond;
+  std::deque<Item*> mQueue;
+  bool mClosed = false;
+
+  std::vector<std::unique_ptr<llvm::Module>> mModules;
+  std::thread mWorker;
+
+public:
+  CodeGenPipeline(llvm::LLVMContext& ctx, std::string_view modname, llvm::SourceMgr const* srcMgr = nullptr);
+  ~CodeGenPipeline();
+
+  // the item must not be modified any more once it is queued
+  auto enqueue(Item* item) -> void;
+  // waits for the queue to drain and links the modules. Reachability was decided before const folding, definitions that
+  // are no longer used from `main` or an exported symbol are removed here
+  auto finish(std::vector<std::string> const& exported = {}) -> std::unique_ptr<llvm::Module>;
+
+private:
+  auto run() -> void;
+  auto close() -> void;
+};
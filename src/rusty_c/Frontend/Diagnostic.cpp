@@ -1,4 +1,8 @@
 #include "Diagnostic.hpp"
+
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+
 static char const* gDiagnosticText[] = {
 #define DIAG(id, level, msg) msg,
 #include "Diagnostic.def"
@@ -9,6 +13,11 @@ static llvm::SourceMgr::DiagKind gDiagnosticKind[] = {
 #include "Diagnostic.def"
 };
 
+static char const* gDiagnosticName[] = {
+#define DIAG(id, level, msg) #id,
+#include "Diagnostic.def"
+};
+
 auto DiagnosticsEngine::GetDiagnosticText(DiagId id) -> char const*
 {
   return gDiagnosticText[static_cast<std::underlying_type_t<DiagId>>(id)];
@@ -18,3 +27,153 @@ auto DiagnosticsEngine::GetDiagnosticKind(DiagId id) -> llvm::SourceMgr::DiagKin
 {
   return gDiagnosticKind[static_cast<std::underlying_type_t<DiagId>>(id)];
 }
+
+auto DiagnosticsEngine::GetDiagnosticName(DiagId id) -> char const*
+{
+  return gDiagnosticName[static_cast<std::underlying_type_t<DiagId>>(id)];
+}
+
+static auto KindToString(llvm::SourceMgr::DiagKind kind) -> char const*
+{
+  switch (kind) {
+  case llvm::SourceMgr::DK_Error:
+    return "error";
+  case llvm::SourceMgr::DK_Warning:
+    return "warning";
+  case llvm::SourceMgr::DK_Remark:
+    return "remark";
+  case llvm::SourceMgr::DK_Note:
+    return "note";
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+void DiagnosticsEngine::emit(Diagnostic&& diag)
+{
+  if (GetDiagnosticKind(diag.mId) == llvm::SourceMgr::DK_Error) {
+    if (u32 count = mNumErrors.fetch_add(1); mErrorLimit != 0 && count >= mErrorLimit) {
+      ++mNumSuppressed;
+      return;
+    }
+  }
+  std::lock_guard lock{mMutex};
+  mDiagnostics.push_back(std::move(diag));
+}
+
+namespace {
+struct ResolvedDiagnostic {
+  DiagId id;
+  llvm::SMLoc loc;
+  u32 bufferId; // 0 if the location is not in any buffer
+  u32 line;
+  u32 column;
+  std::string message;
+};
+} // namespace
+
+auto DiagnosticsEngine::flush(llvm::raw_ostream& os) -> void
+{
+  std::vector<Diagnostic> diagnostics;
+  {
+    std::lock_guard lock{mMutex};
+    diagnostics.swap(mDiagnostics);
+  }
+  if (u32 suppressed = mNumSuppressed.exchange(0); suppressed != 0) {
+    Diagnostic note{DiagId::NoteErrorLimitReached, llvm::SMLoc(), {}};
+    PackArg(note.mArgs, mErrorLimit);
+    PackArg(note.mArgs, suppressed);
+    diagnostics.push_back(std::move(note));
+  }
+  if (diagnostics.empty()) {
+    return;
+  }
+
+  std::vector<ResolvedDiagnostic> resolved;
+  resolved.reserve(diagnostics.size());
+  for (auto& diag : diagnostics) {
+    ResolvedDiagnostic r{diag.mId, diag.mLoc, 0, 0, 0, {}};
+    if (diag.mLoc.isValid()) {
+      r.bufferId = mSrcMgr.FindBufferContainingLoc(diag.mLoc);
+      if (r.bufferId != 0) {
+        std::tie(r.line, r.column) = mSrcMgr.getLineAndColumn(diag.mLoc, r.bufferId);
+      }
+    }
+    r.message = utils::vformat(GetDiagnosticText(diag.mId), diag.mArgs);
+    resolved.push_back(std::move(r));
+  }
+
+  // located diagnostics in source order, unlocated ones keep their report order at the end
+  std::stable_sort(resolved.begin(), resolved.end(), [](ResolvedDiagnostic const& lhs, ResolvedDiagnostic const& rhs) {
+    auto lhsKey = std::tuple(lhs.bufferId == 0, lhs.bufferId, lhs.line, lhs.column);
+    auto rhsKey = std::tuple(rhs.bufferId == 0, rhs.bufferId, rhs.line, rhs.column);
+    return lhsKey < rhsKey;
+  });
+  resolved.erase(std::unique(resolved.begin(), resolved.end(),
+                             [](ResolvedDiagnostic const& lhs, ResolvedDiagnostic const& rhs) {
+                               return lhs.id == rhs.id && lhs.loc == rhs.loc && lhs.message == rhs.message;
+                             }),
+                 resolved.end());
+
+  auto fileName = [this](ResolvedDiagnostic const& diag) -> llvm::StringRef {
+    return diag.bufferId == 0 ? "" : mSrcMgr.getMemoryBuffer(diag.bufferId)->getBufferIdentifier();
+  };
+
+  switch (mFormat) {
+  case OutputFormat::Text:
+    for (auto& diag : resolved) {
+      if (diag.bufferId == 0) { // no "file:line:" prefix rather than SourceMgr's "<unknown>:0:"
+        llvm::SMDiagnostic("", GetDiagnosticKind(diag.id), diag.message).print(nullptr, os);
+        continue;
+      }
+      mSrcMgr.PrintMessage(os, diag.loc, GetDiagnosticKind(diag.id), diag.message);
+    }
+    break;
+  case OutputFormat::Json: {
+    llvm::json::Array array;
+    for (auto& diag : resolved) {
+      llvm::json::Object object{
+          {"id", GetDiagnosticName(diag.id)},
+          {"level", KindToString(GetDiagnosticKind(diag.id))},
+          {"message", diag.message},
+      };
+      if (diag.bufferId != 0) {
+        object["file"] = fileName(diag);
+        object["line"] = diag.line;
+        object["column"] = diag.column;
+      }
+      array.push_back(std::move(object));
+    }
+    os << llvm::formatv("{0:2}", llvm::json::Value(std::move(array))) << '\n';
+  } break;
+  case OutputFormat::Sarif: {
+    llvm::json::Array results;
+    for (auto& diag : resolved) {
+      auto kind = GetDiagnosticKind(diag.id);
+      llvm::json::Object result{
+          {"ruleId", GetDiagnosticName(diag.id)},
+          {"level", kind == llvm::SourceMgr::DK_Remark ? "note" : KindToString(kind)},
+          {"message", llvm::json::Object{{"text", diag.message}}},
+      };
+      if (diag.bufferId != 0) {
+        result["locations"] = llvm::json::Array{llvm::json::Object{
+            {"physicalLocation",
+             llvm::json::Object{
+                 {"artifactLocation", llvm::json::Object{{"uri", fileName(diag)}}},
+                 {"region", llvm::json::Object{{"startLine", diag.line}, {"startColumn", diag.column}}},
+             }},
+        }};
+      }
+      results.push_back(std::move(result));
+    }
+    llvm::json::Object sarif{
+        {"$schema", "https://json.schemastore.org/sarif-2.1.0.json"},
+        {"version", "2.1.0"},
+        {"runs", llvm::json::Array{llvm::json::Object{
+                     {"tool", llvm::json::Object{{"driver", llvm::json::Object{{"name", "rusty_c"}}}}},
+                     {"results", std::move(results)},
+                 }}},
+    };
+    os << llvm::formatv("{0:2}", llvm::json::Value(std::move(sarif))) << '\n';
+  } break;
+  }
+}
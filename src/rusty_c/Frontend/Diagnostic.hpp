@@ -4,34 +4,132 @@
 
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 enum class DiagId {
 #define DIAG(id, level, msg) id,
 #include "Diagnostic.def"
 };
 
+// number of arguments a diagnostic text expects, "{}" and "{N}" are both accepted
+consteval auto CountDiagnosticArgs(std::string_view text) -> u32
+{
+  u32 implicit = 0;
+  u32 explicit_ = 0;
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] != '{') {
+      continue;
+    }
+    if (i + 1 < text.size() && text[i + 1] == '{') { // escaped brace
+      ++i;
+      continue;
+    }
+    if (i + 1 < text.size() && text[i + 1] >= '0' && text[i + 1] <= '9') {
+      u32 index = 0;
+      for (++i; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) {
+        index = index * 10 + (text[i] - '0');
+      }
+      explicit_ = std::max(explicit_, index + 1);
+    } else {
+      ++implicit;
+    }
+  }
+  return std::max(implicit, explicit_);
+}
+
+inline constexpr u32 gDiagnosticArgCount[] = {
+#define DIAG(id, level, msg) CountDiagnosticArgs(msg),
+#include "Diagnostic.def"
+};
+
+// not constexpr on purpose, calling it from a consteval context is a compile error
+inline void DiagnosticArgumentCountMismatch() {}
+
+// a DiagId checked at compile time against the number of arguments passed along with it
+template <typename... Args>
+struct DiagFormat {
+  DiagId mId;
+
+  consteval DiagFormat(DiagId id) : mId(id)
+  {
+    if (gDiagnosticArgCount[static_cast<std::underlying_type_t<DiagId>>(id)] != sizeof...(Args)) {
+      DiagnosticArgumentCountMismatch();
+    }
+  }
+};
+
 class DiagnosticsEngine {
+public:
+  enum class OutputFormat { Text, Json, Sarif };
+
+private:
   static auto GetDiagnosticText(DiagId id) -> char const*;
   static auto GetDiagnosticKind(DiagId id) -> llvm::SourceMgr::DiagKind;
+  static auto GetDiagnosticName(DiagId id) -> char const*;
+
+  // a reported diagnostic, formatting and line/column resolution are deferred until flush
+  struct Diagnostic {
+    DiagId mId;
+    llvm::SMLoc mLoc;
+    utils::dynamic_format_arg_store<utils::format_context> mArgs;
+  };
 
   llvm::SourceMgr& mSrcMgr;
-  u32 mNumErrors;
+  std::mutex mMutex;
+  std::vector<Diagnostic> mDiagnostics;
+  std::atomic<u32> mNumErrors;
+  std::atomic<u32> mNumSuppressed;
+  u32 mErrorLimit; // 0 for unlimited
+  OutputFormat mFormat;
+
+  template <typename T>
+  static void PackArg(utils::dynamic_format_arg_store<utils::format_context>& store, T&& arg)
+  {
+    // string views may point into temporaries, keep an owned copy
+    if constexpr (std::is_convertible_v<T, std::string_view>) {
+      store.push_back(std::string(std::string_view(arg)));
+    } else {
+      store.push_back(std::forward<T>(arg));
+    }
+  }
+
+  template <typename... Args>
+  void record(llvm::SMLoc loc, DiagId id, Args&&... args)
+  {
+    Diagnostic diag{id, loc, {}};
+    diag.mArgs.reserve(sizeof...(Args), 0);
+    (PackArg(diag.mArgs, std::forward<Args>(args)), ...);
+    emit(std::move(diag));
+  }
+  void emit(Diagnostic&& diag);
 
 public:
-  DiagnosticsEngine(llvm::SourceMgr& srcMgr) : mSrcMgr(srcMgr), mNumErrors(0) {}
+  DiagnosticsEngine(llvm::SourceMgr& srcMgr)
+      : mSrcMgr(srcMgr), mNumErrors(0), mNumSuppressed(0), mErrorLimit(0), mFormat(OutputFormat::Text)
+  {
+  }
+  ~DiagnosticsEngine() { flush(); }
 
   auto numErrors() -> u32 { return mNumErrors; }
+  auto getSourceMgr() -> llvm::SourceMgr const& { return mSrcMgr; }
+  auto setErrorLimit(u32 limit) -> void { mErrorLimit = limit; }
+  auto setOutputFormat(OutputFormat format) -> void { mFormat = format; }
+  auto hasReachedErrorLimit() -> bool { return mErrorLimit != 0 && mNumErrors >= mErrorLimit; }
+
+  // sorts, deduplicates and prints every buffered diagnostic, safe to call more than once
+  auto flush(llvm::raw_ostream& os = llvm::errs()) -> void;
+
   template <typename... Args>
-  void report(llvm::SMLoc loc, DiagId id, Args&&... args)
+  void report(llvm::SMLoc loc, DiagFormat<std::type_identity_t<Args>...> id, Args&&... args)
   {
-    std::string msg = utils::vformat(GetDiagnosticText(id), utils::make_format_args(std::forward<Args>(args)...));
-    auto kind = GetDiagnosticKind(id);
-    mSrcMgr.PrintMessage(loc, kind, msg);
-    mNumErrors += (kind == llvm::SourceMgr::DK_Error) ? 1 : 0;
+    record(loc, id.mId, std::forward<Args>(args)...);
   }
   template <typename... Args>
-  void report(char const* loc, DiagId id, Args&&... args)
+  void report(char const* loc, DiagFormat<std::type_identity_t<Args>...> id, Args&&... args)
   {
-    report(llvm::SMLoc::getFromPointer(loc), id, std::forward<Args>(args)...);
+    record(llvm::SMLoc::getFromPointer(loc), id.mId, std::forward<Args>(args)...);
   }
 };
@@ -28,7 +28,7 @@ bool IsPunct(char c)
 {
   return c == '[' || c == ']' || c == '(' || c == ')' || c == '{' || c == '}' || c == '.' || c == '&' || c == '*' ||
          c == '+' || c == '-' || c == '~' || c == '!' || c == '/' || c == '%' || c == '<' || c == '>' || c == '^' ||
-         c == '|' || c == '?' || c == ':' || c == ';' || c == '=' || c == ',' || c == '\'';
+         c == '|' || c == '?' || c == ':' || c == ';' || c == '=' || c == ',' || c == '\'' || c == '#';
 }
 
 auto Lexer::tokenize() -> std::vector<Token>
@@ -37,6 +37,10 @@ auto Lexer::tokenize() -> std::vector<Token>
   while (!mCursor.isEnd()) {
     vec.push_back(nextToken());
   }
+  // a token may end the buffer, the parser still needs an END to stop at
+  if (vec.empty() || !vec.back().is(TokenKind::END)) {
+    vec.push_back({curr(), TokenKind::END});
+  }
   return vec;
 }
 
@@ -64,8 +68,8 @@ auto Lexer::scanStringLiteral() -> Token
   while (peek() != '"') {
     skip();
   }
-  skip();
   std::string value(start, mCursor.curr());
+  skip();
   return {curr(), TokenKind::StringLiteral, value};
 }
 
@@ -106,10 +110,10 @@ auto Lexer::scanIntegerSuffix() -> Lexer::IntegerType
       return IntegerType::i16;
     } else if (view.starts_with("i32")) {
       mCursor.skip(3);
-      return IntegerType::i16;
+      return IntegerType::i32;
     } else if (view.starts_with("i64")) {
       mCursor.skip(3);
-      return IntegerType::i16;
+      return IntegerType::i64;
     } else if (view.starts_with("u8")) {
       mCursor.skip(2);
       return IntegerType::u8;
@@ -202,7 +206,11 @@ auto Lexer::scanFloat() -> Token
 
   mCursor.skip(std::abs(start - end));
 
-  if (char ch = peek(); ch == '_') {
+  // `1.5f32` or `1.5_f32`
+  if (char ch = peek(); ch == '_' || ch == 'f') {
+    if (ch == '_') {
+      skip();
+    }
     auto start = mCursor.curr();
     std::string_view view{start, 3};
     if (view.starts_with("f32")) {
@@ -243,7 +251,11 @@ auto Lexer::scanNumber() -> Token
     skip();
   }
 
-  if (char ch = peek(); ch == '.' 
+  // `t.0.1` indexes a tuple twice, a number right after a `.` is never a float. Neither is one before `..` in `0..n`,
+  // but the one after it may be
+  auto isTupleIndex = start != getBuffer().begin() && start[-1] == '.' &&
+                      (start - 1 == getBuffer().begin() || start[-2] != '.');
+  if (char ch = peek(); ch == '.' && !isTupleIndex && mCursor.peek(1) != '.'
   /* || ch == 'E' || ch == 'e'
    */) {
     if (base == 8) {
@@ -319,6 +331,9 @@ auto Lexer::scanPunct() -> Token
     if (ch = mCursor.peek(1); ch == '=') {
       type = TokenKind::PunLe;
       skip(), skip();
+    } else if (ch == '<') {
+      type = TokenKind::PunShl;
+      skip(), skip();
     } else {
       type = TokenKind::PunLt;
       skip();
@@ -329,6 +344,9 @@ auto Lexer::scanPunct() -> Token
     if (ch = mCursor.peek(1); ch == '=') {
       type = TokenKind::PunGe;
       skip(), skip();
+    } else if (ch == '>') {
+      type = TokenKind::PunShr;
+      skip(), skip();
     } else {
       type = TokenKind::PunGt;
       skip();
@@ -378,17 +396,53 @@ auto Lexer::scanPunct() -> Token
     skip();
   } break;
   case ':': {
-    type = TokenKind::PunColon;
-    skip();
+    if (ch = mCursor.peek(1); ch == ':') {
+      type = TokenKind::PunPathSep;
+      skip(), skip();
+    } else {
+      type = TokenKind::PunColon;
+      skip();
+    }
+  } break;
+  case '.': {
+    if (ch = mCursor.peek(1); ch == '.') {
+      type = TokenKind::PunDotDot;
+      skip(), skip();
+    } else {
+      type = TokenKind::PunDot;
+      skip();
+    }
   } break;
   case '&': {
-    type = TokenKind::PunAnd;
+    if (ch = mCursor.peek(1); ch == '&') {
+      type = TokenKind::PunAndAnd;
+      skip(), skip();
+    } else {
+      type = TokenKind::PunAnd;
+      skip();
+    }
+  } break;
+  case '|': {
+    if (ch = mCursor.peek(1); ch == '|') {
+      type = TokenKind::PunOrOr;
+      skip(), skip();
+    } else {
+      type = TokenKind::PunOr;
+      skip();
+    }
+  } break;
+  case '^': {
+    type = TokenKind::PunCaret;
     skip();
   } break;
   case '\'': {
     type = TokenKind::PunSQuote;
     skip();
   } break;
+  case '#': {
+    type = TokenKind::PunPound;
+    skip();
+  } break;
   }
 
   return {curr(), type};
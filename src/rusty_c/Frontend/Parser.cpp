@@ -6,7 +6,7 @@ bool IsUnaryTok(TokenKind tok) { return UnaryExpr::MapKind(tok) != UnaryExpr::Ki
 
 auto Parser::parseExprStmt(PredT pred) -> std::unique_ptr<ExprStmt>
 {
-  if (auto& tok = peek(); tok.isOneOf(PunLBrace, Kwif, Kwwhile, Kwloop)) {
+  if (auto& tok = peek(); tok.isOneOf(PunLBrace, Kwif, Kwwhile, Kwloop, Kwfor)) {
     auto ret = std::make_unique<ExprStmt>(parseExprWithBlock(pred));
     skipIf(PunSemi);
     return ret;
@@ -19,7 +19,7 @@ auto Parser::parseExprStmt(PredT pred) -> std::unique_ptr<ExprStmt>
 
 auto Parser::parseExpr(PredT pred) -> std::unique_ptr<Expr>
 {
-  if (peek().isOneOf(Kwloop, Kwwhile, PunLBrace, Kwif)) {
+  if (peek().isOneOf(Kwloop, Kwwhile, Kwfor, PunLBrace, Kwif)) {
     return parseExprWithBlock(pred);
   } else {
     return parseExprWithoutBlock(pred);
@@ -54,30 +54,55 @@ auto Parser::parseBinaryExpr(PredT pred, i32 bp) -> std::unique_ptr<Expr>
   std::unique_ptr<Expr> left;
 
   if (auto tok = peek().getKind(); tok == PunLParen) {
-    left = parseGroupedExpr(pred); // parse grouped expression
+    left = parsePostfixExpr(parseGroupedExpr(pred)); // parse grouped expression
+  } else if (tok == PunLBrack) {
+    left = parsePostfixExpr(parseArrayExpr());
   } else if (tok == NumberLiteral || tok == StringLiteral) {
     left = parseLiteralExpr();
   } else if (tok == Identifier) {
-    if (peek(1).is(PunLParen)) { // parse function call expression
+    // `f(..)`, or `f32x4::splat(..)` for an associated function of a builtin type
+    auto isPath = peek(1).is(PunPathSep) && peek(2).is(Identifier) && peek(3).is(PunLParen);
+    if (peek(1).is(PunLParen) || isPath) { // parse function call expression
       auto loc = currBufLoc();
       auto callee = peek().get<std::string>();
       skip();
+      if (isPath) {
+        skip();
+        callee += "::" + peek().get<std::string>();
+        skip();
+      }
       skip();
       std::vector<std::unique_ptr<Expr>> args{};
       while (!peek().is(PunRParen)) {
-        args.push_back(parseExpr([](auto tok) { return tok.is(PunComma); }));
+        args.push_back(parseExpr([](auto tok) { return tok.isOneOf(PunComma, PunRParen); }));
         skipIf(PunComma);
       }
       skip(); // skip RParen
       left = std::make_unique<CallExpr>(callee, std::move(args), loc);
+    } else if (peek(1).is(PunLBrace) && !pred(peek(1)) &&
+               (peek(2).is(PunRBrace) || (peek(2).is(Identifier) && peek(3).is(PunColon)))) {
+      // `Name { field: value }`, not where a brace ends the expression as in `if x {`
+      left = parseStructExpr();
     } else {
       left = parseLiteralExpr();
     }
+    left = parsePostfixExpr(std::move(left));
   } else if (auto kind = UnaryExpr::MapKind(tok); kind != UnaryExpr::Kind::SIZE) { // parse unary expression
     auto [bp] = UnaryExpr::BindingPower(kind);                                     // prefix
+    auto loc = currBufLoc();
     skip();
+    if (kind == UnaryExpr::Kind::Ref && peek().is(Kwmut)) { // `&mut place`
+      kind = UnaryExpr::Kind::RefMut;
+      skip();
+    }
+    auto right = parseBinaryExpr(pred, bp);
+    left = std::make_unique<UnaryExpr>(kind, std::move(right), loc);
+  } else if (tok == PunAndAnd) { // `&&x`, a borrow of a borrow
+    auto [bp] = UnaryExpr::BindingPower(UnaryExpr::Kind::Ref);
+    auto loc = currBufLoc();
+    splitAndAnd();
     auto right = parseBinaryExpr(pred, bp);
-    left = std::make_unique<UnaryExpr>(kind, std::move(right));
+    left = std::make_unique<UnaryExpr>(UnaryExpr::Kind::Ref, std::move(right), loc);
   } else {
     mDiags.report(currSMLoc(), DiagId::ErrExpectedExpr);
   }
@@ -101,30 +126,231 @@ auto Parser::parseBinaryExpr(PredT pred, i32 bp) -> std::unique_ptr<Expr>
   return left;
 }
 
-auto Parser::parseGroupedExpr(PredT pred) -> std::unique_ptr<GroupedExpr>
+// indexing, field accesses and method calls bind tighter than any prefix or binary operator
+auto Parser::parsePostfixExpr(std::unique_ptr<Expr> base) -> std::unique_ptr<Expr>
+{
+  while (peek().isOneOf(PunLBrack, PunDot)) {
+    auto loc = currBufLoc();
+    if (peek().is(PunLBrack)) {
+      skip();
+      auto index = parseExpr([](auto v) { return v.is(PunRBrack); });
+      if (!consume(PunRBrack)) {
+        // e.g. a range `a[i..]`, resume after the bracket so the caller makes progress
+        skipAfter([](auto const& tok) { return tok.is(PunRBrack); });
+        skipIf(PunRBrack);
+      }
+      base = std::make_unique<IndexExpr>(std::move(base), std::move(index), loc);
+      continue;
+    }
+    skip();
+    // `t.0`, the lexer never makes the index part of a float
+    if (peek().is(NumberLiteral) && std::holds_alternative<i32>(peek().getValue())) {
+      auto index = ToString(peek().getValue());
+      skip();
+      base = std::make_unique<FieldExpr>(std::move(base), std::move(index), loc);
+      continue;
+    }
+    if (!expect(Identifier)) {
+      return base;
+    }
+    auto method = peek().get<std::string>();
+    skip();
+    if (!peek().is(PunLParen)) {
+      base = std::make_unique<FieldExpr>(std::move(base), std::move(method), loc);
+      continue;
+    }
+    skip();
+    std::vector<std::unique_ptr<Expr>> args{};
+    while (!peek().is(PunRParen) && !peek().is(END)) {
+      args.push_back(parseExpr([](auto tok) { return tok.isOneOf(PunComma, PunRParen); }));
+      skipIf(PunComma);
+    }
+    consume(PunRParen);
+    base = std::make_unique<MethodCallExpr>(std::move(base), std::move(method), std::move(args), loc);
+  }
+  return base;
+}
+
+// `[a, b, c]` or `[value; N]`
+auto Parser::parseArrayExpr() -> std::unique_ptr<ArrayExpr>
+{
+  auto loc = currBufLoc();
+  consume(PunLBrack);
+  std::vector<std::unique_ptr<Expr>> elems{};
+  auto repeat = std::optional<u64>{};
+  while (!peek().is(PunRBrack) && !peek().is(END)) {
+    elems.push_back(parseExpr([](auto tok) { return tok.isOneOf(PunComma, PunSemi, PunRBrack); }));
+    if (elems.back() == nullptr) {
+      skipAfter([](auto const& tok) { return tok.is(PunRBrack); });
+      break;
+    }
+    if (elems.size() == 1 && peek().is(PunSemi)) {
+      skip();
+      repeat = parseArrayLength();
+      break;
+    }
+    skipIf(PunComma);
+  }
+  consume(PunRBrack);
+  return std::make_unique<ArrayExpr>(std::move(elems), repeat, loc);
+}
+
+// `Name { field: value, ... }`
+auto Parser::parseStructExpr() -> std::unique_ptr<StructExpr>
+{
+  auto loc = currBufLoc();
+  auto name = peek().get<std::string>();
+  skip();
+  consume(PunLBrace);
+  std::vector<StructExpr::FieldInit> fields{};
+  while (!peek().is(PunRBrace) && !peek().is(END)) {
+    if (!expect(Identifier)) {
+      skipAfter([](auto const& tok) { return tok.is(PunRBrace); });
+      break;
+    }
+    auto field = peek().get<std::string>();
+    skip();
+    consume(PunColon);
+    auto value = parseExpr([](auto tok) { return tok.isOneOf(PunComma, PunRBrace); });
+    if (value == nullptr) {
+      skipAfter([](auto const& tok) { return tok.is(PunRBrace); });
+      break;
+    }
+    fields.push_back({std::move(field), std::move(value)});
+    skipIf(PunComma);
+  }
+  consume(PunRBrace);
+  return std::make_unique<StructExpr>(std::move(name), std::move(fields), loc);
+}
+
+auto Parser::parseArrayLength() -> u64
+{
+  auto len = std::optional<u64>{};
+  if (peek().is(NumberLiteral)) {
+    std::visit(
+        [&]<typename T>(T const& v) {
+          if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+            if (v >= 0) {
+              len = static_cast<u64>(v);
+            }
+          }
+        },
+        peek().getValue());
+    skip();
+  }
+  if (!len) {
+    mDiags.report(currSMLoc(), DiagId::ErrInvalidArrayLength);
+  }
+  return len.value_or(0);
+}
+
+// `(a)` groups, `()`, `(a,)` and `(a, b)` are tuples
+auto Parser::parseGroupedExpr(PredT pred) -> std::unique_ptr<ExprWithoutBlock>
 {
   auto loc = currBufLoc();
   consume(PunLParen);
-  auto expr = parseExpr([](auto v) { return v.is(PunRParen); });
+  std::vector<std::unique_ptr<Expr>> elems{};
+  auto isTuple = peek().is(PunRParen);
+  while (!peek().is(PunRParen) && !peek().is(END)) {
+    elems.push_back(parseExpr([](auto v) { return v.isOneOf(PunComma, PunRParen); }));
+    if (elems.back() == nullptr) {
+      skipAfter([](auto const& tok) { return tok.is(PunRParen); });
+      break;
+    }
+    if (peek().is(PunComma)) {
+      skip();
+      isTuple = true;
+    } else if (!peek().is(PunRParen)) {
+      break;
+    }
+  }
   consume(PunRParen);
-  return std::make_unique<GroupedExpr>(std::move(expr), loc);
+  if (!isTuple) {
+    return std::make_unique<GroupedExpr>(std::move(elems.front()), loc);
+  }
+  return std::make_unique<TupleExpr>(std::move(elems), loc);
 }
 
 auto Parser::isItemStart(Token const& tok) -> bool
 {
-  return tok.isOneOf(Kwfn, Kwextern); // TODO: add more
+  return tok.isOneOf(Kwfn, Kwextern, Kwconst, Kwstatic, Kwstruct); // TODO: add more
 }
 
-auto Parser::parseItem() -> std::unique_ptr<Item>
+auto Parser::parseOuterAttributes() -> std::vector<Attribute>
 {
-  if (peek().is(Kwfn)) {
-    return parseFunctionItem();
+  std::vector<Attribute> attrs{};
+  while (peek().is(PunPound)) {
+    skip();
+    consume(PunLBrack);
+    if (!expect(Identifier)) {
+      skipAfter([](Token const& tok) { return tok.is(PunRBrack); });
+      skipIf(PunRBrack);
+      continue;
+    }
+    auto attr = Attribute{peek().get<std::string>(), {}, currBufLoc()};
+    skip();
+    auto wellFormed = true;
+    if (peek().is(PunLParen)) {
+      skip();
+      while (wellFormed && !peek().is(PunRParen)) {
+        if (peek().is(NumberLiteral)) {
+          attr.mArgs.push_back(ToString(peek().getValue()));
+          skip();
+          wellFormed = peek().is(PunRParen) || consume(PunComma);
+        } else if (wellFormed = expect(Identifier); wellFormed) {
+          auto arg = peek().get<std::string>();
+          skip();
+          // a nested argument such as `align(64)` is kept as written
+          if (peek().is(PunLParen)) {
+            skip();
+            if (peek().is(NumberLiteral)) {
+              arg += "(" + ToString(peek().getValue()) + ")";
+              skip();
+            } else if (wellFormed = expect(Identifier); wellFormed) {
+              arg += "(" + peek().get<std::string>() + ")";
+              skip();
+            }
+            wellFormed = wellFormed && consume(PunRParen);
+          }
+          attr.mArgs.push_back(std::move(arg));
+          wellFormed = wellFormed && (peek().is(PunRParen) || consume(PunComma));
+        }
+      }
+      wellFormed = wellFormed && consume(PunRParen);
+    }
+    if (!wellFormed || !expect(PunRBrack)) {
+      // already reported, resume after the attribute
+      skipAfter([](Token const& tok) { return tok.is(PunRBrack); });
+    }
+    skipIf(PunRBrack);
+    attrs.push_back(std::move(attr));
   }
-  if (peek().is(Kwextern) /* && peek(1).is(StringLiteral) && peek(2).is(PunLBrace) */) {
-    std::cout << peek(1).getKind() << '\n';
-    return parseExternalBlockItem();
+  return attrs;
+}
+
+auto Parser::parseItem(std::vector<Attribute> attrs) -> std::unique_ptr<Item>
+{
+  for (auto& attr : parseOuterAttributes()) {
+    attrs.push_back(std::move(attr));
+  }
+  std::unique_ptr<Item> item;
+  if (peek().is(Kwfn) || (peek().is(Kwconst) && peek(1).is(Kwfn))) {
+    item = parseFunctionItem();
+  } else if (peek().is(Kwextern) /* && peek(1).is(StringLiteral) && peek(2).is(PunLBrace) */) {
+    item = parseExternalBlockItem();
+  } else if (peek().is(Kwstruct)) {
+    item = parseStructItem();
+  } else if (peek().is(Kwconst)) {
+    item = parseConstantItem();
+  } else if (peek().is(Kwstatic)) {
+    item = parseStaticItem();
+  }
+  if (item) {
+    item->mAttrs = std::move(attrs);
+    return item;
   }
-  mDiags.report(currSMLoc(), DiagId::ErrUnexpected, "fn or extern", TokenKindToString(peek().getKind()));
+  mDiags.report(currSMLoc(), DiagId::ErrUnexpected, "fn, extern, struct, const or static",
+                TokenKindToString(peek().getKind()));
   utils::Unreachable(utils::SrcLoc::current(), "current {}\n", TokenKindToString(peek().getKind()));
 }
 
@@ -153,9 +379,35 @@ auto Parser::parseLetStmt() -> std::unique_ptr<LetStmt>
 {
   auto loc = currBufLoc();
   consume(Kwlet);
-  expect(Identifier);
-  auto name = peek().get<std::string>();
-  skip();
+  // `let (a, b) = ..` or `let (a,) = ..`, like in expressions `(a)` is just `a`
+  auto pattern = std::optional<std::vector<std::string>>{};
+  auto name = std::string{};
+  if (peek().is(PunLParen)) {
+    skip();
+    pattern.emplace();
+    auto isTuple = false;
+    while (expect(Identifier)) {
+      pattern->push_back(peek().get<std::string>());
+      skip();
+      if (!peek().is(PunComma)) {
+        break;
+      }
+      skip();
+      isTuple = true;
+      if (peek().is(PunRParen)) {
+        break;
+      }
+    }
+    consume(PunRParen);
+    if (!isTuple && pattern->size() == 1) {
+      name = std::move(pattern->front());
+      pattern.reset();
+    }
+  } else {
+    expect(Identifier);
+    name = peek().get<std::string>();
+    skip();
+  }
 
   std::unique_ptr<TypeBase> expectType{nullptr};
   if (peek().is(PunColon)) {
@@ -166,6 +418,9 @@ auto Parser::parseLetStmt() -> std::unique_ptr<LetStmt>
   consume(PunEq);
   auto expr = parseExpr([](auto v) { return v.is(PunSemi); });
   skip(); // skip semicolon
+  if (pattern) {
+    return std::make_unique<LetStmt>(std::move(*pattern), std::move(expectType), std::move(expr), loc);
+  }
   return std::make_unique<LetStmt>(name, std::move(expectType), std::move(expr), loc);
 }
 
@@ -174,7 +429,7 @@ auto Parser::parseExprWithBlock(PredT pred) -> std::unique_ptr<ExprWithBlock>
 
   if (peek().is(PunLBrace)) {
     return parseBlockExpr();
-  } else if (peek().isOneOf(Kwloop, Kwwhile)) {
+  } else if (peek().isOneOf(Kwloop, Kwwhile, Kwfor)) {
     return parseLoopExpr();
   } else if (peek().is(Kwif)) {
     return parseIfExpr();
@@ -191,20 +446,23 @@ auto Parser::parseBlockExpr() -> std::unique_ptr<BlockExpr>
   std::unique_ptr<Expr> ret{nullptr};
 
   bool isItemEnd = false;
-  puts("a");
   while (!peek().is(PunRBrace)) { // TODO expr without block
+    // outer attributes belong to the item or loop that follows
+    auto attrs = parseOuterAttributes();
     if (isItemStart(peek())) {
-      items.push_back(parseItem());
+      items.push_back(parseItem(std::move(attrs)));
       isItemEnd = true;
       continue;
     }
     auto stmt = parseStmt([](auto v) { return v.isOneOf(PunRBrace, PunSemi); });
+    if (!attrs.empty()) {
+      attachLoopAttributes(stmt.get(), std::move(attrs));
+    }
     stmts.push_back(std::move(stmt));
     isItemEnd = false;
   }
-  puts("b");
 
-  if (!peek(-1).is(PunSemi) && !isItemEnd) {
+  if (!peek(-1).is(PunSemi) && !isItemEnd && !stmts.empty() && stmts.back()->mType == Stmt::Type::Expression) {
     auto back = std::move(stmts.back());
     stmts.pop_back();
     ret = std::move(back->as<ExprStmt>()->mExpr); // move the expression out of the statement
@@ -212,6 +470,20 @@ auto Parser::parseBlockExpr() -> std::unique_ptr<BlockExpr>
   consume(PunRBrace);
   return std::make_unique<BlockExpr>(std::move(stmts), std::move(items), std::move(ret));
 }
+auto Parser::attachLoopAttributes(Stmt* stmt, std::vector<Attribute> attrs) -> void
+{
+  if (stmt != nullptr && stmt->mType == Stmt::Type::Expression) {
+    if (auto expr = stmt->as<ExprStmt>()->mExpr.get();
+        expr != nullptr && expr->mType == Expr::Type::WithBlock &&
+        expr->as<ExprWithBlock>()->mType == ExprWithBlock::Type::Loop) {
+      expr->as<LoopExpr>()->mAttrs = std::move(attrs);
+      return;
+    }
+  }
+  for (auto const& attr : attrs) {
+    mDiags.report(attr.mLoc, DiagId::ErrMisplacedAttribute, attr.mName, "this statement");
+  }
+}
 auto Parser::parseIfExpr() -> std::unique_ptr<IfExpr>
 {
   auto loc = currBufLoc();
@@ -237,6 +509,8 @@ auto Parser::parseLoopExpr() -> std::unique_ptr<LoopExpr>
     return parseInfiniteLoopExpr();
   } else if (peek().is(Kwwhile)) {
     return parsePredicateLoopExpr();
+  } else if (peek().is(Kwfor)) {
+    return parseIteratorLoopExpr();
   }
   utils::Unreachable(utils::SrcLoc::current());
 }
@@ -255,6 +529,57 @@ auto Parser::parsePredicateLoopExpr() -> std::unique_ptr<PredicateLoopExpr>
   auto body = parseBlockExpr();
   return std::make_unique<PredicateLoopExpr>(std::move(cond), std::move(body), loc);
 }
+// `for i in a..b {}` or `for i in (a..b).step_by(k) {}`
+auto Parser::parseIteratorLoopExpr() -> std::unique_ptr<IteratorLoopExpr>
+{
+  auto loc = currBufLoc();
+  consume(Kwfor);
+  auto name = std::string{};
+  if (expect(Identifier)) {
+    name = peek().get<std::string>();
+    skip();
+  }
+  consume(Kwin);
+  // `(a..b)` is told apart from a range starting with `(a)` by a `..` directly inside the parentheses
+  auto grouped = false;
+  if (peek().is(PunLParen)) {
+    auto depth = 0;
+    for (auto i = 0; !peek(i).is(END); ++i) {
+      if (peek(i).isOneOf(PunLParen, PunLBrack, PunLBrace)) {
+        ++depth;
+      } else if (peek(i).isOneOf(PunRParen, PunRBrack, PunRBrace) && --depth == 0) {
+        break;
+      } else if (peek(i).is(PunDotDot) && depth == 1) {
+        grouped = true;
+        break;
+      }
+    }
+  }
+  if (grouped) {
+    skip();
+  }
+  auto start = parseExpr([](auto v) { return v.is(PunDotDot); });
+  consume(PunDotDot);
+  auto end = grouped ? parseExpr([](auto v) { return v.is(PunRParen); })
+                     : parseExpr([](auto v) { return v.is(PunLBrace); });
+  auto step = std::unique_ptr<Expr>{};
+  if (grouped) {
+    consume(PunRParen);
+    consume(PunDot);
+    if (expect(Identifier)) {
+      if (auto method = peek().get<std::string>(); method != "step_by") {
+        mDiags.report(currSMLoc(), DiagId::ErrUnknownMethod, method, "Range");
+      }
+      skip();
+    }
+    consume(PunLParen);
+    step = parseExpr([](auto v) { return v.is(PunRParen); });
+    consume(PunRParen);
+  }
+  auto body = parseBlockExpr();
+  return std::make_unique<IteratorLoopExpr>(std::move(name), std::move(start), std::move(end), std::move(step),
+                                            std::move(body), loc);
+}
 
 auto Parser::parseStmts() -> std::vector<std::unique_ptr<Stmt>>
 {
@@ -271,6 +596,11 @@ auto Parser::parseFunctionItem() -> std::unique_ptr<FunctionItem>
   std::vector<std::unique_ptr<TypeBase>> paramTypes{};
 
   auto loc = currBufLoc();
+  bool isConst = false;
+  if (peek().is(Kwconst)) {
+    skip();
+    isConst = true;
+  }
   consume(Kwfn);
   expect(Identifier);
   auto identifier = peek().get<std::string>();
@@ -282,6 +612,7 @@ auto Parser::parseFunctionItem() -> std::unique_ptr<FunctionItem>
     skip();
     consume(PunColon);
     paramTypes.push_back(parseType());
+    skipIf(PunComma);
   }
   consume(PunRParen);
 
@@ -293,17 +624,20 @@ auto Parser::parseFunctionItem() -> std::unique_ptr<FunctionItem>
   }
 
   // function declaration
+  std::unique_ptr<FunctionItem> item;
   if (peek().is(PunSemi)) {
     skip();
-    return std::make_unique<FunctionItem>(identifier, std::move(paramNames),
+    item = std::make_unique<FunctionItem>(identifier, std::move(paramNames),
                                           std::make_unique<FunctionType>(std::move(paramTypes), std::move(retType)),
                                           nullptr, loc);
   } else {
     auto body = parseBlockExpr();
-    return std::make_unique<FunctionItem>(identifier, std::move(paramNames),
+    item = std::make_unique<FunctionItem>(identifier, std::move(paramNames),
                                           std::make_unique<FunctionType>(std::move(paramTypes), std::move(retType)),
                                           std::move(body), loc);
   }
+  item->mIsConst = isConst;
+  return item;
 }
 
 auto Parser::parseExternalBlockItem() -> std::unique_ptr<ExternalBlockItem>
@@ -315,12 +649,74 @@ auto Parser::parseExternalBlockItem() -> std::unique_ptr<ExternalBlockItem>
   consume(PunLBrace);
   std::vector<std::unique_ptr<FunctionItem>> items{};
   while (!peek().is(PunRBrace)) {
+    auto attrs = parseOuterAttributes();
     items.push_back(parseFunctionItem());
+    items.back()->mAttrs = std::move(attrs);
   }
   consume(PunRBrace);
   return std::make_unique<ExternalBlockItem>(abi, std::move(items));
 }
 
+auto Parser::parseStructItem() -> std::unique_ptr<StructItem>
+{
+  auto loc = currBufLoc();
+  consume(Kwstruct);
+  expect(Identifier);
+  auto name = peek().get<std::string>();
+  skip();
+  consume(PunLBrace);
+  std::vector<StructItem::Field> fields{};
+  while (!peek().is(PunRBrace) && !peek().is(END)) {
+    if (!expect(Identifier)) {
+      skipAfter([](auto const& tok) { return tok.is(PunRBrace); });
+      break;
+    }
+    auto fieldLoc = currBufLoc();
+    auto field = peek().get<std::string>();
+    skip();
+    consume(PunColon);
+    fields.push_back({std::move(field), parseType(), fieldLoc});
+    skipIf(PunComma);
+  }
+  consume(PunRBrace);
+  return std::make_unique<StructItem>(name, std::move(fields), loc);
+}
+
+auto Parser::parseConstantItem() -> std::unique_ptr<ConstantItem>
+{
+  auto loc = currBufLoc();
+  consume(Kwconst);
+  expect(Identifier);
+  auto name = peek().get<std::string>();
+  skip();
+  consume(PunColon);
+  auto type = parseType();
+  consume(PunEq);
+  auto expr = parseExpr([](auto v) { return v.is(PunSemi); });
+  consume(PunSemi);
+  return std::make_unique<ConstantItem>(name, std::move(type), std::move(expr), loc);
+}
+
+auto Parser::parseStaticItem() -> std::unique_ptr<StaticItem>
+{
+  auto loc = currBufLoc();
+  consume(Kwstatic);
+  auto isMutable = false;
+  if (peek().is(Kwmut)) {
+    skip();
+    isMutable = true;
+  }
+  expect(Identifier);
+  auto name = peek().get<std::string>();
+  skip();
+  consume(PunColon);
+  auto type = parseType();
+  consume(PunEq);
+  auto expr = parseExpr([](auto v) { return v.is(PunSemi); });
+  consume(PunSemi);
+  return std::make_unique<StaticItem>(name, std::move(type), std::move(expr), isMutable, loc);
+}
+
 auto Parser::parseReturnExpr() -> std::unique_ptr<ReturnExpr>
 {
   auto loc = currBufLoc();
@@ -337,6 +733,7 @@ auto Parser::parseType() -> std::unique_ptr<TypeBase>
 {
   auto tokKind = peek();
   if (tokKind.is(PunNot)) {
+    skip();
     return std::make_unique<Never>(TypeNever);
   } else if (tokKind.is(Identifier)) {
     auto typeName = peek().get<std::string>();
@@ -345,10 +742,20 @@ auto Parser::parseType() -> std::unique_ptr<TypeBase>
     if (auto type = GetNumBoolMap(typeName); type != nullptr) {
       return type;
     }
+    return std::make_unique<StructType>(typeName); // resolved by Sema
   } else if (tokKind.is(Kwfn)) {
     return parseFunctionType();
   } else if (tokKind.is(PunLParen)) {
     return parseTupleType();
+  } else if (tokKind.is(PunAndAnd)) { // `&&T`, a reference to a reference
+    splitAndAnd();
+    return std::make_unique<ReferenceType>(parseType(), false);
+  } else if (tokKind.is(PunAnd) && peek(1).is(PunLBrack)) {
+    return parseSliceType();
+  } else if (tokKind.isOneOf(PunAnd, PunStar)) {
+    return parsePointerType();
+  } else if (tokKind.is(PunLBrack)) {
+    return parseArrayType();
   }
   utils::Unreachable(utils::SrcLoc::current());
 }
@@ -365,6 +772,48 @@ auto Parser::parseTupleType() -> std::unique_ptr<TupleType>
   return std::make_unique<TupleType>(std::move(types));
 }
 
+// `&[T]`, or `&[T; N]` which is a reference to an array
+auto Parser::parseSliceType() -> std::unique_ptr<TypeBase>
+{
+  consume(PunAnd);
+  consume(PunLBrack);
+  auto elem = parseType();
+  if (peek().is(PunSemi)) {
+    skip();
+    auto len = parseArrayLength();
+    consume(PunRBrack);
+    return std::make_unique<ReferenceType>(std::make_unique<ArrayType>(std::move(elem), len), false);
+  }
+  consume(PunRBrack);
+  return std::make_unique<SliceType>(std::move(elem));
+}
+
+// `&T`, `&mut T`, `*const T` or `*mut T`
+auto Parser::parsePointerType() -> std::unique_ptr<TypeBase>
+{
+  auto isReference = peek().is(PunAnd);
+  skip();
+  auto isMutable = peek().is(Kwmut);
+  if (isMutable || (!isReference && expect(Kwconst))) {
+    skip();
+  }
+  auto pointee = parseType();
+  if (isReference) {
+    return std::make_unique<ReferenceType>(std::move(pointee), isMutable);
+  }
+  return std::make_unique<RawPointerType>(std::move(pointee), isMutable);
+}
+
+auto Parser::parseArrayType() -> std::unique_ptr<ArrayType>
+{
+  consume(PunLBrack);
+  auto elem = parseType();
+  consume(PunSemi);
+  auto len = parseArrayLength();
+  consume(PunRBrack);
+  return std::make_unique<ArrayType>(std::move(elem), len);
+}
+
 auto Parser::parseFunctionType() -> std::unique_ptr<FunctionType>
 {
   consume(Kwfn);
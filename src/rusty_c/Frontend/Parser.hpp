@@ -27,10 +27,15 @@ public:
   auto parseLoopExpr() -> std::unique_ptr<LoopExpr>;
   auto parseInfiniteLoopExpr() -> std::unique_ptr<InfiniteLoopExpr>;
   auto parsePredicateLoopExpr() -> std::unique_ptr<PredicateLoopExpr>;
+  auto parseIteratorLoopExpr() -> std::unique_ptr<IteratorLoopExpr>;
 
   auto parseExprWithoutBlock(PredT pred) -> std::unique_ptr<Expr>;
   auto parseLiteralExpr() -> std::unique_ptr<LiteralExpr>;
-  auto parseGroupedExpr(PredT pred) -> std::unique_ptr<GroupedExpr>;
+  auto parseGroupedExpr(PredT pred) -> std::unique_ptr<ExprWithoutBlock>;
+  auto parsePostfixExpr(std::unique_ptr<Expr> base) -> std::unique_ptr<Expr>;
+  auto parseArrayExpr() -> std::unique_ptr<ArrayExpr>;
+  auto parseArrayLength() -> u64;
+  auto parseStructExpr() -> std::unique_ptr<StructExpr>;
   auto parseBinaryExpr(PredT pred, i32 bp) -> std::unique_ptr<Expr>;
   auto parseReturnExpr() -> std::unique_ptr<ReturnExpr>;
 
@@ -41,19 +46,29 @@ public:
 
   // parse item
   auto isItemStart(Token const& tok) -> bool;
-  auto parseItem() -> std::unique_ptr<Item>;
+  auto parseItem(std::vector<Attribute> attrs = {}) -> std::unique_ptr<Item>;
+  auto parseOuterAttributes() -> std::vector<Attribute>;
+  auto attachLoopAttributes(Stmt* stmt, std::vector<Attribute> attrs) -> void;
 
   auto parseFunctionItem() -> std::unique_ptr<FunctionItem>;
   auto parseExternalBlockItem() -> std::unique_ptr<ExternalBlockItem>;
+  auto parseStructItem() -> std::unique_ptr<StructItem>;
+  auto parseConstantItem() -> std::unique_ptr<ConstantItem>;
+  auto parseStaticItem() -> std::unique_ptr<StaticItem>;
 
   // parse type
   auto parseType() -> std::unique_ptr<TypeBase>;
   auto parseFunctionType() -> std::unique_ptr<FunctionType>;
   auto parseTupleType() -> std::unique_ptr<TupleType>;
+  auto parseSliceType() -> std::unique_ptr<TypeBase>;
+  auto parsePointerType() -> std::unique_ptr<TypeBase>;
+  auto parseArrayType() -> std::unique_ptr<ArrayType>;
 
   auto currSMLoc() -> llvm::SMLoc { return llvm::SMLoc::getFromPointer(currBufLoc()); }
   auto currBufLoc() -> char const* { return mCursor.peek().getLoc(); }
   auto skip() -> void { mCursor.skip(); };
+  // where a prefix `&` is expected `&&` stands for two of them, the first one is taken off
+  auto splitAndAnd() -> void { mCursor.peek() = Token(currBufLoc() + 1, PunAnd); }
   auto skipIf(TokenKind type) -> void;
   auto peek(i32 n = 0) -> Token const& { return mCursor.peek(n); };
   auto skipAfter(std::function<bool(Token const&)>&& pred) -> void;
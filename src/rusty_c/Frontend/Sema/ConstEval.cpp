@@ -0,0 +1,946 @@
+#include "ConstEval.hpp"
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+enum class ArithStatus { Ok, Invalid, Overflow, DivByZero };
+}
+
+static auto BinaryOpSpelling(BinaryExpr::Kind kind) -> char const*
+{
+  switch (kind) {
+  case BinaryExpr::Kind::Add:
+    return "+";
+  case BinaryExpr::Kind::Sub:
+    return "-";
+  case BinaryExpr::Kind::Mul:
+    return "*";
+  case BinaryExpr::Kind::Div:
+    return "/";
+  case BinaryExpr::Kind::Rem:
+    return "%";
+  case BinaryExpr::Kind::BitAnd:
+    return "&";
+  case BinaryExpr::Kind::BitOr:
+    return "|";
+  case BinaryExpr::Kind::BitXor:
+    return "^";
+  case BinaryExpr::Kind::Shl:
+    return "<<";
+  case BinaryExpr::Kind::Shr:
+    return ">>";
+  case BinaryExpr::Kind::Eq:
+    return "==";
+  case BinaryExpr::Kind::Ne:
+    return "!=";
+  case BinaryExpr::Kind::Gt:
+    return ">";
+  case BinaryExpr::Kind::Lt:
+    return "<";
+  case BinaryExpr::Kind::Ge:
+    return ">=";
+  case BinaryExpr::Kind::Le:
+    return "<=";
+  case BinaryExpr::Kind::LogicalAnd:
+    return "&&";
+  case BinaryExpr::Kind::LogicalOr:
+    return "||";
+  case BinaryExpr::Kind::Assignment:
+    return "=";
+  case BinaryExpr::Kind::SIZE:
+    break;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+template <typename T>
+static auto EvalBinary(BinaryExpr::Kind kind, T lhs, T rhs, ConstValue& out) -> ArithStatus
+{
+  switch (kind) {
+  case BinaryExpr::Kind::Eq:
+    out = lhs == rhs;
+    return ArithStatus::Ok;
+  case BinaryExpr::Kind::Ne:
+    out = lhs != rhs;
+    return ArithStatus::Ok;
+  case BinaryExpr::Kind::Gt:
+    out = lhs > rhs;
+    return ArithStatus::Ok;
+  case BinaryExpr::Kind::Lt:
+    out = lhs < rhs;
+    return ArithStatus::Ok;
+  case BinaryExpr::Kind::Ge:
+    out = lhs >= rhs;
+    return ArithStatus::Ok;
+  case BinaryExpr::Kind::Le:
+    out = lhs <= rhs;
+    return ArithStatus::Ok;
+  default:
+    break;
+  }
+
+  if constexpr (std::is_same_v<T, bool>) {
+    switch (kind) {
+    case BinaryExpr::Kind::BitAnd:
+      out = lhs && rhs;
+      return ArithStatus::Ok;
+    case BinaryExpr::Kind::BitOr:
+      out = lhs || rhs;
+      return ArithStatus::Ok;
+    case BinaryExpr::Kind::BitXor:
+      out = lhs != rhs;
+      return ArithStatus::Ok;
+    default:
+      return ArithStatus::Invalid;
+    }
+  } else if constexpr (std::is_floating_point_v<T>) {
+    switch (kind) {
+    case BinaryExpr::Kind::Add:
+      out = T(lhs + rhs);
+      return ArithStatus::Ok;
+    case BinaryExpr::Kind::Sub:
+      out = T(lhs - rhs);
+      return ArithStatus::Ok;
+    case BinaryExpr::Kind::Mul:
+      out = T(lhs * rhs);
+      return ArithStatus::Ok;
+    case BinaryExpr::Kind::Div:
+      out = T(lhs / rhs);
+      return ArithStatus::Ok;
+    case BinaryExpr::Kind::Rem:
+      out = T(std::fmod(lhs, rhs));
+      return ArithStatus::Ok;
+    default:
+      return ArithStatus::Invalid;
+    }
+  } else {
+    T result{};
+    switch (kind) {
+    case BinaryExpr::Kind::Add:
+      if (__builtin_add_overflow(lhs, rhs, &result)) {
+        return ArithStatus::Overflow;
+      }
+      break;
+    case BinaryExpr::Kind::Sub:
+      if (__builtin_sub_overflow(lhs, rhs, &result)) {
+        return ArithStatus::Overflow;
+      }
+      break;
+    case BinaryExpr::Kind::Mul:
+      if (__builtin_mul_overflow(lhs, rhs, &result)) {
+        return ArithStatus::Overflow;
+      }
+      break;
+    case BinaryExpr::Kind::Div:
+    case BinaryExpr::Kind::Rem:
+      if (rhs == 0) {
+        return ArithStatus::DivByZero;
+      }
+      if constexpr (std::is_signed_v<T>) {
+        if (lhs == std::numeric_limits<T>::min() && rhs == -1) {
+          return ArithStatus::Overflow;
+        }
+      }
+      result = kind == BinaryExpr::Kind::Div ? T(lhs / rhs) : T(lhs % rhs);
+      break;
+    case BinaryExpr::Kind::BitAnd:
+      result = T(lhs & rhs);
+      break;
+    case BinaryExpr::Kind::BitOr:
+      result = T(lhs | rhs);
+      break;
+    case BinaryExpr::Kind::BitXor:
+      result = T(lhs ^ rhs);
+      break;
+    case BinaryExpr::Kind::Shl:
+    case BinaryExpr::Kind::Shr:
+      if (rhs < 0 || static_cast<u64>(rhs) >= sizeof(T) * 8) {
+        return ArithStatus::Overflow;
+      }
+      // shift the unsigned representation left, right shifts of signed values are arithmetic
+      result = kind == BinaryExpr::Kind::Shl ? T(std::make_unsigned_t<T>(lhs) << rhs) : T(lhs >> rhs);
+      break;
+    default:
+      return ArithStatus::Invalid;
+    }
+    out = result;
+    return ArithStatus::Ok;
+  }
+}
+
+template <typename T>
+static auto EvalUnary(UnaryExpr::Kind kind, T value, ConstValue& out) -> ArithStatus
+{
+  if constexpr (std::is_same_v<T, bool>) {
+    if (kind == UnaryExpr::Kind::Not) {
+      out = !value;
+      return ArithStatus::Ok;
+    }
+    return ArithStatus::Invalid;
+  } else if constexpr (std::is_floating_point_v<T>) {
+    if (kind == UnaryExpr::Kind::Neg) {
+      out = T(-value);
+      return ArithStatus::Ok;
+    }
+    return ArithStatus::Invalid;
+  } else {
+    if (kind == UnaryExpr::Kind::Not) {
+      out = T(~value);
+      return ArithStatus::Ok;
+    }
+    if constexpr (std::is_signed_v<T>) {
+      if (value == std::numeric_limits<T>::min()) {
+        return ArithStatus::Overflow;
+      }
+    } else if (value != 0) {
+      return ArithStatus::Overflow;
+    }
+    out = T(-value);
+    return ArithStatus::Ok;
+  }
+}
+
+static auto ValueToString(ConstValue const& value) -> std::string
+{
+  return std::visit(
+      []<typename T>(T const& v) -> std::string {
+        if constexpr (std::is_same_v<T, std::monostate>) {
+          return "()";
+        } else {
+          return utils::format("{}", v);
+        }
+      },
+      value);
+}
+
+static auto ExprLoc(Expr* expr) -> char const*
+{
+  if (expr->mType != Expr::Type::WithoutBlock) {
+    return nullptr;
+  }
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    return e->as<LiteralExpr>()->getLoc();
+  case ExprWithoutBlock::Type::Grouped:
+    return e->as<GroupedExpr>()->getLoc();
+  case ExprWithoutBlock::Type::Call:
+    return e->as<CallExpr>()->getLoc();
+  case ExprWithoutBlock::Type::Return:
+    return e->as<ReturnExpr>()->getLoc();
+  case ExprWithoutBlock::Type::Index:
+    return e->as<IndexExpr>()->getLoc();
+  case ExprWithoutBlock::Type::MethodCall:
+    return e->as<MethodCallExpr>()->getLoc();
+  case ExprWithoutBlock::Type::Array:
+    return e->as<ArrayExpr>()->getLoc();
+  case ExprWithoutBlock::Type::Struct:
+    return e->as<StructExpr>()->getLoc();
+  case ExprWithoutBlock::Type::Field:
+    return e->as<FieldExpr>()->getLoc();
+  case ExprWithoutBlock::Type::Tuple:
+    return e->as<TupleExpr>()->getLoc();
+  case ExprWithoutBlock::Type::Operator: {
+    auto op = e->as<OperatorExpr>();
+    return op->mType == OperatorExpr::Type::Binary ? op->as<BinaryExpr>()->getLoc() : op->as<UnaryExpr>()->getLoc();
+  }
+  }
+  return nullptr;
+}
+
+auto ConstEvaluator::ToLiteralExpr(ConstValue const& value, TypeBase const* type, char const* loc)
+    -> std::unique_ptr<LiteralExpr>
+{
+  assert(!std::holds_alternative<std::monostate>(value) && "unit has no literal");
+  auto literal = std::visit(
+      []<typename T>(T const& v) -> LiteralExpr::ValueType {
+        if constexpr (std::is_same_v<T, std::monostate>) {
+          utils::Unreachable(utils::SrcLoc::current());
+        } else {
+          return v;
+        }
+      },
+      value);
+  // ConstValue and LiteralExpr::Kind share their order, shifted by the unit alternative
+  auto kind = static_cast<LiteralExpr::Kind>(value.index() - 1);
+  auto expr = std::make_unique<LiteralExpr>(kind, literal, loc);
+  expr->mExprType = TypeClone(type);
+  return expr;
+}
+
+//===----------------------------------------------------------------------===//
+// Folding
+//===----------------------------------------------------------------------===//
+
+auto ConstEvaluator::foldCrate(Crate* crate) -> void
+{
+  for (auto& item : crate->mItems) {
+    foldItem(item.get());
+  }
+}
+
+// what IRGen can lower to an initializer: literals and consts, also inside arrays, tuples and structs. Consts naming
+// each other in a cycle never end up as one
+static constexpr u32 kMaxConstNesting = 256;
+static auto IsConstantInitializer(Expr const* expr, u32 depth = 0) -> bool
+{
+  if (expr->mType != Expr::Type::WithoutBlock || depth > kMaxConstNesting) {
+    return false;
+  }
+  auto isConstant = [&](std::unique_ptr<Expr> const& e) { return IsConstantInitializer(e.get(), depth); };
+  switch (auto e = expr->as<ExprWithoutBlock>(); e->mType) {
+  case ExprWithoutBlock::Type::Literal: {
+    auto literal = e->as<LiteralExpr>();
+    if (literal->mKind == LiteralExpr::Kind::Identifier) {
+      return literal->mItem != nullptr && literal->mItem->mKind == Item::Kind::ConstantItem &&
+             IsConstantInitializer(literal->mItem->as<ConstantItem>()->mExpr.get(), depth + 1);
+    }
+    return literal->mKind != LiteralExpr::Kind::String;
+  }
+  case ExprWithoutBlock::Type::Grouped:
+    return isConstant(e->as<GroupedExpr>()->mExpr);
+  case ExprWithoutBlock::Type::Array:
+    return std::all_of(e->as<ArrayExpr>()->mElems.begin(), e->as<ArrayExpr>()->mElems.end(), isConstant);
+  case ExprWithoutBlock::Type::Tuple:
+    return std::all_of(e->as<TupleExpr>()->mElems.begin(), e->as<TupleExpr>()->mElems.end(), isConstant);
+  case ExprWithoutBlock::Type::Struct:
+    return std::all_of(e->as<StructExpr>()->mFields.begin(), e->as<StructExpr>()->mFields.end(),
+                       [&](auto const& init) { return isConstant(init.mValue); });
+  default:
+    return false;
+  }
+}
+
+// the initializer of a const or static has to fold completely, unless folding it already failed with an error
+auto ConstEvaluator::foldInitializer(std::string const& name, std::unique_ptr<Expr>& expr, char const* loc) -> void
+{
+  auto errors = mDiags.numErrors();
+  foldExpr(expr);
+  if (mDiags.numErrors() == errors && !IsConstantInitializer(expr.get())) {
+    mDiags.report(loc, DiagId::ErrNotConstant, name);
+  }
+}
+auto ConstEvaluator::foldItem(Item* item) -> void
+{
+  switch (item->mKind) {
+  case Item::Kind::Function:
+    if (auto fn = item->as<FunctionItem>(); !fn->isDeclaration()) {
+      foldBlockExpr(fn->mBody.get());
+    }
+    break;
+  case Item::Kind::ConstantItem: {
+    auto constant = item->as<ConstantItem>();
+    foldInitializer(constant->mName, constant->mExpr, constant->getLoc());
+  } break;
+  case Item::Kind::StaticItem: {
+    auto staticItem = item->as<StaticItem>();
+    foldInitializer(staticItem->mName, staticItem->mExpr, staticItem->getLoc());
+  } break;
+  default:
+    break;
+  }
+}
+
+auto ConstEvaluator::foldStmt(Stmt* stmt) -> void
+{
+  if (stmt == nullptr) {
+    return;
+  }
+  switch (stmt->mType) {
+  case Stmt::Type::Let:
+    return foldExpr(stmt->as<LetStmt>()->mExpr);
+  case Stmt::Type::Expression:
+    return foldExpr(stmt->as<ExprStmt>()->mExpr);
+  }
+}
+
+auto ConstEvaluator::foldBlockExpr(BlockExpr* expr) -> void
+{
+  for (auto& item : expr->mItems) {
+    foldItem(item.get());
+  }
+  for (auto& stmt : expr->mStmts) {
+    foldStmt(stmt.get());
+  }
+  foldExpr(expr->mReturn);
+}
+
+auto ConstEvaluator::foldExprWithBlock(ExprWithBlock* expr) -> void
+{
+  switch (expr->mType) {
+  case ExprWithBlock::Type::Block:
+    return foldBlockExpr(expr->as<BlockExpr>());
+  case ExprWithBlock::Type::If: {
+    auto ifExpr = expr->as<IfExpr>();
+    foldExpr(ifExpr->mCond);
+    foldBlockExpr(ifExpr->mThen.get());
+    if (ifExpr->mElse) {
+      foldExprWithBlock(ifExpr->mElse.get());
+    }
+  } break;
+  case ExprWithBlock::Type::Loop: {
+    auto loop = expr->as<LoopExpr>();
+    if (loop->mType == LoopExpr::Type::PredicateLoop) {
+      foldExpr(loop->as<PredicateLoopExpr>()->mCond);
+      foldBlockExpr(loop->as<PredicateLoopExpr>()->mExpr.get());
+    } else if (loop->mType == LoopExpr::Type::IteratorLoop) {
+      auto forLoop = loop->as<IteratorLoopExpr>();
+      foldExpr(forLoop->mStart);
+      foldExpr(forLoop->mEnd);
+      foldExpr(forLoop->mStep);
+      foldBlockExpr(forLoop->mExpr.get());
+    } else {
+      foldBlockExpr(loop->as<InfiniteLoopExpr>()->mExpr.get());
+    }
+  } break;
+  case ExprWithBlock::Type::IfLet:
+  case ExprWithBlock::Type::Match:
+    utils::Unimplemented(utils::SrcLoc::current());
+  }
+}
+
+auto ConstEvaluator::foldExpr(std::unique_ptr<Expr>& expr) -> void
+{
+  if (expr == nullptr) {
+    return;
+  }
+  if (expr->mType == Expr::Type::WithBlock) {
+    return foldExprWithBlock(expr->as<ExprWithBlock>());
+  }
+
+  // fold operands first so that only literal leaves are left to check
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    // a const that is a single value is inlined, an aggregate one is left to IRGen
+    if (auto item = e->as<LiteralExpr>()->mItem; item != nullptr && item->mKind == Item::Kind::ConstantItem) {
+      if (auto value = evaluate(expr.get()); value && !std::holds_alternative<std::monostate>(*value)) {
+        expr = ToLiteralExpr(*value, expr->getType(), ExprLoc(expr.get()));
+      }
+    }
+    return;
+  case ExprWithoutBlock::Type::Grouped:
+    foldExpr(e->as<GroupedExpr>()->mExpr);
+    break;
+  case ExprWithoutBlock::Type::Operator:
+    if (auto op = e->as<OperatorExpr>(); op->mType == OperatorExpr::Type::Binary) {
+      foldExpr(op->as<BinaryExpr>()->mLeft);
+      foldExpr(op->as<BinaryExpr>()->mRight);
+    } else {
+      foldExpr(op->as<UnaryExpr>()->mRight);
+    }
+    break;
+  case ExprWithoutBlock::Type::Call:
+    for (auto& arg : e->as<CallExpr>()->mArgs) {
+      foldExpr(arg);
+    }
+    break;
+  case ExprWithoutBlock::Type::Return:
+    foldExpr(e->as<ReturnExpr>()->mExpr);
+    return;
+  case ExprWithoutBlock::Type::Index:
+    foldExpr(e->as<IndexExpr>()->mBase);
+    foldExpr(e->as<IndexExpr>()->mIndex);
+    return;
+  case ExprWithoutBlock::Type::MethodCall:
+    foldExpr(e->as<MethodCallExpr>()->mReceiver);
+    for (auto& arg : e->as<MethodCallExpr>()->mArgs) {
+      foldExpr(arg);
+    }
+    return;
+  case ExprWithoutBlock::Type::Array:
+    for (auto& elem : e->as<ArrayExpr>()->mElems) {
+      foldExpr(elem);
+    }
+    return;
+  case ExprWithoutBlock::Type::Struct:
+    for (auto& init : e->as<StructExpr>()->mFields) {
+      foldExpr(init.mValue);
+    }
+    return;
+  case ExprWithoutBlock::Type::Field:
+    foldExpr(e->as<FieldExpr>()->mBase);
+    return;
+  case ExprWithoutBlock::Type::Tuple:
+    for (auto& elem : e->as<TupleExpr>()->mElems) {
+      foldExpr(elem);
+    }
+    return;
+  }
+
+  if (!isFoldable(expr.get())) {
+    return;
+  }
+  if (auto value = evaluate(expr.get()); value && !std::holds_alternative<std::monostate>(*value)) {
+    expr = ToLiteralExpr(*value, expr->getType(), ExprLoc(expr.get()));
+  }
+}
+
+// whether every operand is a literal value, identifiers are never constant outside of a const fn
+auto ConstEvaluator::isFoldable(Expr* expr) -> bool
+{
+  auto isValue = [](std::unique_ptr<Expr> const& e) {
+    if (e == nullptr || e->mType != Expr::Type::WithoutBlock) {
+      return false;
+    }
+    auto w = e->as<ExprWithoutBlock>();
+    return w->mType == ExprWithoutBlock::Type::Literal &&
+           w->as<LiteralExpr>()->mKind != LiteralExpr::Kind::Identifier &&
+           w->as<LiteralExpr>()->mKind != LiteralExpr::Kind::String;
+  };
+
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Grouped:
+    return isValue(e->as<GroupedExpr>()->mExpr);
+  case ExprWithoutBlock::Type::Operator:
+    if (auto op = e->as<OperatorExpr>(); op->mType == OperatorExpr::Type::Binary) {
+      auto bin = op->as<BinaryExpr>();
+      if (bin->mKind == BinaryExpr::Kind::LogicalAnd || bin->mKind == BinaryExpr::Kind::LogicalOr) {
+        // `false && x` is false whatever `x` is, which is then never evaluated
+        return isValue(bin->mLeft) &&
+               (isValue(bin->mRight) || std::get<bool>(bin->mLeft->as<ExprWithoutBlock>()->as<LiteralExpr>()->mValue) ==
+                                            (bin->mKind == BinaryExpr::Kind::LogicalOr));
+      }
+      return bin->mKind != BinaryExpr::Kind::Assignment && isValue(bin->mLeft) && isValue(bin->mRight);
+    } else {
+      auto unary = op->as<UnaryExpr>();
+      return (unary->mKind == UnaryExpr::Kind::Neg || unary->mKind == UnaryExpr::Kind::Not) &&
+             isValue(unary->mRight);
+    }
+  case ExprWithoutBlock::Type::Call: {
+    auto call = e->as<CallExpr>();
+    return call->mFnItem && call->mFnItem->mIsConst && !call->mFnItem->isDeclaration() &&
+           std::all_of(call->mArgs.begin(), call->mArgs.end(), isValue);
+  }
+  default:
+    return false;
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Evaluation
+//===----------------------------------------------------------------------===//
+
+auto ConstEvaluator::evaluate(Expr* expr) -> std::optional<ConstValue>
+{
+  mSteps = 0;
+  mDepth = 0;
+  mLimitExceeded = false;
+  mDepthExceeded = false;
+  mReturning = false;
+  mEnv.clear();
+  return evalExpr(expr);
+}
+
+auto ConstEvaluator::lookup(std::string const& name) -> ConstValue*
+{
+  for (auto it = mEnv.rbegin(); it != mEnv.rend(); ++it) {
+    if (auto found = it->find(name); found != it->end()) {
+      return &found->second;
+    }
+  }
+  return nullptr;
+}
+
+auto ConstEvaluator::evalExpr(Expr* expr) -> std::optional<ConstValue>
+{
+  if (expr == nullptr) {
+    return ConstValue{};
+  }
+  if (++mSteps > mStepLimit) {
+    mLimitExceeded = true;
+    return std::nullopt;
+  }
+
+  if (expr->mType == Expr::Type::WithBlock) {
+    auto e = expr->as<ExprWithBlock>();
+    switch (e->mType) {
+    case ExprWithBlock::Type::Block:
+      return evalBlockExpr(e->as<BlockExpr>());
+    case ExprWithBlock::Type::If:
+      return evalIfExpr(e->as<IfExpr>());
+    case ExprWithBlock::Type::Loop:
+      return evalLoopExpr(e->as<LoopExpr>());
+    case ExprWithBlock::Type::IfLet:
+    case ExprWithBlock::Type::Match:
+      return std::nullopt;
+    }
+  }
+
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    return evalLiteralExpr(e->as<LiteralExpr>());
+  case ExprWithoutBlock::Type::Grouped:
+    return evalExpr(e->as<GroupedExpr>()->mExpr.get());
+  case ExprWithoutBlock::Type::Operator:
+    if (auto op = e->as<OperatorExpr>(); op->mType == OperatorExpr::Type::Binary) {
+      return evalBinaryExpr(op->as<BinaryExpr>());
+    } else {
+      return evalUnaryExpr(op->as<UnaryExpr>());
+    }
+  case ExprWithoutBlock::Type::Call:
+    return evalCallExpr(e->as<CallExpr>());
+  case ExprWithoutBlock::Type::Return: {
+    if (mEnv.empty()) { // not inside a const fn
+      return std::nullopt;
+    }
+    auto value = evalExpr(e->as<ReturnExpr>()->mExpr.get());
+    if (!value) {
+      return std::nullopt;
+    }
+    mReturnValue = *value;
+    mReturning = true;
+    return ConstValue{};
+  }
+  case ExprWithoutBlock::Type::Index: // there are no slice, array, struct or tuple values at compile time
+  case ExprWithoutBlock::Type::MethodCall:
+  case ExprWithoutBlock::Type::Array:
+  case ExprWithoutBlock::Type::Struct:
+  case ExprWithoutBlock::Type::Field:
+  case ExprWithoutBlock::Type::Tuple:
+    return std::nullopt;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+auto ConstEvaluator::evalStmt(Stmt* stmt) -> bool
+{
+  if (stmt == nullptr) {
+    return true;
+  }
+  switch (stmt->mType) {
+  case Stmt::Type::Let: {
+    auto let = stmt->as<LetStmt>();
+    auto value = evalExpr(let->mExpr.get());
+    if (!value || mEnv.empty() || let->mPattern) {
+      return false;
+    }
+    if (!mReturning) {
+      mEnv.back()[let->mName] = *value;
+    }
+    return true;
+  }
+  case Stmt::Type::Expression:
+    return evalExpr(stmt->as<ExprStmt>()->mExpr.get()).has_value();
+  }
+  return false;
+}
+
+auto ConstEvaluator::evalBlockExpr(BlockExpr* expr) -> std::optional<ConstValue>
+{
+  mEnv.emplace_back();
+  std::optional<ConstValue> result = ConstValue{};
+  for (auto& stmt : expr->mStmts) {
+    if (!evalStmt(stmt.get())) {
+      result = std::nullopt;
+      break;
+    }
+    if (mReturning) {
+      break;
+    }
+  }
+  if (result && !mReturning && expr->mReturn) {
+    result = evalExpr(expr->mReturn.get());
+  }
+  mEnv.pop_back();
+  return result;
+}
+
+auto ConstEvaluator::evalIfExpr(IfExpr* expr) -> std::optional<ConstValue>
+{
+  auto cond = evalExpr(expr->mCond.get());
+  if (!cond || mReturning) {
+    return cond;
+  }
+  if (!std::holds_alternative<bool>(*cond)) {
+    return std::nullopt;
+  }
+  if (std::get<bool>(*cond)) {
+    return evalBlockExpr(expr->mThen.get());
+  }
+  if (expr->mElse) {
+    return evalExpr(expr->mElse.get());
+  }
+  return ConstValue{};
+}
+
+auto ConstEvaluator::evalLoopExpr(LoopExpr* expr) -> std::optional<ConstValue>
+{
+  if (expr->mType == LoopExpr::Type::IteratorLoop) {
+    return evalIteratorLoopExpr(expr->as<IteratorLoopExpr>());
+  }
+  // there is no `break`, a loop is only left through its predicate or a `return`
+  while (true) {
+    BlockExpr* body = nullptr;
+    if (expr->mType == LoopExpr::Type::PredicateLoop) {
+      auto loop = expr->as<PredicateLoopExpr>();
+      auto cond = evalExpr(loop->mCond.get());
+      if (!cond || mReturning) {
+        return cond;
+      }
+      if (!std::holds_alternative<bool>(*cond)) {
+        return std::nullopt;
+      }
+      if (!std::get<bool>(*cond)) {
+        return ConstValue{};
+      }
+      body = loop->mExpr.get();
+    } else {
+      body = expr->as<InfiniteLoopExpr>()->mExpr.get();
+    }
+    if (!evalBlockExpr(body) || mReturning) {
+      return mReturning ? std::optional<ConstValue>(ConstValue{}) : std::nullopt;
+    }
+  }
+}
+
+// the loop variable gets a scope of its own in every iteration, so assigning it does not change the iteration. A step
+// that is not positive traps at runtime and is left for it
+auto ConstEvaluator::evalIteratorLoopExpr(IteratorLoopExpr* expr) -> std::optional<ConstValue>
+{
+  auto start = evalExpr(expr->mStart.get());
+  if (!start || mReturning) {
+    return start;
+  }
+  auto end = evalExpr(expr->mEnd.get());
+  if (!end || mReturning) {
+    return end;
+  }
+  auto step = expr->mStep ? evalExpr(expr->mStep.get()) : std::optional<ConstValue>{};
+  if (expr->mStep && (!step || mReturning)) {
+    return step;
+  }
+  return std::visit(
+      [&]<typename T>(T value) -> std::optional<ConstValue> {
+        if constexpr (!std::is_integral_v<T> || std::is_same_v<T, bool>) {
+          return std::nullopt;
+        } else {
+          if (!std::holds_alternative<T>(*end) || (step && !std::holds_alternative<T>(*step))) {
+            return std::nullopt;
+          }
+          auto by = step ? std::get<T>(*step) : T{1};
+          if (!(by > T{0})) {
+            return std::nullopt;
+          }
+          while (value < std::get<T>(*end)) {
+            if (++mSteps > mStepLimit) {
+              mLimitExceeded = true;
+              return std::nullopt;
+            }
+            mEnv.push_back({{expr->mName, value}});
+            auto result = evalBlockExpr(expr->mExpr.get());
+            mEnv.pop_back();
+            if (!result || mReturning) {
+              return mReturning ? std::optional<ConstValue>(ConstValue{}) : std::nullopt;
+            }
+            if (__builtin_add_overflow(value, by, &value)) {
+              break;
+            }
+          }
+          return ConstValue{};
+        }
+      },
+      *start);
+}
+
+auto ConstEvaluator::evalLiteralExpr(LiteralExpr* expr) -> std::optional<ConstValue>
+{
+  switch (expr->mKind) {
+  case LiteralExpr::Kind::Identifier: {
+    if (auto value = lookup(std::get<std::string>(expr->mValue))) {
+      return *value;
+    }
+    if (expr->mItem != nullptr && expr->mItem->mKind == Item::Kind::ConstantItem) {
+      return evalConstantItem(expr->mItem->as<ConstantItem>());
+    }
+    return std::nullopt; // a static is only known at runtime
+  }
+  case LiteralExpr::Kind::String:
+    return std::nullopt;
+  default:
+    return std::visit(
+        []<typename T>(T const& v) -> std::optional<ConstValue> {
+          if constexpr (std::is_same_v<T, std::string>) {
+            return std::nullopt;
+          } else {
+            return ConstValue{v};
+          }
+        },
+        expr->mValue);
+  }
+}
+
+// the initializer sees no locals, like the body of a callee. Consts that refer to each other in a cycle run into the
+// call depth limit
+auto ConstEvaluator::evalConstantItem(ConstantItem* item) -> std::optional<ConstValue>
+{
+  if (mDepth >= kMaxCallDepth) {
+    mDepthExceeded = true;
+    return std::nullopt;
+  }
+  auto outerEnv = std::move(mEnv);
+  mEnv.clear();
+  ++mDepth;
+  auto result = evalExpr(item->mExpr.get());
+  --mDepth;
+  mEnv = std::move(outerEnv);
+  return result;
+}
+
+auto ConstEvaluator::evalUnaryExpr(UnaryExpr* expr) -> std::optional<ConstValue>
+{
+  if (expr->mKind != UnaryExpr::Kind::Neg && expr->mKind != UnaryExpr::Kind::Not) {
+    return std::nullopt; // memory is not modelled
+  }
+  auto value = evalExpr(expr->mRight.get());
+  if (!value || mReturning) {
+    return value;
+  }
+  ConstValue result;
+  auto status = std::visit(
+      [&]<typename T>(T const& v) {
+        if constexpr (std::is_same_v<T, std::monostate>) {
+          return ArithStatus::Invalid;
+        } else {
+          return EvalUnary(expr->mKind, v, result);
+        }
+      },
+      *value);
+  switch (status) {
+  case ArithStatus::Ok:
+    return result;
+  case ArithStatus::Overflow:
+    mDiags.report(expr->getLoc(), DiagId::ErrConstUnaryOverflow, expr->mKind == UnaryExpr::Kind::Neg ? "-" : "!",
+                  ValueToString(*value));
+    return std::nullopt;
+  default:
+    return std::nullopt;
+  }
+}
+
+auto ConstEvaluator::evalBinaryExpr(BinaryExpr* expr) -> std::optional<ConstValue>
+{
+  if (expr->mKind == BinaryExpr::Kind::Assignment) {
+    return evalAssignment(expr);
+  }
+  auto lhs = evalExpr(expr->mLeft.get());
+  if (!lhs || mReturning) {
+    return lhs;
+  }
+  if (expr->mKind == BinaryExpr::Kind::LogicalAnd || expr->mKind == BinaryExpr::Kind::LogicalOr) {
+    if (!std::holds_alternative<bool>(*lhs)) {
+      return std::nullopt;
+    }
+    // the right operand only runs when the left one does not decide
+    if (std::get<bool>(*lhs) == (expr->mKind == BinaryExpr::Kind::LogicalOr)) {
+      return lhs;
+    }
+    return evalExpr(expr->mRight.get());
+  }
+  auto rhs = evalExpr(expr->mRight.get());
+  if (!rhs || mReturning) {
+    return rhs;
+  }
+  if (lhs->index() != rhs->index()) {
+    return std::nullopt;
+  }
+
+  ConstValue result;
+  auto status = std::visit(
+      [&]<typename T>(T const& l) {
+        if constexpr (std::is_same_v<T, std::monostate>) {
+          return ArithStatus::Invalid;
+        } else {
+          return EvalBinary(expr->mKind, l, std::get<T>(*rhs), result);
+        }
+      },
+      *lhs);
+
+  switch (status) {
+  case ArithStatus::Ok:
+    return result;
+  case ArithStatus::Overflow:
+    mDiags.report(expr->getLoc(), DiagId::ErrConstOverflow, ValueToString(*lhs), BinaryOpSpelling(expr->mKind),
+                  ValueToString(*rhs));
+    return std::nullopt;
+  case ArithStatus::DivByZero:
+    mDiags.report(expr->getLoc(), DiagId::ErrConstDivByZero, ValueToString(*lhs), BinaryOpSpelling(expr->mKind),
+                  ValueToString(*rhs));
+    return std::nullopt;
+  case ArithStatus::Invalid:
+    return std::nullopt;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+auto ConstEvaluator::evalAssignment(BinaryExpr* expr) -> std::optional<ConstValue>
+{
+  auto target = expr->mLeft.get();
+  if (target->mType != Expr::Type::WithoutBlock ||
+      target->as<ExprWithoutBlock>()->mType != ExprWithoutBlock::Type::Literal) {
+    return std::nullopt;
+  }
+  auto literal = target->as<ExprWithoutBlock>()->as<LiteralExpr>();
+  if (literal->mKind != LiteralExpr::Kind::Identifier) {
+    return std::nullopt;
+  }
+  auto slot = lookup(std::get<std::string>(literal->mValue));
+  if (slot == nullptr) {
+    return std::nullopt;
+  }
+  auto value = evalExpr(expr->mRight.get());
+  if (!value || mReturning) {
+    return value;
+  }
+  *slot = *value;
+  return ConstValue{};
+}
+
+auto ConstEvaluator::evalCallExpr(CallExpr* expr) -> std::optional<ConstValue>
+{
+  auto fn = expr->mFnItem;
+  if (fn == nullptr || !fn->mIsConst || fn->isDeclaration() || fn->mParamNames.size() != expr->mArgs.size()) {
+    return std::nullopt;
+  }
+
+  std::unordered_map<std::string, ConstValue> params;
+  for (size_t i = 0; i < expr->mArgs.size(); ++i) {
+    auto arg = evalExpr(expr->mArgs[i].get());
+    if (!arg || mReturning) {
+      return arg;
+    }
+    params[fn->mParamNames[i]] = *arg;
+  }
+
+  if (mDepth >= kMaxCallDepth) {
+    mDepthExceeded = true;
+    return std::nullopt;
+  }
+
+  // the callee only sees its own parameters
+  auto callerEnv = std::move(mEnv);
+  mEnv.clear();
+  mEnv.push_back(std::move(params));
+  ++mDepth;
+  auto result = evalBlockExpr(fn->mBody.get());
+  --mDepth;
+  mEnv = std::move(callerEnv);
+
+  if (result && mReturning) {
+    result = mReturnValue;
+    mReturning = false;
+  }
+  if (!result && mDepth == 0) {
+    if (mLimitExceeded) {
+      mDiags.report(expr->getLoc(), DiagId::WarnConstEvalLimit, fn->mName, mStepLimit);
+    } else if (mDepthExceeded) {
+      mDiags.report(expr->getLoc(), DiagId::WarnConstEvalDepth, fn->mName, kMaxCallDepth);
+    }
+  }
+  return result;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Frontend/Diagnostic.hpp"
+#include "Frontend/Syntax.hpp"
+#include <optional>
+#include <unordered_map>
+
+// value of a constant expression, std::monostate stands for unit
+using ConstValue = std::variant<std::monostate, bool, i8, i16, i32, i64, u8, u16, u32, u64, float, double>;
+
+// Evaluates expressions of the typed AST at compile time. Calls to `const fn` are run in a small interpreter that
+// gives up once it has taken more than `stepLimit` steps or nested more than kMaxCallDepth calls, leaving the call
+// for runtime.
+class ConstEvaluator {
+  DiagnosticsEngine& mDiags;
+  u64 mStepLimit;
+  u64 mSteps = 0;
+  u32 mDepth = 0;
+  bool mLimitExceeded = false; // ran out of steps
+  bool mDepthExceeded = false; // nested deeper than kMaxCallDepth
+  bool mReturning = false; // unwinding a `return` inside a const fn
+  ConstValue mReturnValue;
+  std::vector<std::unordered_map<std::string, ConstValue>> mEnv; // scopes of the const fn being interpreted
+
+  static constexpr u32 kMaxCallDepth = 256;
+
+public:
+  ConstEvaluator(DiagnosticsEngine& diags, u64 stepLimit = 1'000'000) : mDiags(diags), mStepLimit(stepLimit) {}
+
+  // evaluates an expression that has no free local variables, nullopt if it is not constant
+  auto evaluate(Expr* expr) -> std::optional<ConstValue>;
+
+  // replaces every constant operator expression, const fn call and use of a const in the crate by a LiteralExpr
+  auto foldCrate(Crate* crate) -> void;
+  auto foldItem(Item* item) -> void;
+
+  static auto ToLiteralExpr(ConstValue const& value, TypeBase const* type, char const* loc)
+      -> std::unique_ptr<LiteralExpr>;
+
+private:
+  auto foldStmt(Stmt* stmt) -> void;
+  auto foldBlockExpr(BlockExpr* expr) -> void;
+  auto foldExprWithBlock(ExprWithBlock* expr) -> void;
+  auto foldExpr(std::unique_ptr<Expr>& expr) -> void;
+  auto foldInitializer(std::string const& name, std::unique_ptr<Expr>& expr, char const* loc) -> void;
+  auto isFoldable(Expr* expr) -> bool;
+
+  auto evalExpr(Expr* expr) -> std::optional<ConstValue>;
+  auto evalStmt(Stmt* stmt) -> bool;
+  auto evalBlockExpr(BlockExpr* expr) -> std::optional<ConstValue>;
+  auto evalIfExpr(IfExpr* expr) -> std::optional<ConstValue>;
+  auto evalLoopExpr(LoopExpr* expr) -> std::optional<ConstValue>;
+  auto evalIteratorLoopExpr(IteratorLoopExpr* expr) -> std::optional<ConstValue>;
+  auto evalLiteralExpr(LiteralExpr* expr) -> std::optional<ConstValue>;
+  auto evalUnaryExpr(UnaryExpr* expr) -> std::optional<ConstValue>;
+  auto evalBinaryExpr(BinaryExpr* expr) -> std::optional<ConstValue>;
+  auto evalAssignment(BinaryExpr* expr) -> std::optional<ConstValue>;
+  auto evalCallExpr(CallExpr* expr) -> std::optional<ConstValue>;
+  auto evalConstantItem(ConstantItem* item) -> std::optional<ConstValue>;
+
+  auto lookup(std::string const& name) -> ConstValue*;
+};
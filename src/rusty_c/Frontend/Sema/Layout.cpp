@@ -0,0 +1,208 @@
+#include "Layout.hpp"
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <bit>
+
+static auto AlignTo(u64 value, u64 align) -> u64 { return (value + align - 1) / align * align; }
+
+auto LoweredAlign(TypeBase const* type) -> u64
+{
+  switch (type->mKind) {
+  case TypeBase::Kind::Struct:
+    return 1;
+  case TypeBase::Kind::Array:
+    return LoweredAlign(type->as<ArrayType>()->mElem.get());
+  case TypeBase::Kind::Tuple: {
+    auto align = u64{1};
+    for (auto& elem : type->as<TupleType>()->mTypes) {
+      align = LayoutOf(elem.get()).mSize == 0 ? align : std::max(align, LoweredAlign(elem.get()));
+    }
+    return align;
+  }
+  default:
+    return LayoutOf(type).mAlign;
+  }
+}
+
+// elements stay in order, zero sized ones take no room and impose no alignment
+static auto TupleLayout(TupleType const* type, std::vector<u64>* offsets) -> TypeLayout
+{
+  auto offset = u64{0};
+  auto align = u64{1};
+  for (auto& elem : type->mTypes) {
+    auto layout = LayoutOf(elem.get());
+    if (layout.mSize != 0) {
+      offset = AlignTo(offset, layout.mAlign);
+      align = std::max(align, layout.mAlign);
+    }
+    if (offsets != nullptr) {
+      offsets->push_back(offset);
+    }
+    offset += layout.mSize;
+  }
+  return {AlignTo(offset, align), align};
+}
+
+auto HasLayout(TypeBase const* type) -> bool
+{
+  switch (type->mKind) {
+  case TypeBase::Kind::Boolean:
+  case TypeBase::Kind::I8:
+  case TypeBase::Kind::I16:
+  case TypeBase::Kind::I32:
+  case TypeBase::Kind::I64:
+  case TypeBase::Kind::U8:
+  case TypeBase::Kind::U16:
+  case TypeBase::Kind::U32:
+  case TypeBase::Kind::U64:
+  case TypeBase::Kind::F32:
+  case TypeBase::Kind::F64:
+  case TypeBase::Kind::Slice:
+  case TypeBase::Kind::Vector:
+  case TypeBase::Kind::Reference:
+  case TypeBase::Kind::RawPointer:
+    return true;
+  case TypeBase::Kind::Array:
+    return HasLayout(type->as<ArrayType>()->mElem.get());
+  case TypeBase::Kind::Struct:
+    return type->as<StructType>()->mItem != nullptr;
+  case TypeBase::Kind::Tuple: {
+    // the unit type has no values to store, as an element it is erased
+    auto const& elems = type->as<TupleType>()->mTypes;
+    return !elems.empty() && std::all_of(elems.begin(), elems.end(), [](std::unique_ptr<TypeBase> const& elem) {
+      return HasLayout(elem.get()) || (elem->mKind == TypeBase::Kind::Tuple && elem->as<TupleType>()->isUnit());
+    });
+  }
+  default:
+    return false;
+  }
+}
+
+auto LayoutOf(TypeBase const* type) -> TypeLayout
+{
+  switch (type->mKind) {
+  case TypeBase::Kind::Boolean:
+  case TypeBase::Kind::I8:
+  case TypeBase::Kind::U8:
+    return {1, 1};
+  case TypeBase::Kind::I16:
+  case TypeBase::Kind::U16:
+    return {2, 2};
+  case TypeBase::Kind::I32:
+  case TypeBase::Kind::U32:
+  case TypeBase::Kind::F32:
+    return {4, 4};
+  case TypeBase::Kind::I64:
+  case TypeBase::Kind::U64:
+  case TypeBase::Kind::F64:
+    return {8, 8};
+  case TypeBase::Kind::Reference:
+  case TypeBase::Kind::RawPointer:
+    return {8, 8};
+  case TypeBase::Kind::Slice:
+    return {16, 8}; // pointer and length
+  case TypeBase::Kind::Array: {
+    auto array = type->as<ArrayType>();
+    auto elem = LayoutOf(array->mElem.get());
+    return {elem.mSize * array->mLen, elem.mAlign};
+  }
+  case TypeBase::Kind::Vector: {
+    // a mask takes a bit per lane, vectors are aligned to their size
+    auto vec = type->as<VectorType>();
+    auto bits = vec->isMask() ? vec->mLanes : vec->mLanes * LayoutOf(vec->mElem.get()).mSize * 8;
+    auto size = std::bit_ceil(std::max<u64>((bits + 7) / 8, 1));
+    return {size, size};
+  }
+  case TypeBase::Kind::Struct: {
+    auto const& layout = type->as<StructType>()->mItem->mLayout;
+    return {layout.mSize, layout.mAlign};
+  }
+  case TypeBase::Kind::Tuple:
+    return TupleLayout(type->as<TupleType>(), nullptr); // {0, 1} for the unit type
+  default:
+    utils::Unreachable(utils::SrcLoc::current());
+  }
+}
+
+auto TupleElementOffset(TupleType const* type, u32 index) -> u64
+{
+  auto offsets = std::vector<u64>{};
+  TupleLayout(type, &offsets);
+  return offsets[index];
+}
+
+// every size is a multiple of its alignment, so sorting by decreasing alignment leaves padding only at the end
+auto ComputeStructLayout(StructItem const* item) -> StructLayout
+{
+  auto layout = StructLayout{};
+  auto count = item->mFields.size();
+  layout.mOffsets.resize(count);
+  layout.mMemoryOrder.resize(count);
+  std::iota(layout.mMemoryOrder.begin(), layout.mMemoryOrder.end(), 0u);
+  if (!item->mReprC && !item->mPacked) {
+    std::stable_sort(layout.mMemoryOrder.begin(), layout.mMemoryOrder.end(), [&](u32 lhs, u32 rhs) {
+      return LayoutOf(item->mFields[lhs].mType.get()).mAlign > LayoutOf(item->mFields[rhs].mType.get()).mAlign;
+    });
+  }
+  auto offset = u64{0};
+  for (auto i : layout.mMemoryOrder) {
+    auto field = LayoutOf(item->mFields[i].mType.get());
+    auto align = item->mPacked ? 1 : field.mAlign;
+    offset = AlignTo(offset, align);
+    layout.mOffsets[i] = offset;
+    offset += field.mSize;
+    layout.mAlign = std::max(layout.mAlign, align);
+  }
+  layout.mAlign = std::max(layout.mAlign, item->mMinAlign);
+  layout.mSize = AlignTo(offset, layout.mAlign);
+  return layout;
+}
+
+auto PrintStructLayout(llvm::raw_ostream& os, StructItem const* item) -> void
+{
+  auto const& layout = item->mLayout;
+  auto reprs = std::vector<std::string>{};
+  if (item->mReprC) {
+    reprs.push_back("C");
+  }
+  if (item->mPacked) {
+    reprs.push_back("packed");
+  }
+  if (item->mMinAlign > 1) {
+    reprs.push_back("align(" + std::to_string(item->mMinAlign) + ")");
+  }
+  auto used = u64{0};
+  for (auto const& field : item->mFields) {
+    used += LayoutOf(field.mType.get()).mSize;
+  }
+  os << "type `" << item->mName << "`: " << layout.mSize << " bytes, alignment " << layout.mAlign << ", "
+     << layout.mSize - used << " bytes of padding";
+  if (!reprs.empty()) {
+    os << ", repr(";
+    for (size_t i = 0; i < reprs.size(); ++i) {
+      os << (i == 0 ? "" : ", ") << reprs[i];
+    }
+    os << ")";
+  }
+  if (!std::is_sorted(layout.mMemoryOrder.begin(), layout.mMemoryOrder.end())) {
+    os << ", fields reordered";
+  }
+  os << "\n";
+
+  auto offset = u64{0};
+  auto printPadding = [&](u64 end) {
+    if (end > offset) {
+      os << "    offset " << offset << ": padding, " << end - offset << " bytes\n";
+    }
+  };
+  for (auto i : layout.mMemoryOrder) {
+    auto const& field = item->mFields[i];
+    auto size = LayoutOf(field.mType.get()).mSize;
+    printPadding(layout.mOffsets[i]);
+    os << "    offset " << layout.mOffsets[i] << ": field `" << field.mName << "`: " << TypeToString(field.mType.get())
+       << ", " << size << " bytes\n";
+    offset = layout.mOffsets[i] + size;
+  }
+  printPadding(layout.mSize);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Frontend/Syntax.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+struct TypeLayout {
+  u64 mSize;
+  u64 mAlign;
+};
+
+// whether values of the type have a place in memory, only those can be fields of a struct
+auto HasLayout(TypeBase const* type) -> bool;
+// size and alignment in memory, the same as LLVM gives the lowered type. Structs have to be laid out already
+auto LayoutOf(TypeBase const* type) -> TypeLayout;
+// alignment LLVM gives the lowered type, below LayoutOf's for structs as they are lowered packed
+auto LoweredAlign(TypeBase const* type) -> u64;
+// offset of an element of a tuple
+auto TupleElementOffset(TupleType const* type, u32 index) -> u64;
+// places the fields of a struct whose field types all have a layout
+auto ComputeStructLayout(StructItem const* item) -> StructLayout;
+// `--print-type-layouts`, the fields in memory order and the padding between them
+auto PrintStructLayout(llvm::raw_ostream& os, StructItem const* item) -> void;
@@ -1,11 +1,47 @@
 #include "Sema.hpp"
+#include "Layout.hpp"
 #include "utils/utils.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <charconv>
+
 auto Sema::actOnCrate(Crate const* crate) -> void
 {
   auto guard = enterScope();
   for (auto& item : crate->mItems) {
+    declareItem(item.get());
+  }
+  resolveItemTypes(crate->mItems);
+  // const fns, consts and statics go first, so they are complete when calls to them in other functions are folded.
+  // All of them are checked before any is handed on, folding an initializer may call any const fn and a const fn is
+  // only handed on once the consts it uses are folded
+  auto isConstEvaluated = [](Item* item) {
+    return item->mKind == Item::Kind::ConstantItem || item->mKind == Item::Kind::StaticItem ||
+           (item->mKind == Item::Kind::Function && item->as<FunctionItem>()->mIsConst);
+  };
+  for (auto& item : crate->mItems) {
+    if (isConstEvaluated(item.get())) {
+      actOnItem(item.get());
+    }
+  }
+  if (mOnItemChecked) {
+    for (auto initializersFirst : {true, false}) {
+      for (auto& item : crate->mItems) {
+        if (isConstEvaluated(item.get()) && (item->mKind != Item::Kind::Function) == initializersFirst) {
+          mOnItemChecked(item.get());
+        }
+      }
+    }
+  }
+  for (auto& item : crate->mItems) {
+    if (isConstEvaluated(item.get())) {
+      continue;
+    }
     actOnItem(item.get());
+    if (mOnItemChecked && item->mKind == Item::Kind::Function) {
+      mOnItemChecked(item.get());
+    }
   }
 }
 
@@ -26,8 +62,18 @@ auto Sema::actOnExprWithBlock(ExprWithBlock* expr) -> std::unique_ptr<TypeBase>
   utils::Unreachable(utils::SrcLoc::current());
 }
 auto Sema::actOnBlockExpr(BlockExpr* expr) -> std::unique_ptr<TypeBase>
+{
+  auto type = actOnBlockExprImpl(expr);
+  expr->mExprType = TypeClone(type);
+  return type;
+}
+auto Sema::actOnBlockExprImpl(BlockExpr* expr) -> std::unique_ptr<TypeBase>
 {
   auto guard = enterScope();
+  for (auto& item : expr->mItems) {
+    declareItem(item.get());
+  }
+  resolveItemTypes(expr->mItems);
   for (auto& item : expr->mItems) {
     actOnItem(item.get());
   }
@@ -55,31 +101,43 @@ auto Sema::actOnIfExpr(IfExpr* expr) -> std::unique_ptr<TypeBase>
 {
   actOnExpr(expr->mCond.get());
   auto thenType = actOnBlockExpr(expr->mThen.get());
+  if (!expr->mElse) {
+    thenType = std::make_unique<TupleType>(); // if without else is always unit
+  }
   if (expr->mElse) {
     assert(expr->mElse->mType == ExprWithBlock::Type::Block || expr->mElse->mType == ExprWithBlock::Type::If ||
            expr->mElse->mType == ExprWithBlock::Type::IfLet);
     auto elseType = actOnExprWithBlock(expr->mElse.get());
-    if (!TypeEquals(thenType.get(), elseType.get())) {
+    if (thenType->mKind != TypeBase::Kind::Never && elseType->mKind != TypeBase::Kind::Never &&
+        !TypeEquals(thenType.get(), elseType.get())) {
       mDiags.report((expr->mLoc), DiagId::ErrIncompatibleTypes, "if else expression", TypeToString(thenType.get()),
                     TypeToString(elseType.get()));
     }
+    if (thenType->mKind == TypeBase::Kind::Never) {
+      thenType = std::move(elseType);
+    }
   }
+  expr->mExprType = TypeClone(thenType);
   return thenType;
 }
+static auto IsInteger(TypeBase const* type) -> bool;
 auto Sema::actOnLoopExpr(LoopExpr* expr) -> std::unique_ptr<TypeBase>
 {
+  checkLoopAttributes(expr);
   switch (expr->mType) {
   case LoopExpr::Type::InfiniteLoop:
     return actOnInfiniteLoopExpr(expr->as<InfiniteLoopExpr>());
   case LoopExpr::Type::PredicateLoop:
     return actOnPredicateLoopExpr(expr->as<PredicateLoopExpr>());
+  case LoopExpr::Type::IteratorLoop:
+    return actOnIteratorLoopExpr(expr->as<IteratorLoopExpr>());
   }
   utils::Unimplemented(utils::SrcLoc::current());
 }
 auto Sema::actOnInfiniteLoopExpr(InfiniteLoopExpr* expr) -> std::unique_ptr<TypeBase>
 {
   actOnBlockExpr(expr->mExpr.get());
-  return std::make_unique<TupleType>(); // return unit
+  return std::make_unique<Never>(); // there is no `break`, so it never yields
 }
 auto Sema::actOnPredicateLoopExpr(PredicateLoopExpr* expr) -> std::unique_ptr<TypeBase>
 {
@@ -87,6 +145,35 @@ auto Sema::actOnPredicateLoopExpr(PredicateLoopExpr* expr) -> std::unique_ptr<Ty
   actOnBlockExpr(expr->mExpr.get());
   return std::make_unique<TupleType>(); // return unit
 }
+// the bounds and the step share one integer type, which is that of the loop variable
+auto Sema::actOnIteratorLoopExpr(IteratorLoopExpr* expr) -> std::unique_ptr<TypeBase>
+{
+  auto type = actOnExpr(expr->mStart.get());
+  auto endType = actOnExpr(expr->mEnd.get());
+  if (!IsInteger(type.get())) {
+    mDiags.report(expr->getLoc(), DiagId::ErrInvalidRangeType, TypeToString(type.get()));
+    type = std::make_unique<Unknown>();
+  } else if (!IsInteger(endType.get())) {
+    mDiags.report(expr->getLoc(), DiagId::ErrInvalidRangeType, TypeToString(endType.get()));
+  } else if (type->mKind == TypeBase::Kind::Unknown) {
+    type = std::move(endType);
+  } else if (!TypeEquals(type.get(), endType.get()) && endType->mKind != TypeBase::Kind::Unknown) {
+    mDiags.report(expr->getLoc(), DiagId::ErrIncompatibleTypes, "range bounds", TypeToString(type.get()),
+                  TypeToString(endType.get()));
+  }
+  if (expr->mStep) {
+    auto stepType = actOnExpr(expr->mStep.get());
+    if (!TypeEquals(type.get(), stepType.get()) && type->mKind != TypeBase::Kind::Unknown &&
+        stepType->mKind != TypeBase::Kind::Unknown) {
+      mDiags.report(expr->getLoc(), DiagId::ErrIncompatibleTypes, "step_by", TypeToString(type.get()),
+                    TypeToString(stepType.get()));
+    }
+  }
+  auto guard = enterScope();
+  insertIdentifier(expr->mName, std::move(type));
+  actOnBlockExpr(expr->mExpr.get());
+  return std::make_unique<TupleType>();
+}
 auto Sema::actOnExprWithoutBlock(ExprWithoutBlock* expr) -> std::unique_ptr<TypeBase>
 {
   switch (expr->mType) {
@@ -100,36 +187,655 @@ auto Sema::actOnExprWithoutBlock(ExprWithoutBlock* expr) -> std::unique_ptr<Type
     return actOnCallExpr(expr->as<CallExpr>());
   case ExprWithoutBlock::Type::Return:
     return actOnReturnExpr(expr->as<ReturnExpr>());
+  case ExprWithoutBlock::Type::Index:
+    return actOnIndexExpr(expr->as<IndexExpr>());
+  case ExprWithoutBlock::Type::MethodCall:
+    return actOnMethodCallExpr(expr->as<MethodCallExpr>());
+  case ExprWithoutBlock::Type::Array:
+    return actOnArrayExpr(expr->as<ArrayExpr>());
+  case ExprWithoutBlock::Type::Struct:
+    return actOnStructExpr(expr->as<StructExpr>());
+  case ExprWithoutBlock::Type::Field:
+    return actOnFieldExpr(expr->as<FieldExpr>());
+  case ExprWithoutBlock::Type::Tuple:
+    return actOnTupleExpr(expr->as<TupleExpr>());
   }
   utils::Unreachable(utils::SrcLoc::current());
 }
 auto Sema::actOnCallExpr(CallExpr* expr) -> std::unique_ptr<TypeBase>
 {
-  FunctionItem* fn = lookupItem(expr->mCallee)->as<FunctionItem>();
+  if (expr->mCallee.find("::") != std::string::npos) {
+    return actOnVectorCallExpr(expr);
+  }
+  auto item = lookupItem(expr->mCallee);
+  FunctionItem* fn = item && item->mKind == Item::Kind::Function ? item->as<FunctionItem>() : nullptr;
   if (fn == nullptr) {
-    mDiags.report((expr->getLoc()), DiagId::ErrInvalidFunctionCall,
-                  utils::format("undeclared function '{}'", expr->mCallee));
+    mDiags.report((expr->getLoc()), DiagId::ErrUndeclaredFunction, expr->mCallee);
     return std::make_unique<Unknown>();
   }
+  expr->mFnItem = fn;
+
+  if (auto caller = mFunctionStack.top().fn; caller != nullptr && caller->mIsConst && !fn->mIsConst) {
+    mDiags.report((expr->getLoc()), DiagId::ErrNonConstCallInConstFn, fn->mName, caller->mName);
+  }
 
   if (fn->mParamNames.size() != expr->mArgs.size()) {
-    mDiags.report((expr->getLoc()), DiagId::ErrInvalidFunctionCall,
-                  utils::format("incompatible number of arguments, expected '{}' got '{}'", fn->mParamNames.size(),
-                                expr->mArgs.size()));
+    mDiags.report((expr->getLoc()), DiagId::ErrArgumentCount, fn->mParamNames.size(), expr->mArgs.size());
     return TypeClone(fn->mFnType->mRet);
   }
 
   for (size_t i = 0; i < fn->mParamNames.size(); ++i) {
     auto argType = actOnExpr(expr->mArgs[i].get());
-    if (!TypeEquals(fn->mFnType->mParams[i].get(), argType.get())) {
-      mDiags.report((expr->getLoc()), DiagId::ErrInvalidFunctionCall,
-                    "incompatible parameter type at {}, expected '{}' got '{}'", i,
-                    TypeToString(fn->mFnType->mParams[i].get()), TypeToString(argType.get()));
+    if (!TypeCoercible(argType.get(), fn->mFnType->mParams[i].get())) {
+      mDiags.report((expr->getLoc()), DiagId::ErrArgumentType, i, TypeToString(fn->mFnType->mParams[i].get()),
+                    TypeToString(argType.get()));
+    } else {
+      coerce(expr->mArgs[i], fn->mFnType->mParams[i].get(), expr->getLoc());
     }
   }
+  checkBorrowConflicts(expr);
   return TypeClone(fn->mFnType->mRet);
 }
 
+static auto IsInteger(TypeBase const* type) -> bool
+{
+  switch (type->mKind) {
+  case TypeBase::Kind::I8:
+  case TypeBase::Kind::I16:
+  case TypeBase::Kind::I32:
+  case TypeBase::Kind::I64:
+  case TypeBase::Kind::U8:
+  case TypeBase::Kind::U16:
+  case TypeBase::Kind::U32:
+  case TypeBase::Kind::U64:
+  case TypeBase::Kind::Unknown:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static auto ElementType(TypeBase const* type) -> TypeBase const*
+{
+  if (type->mKind == TypeBase::Kind::Slice) {
+    return type->as<SliceType>()->mElem.get();
+  }
+  if (type->mKind == TypeBase::Kind::Array) {
+    return type->as<ArrayType>()->mElem.get();
+  }
+  return nullptr;
+}
+
+// slices, arrays, structs and tuples, which are only ever assigned as a whole
+static auto IsCompound(TypeBase const* type) -> bool
+{
+  return ElementType(type) != nullptr || type->mKind == TypeBase::Kind::Struct ||
+         (type->mKind == TypeBase::Kind::Tuple && !type->as<TupleType>()->isUnit());
+}
+
+// a SIMD vector stored in the value itself, not behind a pointer
+static auto ContainsVector(TypeBase const* type, std::vector<StructItem const*> outer = {}) -> bool
+{
+  switch (type->mKind) {
+  case TypeBase::Kind::Vector:
+    return true;
+  case TypeBase::Kind::Array:
+    return ContainsVector(type->as<ArrayType>()->mElem.get(), outer);
+  case TypeBase::Kind::Tuple: {
+    auto const& elems = type->as<TupleType>()->mTypes;
+    return std::any_of(elems.begin(), elems.end(), [&](auto const& elem) { return ContainsVector(elem.get(), outer); });
+  }
+  case TypeBase::Kind::Struct: {
+    auto item = type->as<StructType>()->mItem;
+    if (item == nullptr || std::find(outer.begin(), outer.end(), item) != outer.end()) {
+      return false;
+    }
+    outer.push_back(item);
+    return std::any_of(item->mFields.begin(), item->mFields.end(),
+                       [&](auto const& field) { return ContainsVector(field.mType.get(), outer); });
+  }
+  default:
+    return false;
+  }
+}
+
+// numbers, booleans and arrays, tuples and structs of them, which is what an initializer can be made of. A struct
+// that holds itself has no layout and is reported there
+static auto HasConstantValues(TypeBase const* type, std::vector<StructItem const*> outer = {}) -> bool
+{
+  switch (type->mKind) {
+  case TypeBase::Kind::Boolean:
+  case TypeBase::Kind::I8:
+  case TypeBase::Kind::I16:
+  case TypeBase::Kind::I32:
+  case TypeBase::Kind::I64:
+  case TypeBase::Kind::U8:
+  case TypeBase::Kind::U16:
+  case TypeBase::Kind::U32:
+  case TypeBase::Kind::U64:
+  case TypeBase::Kind::F32:
+  case TypeBase::Kind::F64:
+    return true;
+  case TypeBase::Kind::Array:
+    return HasConstantValues(type->as<ArrayType>()->mElem.get(), outer);
+  case TypeBase::Kind::Tuple: {
+    auto const& elems = type->as<TupleType>()->mTypes;
+    return std::all_of(elems.begin(), elems.end(),
+                       [&](auto const& elem) { return HasConstantValues(elem.get(), outer); });
+  }
+  case TypeBase::Kind::Struct: {
+    auto item = type->as<StructType>()->mItem;
+    if (item == nullptr || std::find(outer.begin(), outer.end(), item) != outer.end()) {
+      return false;
+    }
+    outer.push_back(item);
+    return std::all_of(item->mFields.begin(), item->mFields.end(),
+                       [&](auto const& field) { return HasConstantValues(field.mType.get(), outer); });
+  }
+  default:
+    return false;
+  }
+}
+
+// locals, elements of a slice or array and the fields of a struct that is a place itself
+static auto IsPlace(Expr const* expr) -> bool
+{
+  if (expr->mType != Expr::Type::WithoutBlock) {
+    return false;
+  }
+  switch (auto e = expr->as<ExprWithoutBlock>(); e->mType) {
+  case ExprWithoutBlock::Type::Grouped:
+    return IsPlace(e->as<GroupedExpr>()->mExpr.get());
+  case ExprWithoutBlock::Type::Index:
+    return true;
+  case ExprWithoutBlock::Type::Field:
+    return IsPlace(e->as<FieldExpr>()->mBase.get());
+  case ExprWithoutBlock::Type::Literal:
+    return e->as<LiteralExpr>()->mKind == LiteralExpr::Kind::Identifier;
+  case ExprWithoutBlock::Type::Operator:
+    return e->as<OperatorExpr>()->mType == OperatorExpr::Type::Unary &&
+           e->as<OperatorExpr>()->as<UnaryExpr>()->mKind == UnaryExpr::Kind::Deref;
+  default:
+    return false;
+  }
+}
+
+static auto AsBorrow(Expr const* expr) -> UnaryExpr const*
+{
+  while (expr->mType == Expr::Type::WithoutBlock &&
+         expr->as<ExprWithoutBlock>()->mType == ExprWithoutBlock::Type::Grouped) {
+    expr = expr->as<ExprWithoutBlock>()->as<GroupedExpr>()->mExpr.get();
+  }
+  if (expr->mType != Expr::Type::WithoutBlock ||
+      expr->as<ExprWithoutBlock>()->mType != ExprWithoutBlock::Type::Operator ||
+      expr->as<ExprWithoutBlock>()->as<OperatorExpr>()->mType != OperatorExpr::Type::Unary) {
+    return nullptr;
+  }
+  auto unary = expr->as<ExprWithoutBlock>()->as<OperatorExpr>()->as<UnaryExpr>();
+  if (unary->mKind == UnaryExpr::Kind::Unsize) { // a slice of a borrowed array borrows it too
+    return AsBorrow(unary->mRight.get());
+  }
+  return unary->mKind == UnaryExpr::Kind::Ref || unary->mKind == UnaryExpr::Kind::RefMut ? unary : nullptr;
+}
+
+// the local a place is part of, none for one behind a pointer
+static auto PlaceRoot(Expr const* expr) -> std::optional<std::string>
+{
+  if (expr->mType != Expr::Type::WithoutBlock) {
+    return std::nullopt;
+  }
+  switch (auto e = expr->as<ExprWithoutBlock>(); e->mType) {
+  case ExprWithoutBlock::Type::Grouped:
+    return PlaceRoot(e->as<GroupedExpr>()->mExpr.get());
+  case ExprWithoutBlock::Type::Index:
+    return e->as<IndexExpr>()->mBase->getType()->mKind == TypeBase::Kind::Array
+               ? PlaceRoot(e->as<IndexExpr>()->mBase.get())
+               : std::nullopt;
+  case ExprWithoutBlock::Type::Field:
+    return PlaceRoot(e->as<FieldExpr>()->mBase.get());
+  case ExprWithoutBlock::Type::Literal:
+    if (e->as<LiteralExpr>()->mKind == LiteralExpr::Kind::Identifier) {
+      return std::get<std::string>(e->as<LiteralExpr>()->mValue);
+    }
+    return std::nullopt;
+  default:
+    return std::nullopt;
+  }
+}
+
+// the value of an integer literal, literals are never negative
+static auto AsIndexLiteral(Expr const* expr) -> std::optional<u64>
+{
+  if (expr->mType != Expr::Type::WithoutBlock ||
+      expr->as<ExprWithoutBlock>()->mType != ExprWithoutBlock::Type::Literal) {
+    return std::nullopt;
+  }
+  auto result = std::optional<u64>{};
+  std::visit(
+      [&]<typename T>(T const& v) {
+        if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+          result = static_cast<u64>(v);
+        }
+      },
+      expr->as<ExprWithoutBlock>()->as<LiteralExpr>()->mValue);
+  return result;
+}
+
+// a place is written or borrowed as mutable, which a shared reference on the way to it forbids. Elements of a slice
+// stay writable
+auto Sema::checkMutablePlace(Expr const* expr, char const* loc) -> void
+{
+  if (expr->mType != Expr::Type::WithoutBlock) {
+    return;
+  }
+  switch (auto e = expr->as<ExprWithoutBlock>(); e->mType) {
+  case ExprWithoutBlock::Type::Grouped:
+    return checkMutablePlace(e->as<GroupedExpr>()->mExpr.get(), loc);
+  case ExprWithoutBlock::Type::Index:
+    if (e->as<IndexExpr>()->mBase->getType()->mKind == TypeBase::Kind::Array) {
+      checkMutablePlace(e->as<IndexExpr>()->mBase.get(), loc);
+    }
+    return;
+  case ExprWithoutBlock::Type::Field:
+    return checkMutablePlace(e->as<FieldExpr>()->mBase.get(), loc);
+  case ExprWithoutBlock::Type::Literal:
+    if (auto item = e->as<LiteralExpr>()->mItem; item != nullptr && item->mKind == Item::Kind::ConstantItem) {
+      mDiags.report(loc, DiagId::ErrMutateImmutableItem, "const", item->as<ConstantItem>()->mName);
+    } else if (item != nullptr && item->mKind == Item::Kind::StaticItem && !item->as<StaticItem>()->mMutable) {
+      mDiags.report(loc, DiagId::ErrMutateImmutableItem, "static", item->as<StaticItem>()->mName);
+    }
+    return;
+  case ExprWithoutBlock::Type::Operator: {
+    auto op = e->as<OperatorExpr>();
+    if (op->mType != OperatorExpr::Type::Unary || op->as<UnaryExpr>()->mKind != UnaryExpr::Kind::Deref) {
+      return;
+    }
+    auto pointer = op->as<UnaryExpr>()->mRight->getType();
+    auto isMutable = pointer->mKind == TypeBase::Kind::Reference   ? pointer->as<ReferenceType>()->mMutable
+                     : pointer->mKind == TypeBase::Kind::RawPointer ? pointer->as<RawPointerType>()->mMutable
+                                                                    : true;
+    if (!isMutable) {
+      mDiags.report(loc, DiagId::ErrMutateThroughShared, TypeToString(pointer));
+    }
+    return;
+  }
+  default:
+    return;
+  }
+}
+
+// the parameters of a function do not alias when one of them is a mutable reference, which is what a call has to
+// guarantee for the locals it borrows. A reference held in a local is not followed
+auto Sema::checkBorrowConflicts(CallExpr const* expr) -> void
+{
+  auto borrows = std::vector<std::pair<std::string, bool>>{};
+  for (auto& arg : expr->mArgs) {
+    if (auto borrow = AsBorrow(arg.get())) {
+      if (auto root = PlaceRoot(borrow->mRight.get())) {
+        borrows.emplace_back(*root, borrow->mKind == UnaryExpr::Kind::RefMut);
+      }
+    }
+  }
+  for (size_t i = 0; i < borrows.size(); ++i) {
+    for (size_t j = i + 1; j < borrows.size(); ++j) {
+      if (borrows[i].first == borrows[j].first && (borrows[i].second || borrows[j].second)) {
+        mDiags.report(expr->getLoc(), DiagId::ErrConflictingBorrow, borrows[i].first);
+        return;
+      }
+    }
+  }
+}
+
+// `r.field`, `r[i]` and `r.len()` look through references, as if the code said `(*r)`
+auto Sema::autoDeref(std::unique_ptr<Expr>& base, std::unique_ptr<TypeBase> type, char const* loc)
+    -> std::unique_ptr<TypeBase>
+{
+  while (type->mKind == TypeBase::Kind::Reference) {
+    auto pointee = TypeClone(type->as<ReferenceType>()->mPointee);
+    base = std::make_unique<UnaryExpr>(UnaryExpr::Kind::Deref, std::move(base), loc);
+    base->mExprType = TypeClone(pointee);
+    type = std::move(pointee);
+  }
+  return type;
+}
+
+// an expression of type `&[T; N]` where `&[T]` is expected becomes a slice of the whole array, every other coercion
+// keeps the representation
+auto Sema::coerce(std::unique_ptr<Expr>& expr, TypeBase const* to, char const* loc) -> void
+{
+  if (expr == nullptr || !TypeUnsizes(expr->getType(), to)) {
+    return;
+  }
+  expr = std::make_unique<UnaryExpr>(UnaryExpr::Kind::Unsize, std::move(expr), loc);
+  expr->mExprType = TypeClone(to);
+}
+
+auto Sema::actOnArrayExpr(ArrayExpr* expr) -> std::unique_ptr<TypeBase>
+{
+  if (expr->mElems.empty()) {
+    mDiags.report(expr->getLoc(), DiagId::ErrEmptyArray);
+    return std::make_unique<Unknown>();
+  }
+  auto elemType = actOnExpr(expr->mElems.front().get());
+  for (size_t i = 1; i < expr->mElems.size(); ++i) {
+    if (auto type = actOnExpr(expr->mElems[i].get()); !TypeEquals(elemType.get(), type.get())) {
+      mDiags.report(expr->getLoc(), DiagId::ErrIncompatibleTypes, "array element", TypeToString(elemType.get()),
+                    TypeToString(type.get()));
+    }
+  }
+  return std::make_unique<ArrayType>(std::move(elemType), expr->mRepeat.value_or(expr->mElems.size()));
+}
+
+// any integer type is accepted as an index, a negative one is out of bounds
+auto Sema::actOnIndexExpr(IndexExpr* expr) -> std::unique_ptr<TypeBase>
+{
+  auto baseType = autoDeref(expr->mBase, actOnExpr(expr->mBase.get()), expr->getLoc());
+  auto indexType = actOnExpr(expr->mIndex.get());
+  if (!IsInteger(indexType.get())) {
+    mDiags.report(expr->getLoc(), DiagId::ErrInvalidIndexType, TypeToString(indexType.get()));
+  }
+  if (baseType->mKind == TypeBase::Kind::Array) {
+    // a constant index into an array is checked here instead of at runtime
+    if (auto index = AsIndexLiteral(expr->mIndex.get())) {
+      if (auto len = baseType->as<ArrayType>()->mLen; *index >= len) {
+        mDiags.report(expr->getLoc(), DiagId::ErrIndexOutOfBounds, *index, len);
+      }
+      expr->mChecked = false;
+    }
+  }
+  if (auto elemType = ElementType(baseType.get())) {
+    return TypeClone(elemType);
+  }
+  if (baseType->mKind != TypeBase::Kind::Unknown) {
+    mDiags.report(expr->getLoc(), DiagId::ErrNotIndexable, TypeToString(baseType.get()));
+  }
+  return std::make_unique<Unknown>();
+}
+
+// every field is initialized exactly once, the values are checked in source order
+auto Sema::actOnStructExpr(StructExpr* expr) -> std::unique_ptr<TypeBase>
+{
+  auto item = lookupItem(expr->mName);
+  auto st = item && item->mKind == Item::Kind::Struct ? item->as<StructItem>() : nullptr;
+  if (st == nullptr) {
+    mDiags.report(expr->getLoc(), DiagId::ErrUnknownType, expr->mName);
+    for (auto& init : expr->mFields) {
+      actOnExpr(init.mValue.get());
+    }
+    return std::make_unique<Unknown>();
+  }
+  expr->mItem = st;
+  auto initialized = std::vector<bool>(st->mFields.size());
+  for (auto& init : expr->mFields) {
+    auto type = actOnExpr(init.mValue.get());
+    auto index = st->findField(init.mName);
+    if (!index) {
+      mDiags.report(expr->getLoc(), DiagId::ErrUnknownField, init.mName, st->mName);
+      continue;
+    }
+    if (initialized[*index]) {
+      mDiags.report(expr->getLoc(), DiagId::ErrDuplicateField, init.mName);
+      continue;
+    }
+    initialized[*index] = true;
+    init.mIndex = *index;
+    if (auto fieldType = st->mFields[*index].mType.get(); !TypeCoercible(type.get(), fieldType)) {
+      mDiags.report(expr->getLoc(), DiagId::ErrIncompatibleFieldType, init.mName, TypeToString(fieldType),
+                    TypeToString(type.get()));
+    } else {
+      coerce(init.mValue, fieldType, expr->getLoc());
+    }
+  }
+  for (size_t i = 0; i < st->mFields.size(); ++i) {
+    if (!initialized[i]) {
+      mDiags.report(expr->getLoc(), DiagId::ErrMissingField, st->mFields[i].mName, st->mName);
+    }
+  }
+  return std::make_unique<StructType>(st->mName, st);
+}
+
+auto Sema::actOnFieldExpr(FieldExpr* expr) -> std::unique_ptr<TypeBase>
+{
+  auto baseType = autoDeref(expr->mBase, actOnExpr(expr->mBase.get()), expr->getLoc());
+  if (baseType->mKind == TypeBase::Kind::Unknown) {
+    return std::make_unique<Unknown>();
+  }
+  if (auto item = baseType->mKind == TypeBase::Kind::Struct ? baseType->as<StructType>()->mItem : nullptr) {
+    if (auto index = item->findField(expr->mField)) {
+      expr->mIndex = *index;
+      return TypeClone(item->mFields[*index].mType);
+    }
+  }
+  if (baseType->mKind == TypeBase::Kind::Tuple) {
+    auto const& elems = baseType->as<TupleType>()->mTypes;
+    auto index = u32{0};
+    auto [end, ec] = std::from_chars(expr->mField.data(), expr->mField.data() + expr->mField.size(), index);
+    if (ec == std::errc{} && end == expr->mField.data() + expr->mField.size() && index < elems.size()) {
+      expr->mIndex = index;
+      return TypeClone(elems[index]);
+    }
+  }
+  mDiags.report(expr->getLoc(), DiagId::ErrUnknownField, expr->mField, TypeToString(baseType.get()));
+  return std::make_unique<Unknown>();
+}
+
+auto Sema::actOnTupleExpr(TupleExpr* expr) -> std::unique_ptr<TypeBase>
+{
+  auto types = std::vector<std::unique_ptr<TypeBase>>{};
+  for (auto& elem : expr->mElems) {
+    types.push_back(actOnExpr(elem.get()));
+  }
+  return std::make_unique<TupleType>(std::move(types));
+}
+
+auto Sema::actOnMethodCallExpr(MethodCallExpr* expr) -> std::unique_ptr<TypeBase>
+{
+  auto receiverType = autoDeref(expr->mReceiver, actOnExpr(expr->mReceiver.get()), expr->getLoc());
+  auto argTypes = std::vector<std::unique_ptr<TypeBase>>{};
+  for (auto& arg : expr->mArgs) {
+    argTypes.push_back(actOnExpr(arg.get()));
+  }
+  if (receiverType->mKind == TypeBase::Kind::Unknown) {
+    return std::make_unique<Unknown>();
+  }
+
+  if (auto elemType = ElementType(receiverType.get())) {
+    if (expr->mMethod == "len") {
+      expr->mBuiltin = MethodCallExpr::Builtin::Len;
+      checkArgCount(expr->getLoc(), 0, argTypes.size());
+      return std::make_unique<U64>();
+    }
+    // no bounds check, an index out of bounds is undefined behavior
+    if (expr->mMethod == "get_unchecked") {
+      expr->mBuiltin = MethodCallExpr::Builtin::GetUnchecked;
+      if (checkArgCount(expr->getLoc(), 1, argTypes.size()) && !IsInteger(argTypes.front().get())) {
+        mDiags.report(expr->getLoc(), DiagId::ErrInvalidIndexType, TypeToString(argTypes.front().get()));
+      }
+      return TypeClone(elemType);
+    }
+  }
+  if (receiverType->mKind == TypeBase::Kind::Vector) {
+    return actOnVectorMethodCallExpr(expr, receiverType->as<VectorType>(), argTypes);
+  }
+  mDiags.report(expr->getLoc(), DiagId::ErrUnknownMethod, expr->mMethod, TypeToString(receiverType.get()));
+  return std::make_unique<Unknown>();
+}
+
+auto Sema::checkArgCount(char const* loc, size_t expected, size_t got) -> bool
+{
+  if (expected == got) {
+    return true;
+  }
+  mDiags.report(loc, DiagId::ErrArgumentCount, expected, got);
+  return false;
+}
+
+// a vector load or store accesses elements `index..index + lanes` of a slice or array of the lane type
+auto Sema::checkVectorMemory(char const* loc, VectorType const* vec, TypeBase const* memory, TypeBase const* index)
+    -> void
+{
+  if (!IsInteger(index)) {
+    mDiags.report(loc, DiagId::ErrInvalidIndexType, TypeToString(index));
+  }
+  auto elemType = ElementType(memory);
+  if (elemType == nullptr) {
+    if (memory->mKind != TypeBase::Kind::Unknown) {
+      mDiags.report(loc, DiagId::ErrNotIndexable, TypeToString(memory));
+    }
+    return;
+  }
+  if (!TypeEquals(elemType, vec->mElem.get())) {
+    mDiags.report(loc, DiagId::ErrIncompatibleTypes, "vector lanes", TypeToString(vec->mElem.get()),
+                  TypeToString(elemType));
+  }
+}
+
+// `T::splat(x)` puts x in every lane, `T::load(s, i)` and `T::load_aligned(s, i)` read the lanes from a slice or
+// array, the aligned one assumes their address is a multiple of the vector size. A bool is a byte in memory but a
+// bit in a mask, masks are never loaded
+auto Sema::actOnVectorCallExpr(CallExpr* expr) -> std::unique_ptr<TypeBase>
+{
+  auto argTypes = std::vector<std::unique_ptr<TypeBase>>{};
+  for (auto& arg : expr->mArgs) {
+    argTypes.push_back(actOnExpr(arg.get()));
+  }
+  auto sep = expr->mCallee.find("::");
+  auto type = GetNumBoolMap(std::string_view(expr->mCallee).substr(0, sep));
+  auto name = expr->mCallee.substr(sep + 2);
+  if (type == nullptr || type->mKind != TypeBase::Kind::Vector) {
+    mDiags.report(expr->getLoc(), DiagId::ErrUndeclaredFunction, expr->mCallee);
+    return std::make_unique<Unknown>();
+  }
+  auto vec = type->as<VectorType>();
+  if (name == "splat") {
+    expr->mBuiltin = CallExpr::Builtin::Splat;
+    if (checkArgCount(expr->getLoc(), 1, argTypes.size()) && !TypeEquals(vec->mElem.get(), argTypes[0].get())) {
+      mDiags.report(expr->getLoc(), DiagId::ErrIncompatibleTypes, "splat", TypeToString(vec->mElem.get()),
+                    TypeToString(argTypes[0].get()));
+    }
+    return type;
+  }
+  if ((name == "load" || name == "load_aligned") && !vec->isMask()) {
+    expr->mBuiltin = name == "load" ? CallExpr::Builtin::Load : CallExpr::Builtin::LoadAligned;
+    if (checkArgCount(expr->getLoc(), 2, argTypes.size())) {
+      checkVectorMemory(expr->getLoc(), vec, argTypes[0].get(), argTypes[1].get());
+    }
+    return type;
+  }
+  mDiags.report(expr->getLoc(), DiagId::ErrUnknownMethod, name, TypeToString(vec));
+  return std::make_unique<Unknown>();
+}
+
+static const std::unordered_map<std::string_view, MethodCallExpr::Builtin> kReductions{
+    {"reduce_add", MethodCallExpr::Builtin::ReduceAdd},
+    {"reduce_mul", MethodCallExpr::Builtin::ReduceMul},
+    {"reduce_min", MethodCallExpr::Builtin::ReduceMin},
+    {"reduce_max", MethodCallExpr::Builtin::ReduceMax},
+};
+
+// lane indices have to be literals and are checked here
+auto Sema::actOnVectorMethodCallExpr(MethodCallExpr* expr, VectorType const* vec,
+                                     std::vector<std::unique_ptr<TypeBase>> const& argTypes)
+    -> std::unique_ptr<TypeBase>
+{
+  using Builtin = MethodCallExpr::Builtin;
+  auto const& method = expr->mMethod;
+  auto loc = expr->getLoc();
+  auto checkLane = [&](Expr const* arg, u32 lanes) {
+    if (auto lane = AsIndexLiteral(arg); !lane || *lane >= lanes) {
+      mDiags.report(loc, DiagId::ErrInvalidLaneIndex, lanes);
+      return false;
+    }
+    return true;
+  };
+
+  if (method == "extract") {
+    expr->mBuiltin = Builtin::Extract;
+    if (checkArgCount(loc, 1, argTypes.size())) {
+      checkLane(expr->mArgs[0].get(), vec->mLanes);
+    }
+    return TypeClone(vec->mElem);
+  }
+  if (method == "insert") {
+    expr->mBuiltin = Builtin::Insert;
+    if (checkArgCount(loc, 2, argTypes.size())) {
+      checkLane(expr->mArgs[0].get(), vec->mLanes);
+      if (!TypeEquals(vec->mElem.get(), argTypes[1].get())) {
+        mDiags.report(loc, DiagId::ErrIncompatibleTypes, "insert", TypeToString(vec->mElem.get()),
+                      TypeToString(argTypes[1].get()));
+      }
+    }
+    return TypeClone(vec);
+  }
+  // `v.shuffle([3, 2, 1, 0])`, or `v.shuffle(w, [0, 4, 1, 5])` where the lanes of w follow those of v
+  if (method == "shuffle") {
+    expr->mBuiltin = Builtin::Shuffle;
+    expr->mShuffle.clear();
+    if (argTypes.empty() || argTypes.size() > 2) {
+      checkArgCount(loc, 2, argTypes.size());
+      return std::make_unique<Unknown>();
+    }
+    if (argTypes.size() == 2 && !TypeEquals(vec, argTypes[0].get())) {
+      mDiags.report(loc, DiagId::ErrIncompatibleTypes, "shuffle", TypeToString(vec), TypeToString(argTypes[0].get()));
+    }
+    auto sources = static_cast<u32>(vec->mLanes * argTypes.size());
+    auto lanes = expr->mArgs.back().get();
+    auto array = lanes->mType == Expr::Type::WithoutBlock &&
+                         lanes->as<ExprWithoutBlock>()->mType == ExprWithoutBlock::Type::Array
+                     ? lanes->as<ExprWithoutBlock>()->as<ArrayExpr>()
+                     : nullptr;
+    if (array == nullptr || array->mElems.empty() || array->mRepeat == 0) {
+      mDiags.report(loc, DiagId::ErrInvalidLaneIndex, sources);
+      return std::make_unique<Unknown>();
+    }
+    for (u64 i = 0; i < array->mRepeat.value_or(array->mElems.size()); ++i) {
+      auto lane = array->mElems[array->mRepeat ? 0 : i].get();
+      if (!checkLane(lane, sources)) {
+        return std::make_unique<Unknown>();
+      }
+      expr->mShuffle.push_back(static_cast<u32>(*AsIndexLiteral(lane)));
+    }
+    return std::make_unique<VectorType>(TypeClone(vec->mElem), static_cast<u32>(expr->mShuffle.size()));
+  }
+  // lanes are combined in an unspecified order, a float sum may round differently than a loop
+  if (auto it = kReductions.find(method); it != kReductions.end() && !vec->isMask()) {
+    expr->mBuiltin = it->second;
+    checkArgCount(loc, 0, argTypes.size());
+    return TypeClone(vec->mElem);
+  }
+  if ((method == "store" || method == "store_aligned") && !vec->isMask()) {
+    expr->mBuiltin = method == "store" ? Builtin::Store : Builtin::StoreAligned;
+    if (checkArgCount(loc, 2, argTypes.size())) {
+      checkVectorMemory(loc, vec, argTypes[0].get(), argTypes[1].get());
+    }
+    return std::make_unique<TupleType>();
+  }
+  if (vec->isMask() && method == "select") {
+    expr->mBuiltin = Builtin::Select;
+    if (!checkArgCount(loc, 2, argTypes.size())) {
+      return std::make_unique<Unknown>();
+    }
+    auto picked = argTypes[0].get();
+    if (!TypeEquals(picked, argTypes[1].get())) {
+      mDiags.report(loc, DiagId::ErrIncompatibleTypes, "select", TypeToString(picked),
+                    TypeToString(argTypes[1].get()));
+    }
+    if (picked->mKind != TypeBase::Kind::Unknown &&
+        (picked->mKind != TypeBase::Kind::Vector || picked->as<VectorType>()->mLanes != vec->mLanes)) {
+      mDiags.report(loc, DiagId::ErrIncompatibleTypes, "select", TypeToString(vec), TypeToString(picked));
+      return std::make_unique<Unknown>();
+    }
+    return TypeClone(picked);
+  }
+  if (vec->isMask() && (method == "any" || method == "all")) {
+    expr->mBuiltin = method == "any" ? Builtin::Any : Builtin::All;
+    checkArgCount(loc, 0, argTypes.size());
+    return std::make_unique<Boolean>();
+  }
+  mDiags.report(loc, DiagId::ErrUnknownMethod, method, TypeToString(vec));
+  return std::make_unique<Unknown>();
+}
+
 auto Sema::actOnOperatorExpr(OperatorExpr* expr) -> std::unique_ptr<TypeBase>
 {
   switch (expr->mType) {
@@ -143,18 +849,87 @@ auto Sema::actOnOperatorExpr(OperatorExpr* expr) -> std::unique_ptr<TypeBase>
 
 auto Sema::actOnBinaryExpr(BinaryExpr* expr) -> std::unique_ptr<TypeBase>
 {
+  if (expr->mKind == BinaryExpr::Kind::Assignment && !IsPlace(expr->mLeft.get())) {
+    mDiags.report(expr->getLoc(), DiagId::ErrInvalidAssignTarget);
+  }
   auto lhsType = actOnExpr(expr->mLeft.get());
   auto rhsType = actOnExpr(expr->mRight.get());
-  if (!TypeEquals(lhsType.get(), rhsType.get())) {
-    mDiags.report((expr->getLoc()), DiagId::ErrIncompatibleTypes, "", TypeToString(lhsType.get()), "and",
+  if (expr->mKind == BinaryExpr::Kind::Assignment) {
+    checkMutablePlace(expr->mLeft.get(), expr->getLoc());
+  }
+  if (expr->mKind == BinaryExpr::Kind::LogicalAnd || expr->mKind == BinaryExpr::Kind::LogicalOr) {
+    auto boolean = Boolean{};
+    for (auto type : {lhsType.get(), rhsType.get()}) {
+      if (!TypeCoercible(type, &boolean)) {
+        mDiags.report(expr->getLoc(), DiagId::ErrInvalidOperandType,
+                      expr->mKind == BinaryExpr::Kind::LogicalAnd ? "&&" : "||", TypeToString(type));
+      }
+    }
+    return std::make_unique<Boolean>();
+  }
+  // pointers are only compared for equality
+  auto isPointer = PointeeType(lhsType.get()) != nullptr;
+  if ((IsCompound(lhsType.get()) && expr->mKind != BinaryExpr::Kind::Assignment) ||
+      (isPointer && expr->mKind != BinaryExpr::Kind::Assignment && expr->mKind != BinaryExpr::Kind::Eq &&
+       expr->mKind != BinaryExpr::Kind::Ne)) {
+    mDiags.report(expr->getLoc(), DiagId::ErrInvalidOperandType, BinaryExpr::ToString(expr->mKind),
+                  TypeToString(lhsType.get()));
+    return std::make_unique<Unknown>();
+  }
+  auto compatible = expr->mKind == BinaryExpr::Kind::Assignment ? TypeCoercible(rhsType.get(), lhsType.get())
+                                                                 : TypeEquals(lhsType.get(), rhsType.get());
+  if (!compatible) {
+    mDiags.report((expr->getLoc()), DiagId::ErrIncompatibleTypes, "binary expression", TypeToString(lhsType.get()),
                   TypeToString(rhsType.get()));
+  } else if (expr->mKind == BinaryExpr::Kind::Assignment) {
+    coerce(expr->mRight, lhsType.get(), expr->getLoc());
   }
   // TODO: check if the operator is valid for the type
-  return lhsType;
+  switch (expr->mKind) {
+  case BinaryExpr::Kind::Eq:
+  case BinaryExpr::Kind::Ne:
+  case BinaryExpr::Kind::Gt:
+  case BinaryExpr::Kind::Lt:
+  case BinaryExpr::Kind::Ge:
+  case BinaryExpr::Kind::Le:
+    // vectors compare lane by lane into a mask
+    if (lhsType->mKind == TypeBase::Kind::Vector) {
+      return std::make_unique<VectorType>(std::make_unique<Boolean>(), lhsType->as<VectorType>()->mLanes);
+    }
+    return std::make_unique<Boolean>();
+  case BinaryExpr::Kind::Assignment:
+    return std::make_unique<TupleType>();
+  default:
+    return lhsType;
+  }
 }
 auto Sema::actOnUnaryExpr(UnaryExpr* expr) -> std::unique_ptr<TypeBase>
 {
   auto type = actOnExpr(expr->mRight.get());
+  switch (expr->mKind) {
+  case UnaryExpr::Kind::Ref:
+    return std::make_unique<ReferenceType>(std::move(type), false);
+  case UnaryExpr::Kind::RefMut:
+    checkMutablePlace(expr->mRight.get(), expr->getLoc());
+    return std::make_unique<ReferenceType>(std::move(type), true);
+  case UnaryExpr::Kind::Unsize:
+    return std::make_unique<SliceType>(TypeClone(PointeeType(type.get())->as<ArrayType>()->mElem));
+  case UnaryExpr::Kind::Deref:
+    if (auto pointee = PointeeType(type.get())) {
+      return TypeClone(pointee);
+    }
+    if (type->mKind != TypeBase::Kind::Unknown) {
+      mDiags.report(expr->getLoc(), DiagId::ErrInvalidOperandType, "*", TypeToString(type.get()));
+    }
+    return std::make_unique<Unknown>();
+  default:
+    break;
+  }
+  if (IsCompound(type.get()) || PointeeType(type.get()) != nullptr) {
+    mDiags.report(expr->getLoc(), DiagId::ErrInvalidOperandType, UnaryExpr::ToString(expr->mKind),
+                  TypeToString(type.get()));
+    return std::make_unique<Unknown>();
+  }
   // TODO: check if the operator is valid for the type
   return type;
 }
@@ -193,9 +968,17 @@ auto Sema::actOnLiteralExpr(LiteralExpr* expr) -> std::unique_ptr<TypeBase>
       } else {
         if (itemType->mKind == Item::Kind::Function) {
           return TypeClone(itemType->as<FunctionItem>()->mFnType.get());
-        } else {
-          utils::Unimplemented(utils::SrcLoc::current());
         }
+        if (itemType->mKind == Item::Kind::ConstantItem) {
+          expr->mItem = itemType;
+          return TypeClone(itemType->as<ConstantItem>()->mType.get());
+        }
+        if (itemType->mKind == Item::Kind::StaticItem) {
+          expr->mItem = itemType;
+          return TypeClone(itemType->as<StaticItem>()->mType.get());
+        }
+        mDiags.report((expr->getLoc()), DiagId::ErrUndefinedSym, name); // a struct name is not a value
+        return std::make_unique<Unknown>();
       }
     } else {
       return TypeClone(identifierType);
@@ -212,10 +995,14 @@ auto Sema::actOnReturnExpr(ReturnExpr* expr) -> std::unique_ptr<TypeBase>
 {
   auto exprType = actOnExpr(expr->mExpr.get());
   auto currFn = mFunctionStack.top().fn;
-  if (!TypeEquals(exprType.get(), currFn->mFnType->mRet.get())) {
-    mDiags.report((expr->getLoc()), DiagId::ErrIncompatibleTypes,
-                  utils::format("function '{}' return expression", currFn->mName), TypeToString(exprType.get()),
-                  TypeToString(currFn->mFnType->mRet.get()));
+  if (currFn == nullptr) { // in the initializer of a const or static, which is then not constant
+    return std::make_unique<Never>();
+  }
+  if (!TypeCoercible(exprType.get(), currFn->mFnType->mRet.get())) {
+    mDiags.report((expr->getLoc()), DiagId::ErrIncompatibleReturnType, currFn->mName, "return expression",
+                  TypeToString(exprType.get()), TypeToString(currFn->mFnType->mRet.get()));
+  } else {
+    coerce(expr->mExpr, currFn->mFnType->mRet.get(), expr->getLoc());
   }
   return std::make_unique<Never>();
 }
@@ -234,13 +1021,17 @@ auto Sema::actOnStmt(Stmt* stmt) -> void
 
 auto Sema::actOnExpr(Expr* expr) -> std::unique_ptr<TypeBase>
 {
+  std::unique_ptr<TypeBase> type;
   switch (expr->mType) {
   case Expr::Type::WithBlock:
-    return actOnExprWithBlock(expr->as<ExprWithBlock>());
+    type = actOnExprWithBlock(expr->as<ExprWithBlock>());
+    break;
   case Expr::Type::WithoutBlock:
-    return actOnExprWithoutBlock(expr->as<ExprWithoutBlock>());
+    type = actOnExprWithoutBlock(expr->as<ExprWithoutBlock>());
+    break;
   }
-  utils::Unreachable(utils::SrcLoc::current());
+  expr->mExprType = TypeClone(type);
+  return type;
 }
 
 auto Sema::actOnItem(Item* item) -> void
@@ -250,14 +1041,21 @@ auto Sema::actOnItem(Item* item) -> void
     return actOnFunctionItem(item->as<FunctionItem>());
   case Item::Kind::ExternBlock:
     return actOnExternalBlockItem(item->as<ExternalBlockItem>());
+  case Item::Kind::Struct:
+    return; // checked and laid out along with the declarations
+  case Item::Kind::ConstantItem: {
+    auto constant = item->as<ConstantItem>();
+    return checkInitializer(constant->mName, constant->mType.get(), constant->mExpr.get(), constant->getLoc());
+  }
+  case Item::Kind::StaticItem: {
+    auto staticItem = item->as<StaticItem>();
+    return checkInitializer(staticItem->mName, staticItem->mType.get(), staticItem->mExpr.get(), staticItem->getLoc());
+  }
   case Item::Kind::Module:
   case Item::Kind::UseDeclaration:
   case Item::Kind::TypeAlias:
-  case Item::Kind::Struct:
   case Item::Kind::Enumeration:
   case Item::Kind::Union:
-  case Item::Kind::ConstantItem:
-  case Item::Kind::StaticItem:
   case Item::Kind::Trait:
   case Item::Kind::Implementation:
   case Item::Kind::ExternCrate:
@@ -268,9 +1066,350 @@ auto Sema::actOnItem(Item* item) -> void
   }
 }
 
+auto Sema::declareItem(Item* item) -> void
+{
+  switch (item->mKind) {
+  case Item::Kind::Function: {
+    auto fn = item->as<FunctionItem>();
+    if (!insertItem(fn->mName, fn)) {
+      mDiags.report((fn->getLoc()), DiagId::ErrRedefinedSym, fn->mName);
+    }
+    checkFunctionAttributes(fn);
+  } break;
+  case Item::Kind::ExternBlock:
+    for (auto const& attr : item->mAttrs) {
+      mDiags.report(attr.mLoc, DiagId::ErrMisplacedAttribute, attr.mName, "an extern block");
+    }
+    for (auto& fn : item->as<ExternalBlockItem>()->mItems) {
+      if (!insertItem(fn->mName, fn.get())) {
+        mDiags.report((fn->getLoc()), DiagId::ErrRedefinedSym, fn->mName);
+      }
+      checkFunctionAttributes(fn.get());
+    }
+    break;
+  case Item::Kind::Struct: {
+    // only at the top level, a struct name then stands for the same type in the whole crate
+    auto st = item->as<StructItem>();
+    if (!mFunctionStack.empty()) {
+      mDiags.report(st->getLoc(), DiagId::ErrNestedStruct, st->mName);
+      break;
+    }
+    if (!insertItem(st->mName, st)) {
+      mDiags.report(st->getLoc(), DiagId::ErrRedefinedSym, st->mName);
+    }
+    for (u32 i = 0; i < st->mFields.size(); ++i) {
+      if (st->findField(st->mFields[i].mName) != i) {
+        mDiags.report(st->mFields[i].mLoc, DiagId::ErrDuplicateField, st->mFields[i].mName);
+      }
+    }
+    checkStructAttributes(st);
+  } break;
+  case Item::Kind::ConstantItem: {
+    auto constant = item->as<ConstantItem>();
+    if (!insertItem(constant->mName, constant)) {
+      mDiags.report(constant->getLoc(), DiagId::ErrRedefinedSym, constant->mName);
+    }
+    for (auto const& attr : item->mAttrs) {
+      mDiags.report(attr.mLoc, DiagId::ErrMisplacedAttribute, attr.mName, "a const");
+    }
+  } break;
+  case Item::Kind::StaticItem: {
+    // a single global for the whole crate, one in a function would need a name of its own in every module
+    auto staticItem = item->as<StaticItem>();
+    if (!mFunctionStack.empty()) {
+      mDiags.report(staticItem->getLoc(), DiagId::ErrNestedStatic, staticItem->mName);
+      break;
+    }
+    if (!insertItem(staticItem->mName, staticItem)) {
+      mDiags.report(staticItem->getLoc(), DiagId::ErrRedefinedSym, staticItem->mName);
+    }
+    for (auto const& attr : item->mAttrs) {
+      mDiags.report(attr.mLoc, DiagId::ErrMisplacedAttribute, attr.mName, "a static");
+    }
+  } break;
+  default:
+    break;
+  }
+}
+
+// runs once the items of a scope are declared, types may name a struct declared further down
+auto Sema::resolveItemTypes(std::vector<std::unique_ptr<Item>> const& items) -> void
+{
+  auto structs = std::vector<StructItem*>{};
+  for (auto& item : items) {
+    switch (item->mKind) {
+    case Item::Kind::Function:
+      resolveType(item->as<FunctionItem>()->mFnType.get(), item->as<FunctionItem>()->getLoc());
+      break;
+    case Item::Kind::ExternBlock:
+      for (auto& fn : item->as<ExternalBlockItem>()->mItems) {
+        resolveType(fn->mFnType.get(), fn->getLoc());
+      }
+      break;
+    case Item::Kind::Struct: {
+      auto st = item->as<StructItem>();
+      if (lookupItem(st->mName) != st) {
+        break; // nested or redefined, already reported
+      }
+      for (auto& field : st->mFields) {
+        if (resolveType(field.mType.get(), field.mLoc) && !HasLayout(field.mType.get())) {
+          mDiags.report(field.mLoc, DiagId::ErrInvalidFieldType, field.mName, TypeToString(field.mType.get()));
+        }
+      }
+      structs.push_back(st);
+    } break;
+    case Item::Kind::ConstantItem: {
+      auto constant = item->as<ConstantItem>();
+      if (resolveType(constant->mType.get(), constant->getLoc()) && !HasConstantValues(constant->mType.get())) {
+        mDiags.report(constant->getLoc(), DiagId::ErrInvalidConstType, "Const", constant->mName,
+                      TypeToString(constant->mType.get()));
+      }
+    } break;
+    case Item::Kind::StaticItem: {
+      auto staticItem = item->as<StaticItem>();
+      if (resolveType(staticItem->mType.get(), staticItem->getLoc()) && !HasConstantValues(staticItem->mType.get())) {
+        mDiags.report(staticItem->getLoc(), DiagId::ErrInvalidConstType, "Static", staticItem->mName,
+                      TypeToString(staticItem->mType.get()));
+      }
+    } break;
+    default:
+      break;
+    }
+  }
+  for (auto st : structs) {
+    layoutStruct(st);
+  }
+}
+
+// points the struct types at their items, false if one of them is not declared
+auto Sema::resolveType(TypeBase* type, char const* loc) -> bool
+{
+  switch (type->mKind) {
+  case TypeBase::Kind::Struct: {
+    auto st = type->as<StructType>();
+    auto item = lookupItem(st->mName);
+    if (item == nullptr || item->mKind != Item::Kind::Struct) {
+      mDiags.report(loc, DiagId::ErrUnknownType, st->mName);
+      return false;
+    }
+    st->mItem = item->as<StructItem>();
+    return true;
+  }
+  case TypeBase::Kind::Slice:
+    return resolveType(type->as<SliceType>()->mElem.get(), loc);
+  case TypeBase::Kind::Array:
+    return resolveType(type->as<ArrayType>()->mElem.get(), loc);
+  case TypeBase::Kind::Reference:
+    return resolveType(type->as<ReferenceType>()->mPointee.get(), loc);
+  case TypeBase::Kind::RawPointer:
+    return resolveType(type->as<RawPointerType>()->mPointee.get(), loc);
+  case TypeBase::Kind::Tuple: {
+    auto resolved = true;
+    for (auto& elem : type->as<TupleType>()->mTypes) {
+      resolved = resolveType(elem.get(), loc) && resolved;
+    }
+    return resolved;
+  }
+  case TypeBase::Kind::Functions: {
+    auto fn = type->as<FunctionType>();
+    auto resolved = resolveType(fn->mRet.get(), loc);
+    for (auto& param : fn->mParams) {
+      resolved = resolveType(param.get(), loc) && resolved;
+    }
+    return resolved;
+  }
+  default:
+    return true;
+  }
+}
+
+// the structs a struct holds by value, also inside arrays and tuples, are laid out first, a cycle among them would
+// have no finite size. One behind a slice is fine
+auto Sema::layoutStruct(StructItem* item) -> bool
+{
+  if (auto it = mLayouts.find(item); it != mLayouts.end()) {
+    if (it->second == LayoutState::InProgress) {
+      mDiags.report(item->getLoc(), DiagId::ErrRecursiveStruct, item->mName);
+      it->second = LayoutState::Failed;
+    }
+    return it->second == LayoutState::Done;
+  }
+  mLayouts[item] = LayoutState::InProgress;
+  auto layoutHeld = [this](auto& self, TypeBase const* type) -> bool {
+    switch (type->mKind) {
+    case TypeBase::Kind::Struct:
+      return layoutStruct(type->as<StructType>()->mItem);
+    case TypeBase::Kind::Array:
+      return self(self, type->as<ArrayType>()->mElem.get());
+    case TypeBase::Kind::Tuple: {
+      auto complete = true;
+      for (auto& elem : type->as<TupleType>()->mTypes) {
+        complete = self(self, elem.get()) && complete;
+      }
+      return complete;
+    }
+    default:
+      return true;
+    }
+  };
+  auto complete = true;
+  for (auto& field : item->mFields) {
+    if (!HasLayout(field.mType.get())) {
+      complete = false; // already reported
+    } else {
+      complete = layoutHeld(layoutHeld, field.mType.get()) && complete;
+    }
+  }
+  // a cycle through this struct has marked it failed in the meantime
+  complete = complete && mLayouts[item] == LayoutState::InProgress;
+  mLayouts[item] = complete ? LayoutState::Done : LayoutState::Failed;
+  if (complete) {
+    item->mLayout = ComputeStructLayout(item);
+  }
+  return complete;
+}
+
+// `#[repr(C)]` keeps the declaration order, as C code expects it. `#[repr(packed)]` drops all padding, so fields may
+// be misaligned, and `#[repr(align(N))]` raises the alignment, e.g. to give a struct a cache line of its own
+auto Sema::checkStructAttributes(StructItem* item) -> void
+{
+  constexpr auto kExpected = "'C', 'packed' or 'align(N)' with N a power of two";
+  constexpr auto kMaxAlign = u64{1} << 29;
+  Attribute const* alignAttr = nullptr;
+  Attribute const* packedAttr = nullptr;
+  for (auto const& attr : item->mAttrs) {
+    if (attr.mName != "repr") {
+      mDiags.report(attr.mLoc, DiagId::ErrMisplacedAttribute, attr.mName, "a struct");
+      continue;
+    }
+    if (attr.mArgs.empty()) {
+      mDiags.report(attr.mLoc, DiagId::ErrMalformedAttribute, attr.mName, kExpected);
+      continue;
+    }
+    for (auto const& arg : attr.mArgs) {
+      if (arg == "C") {
+        if (item->mReprC) {
+          mDiags.report(attr.mLoc, DiagId::ErrDuplicateAttribute, "repr(C)");
+        }
+        item->mReprC = true;
+      } else if (arg == "packed") {
+        if (packedAttr != nullptr) {
+          mDiags.report(attr.mLoc, DiagId::ErrDuplicateAttribute, "repr(packed)");
+        }
+        packedAttr = &attr;
+        item->mPacked = true;
+      } else if (arg.starts_with("align(") && arg.ends_with(")")) {
+        auto digits = std::string_view(arg).substr(6, arg.size() - 7);
+        auto align = u64{0};
+        auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), align);
+        if (ec != std::errc{} || end != digits.data() + digits.size() || !std::has_single_bit(align) ||
+            align > kMaxAlign) {
+          mDiags.report(attr.mLoc, DiagId::ErrMalformedAttribute, attr.mName, kExpected);
+          continue;
+        }
+        if (alignAttr != nullptr) {
+          mDiags.report(attr.mLoc, DiagId::ErrDuplicateAttribute, "repr(align)");
+        }
+        alignAttr = &attr;
+        item->mMinAlign = align;
+      } else {
+        mDiags.report(attr.mLoc, DiagId::ErrMalformedAttribute, attr.mName, kExpected);
+      }
+    }
+  }
+  if (packedAttr != nullptr && alignAttr != nullptr) {
+    mDiags.report(alignAttr->mLoc, DiagId::ErrConflictingAttributes, "repr(align)", "repr(packed)");
+    item->mMinAlign = 1;
+  }
+}
+
+auto Sema::checkLoopAttributes(LoopExpr* loop) -> void
+{
+  for (auto const& attr : loop->mAttrs) {
+    std::optional<u32>* hint = nullptr;
+    if (attr.mName == "unroll") {
+      hint = &loop->mHints.mUnroll;
+    } else if (attr.mName == "vectorize") {
+      hint = &loop->mHints.mVectorizeWidth;
+    } else if (attr.mName == "interleave") {
+      hint = &loop->mHints.mInterleave;
+    } else {
+      mDiags.report(attr.mLoc, DiagId::ErrMisplacedAttribute, attr.mName, "a loop");
+      continue;
+    }
+    // interleaving has no useful default, the count is required
+    auto count = u32{0};
+    auto const* arg = attr.mArgs.empty() ? nullptr : &attr.mArgs.front();
+    auto valid = attr.mArgs.size() <= 1 && (arg != nullptr || attr.mName != "interleave");
+    if (valid && arg != nullptr) {
+      auto [end, ec] = std::from_chars(arg->data(), arg->data() + arg->size(), count);
+      valid = ec == std::errc{} && end == arg->data() + arg->size() && count > 0;
+    }
+    if (!valid) {
+      mDiags.report(attr.mLoc, DiagId::ErrMalformedAttribute, attr.mName,
+                    attr.mName == "interleave" ? "a positive count" : "no argument or a positive count");
+      continue;
+    }
+    if (hint->has_value()) {
+      mDiags.report(attr.mLoc, DiagId::ErrDuplicateAttribute, attr.mName);
+      continue;
+    }
+    *hint = count;
+  }
+}
+
+// the attributes are only hints for the optimizer, but contradicting ones are rejected rather than picking one
+auto Sema::checkFunctionAttributes(FunctionItem* fn) -> void
+{
+  Attribute const* inlineAttr = nullptr;
+  Attribute const* temperatureAttr = nullptr;
+  auto spelling = [](Attribute const& attr) {
+    return attr.mArgs.empty() ? attr.mName : utils::format("{}({})", attr.mName, attr.mArgs.front());
+  };
+  for (auto const& attr : fn->mAttrs) {
+    if (attr.mName == "inline" || attr.mName == "noinline") {
+      auto hint = FunctionItem::InlineHint::Inline;
+      if (attr.mName == "noinline") {
+        hint = FunctionItem::InlineHint::Never;
+        if (!attr.mArgs.empty()) {
+          mDiags.report(attr.mLoc, DiagId::ErrMalformedAttribute, attr.mName, "no arguments");
+          continue;
+        }
+      } else if (attr.mArgs.size() == 1 && attr.mArgs.front() == "always") {
+        hint = FunctionItem::InlineHint::Always;
+      } else if (attr.mArgs.size() == 1 && attr.mArgs.front() == "never") {
+        hint = FunctionItem::InlineHint::Never;
+      } else if (!attr.mArgs.empty()) {
+        mDiags.report(attr.mLoc, DiagId::ErrMalformedAttribute, attr.mName,
+                      "'inline', 'inline(always)' or 'inline(never)'");
+        continue;
+      }
+      if (inlineAttr != nullptr && fn->mInline != hint) {
+        mDiags.report(attr.mLoc, DiagId::ErrConflictingAttributes, spelling(attr), spelling(*inlineAttr));
+        continue;
+      }
+      inlineAttr = &attr;
+      fn->mInline = hint;
+    } else if (attr.mName == "hot" || attr.mName == "cold") {
+      if (!attr.mArgs.empty()) {
+        mDiags.report(attr.mLoc, DiagId::ErrMalformedAttribute, attr.mName, "no arguments");
+        continue;
+      }
+      auto temperature = attr.mName == "hot" ? FunctionItem::Temperature::Hot : FunctionItem::Temperature::Cold;
+      if (temperatureAttr != nullptr && fn->mTemperature != temperature) {
+        mDiags.report(attr.mLoc, DiagId::ErrConflictingAttributes, spelling(attr), spelling(*temperatureAttr));
+        continue;
+      }
+      temperatureAttr = &attr;
+      fn->mTemperature = temperature;
+    } else {
+      mDiags.report(attr.mLoc, DiagId::ErrUnknownAttribute, attr.mName);
+    }
+  }
+}
+
 auto Sema::actOnFunctionItem(FunctionItem* item) -> void
 {
-  insertItem(item->mName, item);
   mFunctionStack.push({item, mScopes.size()});
   auto guard = enterScope();
   {
@@ -279,35 +1418,73 @@ auto Sema::actOnFunctionItem(FunctionItem* item) -> void
       insertIdentifier(item->mParamNames[i], TypeClone(item->mFnType->mParams[i].get()));
     }
     auto retType = actOnBlockExpr(item->mBody.get());
-    if (!TypeEquals(retType.get(), item->mFnType->mRet.get())) {
-      mDiags.report((item->getLoc()), DiagId::ErrIncompatibleTypes,
-                    utils::format("function '{}' return type", item->mName), TypeToString(item->mFnType->mRet.get()),
-                    TypeToString(retType.get()));
+    if (retType->mKind != TypeBase::Kind::Never && !TypeCoercible(retType.get(), item->mFnType->mRet.get())) {
+      mDiags.report((item->getLoc()), DiagId::ErrIncompatibleReturnType, item->mName, "return type",
+                    TypeToString(item->mFnType->mRet.get()), TypeToString(retType.get()));
+    } else {
+      coerce(item->mBody->mReturn, item->mFnType->mRet.get(), item->getLoc());
     }
   }
   mFunctionStack.pop();
 }
 
+// the initializer sees items but none of the locals around it, whether it is constant is up to ConstEval
+auto Sema::checkInitializer(std::string const& name, TypeBase const* type, Expr* expr, char const* loc) -> void
+{
+  mFunctionStack.push({nullptr, mScopes.size()});
+  auto exprType = actOnExpr(expr);
+  mFunctionStack.pop();
+  if (!TypeCoercible(exprType.get(), type)) {
+    mDiags.report(loc, DiagId::ErrIncompatibleInitializer, name, TypeToString(type), TypeToString(exprType.get()));
+  }
+}
+
 auto Sema::actOnExternalBlockItem(ExternalBlockItem* expr) -> void
 {
+  // declarations were inserted by declareItem, only bodies would need checking. IRGen passes aggregates the way C
+  // does, which it cannot do for a vector inside one
   for (auto& item : expr->mItems) {
-    if (item->isDeclaration()) {
-      insertItem(item->mName, item.get());
+    assert(item->isDeclaration());
+    auto fnType = item->mFnType.get();
+    auto check = [&](TypeBase const* type) {
+      if (IsCompound(type) && ContainsVector(type)) {
+        mDiags.report(item->getLoc(), DiagId::ErrUnsupportedExternType, item->mName, TypeToString(type));
+      }
+    };
+    for (auto& param : fnType->mParams) {
+      check(param.get());
     }
+    check(fnType->mRet.get());
   }
 }
 
 auto Sema::actOnLetStmt(LetStmt* stmt) -> void
 {
   auto type = actOnExpr(stmt->mExpr.get());
-  if (stmt->mExpectType) {
+  if (stmt->mExpectType && resolveType(stmt->mExpectType.get(), stmt->getLoc())) {
     auto expectedType = stmt->mExpectType.get();
-    if (!TypeEquals(type.get(), expectedType)) {
+    if (!TypeCoercible(type.get(), expectedType)) {
       mDiags.report((stmt->getLoc()), DiagId::ErrIncompatibleTypes, "let statement", TypeToString(expectedType),
                     TypeToString(type.get()));
+    } else {
+      coerce(stmt->mExpr, expectedType, stmt->getLoc());
+      type = TypeClone(expectedType); // a pointer converted to the declared one
     }
   }
-  insertIdentifier(stmt->mName, std::move(type));
+  if (!stmt->mPattern) {
+    insertIdentifier(stmt->mName, std::move(type));
+    return;
+  }
+  // the names are still declared when the value does not match, so their uses are not reported as well
+  auto const& names = *stmt->mPattern;
+  auto tuple = type->mKind == TypeBase::Kind::Tuple ? type->as<TupleType>() : nullptr;
+  if (type->mKind != TypeBase::Kind::Unknown && (tuple == nullptr || tuple->mTypes.size() != names.size())) {
+    mDiags.report(stmt->getLoc(), DiagId::ErrTuplePattern, names.size(), TypeToString(type.get()));
+    tuple = nullptr;
+  }
+  for (size_t i = 0; i < names.size(); ++i) {
+    insertIdentifier(names[i], tuple ? TypeClone(tuple->mTypes[i]) : std::make_unique<Unknown>());
+  }
 }
 
 auto Sema::actOnExprStmt(ExprStmt* stmt) -> void
@@ -2,7 +2,9 @@
 
 #include "Frontend/Lexer.hpp"
 #include "Scope.hpp"
+#include <functional>
 #include <stack>
+#include <unordered_map>
 
 class Sema {
   DiagnosticsEngine& mDiags;
@@ -14,18 +16,28 @@ class Sema {
   };
   std::stack<FunctionProp> mFunctionStack;
 
+  std::function<void(Item*)> mOnItemChecked;
+
+  enum class LayoutState { InProgress, Done, Failed };
+  std::unordered_map<StructItem const*, LayoutState> mLayouts;
+
 public:
   Sema(DiagnosticsEngine& diags) : mDiags(diags) {}
 
+  // called after each top-level function, const and static has been checked, e.g. to start lowering it right away
+  auto setOnItemChecked(std::function<void(Item*)> callback) -> void { mOnItemChecked = std::move(callback); }
+
   auto actOnCrate(Crate const* crate) -> void;
 
   auto actOnExpr(Expr* expr) -> std::unique_ptr<TypeBase>;
   auto actOnExprWithBlock(ExprWithBlock* expr) -> std::unique_ptr<TypeBase>;
   auto actOnBlockExpr(BlockExpr* expr) -> std::unique_ptr<TypeBase>;
+  auto actOnBlockExprImpl(BlockExpr* expr) -> std::unique_ptr<TypeBase>;
   auto actOnIfExpr(IfExpr* expr) -> std::unique_ptr<TypeBase>;
   auto actOnLoopExpr(LoopExpr* expr) -> std::unique_ptr<TypeBase>;
   auto actOnInfiniteLoopExpr(InfiniteLoopExpr* expr) -> std::unique_ptr<TypeBase>;
   auto actOnPredicateLoopExpr(PredicateLoopExpr* expr) -> std::unique_ptr<TypeBase>;
+  auto actOnIteratorLoopExpr(IteratorLoopExpr* expr) -> std::unique_ptr<TypeBase>;
 
   auto actOnExprWithoutBlock(ExprWithoutBlock* expr) -> std::unique_ptr<TypeBase>;
   auto actOnOperatorExpr(OperatorExpr* expr) -> std::unique_ptr<TypeBase>;
@@ -35,10 +47,35 @@ public:
   auto actOnGroupedExpr(GroupedExpr* expr) -> std::unique_ptr<TypeBase>;
   auto actOnReturnExpr(ReturnExpr* expr) -> std::unique_ptr<TypeBase>;
   auto actOnCallExpr(CallExpr* expr) -> std::unique_ptr<TypeBase>;
+  auto actOnArrayExpr(ArrayExpr* expr) -> std::unique_ptr<TypeBase>;
+  auto actOnIndexExpr(IndexExpr* expr) -> std::unique_ptr<TypeBase>;
+  auto actOnMethodCallExpr(MethodCallExpr* expr) -> std::unique_ptr<TypeBase>;
+  auto actOnStructExpr(StructExpr* expr) -> std::unique_ptr<TypeBase>;
+  auto actOnFieldExpr(FieldExpr* expr) -> std::unique_ptr<TypeBase>;
+  auto actOnTupleExpr(TupleExpr* expr) -> std::unique_ptr<TypeBase>;
+  auto actOnVectorCallExpr(CallExpr* expr) -> std::unique_ptr<TypeBase>;
+  auto actOnVectorMethodCallExpr(MethodCallExpr* expr, VectorType const* vec,
+                                 std::vector<std::unique_ptr<TypeBase>> const& argTypes) -> std::unique_ptr<TypeBase>;
+  auto checkArgCount(char const* loc, size_t expected, size_t got) -> bool;
+  auto checkMutablePlace(Expr const* expr, char const* loc) -> void;
+  auto checkBorrowConflicts(CallExpr const* expr) -> void;
+  auto autoDeref(std::unique_ptr<Expr>& base, std::unique_ptr<TypeBase> type, char const* loc)
+      -> std::unique_ptr<TypeBase>;
+  auto coerce(std::unique_ptr<Expr>& expr, TypeBase const* to, char const* loc) -> void;
+  auto checkVectorMemory(char const* loc, VectorType const* vec, TypeBase const* memory, TypeBase const* index)
+      -> void;
 
+  auto declareItem(Item* item) -> void;
+  auto checkFunctionAttributes(FunctionItem* fn) -> void;
+  auto checkLoopAttributes(LoopExpr* loop) -> void;
+  auto checkStructAttributes(StructItem* item) -> void;
+  auto resolveItemTypes(std::vector<std::unique_ptr<Item>> const& items) -> void;
+  auto resolveType(TypeBase* type, char const* loc) -> bool;
+  auto layoutStruct(StructItem* item) -> bool;
   auto actOnItem(Item* expr) -> void;
   auto actOnFunctionItem(FunctionItem* expr) -> void;
   auto actOnExternalBlockItem(ExternalBlockItem* expr) -> void;
+  auto checkInitializer(std::string const& name, TypeBase const* type, Expr* expr, char const* loc) -> void;
 
   auto actOnStmt(Stmt* expr) -> void;
   auto actOnLetStmt(LetStmt* expr) -> void;
@@ -55,7 +92,8 @@ public:
   {
     return mScopes.lookupIdUntil(name, mFunctionStack.top().loc);
   }
-  auto lookupItem(std::string const& name) -> Item* { return mScopes.lookupItemUntil(name, mFunctionStack.top().loc); }
+  // items are visible from nested functions, unlike local identifiers
+  auto lookupItem(std::string const& name) -> Item* { return mScopes.lookupItem(name); }
 
   auto lookupIdUntil(std::string const& name, i32 until) -> TypeBase* { return mScopes.lookupIdUntil(name, until); }
   auto lookupItemUntil(std::string const& name, i32 until) -> Item* { return mScopes.lookupItemUntil(name, until); }
@@ -0,0 +1,317 @@
+#include "SemanticHash.hpp"
+#include "Frontend/Visitor.hpp"
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/SHA1.h>
+#include <bit>
+#include <unordered_set>
+
+namespace {
+// every field is length prefixed or fixed size, so different trees cannot feed the same byte sequence
+struct HashVisitor : public Visitor<void> {
+  llvm::SHA1 mHasher;
+  std::unordered_set<Item const*> mNamed; // structs, consts and statics, hashed the first time they are named
+
+  using Visitor<void>::walk;
+
+  void add(u64 value)
+  {
+    u8 bytes[8];
+    for (auto i = 0; i < 8; ++i) {
+      bytes[i] = static_cast<u8>(value >> (i * 8));
+    }
+    mHasher.update(llvm::ArrayRef<u8>(bytes));
+  }
+  void add(std::string_view str)
+  {
+    add(static_cast<u64>(str.size()));
+    mHasher.update(llvm::StringRef(str.data(), str.size()));
+  }
+  void add(TypeBase const* type)
+  {
+    add(type == nullptr ? std::string_view{"?"} : TypeToString(type));
+    if (type != nullptr) {
+      addStructs(type);
+    }
+  }
+  // a struct is named by its type, but the code depends on its fields and layout
+  void addStructs(TypeBase const* type)
+  {
+    switch (type->mKind) {
+    case TypeBase::Kind::Struct:
+      if (auto item = type->as<StructType>()->mItem; item != nullptr && mNamed.insert(item).second) {
+        walk(item);
+      }
+      break;
+    case TypeBase::Kind::Slice:
+      return addStructs(type->as<SliceType>()->mElem.get());
+    case TypeBase::Kind::Array:
+      return addStructs(type->as<ArrayType>()->mElem.get());
+    case TypeBase::Kind::Reference:
+    case TypeBase::Kind::RawPointer:
+      return addStructs(PointeeType(type));
+    case TypeBase::Kind::Tuple:
+      for (auto& elem : type->as<TupleType>()->mTypes) {
+        addStructs(elem.get());
+      }
+      break;
+    case TypeBase::Kind::Functions:
+      for (auto& param : type->as<FunctionType>()->mParams) {
+        addStructs(param.get());
+      }
+      return addStructs(type->as<FunctionType>()->mRet.get());
+    default:
+      break;
+    }
+  }
+
+  void hashExpr(Expr* expr)
+  {
+    add(expr->getType());
+    walkExpr(expr);
+  }
+  void hashOptionalExpr(Expr* expr)
+  {
+    add(static_cast<u64>(expr != nullptr));
+    if (expr != nullptr) {
+      hashExpr(expr);
+    }
+  }
+
+  void walk(ArrayExpr* expr)
+  {
+    add("array");
+    add(static_cast<u64>(expr->mRepeat.has_value()));
+    add(expr->mRepeat.value_or(0));
+    add(static_cast<u64>(expr->mElems.size()));
+    for (auto& elem : expr->mElems) {
+      hashExpr(elem.get());
+    }
+  }
+  void walk(BinaryExpr* expr)
+  {
+    add(BinaryExpr::ToString(expr->mKind));
+    hashExpr(expr->mLeft.get());
+    hashExpr(expr->mRight.get());
+  }
+  void walk(BlockExpr* expr)
+  {
+    add("block");
+    add(static_cast<u64>(expr->mItems.size()));
+    for (auto& item : expr->mItems) {
+      walkItem(item.get());
+    }
+    add(static_cast<u64>(expr->mStmts.size()));
+    for (auto& stmt : expr->mStmts) {
+      walkStmt(stmt.get());
+    }
+    hashOptionalExpr(expr->mReturn.get());
+  }
+  // the callee is only referenced by symbol, its signature is all that matters for this function
+  void walk(CallExpr* expr)
+  {
+    add("call");
+    add(expr->mCallee);
+    if (auto callee = expr->mFnItem) {
+      add(static_cast<u64>(callee->isDeclaration()));
+      add(static_cast<u64>(callee->mTemperature)); // a call to a cold function is an unlikely path
+      add(callee->mFnType.get());
+    }
+    add(static_cast<u64>(expr->mArgs.size()));
+    for (auto& arg : expr->mArgs) {
+      hashExpr(arg.get());
+    }
+  }
+  void walk(GroupedExpr* expr)
+  {
+    add("group");
+    hashExpr(expr->mExpr.get());
+  }
+  void walk(IfExpr* expr)
+  {
+    add("if");
+    hashExpr(expr->mCond.get());
+    hashExpr(expr->mThen.get());
+    hashOptionalExpr(expr->mElse.get());
+  }
+  void walk(IndexExpr* expr)
+  {
+    add("index");
+    add(static_cast<u64>(expr->mChecked));
+    hashExpr(expr->mBase.get());
+    hashExpr(expr->mIndex.get());
+  }
+  void walk(StructExpr* expr)
+  {
+    add("struct");
+    add(expr->mName);
+    add(static_cast<u64>(expr->mFields.size()));
+    for (auto& init : expr->mFields) {
+      add(static_cast<u64>(init.mIndex));
+      hashExpr(init.mValue.get());
+    }
+  }
+  void walk(FieldExpr* expr)
+  {
+    add("field");
+    add(static_cast<u64>(expr->mIndex));
+    hashExpr(expr->mBase.get());
+  }
+  void walk(TupleExpr* expr)
+  {
+    add("tuple");
+    add(static_cast<u64>(expr->mElems.size()));
+    for (auto& elem : expr->mElems) {
+      hashExpr(elem.get());
+    }
+  }
+  void walk(MethodCallExpr* expr)
+  {
+    add("method");
+    add(expr->mMethod);
+    hashExpr(expr->mReceiver.get());
+    add(static_cast<u64>(expr->mArgs.size()));
+    for (auto& arg : expr->mArgs) {
+      hashExpr(arg.get());
+    }
+  }
+  void add(LoopExpr::Hints const& hints)
+  {
+    for (auto const& hint : {hints.mUnroll, hints.mVectorizeWidth, hints.mInterleave}) {
+      add(static_cast<u64>(hint.has_value()));
+      add(static_cast<u64>(hint.value_or(0)));
+    }
+  }
+
+  void walk(InfiniteLoopExpr* expr)
+  {
+    add("loop");
+    add(expr->mHints);
+    hashExpr(expr->mExpr.get());
+  }
+  void walk(IteratorLoopExpr* expr)
+  {
+    add("for");
+    add(expr->mHints);
+    add(expr->mName);
+    hashExpr(expr->mStart.get());
+    hashExpr(expr->mEnd.get());
+    hashOptionalExpr(expr->mStep.get());
+    hashExpr(expr->mExpr.get());
+  }
+  // the value of a const or static is part of the code that uses it
+  void walk(LiteralExpr* expr)
+  {
+    if (auto item = expr->mItem; item != nullptr && mNamed.insert(item).second) {
+      walkItem(item);
+    }
+    add(static_cast<u64>(expr->mKind));
+    std::visit(
+        [this]<typename T>(T const& v) {
+          if constexpr (std::is_same_v<T, std::string>) {
+            add(v);
+          } else if constexpr (std::is_same_v<T, float>) {
+            add(static_cast<u64>(std::bit_cast<u32>(v)));
+          } else if constexpr (std::is_same_v<T, double>) {
+            add(std::bit_cast<u64>(v));
+          } else {
+            add(static_cast<u64>(v));
+          }
+        },
+        expr->mValue);
+  }
+  void walk(PredicateLoopExpr* expr)
+  {
+    add("while");
+    add(expr->mHints);
+    hashExpr(expr->mCond.get());
+    hashExpr(expr->mExpr.get());
+  }
+  void walk(ReturnExpr* expr)
+  {
+    add("return");
+    hashOptionalExpr(expr->mExpr.get());
+  }
+  void walk(UnaryExpr* expr)
+  {
+    add(UnaryExpr::ToString(expr->mKind));
+    hashExpr(expr->mRight.get());
+  }
+  void walk(ExprStmt* stmt)
+  {
+    add("expr");
+    hashExpr(stmt->mExpr.get());
+  }
+  void walk(LetStmt* stmt)
+  {
+    add("let");
+    add(static_cast<u64>(stmt->mPattern.has_value()));
+    for (auto const& name : stmt->boundNames()) {
+      add(name);
+    }
+    add(stmt->mExpectType.get());
+    hashOptionalExpr(stmt->mExpr.get());
+  }
+  void walk(FunctionItem* item)
+  {
+    add("fn");
+    add(item->mName);
+    add(static_cast<u64>(item->mParamNames.size()));
+    for (auto& name : item->mParamNames) {
+      add(name);
+    }
+    add(item->mFnType.get());
+    add(static_cast<u64>(item->mInline));
+    add(static_cast<u64>(item->mTemperature));
+    add(static_cast<u64>(item->isDeclaration()));
+    if (!item->isDeclaration()) {
+      hashExpr(item->mBody.get());
+    }
+  }
+  void walk(StructItem* item)
+  {
+    add("struct");
+    add(item->mName);
+    add(static_cast<u64>(item->mPacked));
+    add(item->mLayout.mSize);
+    add(item->mLayout.mAlign);
+    add(static_cast<u64>(item->mFields.size()));
+    for (u32 i = 0; i < item->mFields.size(); ++i) {
+      add(item->mFields[i].mName);
+      add(item->mFields[i].mType.get());
+      add(i < item->mLayout.mOffsets.size() ? item->mLayout.mOffsets[i] : 0);
+    }
+  }
+  void walk(ConstantItem* item)
+  {
+    add("const");
+    add(item->mName);
+    add(item->mType.get());
+    hashExpr(item->mExpr.get());
+  }
+  void walk(StaticItem* item)
+  {
+    add("static");
+    add(item->mName);
+    add(static_cast<u64>(item->mMutable));
+    add(item->mType.get());
+    hashExpr(item->mExpr.get());
+  }
+  void walk(ExternalBlockItem* item)
+  {
+    add("extern");
+    add(item->mABI);
+    add(static_cast<u64>(item->mItems.size()));
+    for (auto& fn : item->mItems) {
+      walk(fn.get());
+    }
+  }
+};
+} // namespace
+
+auto SemanticHash(FunctionItem* fn) -> std::string
+{
+  auto visitor = HashVisitor{};
+  visitor.walk(fn);
+  return llvm::toHex(visitor.mHasher.final(), true);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "Frontend/Syntax.hpp"
+#include <string>
+
+// Stable hash of a function item after Sema, as 40 hex digits. It covers the structure of the body with the type of
+// every expression, the items nested in it and the signatures of its callees. Source locations and formatting do not
+// contribute, so the hash only changes if the code generated for the function could change.
+auto SemanticHash(FunctionItem* fn) -> std::string;
@@ -26,6 +26,10 @@ auto BinaryExpr::BindingPower(BinaryExpr::Kind kind) -> std::tuple<i32, i32>
   case Kind::Ge:
   case Kind::Le:
     return {10, 11};
+  case Kind::LogicalAnd:
+    return {6, 7};
+  case Kind::LogicalOr:
+    return {4, 5};
   case Kind::Assignment:
     return {3, 2};
   case Kind::SIZE:
@@ -53,9 +57,9 @@ auto BinaryExpr::MapKind(TokenKind tok) -> BinaryExpr::Kind
   case PunOr:
     return Kind::BitOr;
   case PunAndAnd:
+    return Kind::LogicalAnd;
   case PunOrOr:
-    assert(0);
-    return {};
+    return Kind::LogicalOr;
   case PunShl:
     return Kind::Shl;
   case PunShr:
@@ -84,6 +88,10 @@ auto UnaryExpr::BindingPower(UnaryExpr::Kind kind) -> std::tuple<i32>
   switch (kind) {
   case Kind::Neg:
   case Kind::Not:
+  case Kind::Ref:
+  case Kind::RefMut:
+  case Kind::Deref:
+  case Kind::Unsize:
     return {26};
   case Kind::SIZE:
     assert(0);
@@ -97,6 +105,10 @@ auto UnaryExpr::MapKind(TokenKind tok) -> UnaryExpr::Kind
     return Kind::Not;
   case PunMinus:
     return Kind::Neg;
+  case PunAnd: // `&mut` is told apart by the parser
+    return Kind::Ref;
+  case PunStar:
+    return Kind::Deref;
   default:
     return Kind::SIZE;
   }
@@ -125,6 +137,18 @@ void ExprVisitor::visitExprWithoutBlock(ExprWithoutBlock* expr)
     return visit(expr->as<CallExpr>());
   case ExprWithoutBlock::Type::Return:
     return visit(expr->as<ReturnExpr>());
+  case ExprWithoutBlock::Type::Index:
+    return visit(expr->as<IndexExpr>());
+  case ExprWithoutBlock::Type::MethodCall:
+    return visit(expr->as<MethodCallExpr>());
+  case ExprWithoutBlock::Type::Array:
+    return visit(expr->as<ArrayExpr>());
+  case ExprWithoutBlock::Type::Struct:
+    return visit(expr->as<StructExpr>());
+  case ExprWithoutBlock::Type::Field:
+    return visit(expr->as<FieldExpr>());
+  case ExprWithoutBlock::Type::Tuple:
+    return visit(expr->as<TupleExpr>());
   }
   utils::Unimplemented(utils::SrcLoc::current());
 }
@@ -162,6 +186,8 @@ void ExprVisitor::visitLoopExpr(LoopExpr* expr)
     return this->visit(expr->as<InfiniteLoopExpr>());
   case LoopExpr::Type::PredicateLoop:
     return this->visit(expr->as<PredicateLoopExpr>());
+  case LoopExpr::Type::IteratorLoop:
+    return this->visit(expr->as<IteratorLoopExpr>());
   }
 };
 
@@ -188,6 +214,15 @@ void StmtVisitor::visitItem(Item* item)
   case Item::Kind::Function:
     this->visit(item->as<FunctionItem>());
     break;
+  case Item::Kind::Struct:
+    this->visit(item->as<StructItem>());
+    break;
+  case Item::Kind::ConstantItem:
+    this->visit(item->as<ConstantItem>());
+    break;
+  case Item::Kind::StaticItem:
+    this->visit(item->as<StaticItem>());
+    break;
   default:
     utils::Unimplemented(utils::SrcLoc::current());
   }
@@ -213,6 +248,17 @@ void StringifyExpr::visit(UnaryExpr* expr)
   case UnaryExpr::Kind::Not:
     str += '!';
     return visitExpr(expr->mRight.get());
+  case UnaryExpr::Kind::Ref:
+    str += '&';
+    return visitExpr(expr->mRight.get());
+  case UnaryExpr::Kind::RefMut:
+    str += "&mut ";
+    return visitExpr(expr->mRight.get());
+  case UnaryExpr::Kind::Deref:
+    str += '*';
+    return visitExpr(expr->mRight.get());
+  case UnaryExpr::Kind::Unsize:
+    return visitExpr(expr->mRight.get());
   case UnaryExpr::Kind::SIZE:
     assert(0);
     break;
@@ -243,6 +289,8 @@ void StringifyExpr::visit(BinaryExpr* expr)
     CASE(Lt, <)
     CASE(Ge, >=)
     CASE(Le, <=)
+    CASE(LogicalAnd, &&)
+    CASE(LogicalOr, ||)
     CASE(Assignment, =)
 #undef CASE
   case BinaryExpr::Kind::SIZE:
@@ -282,6 +330,22 @@ void StringifyExpr::visit(PredicateLoopExpr* expr)
   this->visitExpr(expr->mCond.get());
   this->visit(expr->mExpr.get());
 }
+void StringifyExpr::visit(IteratorLoopExpr* expr)
+{
+  str += "for " + expr->mName + " in ";
+  if (expr->mStep) {
+    str += '(';
+  }
+  this->visitExpr(expr->mStart.get());
+  str += "..";
+  this->visitExpr(expr->mEnd.get());
+  if (expr->mStep) {
+    str += ").step_by(";
+    this->visitExpr(expr->mStep.get());
+    str += ')';
+  }
+  this->visit(expr->mExpr.get());
+}
 
 void StringifyExpr::visit(CallExpr* expr)
 {
@@ -302,6 +366,79 @@ void StringifyExpr::visit(ReturnExpr* expr)
   this->visitExpr(expr->mExpr.get());
 }
 
+void StringifyExpr::visit(IndexExpr* expr)
+{
+  this->visitExpr(expr->mBase.get());
+  str += '[';
+  this->visitExpr(expr->mIndex.get());
+  str += ']';
+}
+
+void StringifyExpr::visit(MethodCallExpr* expr)
+{
+  this->visitExpr(expr->mReceiver.get());
+  str += '.';
+  str += expr->mMethod;
+  str += '(';
+  for (i32 i = 0; i < expr->mArgs.size(); ++i) {
+    this->visitExpr(expr->mArgs[i].get());
+    if (i != expr->mArgs.size() - 1) {
+      str += ',';
+    }
+  }
+  str += ')';
+}
+
+void StringifyExpr::visit(ArrayExpr* expr)
+{
+  str += '[';
+  for (i32 i = 0; i < expr->mElems.size(); ++i) {
+    this->visitExpr(expr->mElems[i].get());
+    if (i != expr->mElems.size() - 1) {
+      str += ',';
+    }
+  }
+  if (expr->mRepeat) {
+    str += ';';
+    str += std::to_string(*expr->mRepeat);
+  }
+  str += ']';
+}
+
+void StringifyExpr::visit(StructExpr* expr)
+{
+  str += expr->mName;
+  str += '{';
+  for (i32 i = 0; i < expr->mFields.size(); ++i) {
+    str += expr->mFields[i].mName;
+    str += ':';
+    this->visitExpr(expr->mFields[i].mValue.get());
+    if (i != expr->mFields.size() - 1) {
+      str += ',';
+    }
+  }
+  str += '}';
+}
+
+void StringifyExpr::visit(FieldExpr* expr)
+{
+  this->visitExpr(expr->mBase.get());
+  str += '.';
+  str += expr->mField;
+}
+
+void StringifyExpr::visit(TupleExpr* expr)
+{
+  str += '(';
+  for (i32 i = 0; i < expr->mElems.size(); ++i) {
+    this->visitExpr(expr->mElems[i].get());
+    if (i != expr->mElems.size() - 1 || expr->mElems.size() == 1) {
+      str += ',';
+    }
+  }
+  str += ')';
+}
+
 void StringifyStmt::visit(ExprStmt* stmt)
 {
   mExprVisitor.visitExpr(stmt->mExpr.get());
@@ -310,7 +447,18 @@ void StringifyStmt::visit(ExprStmt* stmt)
 void StringifyStmt::visit(LetStmt* stmt)
 {
   str += "let ";
-  str += stmt->mName;
+  if (stmt->mPattern) {
+    str += '(';
+    for (i32 i = 0; i < stmt->mPattern->size(); ++i) {
+      str += (*stmt->mPattern)[i];
+      if (i != stmt->mPattern->size() - 1) {
+        str += ',';
+      }
+    }
+    str += ')';
+  } else {
+    str += stmt->mName;
+  }
   str += '=';
   mExprVisitor.visitExpr(stmt->mExpr.get());
   str += ';';
@@ -334,4 +482,39 @@ void StringifyStmt::visit(FunctionItem* item)
     str += TypeToString(item->mFnType->mRet.get());
   }
   mExprVisitor.visitExpr(item->mBody.get());
-}
\ No newline at end of file
+}
+void StringifyStmt::visit(StructItem* item)
+{
+  str += "struct ";
+  str += item->mName;
+  str += '{';
+  for (i32 i = 0; i < item->mFields.size(); ++i) {
+    str += item->mFields[i].mName;
+    str += ':';
+    str += TypeToString(item->mFields[i].mType.get());
+    if (i != item->mFields.size() - 1) {
+      str += ',';
+    }
+  }
+  str += '}';
+}
+void StringifyStmt::visit(ConstantItem* item)
+{
+  str += "const ";
+  str += item->mName;
+  str += ':';
+  str += TypeToString(item->mType.get());
+  str += '=';
+  mExprVisitor.visitExpr(item->mExpr.get());
+  str += ';';
+}
+void StringifyStmt::visit(StaticItem* item)
+{
+  str += item->mMutable ? "static mut " : "static ";
+  str += item->mName;
+  str += ':';
+  str += TypeToString(item->mType.get());
+  str += '=';
+  mExprVisitor.visitExpr(item->mExpr.get());
+  str += ';';
+}
@@ -3,6 +3,8 @@
 #include "Types.hpp"
 #include "common.hpp"
 
+#include <optional>
+
 #define IMPL_AS(Target)                                                                                                \
   template <typename T>                                                                                                \
     requires std::derived_from<T, Target>                                                                              \
@@ -10,6 +12,12 @@
   {                                                                                                                    \
     return static_cast<T*>(this);                                                                                      \
   }                                                                                                                    \
+  template <typename T>                                                                                                \
+    requires std::derived_from<T, Target>                                                                              \
+  auto as() const->T const*                                                                                            \
+  {                                                                                                                    \
+    return static_cast<T const*>(this);                                                                                \
+  }                                                                                                                    \
   Target() = delete;
 
 struct Node {
@@ -76,6 +84,7 @@ public:
 struct LetStmt final : Stmt {
 public:
   std::string mName;
+  std::optional<std::vector<std::string>> mPattern; // `let (a, b) = ..` binds the elements of a tuple instead
   std::unique_ptr<Expr> mExpr;
   std::unique_ptr<TypeBase> mExpectType;
 
@@ -85,19 +94,35 @@ public:
       : Stmt(Stmt::Type::Let), mName(name), mExpr(std::move(expr)), mExpectType(std::move(expectType)) LOC_INIT
   {
   }
+  LetStmt(std::vector<std::string> pattern, std::unique_ptr<TypeBase> expectType, std::unique_ptr<Expr> expr LOC_PARAM)
+      : Stmt(Stmt::Type::Let), mPattern(std::move(pattern)), mExpr(std::move(expr)),
+        mExpectType(std::move(expectType)) LOC_INIT
+  {
+  }
   ~LetStmt() override final = default;
+
+  auto boundNames() const -> std::vector<std::string> { return mPattern ? *mPattern : std::vector{mName}; }
 };
 
 //===----------------------------------------------------------------------===//
 // Item
 //===----------------------------------------------------------------------===//
 
+// outer attribute, `#[name]` or `#[name(arg, ...)]`, interpreted by Sema
+struct Attribute {
+  std::string mName;
+  std::vector<std::string> mArgs;
+  char const* mLoc;
+};
+
 struct Item : Node {
 public:
   DEFINE_KINDS(Module, ExternCrate, UseDeclaration, Function, TypeAlias, Struct, Enumeration, Union, ConstantItem,
                StaticItem, Trait, Implementation, ExternBlock);
   IMPL_AS(Item);
 
+  std::vector<Attribute> mAttrs;
+
 public:
   Item(Kind kind) : mKind(kind) {}
   ~Item() override = default;
@@ -105,10 +130,16 @@ public:
 
 struct FunctionItem final : public Item {
 public:
+  enum class InlineHint { None, Inline, Always, Never };
+  enum class Temperature { None, Hot, Cold };
+
   std::string mName;
   std::vector<std::string> mParamNames;
   std::unique_ptr<FunctionType> mFnType;
   std::unique_ptr<BlockExpr> mBody; // if null, it's a declaration
+  bool mIsConst = false;            // `const fn`, may be evaluated at compile time
+  InlineHint mInline = InlineHint::None;         // from #[inline], #[inline(always)] or #[noinline], set by Sema
+  Temperature mTemperature = Temperature::None; // from #[hot] or #[cold], set by Sema
 
   DEFINE_LOC
 public:
@@ -135,6 +166,86 @@ public:
   ~ExternalBlockItem() override = default;
 };
 
+// byte offsets of the fields by declaration index and the order they are placed in memory, computed by Sema
+struct StructLayout {
+  u64 mSize = 0;
+  u64 mAlign = 1;
+  std::vector<u64> mOffsets;
+  std::vector<u32> mMemoryOrder;
+};
+
+// `struct Name { field: T, ... }`. Without #[repr(C)] the fields are reordered by decreasing alignment, which leaves
+// no padding between them
+struct StructItem final : public Item {
+public:
+  struct Field {
+    std::string mName;
+    std::unique_ptr<TypeBase> mType;
+    char const* mLoc;
+  };
+
+  std::string mName;
+  std::vector<Field> mFields; // in declaration order
+  bool mReprC = false;        // from #[repr(C)], set by Sema
+  bool mPacked = false;       // from #[repr(packed)], set by Sema
+  u64 mMinAlign = 1;          // from #[repr(align(N))], set by Sema
+  StructLayout mLayout;
+
+  DEFINE_LOC
+public:
+  StructItem(std::string const& name, std::vector<Field>&& fields LOC_PARAM)
+      : Item(Item::Kind::Struct), mName(name), mFields(std::move(fields)) LOC_INIT
+  {
+  }
+  ~StructItem() override = default;
+
+  auto findField(std::string_view name) const -> std::optional<u32>
+  {
+    for (u32 i = 0; i < mFields.size(); ++i) {
+      if (mFields[i].mName == name) {
+        return i;
+      }
+    }
+    return std::nullopt;
+  }
+};
+
+// `const NAME: T = expr;`, folded to its value at compile time and inlined at every use, a const has no address
+struct ConstantItem final : public Item {
+public:
+  std::string mName;
+  std::unique_ptr<TypeBase> mType;
+  std::unique_ptr<Expr> mExpr;
+
+  DEFINE_LOC
+public:
+  ConstantItem(std::string const& name, std::unique_ptr<TypeBase> type, std::unique_ptr<Expr> expr LOC_PARAM)
+      : Item(Item::Kind::ConstantItem), mName(name), mType(std::move(type)), mExpr(std::move(expr)) LOC_INIT
+  {
+  }
+  ~ConstantItem() override = default;
+};
+
+// `static NAME: T = expr;` or `static mut NAME: T = expr;`, a single value in memory whose initializer is computed at
+// compile time, nothing runs at startup
+struct StaticItem final : public Item {
+public:
+  std::string mName;
+  std::unique_ptr<TypeBase> mType;
+  std::unique_ptr<Expr> mExpr;
+  bool mMutable;
+
+  DEFINE_LOC
+public:
+  StaticItem(std::string const& name, std::unique_ptr<TypeBase> type, std::unique_ptr<Expr> expr,
+             bool isMutable LOC_PARAM)
+      : Item(Item::Kind::StaticItem), mName(name), mType(std::move(type)), mExpr(std::move(expr)),
+        mMutable(isMutable) LOC_INIT
+  {
+  }
+  ~StaticItem() override = default;
+};
+
 struct Crate final {
 public:
   std::vector<std::unique_ptr<Item>> mItems;
@@ -153,9 +264,13 @@ public:
   DEFINE_TYPES(WithBlock, WithoutBlock);
   IMPL_AS(Expr)
 
+  std::unique_ptr<TypeBase> mExprType; // filled in by Sema, nullptr before
+
 public:
   Expr(Expr::Type type) : mType(type) {}
   ~Expr() override = default;
+
+  auto getType() const -> TypeBase const* { return mExprType.get(); }
 };
 
 //===----------------------------------------------------------------------===//
@@ -164,7 +279,7 @@ public:
 
 struct ExprWithoutBlock : Expr {
 public:
-  DEFINE_TYPES(Literal, Grouped, Operator, Call, Return);
+  DEFINE_TYPES(Literal, Grouped, Operator, Call, Return, Index, MethodCall, Array, Struct, Field, Tuple);
   IMPL_AS(ExprWithoutBlock);
 
 public:
@@ -192,6 +307,7 @@ public:
 public:
   Kind const mKind;
   ValueType mValue;
+  Item* mItem = nullptr; // the const or static an identifier names, set by Sema
   DEFINE_LOC
 public:
   LiteralExpr(Kind type, ValueType const& value LOC_PARAM)
@@ -225,7 +341,8 @@ public:
 
 struct BinaryExpr final : OperatorExpr {
 public:
-  DEFINE_KINDS(Add, Sub, Mul, Div, Rem, BitAnd, BitOr, BitXor, Shl, Shr, Eq, Ne, Gt, Lt, Ge, Le, Assignment);
+  DEFINE_KINDS(Add, Sub, Mul, Div, Rem, BitAnd, BitOr, BitXor, Shl, Shr, Eq, Ne, Gt, Lt, Ge, Le, LogicalAnd, LogicalOr,
+               Assignment);
 
   DEFINE_LOC
 public:
@@ -245,14 +362,15 @@ public:
 
 struct UnaryExpr final : OperatorExpr {
 public:
-  DEFINE_KINDS(Neg, Not);
+  DEFINE_KINDS(Neg, Not, Ref, RefMut, Deref, Unsize); // Unsize has no syntax, Sema inserts it
 
+  DEFINE_LOC
 public:
   std::unique_ptr<Expr> mRight;
 
 public:
-  UnaryExpr(UnaryExpr::Kind kind, std::unique_ptr<Expr> right)
-      : OperatorExpr(OperatorExpr::Type::Unary), mKind(kind), mRight(std::move(right))
+  UnaryExpr(UnaryExpr::Kind kind, std::unique_ptr<Expr> right LOC_PARAM)
+      : OperatorExpr(OperatorExpr::Type::Unary), mKind(kind), mRight(std::move(right)) LOC_INIT
   {
   }
   ~UnaryExpr() override = default;
@@ -263,8 +381,13 @@ public:
 
 struct CallExpr final : ExprWithoutBlock {
 public:
+  // associated functions of the vector types, `f32x4::splat(x)`
+  enum class Builtin { None, Splat, Load, LoadAligned };
+
   std::string mCallee;
   std::vector<std::unique_ptr<Expr>> mArgs;
+  FunctionItem* mFnItem = nullptr;  // resolved by Sema
+  Builtin mBuiltin = Builtin::None; // resolved by Sema
 
   DEFINE_LOC
 public:
@@ -288,6 +411,129 @@ public:
   ~ReturnExpr() override final = default;
 };
 
+// `[a, b, c]`, or `[value; N]` with a single element repeated N times
+struct ArrayExpr final : ExprWithoutBlock {
+public:
+  std::vector<std::unique_ptr<Expr>> mElems;
+  std::optional<u64> mRepeat;
+
+  DEFINE_LOC
+public:
+  ArrayExpr(std::vector<std::unique_ptr<Expr>>&& elems, std::optional<u64> repeat LOC_PARAM)
+      : ExprWithoutBlock(ExprWithoutBlock::Type::Array), mElems(std::move(elems)), mRepeat(repeat) LOC_INIT
+  {
+  }
+  ~ArrayExpr() override final = default;
+};
+
+// `Name { field: value, ... }`, every field once and in any order, the values are evaluated in source order
+struct StructExpr final : ExprWithoutBlock {
+public:
+  struct FieldInit {
+    std::string mName;
+    std::unique_ptr<Expr> mValue;
+    u32 mIndex = 0; // declaration index of the field, resolved by Sema
+  };
+
+  std::string mName;
+  std::vector<FieldInit> mFields;
+  StructItem const* mItem = nullptr; // resolved by Sema
+
+  DEFINE_LOC
+public:
+  StructExpr(std::string name, std::vector<FieldInit>&& fields LOC_PARAM)
+      : ExprWithoutBlock(ExprWithoutBlock::Type::Struct), mName(std::move(name)), mFields(std::move(fields)) LOC_INIT
+  {
+  }
+  ~StructExpr() override final = default;
+};
+
+// `base.field`, or `base.0` for an element of a tuple
+struct FieldExpr final : ExprWithoutBlock {
+public:
+  std::unique_ptr<Expr> mBase;
+  std::string mField;
+  u32 mIndex = 0; // declaration index of the field or index of the element, resolved by Sema
+
+  DEFINE_LOC
+public:
+  FieldExpr(std::unique_ptr<Expr> base, std::string field LOC_PARAM)
+      : ExprWithoutBlock(ExprWithoutBlock::Type::Field), mBase(std::move(base)), mField(std::move(field)) LOC_INIT
+  {
+  }
+  ~FieldExpr() override final = default;
+};
+
+// `(a, b)` or `(a,)`, and `()` for the unit value
+struct TupleExpr final : ExprWithoutBlock {
+public:
+  std::vector<std::unique_ptr<Expr>> mElems;
+
+  DEFINE_LOC
+public:
+  TupleExpr(std::vector<std::unique_ptr<Expr>>&& elems LOC_PARAM)
+      : ExprWithoutBlock(ExprWithoutBlock::Type::Tuple), mElems(std::move(elems)) LOC_INIT
+  {
+  }
+  ~TupleExpr() override final = default;
+};
+
+// `base[index]`, the base is a slice or an array and the index of any integer type
+struct IndexExpr final : ExprWithoutBlock {
+public:
+  std::unique_ptr<Expr> mBase;
+  std::unique_ptr<Expr> mIndex;
+  bool mChecked = true; // cleared once the index is proven to be in bounds
+
+  DEFINE_LOC
+public:
+  IndexExpr(std::unique_ptr<Expr> base, std::unique_ptr<Expr> index LOC_PARAM)
+      : ExprWithoutBlock(ExprWithoutBlock::Type::Index), mBase(std::move(base)), mIndex(std::move(index)) LOC_INIT
+  {
+  }
+  ~IndexExpr() override final = default;
+};
+
+// `receiver.method(args)`, there are no user defined methods yet, only the builtin ones of slices
+struct MethodCallExpr final : ExprWithoutBlock {
+public:
+  enum class Builtin {
+    Unresolved,
+    Len,
+    GetUnchecked,
+    // vectors
+    Extract,
+    Insert,
+    Shuffle,
+    ReduceAdd,
+    ReduceMul,
+    ReduceMin,
+    ReduceMax,
+    Store,
+    StoreAligned,
+    // masks
+    Select,
+    Any,
+    All,
+  };
+
+  std::unique_ptr<Expr> mReceiver;
+  std::string mMethod;
+  std::vector<std::unique_ptr<Expr>> mArgs;
+  Builtin mBuiltin = Builtin::Unresolved; // resolved by Sema
+  std::vector<u32> mShuffle;              // lanes picked by a shuffle, resolved by Sema
+
+  DEFINE_LOC
+public:
+  MethodCallExpr(std::unique_ptr<Expr> receiver, std::string method,
+                 std::vector<std::unique_ptr<Expr>>&& args LOC_PARAM)
+      : ExprWithoutBlock(ExprWithoutBlock::Type::MethodCall), mReceiver(std::move(receiver)),
+        mMethod(std::move(method)), mArgs(std::move(args)) LOC_INIT
+  {
+  }
+  ~MethodCallExpr() override final = default;
+};
+
 //===----------------------------------------------------------------------===//
 // ExprWithBlock
 //===----------------------------------------------------------------------===//
@@ -336,9 +582,19 @@ public:
 
 struct LoopExpr : ExprWithBlock {
 public:
-  DEFINE_TYPES(InfiniteLoop, PredicateLoop);
+  DEFINE_TYPES(InfiniteLoop, PredicateLoop, IteratorLoop);
   IMPL_AS(LoopExpr);
 
+  // from #[unroll], #[vectorize] and #[interleave], set by Sema. 0 requests the transformation but leaves the count to
+  // the optimizer
+  struct Hints {
+    std::optional<u32> mUnroll;
+    std::optional<u32> mVectorizeWidth;
+    std::optional<u32> mInterleave;
+  };
+  std::vector<Attribute> mAttrs;
+  Hints mHints;
+
 public:
   LoopExpr(Type type) : ExprWithBlock(ExprWithBlock::Type::Loop), mType(type) {}
   ~LoopExpr() override = default;
@@ -349,7 +605,7 @@ public:
   std::unique_ptr<BlockExpr> mExpr;
 
 public:
-  InfiniteLoopExpr(std::unique_ptr<BlockExpr> expr) : LoopExpr(LoopExpr::Type::InfiniteLoop) {}
+  InfiniteLoopExpr(std::unique_ptr<BlockExpr> expr) : LoopExpr(LoopExpr::Type::InfiniteLoop), mExpr(std::move(expr)) {}
   ~InfiniteLoopExpr() override final = default;
 };
 
@@ -367,12 +623,36 @@ public:
   ~PredicateLoopExpr() override final = default;
 };
 
+// `for i in start..end` or `for i in (start..end).step_by(step)`, only integer ranges can be iterated. The range is
+// evaluated once before the loop and `i` is bound anew for every iteration
+struct IteratorLoopExpr final : LoopExpr {
+public:
+  std::string mName;
+  std::unique_ptr<Expr> mStart;
+  std::unique_ptr<Expr> mEnd;
+  std::unique_ptr<Expr> mStep; // null without `step_by`
+  std::unique_ptr<BlockExpr> mExpr;
+
+  DEFINE_LOC
+public:
+  IteratorLoopExpr(std::string name, std::unique_ptr<Expr> start, std::unique_ptr<Expr> end, std::unique_ptr<Expr> step,
+                   std::unique_ptr<BlockExpr> expr LOC_PARAM)
+      : LoopExpr(LoopExpr::Type::IteratorLoop), mName(std::move(name)), mStart(std::move(start)), mEnd(std::move(end)),
+        mStep(std::move(step)), mExpr(std::move(expr)) LOC_INIT
+  {
+  }
+  ~IteratorLoopExpr() override final = default;
+};
+
 struct StmtVisitor {
   virtual void visitStmt(Stmt* stmt);
   virtual void visit(ExprStmt* stmt) = 0;
   virtual void visit(LetStmt* stmt) = 0;
   virtual void visitItem(Item* item);
   virtual void visit(FunctionItem* item) = 0;
+  virtual void visit(StructItem* item) = 0;
+  virtual void visit(ConstantItem* item) = 0;
+  virtual void visit(StaticItem* item) = 0;
 };
 
 struct ExprVisitor {
@@ -391,8 +671,15 @@ struct ExprVisitor {
   virtual void visit(IfExpr* expr) = 0;
   virtual void visit(InfiniteLoopExpr* expr) = 0;
   virtual void visit(PredicateLoopExpr* expr) = 0;
+  virtual void visit(IteratorLoopExpr* expr) = 0;
   virtual void visit(CallExpr* expr) = 0;
   virtual void visit(ReturnExpr* expr) = 0;
+  virtual void visit(IndexExpr* expr) = 0;
+  virtual void visit(MethodCallExpr* expr) = 0;
+  virtual void visit(ArrayExpr* expr) = 0;
+  virtual void visit(StructExpr* expr) = 0;
+  virtual void visit(FieldExpr* expr) = 0;
+  virtual void visit(TupleExpr* expr) = 0;
 };
 
 struct StringifyStmt;
@@ -413,9 +700,16 @@ private:
   void visit(IfExpr* expr) override;
   void visit(InfiniteLoopExpr* expr) override;
   void visit(PredicateLoopExpr* expr) override;
+  void visit(IteratorLoopExpr* expr) override;
 
   void visit(CallExpr* expr) override;
   void visit(ReturnExpr* expr) override;
+  void visit(IndexExpr* expr) override;
+  void visit(MethodCallExpr* expr) override;
+  void visit(ArrayExpr* expr) override;
+  void visit(StructExpr* expr) override;
+  void visit(FieldExpr* expr) override;
+  void visit(TupleExpr* expr) override;
 };
 
 struct StringifyStmt : StmtVisitor {
@@ -428,6 +722,9 @@ private:
   void visit(ExprStmt* stmt) override;
   void visit(LetStmt* stmt) override;
   void visit(FunctionItem* item) override;
+  void visit(StructItem* item) override;
+  void visit(ConstantItem* item) override;
+  void visit(StaticItem* item) override;
 };
 
 #undef DEFINE_TYPES
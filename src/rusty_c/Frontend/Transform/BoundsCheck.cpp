@@ -0,0 +1,431 @@
+#include "BoundsCheck.hpp"
+#include "utils/utils.hpp"
+
+#include <optional>
+#include <utility>
+
+static auto SkipGroups(Expr const* expr) -> Expr const*
+{
+  while (expr != nullptr && expr->mType == Expr::Type::WithoutBlock &&
+         expr->as<ExprWithoutBlock>()->mType == ExprWithoutBlock::Type::Grouped) {
+    expr = expr->as<ExprWithoutBlock>()->as<GroupedExpr>()->mExpr.get();
+  }
+  return expr;
+}
+
+// the local an expression names. Facts are never kept about a static, any call may change it
+static auto AsIdentifier(Expr const* expr) -> std::optional<std::string>
+{
+  expr = SkipGroups(expr);
+  if (expr == nullptr || expr->mType != Expr::Type::WithoutBlock) {
+    return std::nullopt;
+  }
+  auto e = expr->as<ExprWithoutBlock>();
+  if (e->mType != ExprWithoutBlock::Type::Literal || e->as<LiteralExpr>()->mKind != LiteralExpr::Kind::Identifier ||
+      e->as<LiteralExpr>()->mItem != nullptr) {
+    return std::nullopt;
+  }
+  return std::get<std::string>(e->as<LiteralExpr>()->mValue);
+}
+
+static auto AsUnsignedLiteral(Expr const* expr) -> std::optional<u64>
+{
+  expr = SkipGroups(expr);
+  if (expr->mType != Expr::Type::WithoutBlock ||
+      expr->as<ExprWithoutBlock>()->mType != ExprWithoutBlock::Type::Literal) {
+    return std::nullopt;
+  }
+  auto result = std::optional<u64>{};
+  std::visit(
+      [&]<typename T>(T const& v) {
+        if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+          if (v >= 0) {
+            result = static_cast<u64>(v);
+          }
+        }
+      },
+      expr->as<ExprWithoutBlock>()->as<LiteralExpr>()->mValue);
+  return result;
+}
+
+// the slice or array `s` of `s.len()`
+static auto AsLengthOf(Expr const* expr) -> std::optional<std::string>
+{
+  expr = SkipGroups(expr);
+  if (expr == nullptr || expr->mType != Expr::Type::WithoutBlock ||
+      expr->as<ExprWithoutBlock>()->mType != ExprWithoutBlock::Type::MethodCall) {
+    return std::nullopt;
+  }
+  auto call = expr->as<ExprWithoutBlock>()->as<MethodCallExpr>();
+  if (call->mBuiltin != MethodCallExpr::Builtin::Len) {
+    return std::nullopt;
+  }
+  return AsIdentifier(call->mReceiver.get());
+}
+
+static auto CollectAssigned(Expr const* expr, std::unordered_set<std::string>& names) -> void;
+
+static auto CollectAssigned(BlockExpr const* block, std::unordered_set<std::string>& names) -> void
+{
+  for (auto& stmt : block->mStmts) {
+    CollectAssigned(stmt->mType == Stmt::Type::Let ? stmt->as<LetStmt>()->mExpr.get()
+                                                   : stmt->as<ExprStmt>()->mExpr.get(),
+                    names);
+  }
+  CollectAssigned(block->mReturn.get(), names);
+}
+
+// locals that may be assigned while evaluating `expr`, nested function items have their own locals
+static auto CollectAssigned(Expr const* expr, std::unordered_set<std::string>& names) -> void
+{
+  if (expr == nullptr) {
+    return;
+  }
+  if (expr->mType == Expr::Type::WithBlock) {
+    auto e = expr->as<ExprWithBlock>();
+    switch (e->mType) {
+    case ExprWithBlock::Type::Block:
+      return CollectAssigned(e->as<BlockExpr>(), names);
+    case ExprWithBlock::Type::If: {
+      auto ifExpr = e->as<IfExpr>();
+      CollectAssigned(ifExpr->mCond.get(), names);
+      CollectAssigned(ifExpr->mThen.get(), names);
+      return CollectAssigned(ifExpr->mElse.get(), names);
+    }
+    case ExprWithBlock::Type::Loop:
+      if (auto loop = e->as<LoopExpr>(); loop->mType == LoopExpr::Type::PredicateLoop) {
+        CollectAssigned(loop->as<PredicateLoopExpr>()->mCond.get(), names);
+        return CollectAssigned(loop->as<PredicateLoopExpr>()->mExpr.get(), names);
+      } else if (loop->mType == LoopExpr::Type::IteratorLoop) {
+        auto forLoop = loop->as<IteratorLoopExpr>();
+        CollectAssigned(forLoop->mStart.get(), names);
+        CollectAssigned(forLoop->mEnd.get(), names);
+        CollectAssigned(forLoop->mStep.get(), names);
+        return CollectAssigned(forLoop->mExpr.get(), names);
+      } else {
+        return CollectAssigned(loop->as<InfiniteLoopExpr>()->mExpr.get(), names);
+      }
+    case ExprWithBlock::Type::IfLet:
+    case ExprWithBlock::Type::Match:
+      utils::Unimplemented(utils::SrcLoc::current());
+    }
+    utils::Unreachable(utils::SrcLoc::current());
+  }
+
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    return;
+  case ExprWithoutBlock::Type::Grouped:
+    return CollectAssigned(e->as<GroupedExpr>()->mExpr.get(), names);
+  case ExprWithoutBlock::Type::Operator:
+    if (auto op = e->as<OperatorExpr>(); op->mType == OperatorExpr::Type::Binary) {
+      auto bin = op->as<BinaryExpr>();
+      if (auto name = AsIdentifier(bin->mLeft.get()); name && bin->mKind == BinaryExpr::Kind::Assignment) {
+        names.insert(*name);
+      }
+      CollectAssigned(bin->mLeft.get(), names);
+      return CollectAssigned(bin->mRight.get(), names);
+    } else {
+      // a mutable borrow may be written through at any later point
+      if (auto unary = op->as<UnaryExpr>(); unary->mKind == UnaryExpr::Kind::RefMut) {
+        if (auto name = AsIdentifier(unary->mRight.get())) {
+          names.insert(*name);
+        }
+      }
+      return CollectAssigned(op->as<UnaryExpr>()->mRight.get(), names);
+    }
+  case ExprWithoutBlock::Type::Call:
+    for (auto& arg : e->as<CallExpr>()->mArgs) {
+      CollectAssigned(arg.get(), names);
+    }
+    return;
+  case ExprWithoutBlock::Type::Return:
+    return CollectAssigned(e->as<ReturnExpr>()->mExpr.get(), names);
+  case ExprWithoutBlock::Type::Index:
+    CollectAssigned(e->as<IndexExpr>()->mBase.get(), names);
+    return CollectAssigned(e->as<IndexExpr>()->mIndex.get(), names);
+  case ExprWithoutBlock::Type::MethodCall:
+    CollectAssigned(e->as<MethodCallExpr>()->mReceiver.get(), names);
+    for (auto& arg : e->as<MethodCallExpr>()->mArgs) {
+      CollectAssigned(arg.get(), names);
+    }
+    return;
+  case ExprWithoutBlock::Type::Array:
+    for (auto& elem : e->as<ArrayExpr>()->mElems) {
+      CollectAssigned(elem.get(), names);
+    }
+    return;
+  case ExprWithoutBlock::Type::Struct:
+    for (auto& init : e->as<StructExpr>()->mFields) {
+      CollectAssigned(init.mValue.get(), names);
+    }
+    return;
+  case ExprWithoutBlock::Type::Field:
+    return CollectAssigned(e->as<FieldExpr>()->mBase.get(), names);
+  case ExprWithoutBlock::Type::Tuple:
+    for (auto& elem : e->as<TupleExpr>()->mElems) {
+      CollectAssigned(elem.get(), names);
+    }
+    return;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+auto BoundsCheckEliminator::Facts::forget(std::string const& name) -> void
+{
+  std::erase_if(mInBounds, [&](auto const& fact) { return fact.first == name || fact.second == name; });
+  std::erase_if(mLengths, [&](auto const& length) { return length.first == name || length.second == name; });
+}
+
+auto BoundsCheckEliminator::Facts::forget(std::unordered_set<std::string> const& names) -> void
+{
+  for (auto const& name : names) {
+    forget(name);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Traversal
+//===----------------------------------------------------------------------===//
+
+auto BoundsCheckEliminator::eliminateCrate(Crate* crate) -> void
+{
+  for (auto& item : crate->mItems) {
+    eliminateItem(item.get());
+  }
+}
+
+auto BoundsCheckEliminator::eliminateItem(Item* item) -> void
+{
+  if (item->mKind == Item::Kind::Function) {
+    if (auto fn = item->as<FunctionItem>(); !fn->isDeclaration()) {
+      auto escaped = std::exchange(mEscaped, {});
+      visitBlockExpr(fn->mBody.get(), Facts{});
+      mEscaped = std::move(escaped);
+    }
+  }
+}
+
+// what is learned inside the block goes out of scope with it, only what was forgotten stays forgotten
+auto BoundsCheckEliminator::visitBlockExpr(BlockExpr* expr, Facts facts) -> void
+{
+  for (auto& item : expr->mItems) {
+    eliminateItem(item.get());
+  }
+  for (auto& stmt : expr->mStmts) {
+    if (stmt->mType == Stmt::Type::Expression) {
+      visitExpr(stmt->as<ExprStmt>()->mExpr.get(), facts);
+      continue;
+    }
+    auto let = stmt->as<LetStmt>();
+    visitExpr(let->mExpr.get(), facts);
+    for (auto const& name : let->boundNames()) {
+      facts.forget(name);
+    }
+    if (auto slice = AsLengthOf(let->mExpr.get());
+        slice && !let->mPattern && *slice != let->mName && !mEscaped.contains(let->mName)) {
+      facts.mLengths[let->mName] = *slice;
+    }
+  }
+  visitExpr(expr->mReturn.get(), facts);
+}
+
+auto BoundsCheckEliminator::visitExpr(Expr* expr, Facts& facts) -> void
+{
+  if (expr == nullptr) {
+    return;
+  }
+
+  if (expr->mType == Expr::Type::WithBlock) {
+    auto e = expr->as<ExprWithBlock>();
+    auto assigned = std::unordered_set<std::string>{};
+    CollectAssigned(e, assigned);
+    switch (e->mType) {
+    case ExprWithBlock::Type::Block:
+      visitBlockExpr(e->as<BlockExpr>(), facts);
+      break;
+    case ExprWithBlock::Type::If: {
+      auto ifExpr = e->as<IfExpr>();
+      visitExpr(ifExpr->mCond.get(), facts);
+      auto thenFacts = facts;
+      learnCondition(ifExpr->mCond.get(), thenFacts);
+      visitBlockExpr(ifExpr->mThen.get(), thenFacts);
+      if (ifExpr->mElse) {
+        auto elseFacts = facts;
+        visitExpr(ifExpr->mElse.get(), elseFacts);
+      }
+    } break;
+    case ExprWithBlock::Type::Loop: {
+      // the loop may come back around after any assignment in it
+      auto loopFacts = facts;
+      loopFacts.forget(assigned);
+      if (auto loop = e->as<LoopExpr>(); loop->mType == LoopExpr::Type::PredicateLoop) {
+        auto whileLoop = loop->as<PredicateLoopExpr>();
+        visitExpr(whileLoop->mCond.get(), loopFacts);
+        learnCondition(whileLoop->mCond.get(), loopFacts);
+        visitBlockExpr(whileLoop->mExpr.get(), loopFacts);
+      } else if (loop->mType == LoopExpr::Type::IteratorLoop) {
+        auto forLoop = loop->as<IteratorLoopExpr>();
+        visitExpr(forLoop->mStart.get(), loopFacts);
+        visitExpr(forLoop->mEnd.get(), loopFacts);
+        visitExpr(forLoop->mStep.get(), loopFacts);
+        loopFacts.forget(forLoop->mName);
+        // the end is evaluated once, it only bounds the index as long as the slice it was taken of stays the same
+        auto slice = lengthOf(forLoop->mEnd.get(), loopFacts);
+        if (slice && !assigned.contains(forLoop->mName) && !assigned.contains(*slice) &&
+            !mEscaped.contains(forLoop->mName) && !mEscaped.contains(*slice)) {
+          loopFacts.mInBounds.emplace(forLoop->mName, *slice);
+        }
+        visitBlockExpr(forLoop->mExpr.get(), loopFacts);
+      } else {
+        visitBlockExpr(loop->as<InfiniteLoopExpr>()->mExpr.get(), loopFacts);
+      }
+    } break;
+    case ExprWithBlock::Type::IfLet:
+    case ExprWithBlock::Type::Match:
+      utils::Unimplemented(utils::SrcLoc::current());
+    }
+    facts.forget(assigned);
+    return;
+  }
+
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    return;
+  case ExprWithoutBlock::Type::Grouped:
+    return visitExpr(e->as<GroupedExpr>()->mExpr.get(), facts);
+  case ExprWithoutBlock::Type::Operator:
+    if (auto op = e->as<OperatorExpr>(); op->mType == OperatorExpr::Type::Binary) {
+      auto bin = op->as<BinaryExpr>();
+      // the right hand side of an assignment is evaluated first
+      if (bin->mKind == BinaryExpr::Kind::Assignment) {
+        visitExpr(bin->mRight.get(), facts);
+        visitExpr(bin->mLeft.get(), facts);
+        if (auto name = AsIdentifier(bin->mLeft.get())) {
+          facts.forget(*name);
+        }
+        return;
+      }
+      visitExpr(bin->mLeft.get(), facts);
+      if (bin->mKind == BinaryExpr::Kind::LogicalAnd) {
+        // the right hand side only runs once the left one held, whatever it assigns may or may not have happened
+        auto rightFacts = facts;
+        learnCondition(bin->mLeft.get(), rightFacts);
+        visitExpr(bin->mRight.get(), rightFacts);
+        auto assigned = std::unordered_set<std::string>{};
+        CollectAssigned(bin->mRight.get(), assigned);
+        return facts.forget(assigned);
+      }
+      return visitExpr(bin->mRight.get(), facts);
+    } else {
+      // nothing is learned about a local any more once a pointer to it may be written through
+      if (auto unary = op->as<UnaryExpr>(); unary->mKind == UnaryExpr::Kind::RefMut) {
+        if (auto name = AsIdentifier(unary->mRight.get())) {
+          mEscaped.insert(*name);
+          facts.forget(*name);
+        }
+      }
+      return visitExpr(op->as<UnaryExpr>()->mRight.get(), facts);
+    }
+  case ExprWithoutBlock::Type::Call:
+    for (auto& arg : e->as<CallExpr>()->mArgs) {
+      visitExpr(arg.get(), facts);
+    }
+    return;
+  case ExprWithoutBlock::Type::Return:
+    return visitExpr(e->as<ReturnExpr>()->mExpr.get(), facts);
+  case ExprWithoutBlock::Type::Index:
+    return visitIndexExpr(e->as<IndexExpr>(), facts);
+  case ExprWithoutBlock::Type::MethodCall:
+    visitExpr(e->as<MethodCallExpr>()->mReceiver.get(), facts);
+    for (auto& arg : e->as<MethodCallExpr>()->mArgs) {
+      visitExpr(arg.get(), facts);
+    }
+    return;
+  case ExprWithoutBlock::Type::Array:
+    for (auto& elem : e->as<ArrayExpr>()->mElems) {
+      visitExpr(elem.get(), facts);
+    }
+    return;
+  case ExprWithoutBlock::Type::Struct:
+    for (auto& init : e->as<StructExpr>()->mFields) {
+      visitExpr(init.mValue.get(), facts);
+    }
+    return;
+  case ExprWithoutBlock::Type::Field:
+    return visitExpr(e->as<FieldExpr>()->mBase.get(), facts);
+  case ExprWithoutBlock::Type::Tuple:
+    for (auto& elem : e->as<TupleExpr>()->mElems) {
+      visitExpr(elem.get(), facts);
+    }
+    return;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+auto BoundsCheckEliminator::visitIndexExpr(IndexExpr* expr, Facts& facts) -> void
+{
+  visitExpr(expr->mBase.get(), facts);
+  visitExpr(expr->mIndex.get(), facts);
+  if (!expr->mChecked) {
+    return;
+  }
+  ++mStats.mChecks;
+  auto slice = AsIdentifier(expr->mBase.get());
+  auto index = AsIdentifier(expr->mIndex.get());
+  if (slice && index && facts.mInBounds.contains({*index, *slice})) {
+    expr->mChecked = false;
+    ++mStats.mEliminated;
+    return;
+  }
+  // an index into an array that only became constant by folding
+  if (auto array = expr->mBase->getType(); array != nullptr && array->mKind == TypeBase::Kind::Array) {
+    if (auto constant = AsUnsignedLiteral(expr->mIndex.get()); constant && *constant < array->as<ArrayType>()->mLen) {
+      expr->mChecked = false;
+      ++mStats.mEliminated;
+    }
+  }
+}
+
+// `i < s.len()`, `s.len() > i` and the same with a local holding the length. Both sides are `u64`, so `i` cannot
+// be negative either
+auto BoundsCheckEliminator::learnCondition(Expr const* cond, Facts& facts) const -> void
+{
+  cond = SkipGroups(cond);
+  if (cond->mType != Expr::Type::WithoutBlock ||
+      cond->as<ExprWithoutBlock>()->mType != ExprWithoutBlock::Type::Operator ||
+      cond->as<ExprWithoutBlock>()->as<OperatorExpr>()->mType != OperatorExpr::Type::Binary) {
+    return;
+  }
+  auto bin = cond->as<ExprWithoutBlock>()->as<OperatorExpr>()->as<BinaryExpr>();
+  if (bin->mKind == BinaryExpr::Kind::LogicalAnd) {
+    learnCondition(bin->mLeft.get(), facts);
+    return learnCondition(bin->mRight.get(), facts);
+  }
+  auto [lower, upper] = std::pair{bin->mLeft.get(), bin->mRight.get()};
+  if (bin->mKind == BinaryExpr::Kind::Gt) {
+    std::swap(lower, upper);
+  } else if (bin->mKind != BinaryExpr::Kind::Lt) {
+    return;
+  }
+
+  auto index = AsIdentifier(lower);
+  auto slice = lengthOf(upper, facts);
+  if (index && slice && !mEscaped.contains(*index) && !mEscaped.contains(*slice)) {
+    facts.mInBounds.emplace(*index, *slice);
+  }
+}
+
+// the slice or array `s` of `s.len()` or of a local holding it
+auto BoundsCheckEliminator::lengthOf(Expr const* expr, Facts const& facts) const -> std::optional<std::string>
+{
+  if (auto slice = AsLengthOf(expr)) {
+    return slice;
+  }
+  if (auto length = AsIdentifier(expr); length && facts.mLengths.contains(*length)) {
+    return facts.mLengths.at(*length);
+  }
+  return std::nullopt;
+}
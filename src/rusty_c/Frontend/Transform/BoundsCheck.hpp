@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Frontend/Syntax.hpp"
+
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+struct BoundsCheckStats {
+  u32 mChecks = 0;     // slice and array indexing expressions
+  u32 mEliminated = 0; // of those, proven to be in bounds
+};
+
+// Clears the bounds check of `s[i]` where `i < s.len()` is known to hold: inside `while i < s.len()`, `if i < s.len()`
+// and `for i in a..s.len()`, or right of `i < s.len() &&`, until `i` or `s` is assigned. The length may also come from
+// a `let n = s.len()` that was not reassigned. Locals are tracked by name, shadowing one forgets everything known about
+// it, and nothing is known about one borrowed as mutable. Arrays indexed by a folded constant within their length need
+// no check either. Runs on the typed AST after the simplifier.
+class BoundsCheckEliminator {
+  struct Facts {
+    std::set<std::pair<std::string, std::string>> mInBounds; // (index, slice or array)
+    std::unordered_map<std::string, std::string> mLengths;   // local holding the length of one
+
+    auto forget(std::string const& name) -> void;
+    auto forget(std::unordered_set<std::string> const& names) -> void;
+  };
+
+  BoundsCheckStats mStats;
+  std::unordered_set<std::string> mEscaped; // locals of the current function borrowed as mutable so far
+
+public:
+  BoundsCheckEliminator() = default;
+
+  auto eliminateCrate(Crate* crate) -> void;
+  auto eliminateItem(Item* item) -> void;
+  auto stats() const -> BoundsCheckStats const& { return mStats; }
+
+private:
+  auto visitBlockExpr(BlockExpr* expr, Facts facts) -> void;
+  auto visitExpr(Expr* expr, Facts& facts) -> void;
+  auto visitIndexExpr(IndexExpr* expr, Facts& facts) -> void;
+  auto learnCondition(Expr const* cond, Facts& facts) const -> void;
+  auto lengthOf(Expr const* expr, Facts const& facts) const -> std::optional<std::string>;
+};
@@ -0,0 +1,281 @@
+#include "Reachability.hpp"
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <utility>
+
+auto ReachabilityAnalysis::analyze(Crate const* crate, std::vector<std::string> const& exported) -> void
+{
+  mCallees.clear();
+  mReachable.clear();
+  mRoots.clear();
+
+  mScopes.emplace_back();
+  declareItems(crate->mItems);
+  for (auto& item : crate->mItems) {
+    visitItem(item.get());
+  }
+
+  auto& global = mScopes.back();
+  if (auto it = global.find("main"); it != global.end()) {
+    mRoots.push_back(it->second);
+  } else {
+    for (auto& item : crate->mItems) {
+      if (item->mKind == Item::Kind::Function) {
+        mRoots.push_back(item->as<FunctionItem>());
+      }
+    }
+  }
+  for (auto& name : exported) {
+    if (auto it = global.find(name); it != global.end()) {
+      mRoots.push_back(it->second);
+    }
+  }
+  mScopes.pop_back();
+
+  auto worklist = mRoots;
+  while (!worklist.empty()) {
+    auto fn = worklist.back();
+    worklist.pop_back();
+    if (!mReachable.insert(fn).second) {
+      continue;
+    }
+    if (auto it = mCallees.find(fn); it != mCallees.end()) {
+      worklist.insert(worklist.end(), it->second.begin(), it->second.end());
+    }
+  }
+}
+
+auto ReachabilityAnalysis::declareItems(std::vector<std::unique_ptr<Item>> const& items) -> void
+{
+  auto& scope = mScopes.back();
+  for (auto& item : items) {
+    if (item->mKind == Item::Kind::Function) {
+      auto fn = item->as<FunctionItem>();
+      scope.try_emplace(fn->mName, fn);
+    } else if (item->mKind == Item::Kind::ExternBlock) {
+      for (auto& fn : item->as<ExternalBlockItem>()->mItems) {
+        scope.try_emplace(fn->mName, fn.get());
+      }
+    }
+  }
+}
+
+auto ReachabilityAnalysis::resolve(std::string const& name) const -> FunctionItem const*
+{
+  for (auto it = mScopes.rbegin(); it != mScopes.rend(); ++it) {
+    if (auto found = it->find(name); found != it->end()) {
+      return found->second;
+    }
+  }
+  return nullptr;
+}
+
+auto ReachabilityAnalysis::visitItem(Item const* item) -> void
+{
+  if (item->mKind == Item::Kind::ConstantItem) {
+    return visitExpr(item->as<ConstantItem>()->mExpr.get());
+  } else if (item->mKind == Item::Kind::StaticItem) {
+    return visitExpr(item->as<StaticItem>()->mExpr.get());
+  } else if (item->mKind != Item::Kind::Function) {
+    return;
+  }
+  auto fn = item->as<FunctionItem>();
+  if (fn->isDeclaration()) {
+    return;
+  }
+  auto outer = std::exchange(mCurrentFn, fn);
+  mCallees[fn]; // functions without calls still get a node
+  visitBlockExpr(fn->mBody.get());
+  mCurrentFn = outer;
+}
+
+auto ReachabilityAnalysis::visitStmt(Stmt const* stmt) -> void
+{
+  switch (stmt->mType) {
+  case Stmt::Type::Let:
+    return visitExpr(stmt->as<LetStmt>()->mExpr.get());
+  case Stmt::Type::Expression:
+    return visitExpr(stmt->as<ExprStmt>()->mExpr.get());
+  default:
+    utils::Unimplemented(utils::SrcLoc::current());
+  }
+}
+
+auto ReachabilityAnalysis::visitBlockExpr(BlockExpr const* expr) -> void
+{
+  mScopes.emplace_back();
+  declareItems(expr->mItems);
+  for (auto& item : expr->mItems) {
+    visitItem(item.get());
+  }
+  for (auto& stmt : expr->mStmts) {
+    visitStmt(stmt.get());
+  }
+  visitExpr(expr->mReturn.get());
+  mScopes.pop_back();
+}
+
+auto ReachabilityAnalysis::visitExpr(Expr const* expr) -> void
+{
+  if (expr == nullptr) {
+    return;
+  }
+
+  if (expr->mType == Expr::Type::WithBlock) {
+    auto e = expr->as<ExprWithBlock>();
+    switch (e->mType) {
+    case ExprWithBlock::Type::Block:
+      return visitBlockExpr(e->as<BlockExpr>());
+    case ExprWithBlock::Type::If: {
+      auto ifExpr = e->as<IfExpr>();
+      visitExpr(ifExpr->mCond.get());
+      visitBlockExpr(ifExpr->mThen.get());
+      return visitExpr(ifExpr->mElse.get());
+    }
+    case ExprWithBlock::Type::Loop:
+      if (auto loop = e->as<LoopExpr>(); loop->mType == LoopExpr::Type::PredicateLoop) {
+        visitExpr(loop->as<PredicateLoopExpr>()->mCond.get());
+        return visitBlockExpr(loop->as<PredicateLoopExpr>()->mExpr.get());
+      } else if (loop->mType == LoopExpr::Type::IteratorLoop) {
+        auto forLoop = loop->as<IteratorLoopExpr>();
+        visitExpr(forLoop->mStart.get());
+        visitExpr(forLoop->mEnd.get());
+        visitExpr(forLoop->mStep.get());
+        return visitBlockExpr(forLoop->mExpr.get());
+      } else {
+        return visitBlockExpr(loop->as<InfiniteLoopExpr>()->mExpr.get());
+      }
+    case ExprWithBlock::Type::IfLet:
+    case ExprWithBlock::Type::Match:
+      utils::Unimplemented(utils::SrcLoc::current());
+    }
+    utils::Unreachable(utils::SrcLoc::current());
+  }
+
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    return;
+  case ExprWithoutBlock::Type::Grouped:
+    return visitExpr(e->as<GroupedExpr>()->mExpr.get());
+  case ExprWithoutBlock::Type::Operator:
+    if (auto op = e->as<OperatorExpr>(); op->mType == OperatorExpr::Type::Binary) {
+      visitExpr(op->as<BinaryExpr>()->mLeft.get());
+      return visitExpr(op->as<BinaryExpr>()->mRight.get());
+    } else {
+      return visitExpr(op->as<UnaryExpr>()->mRight.get());
+    }
+  case ExprWithoutBlock::Type::Call: {
+    auto call = e->as<CallExpr>();
+    if (auto callee = resolve(call->mCallee); callee != nullptr) {
+      if (mCurrentFn != nullptr) {
+        mCallees[mCurrentFn].push_back(callee);
+      } else {
+        mRoots.push_back(callee); // called by the initializer of a const or static
+      }
+    }
+    for (auto& arg : call->mArgs) {
+      visitExpr(arg.get());
+    }
+    return;
+  }
+  case ExprWithoutBlock::Type::Return:
+    return visitExpr(e->as<ReturnExpr>()->mExpr.get());
+  case ExprWithoutBlock::Type::Index:
+    visitExpr(e->as<IndexExpr>()->mBase.get());
+    return visitExpr(e->as<IndexExpr>()->mIndex.get());
+  case ExprWithoutBlock::Type::MethodCall:
+    visitExpr(e->as<MethodCallExpr>()->mReceiver.get());
+    for (auto& arg : e->as<MethodCallExpr>()->mArgs) {
+      visitExpr(arg.get());
+    }
+    return;
+  case ExprWithoutBlock::Type::Array:
+    for (auto& elem : e->as<ArrayExpr>()->mElems) {
+      visitExpr(elem.get());
+    }
+    return;
+  case ExprWithoutBlock::Type::Struct:
+    for (auto& init : e->as<StructExpr>()->mFields) {
+      visitExpr(init.mValue.get());
+    }
+    return;
+  case ExprWithoutBlock::Type::Field:
+    return visitExpr(e->as<FieldExpr>()->mBase.get());
+  case ExprWithoutBlock::Type::Tuple:
+    for (auto& elem : e->as<TupleExpr>()->mElems) {
+      visitExpr(elem.get());
+    }
+    return;
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+//===----------------------------------------------------------------------===//
+// Pruning
+//===----------------------------------------------------------------------===//
+
+auto ReachabilityAnalysis::prune(Crate* crate) -> u32 { return pruneItems(crate->mItems); }
+
+auto ReachabilityAnalysis::pruneItems(std::vector<std::unique_ptr<Item>>& items) -> u32
+{
+  u32 count = 0;
+  for (auto& item : items) {
+    if (item->mKind == Item::Kind::Function) {
+      auto fn = item->as<FunctionItem>();
+      if (!isReachable(fn)) {
+        ++count;
+        item = nullptr;
+      } else if (!fn->isDeclaration()) {
+        count += pruneBlockExpr(fn->mBody.get());
+      }
+    } else if (item->mKind == Item::Kind::ExternBlock) {
+      // only the declarations that are actually called get emitted
+      auto& fns = item->as<ExternalBlockItem>()->mItems;
+      count += std::erase_if(fns, [&](auto& fn) { return !isReachable(fn.get()); });
+      if (fns.empty()) {
+        item = nullptr;
+      }
+    }
+  }
+  std::erase(items, nullptr);
+  return count;
+}
+
+auto ReachabilityAnalysis::pruneBlockExpr(BlockExpr* expr) -> u32
+{
+  auto count = pruneItems(expr->mItems);
+  for (auto& stmt : expr->mStmts) {
+    count += pruneExpr(stmt->mType == Stmt::Type::Let ? stmt->as<LetStmt>()->mExpr.get()
+                                                      : stmt->as<ExprStmt>()->mExpr.get());
+  }
+  return count + pruneExpr(expr->mReturn.get());
+}
+
+// items may only be declared in blocks, so only expressions with a block are of interest
+auto ReachabilityAnalysis::pruneExpr(Expr* expr) -> u32
+{
+  if (expr == nullptr || expr->mType != Expr::Type::WithBlock) {
+    return 0;
+  }
+  auto e = expr->as<ExprWithBlock>();
+  switch (e->mType) {
+  case ExprWithBlock::Type::Block:
+    return pruneBlockExpr(e->as<BlockExpr>());
+  case ExprWithBlock::Type::If: {
+    auto ifExpr = e->as<IfExpr>();
+    return pruneBlockExpr(ifExpr->mThen.get()) + pruneExpr(ifExpr->mElse.get());
+  }
+  case ExprWithBlock::Type::Loop:
+    if (auto loop = e->as<LoopExpr>(); loop->mType == LoopExpr::Type::PredicateLoop) {
+      return pruneBlockExpr(loop->as<PredicateLoopExpr>()->mExpr.get());
+    } else if (loop->mType == LoopExpr::Type::IteratorLoop) {
+      return pruneBlockExpr(loop->as<IteratorLoopExpr>()->mExpr.get());
+    } else {
+      return pruneBlockExpr(loop->as<InfiniteLoopExpr>()->mExpr.get());
+    }
+  default:
+    return 0;
+  }
+}
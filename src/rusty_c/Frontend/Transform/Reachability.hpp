@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Frontend/Syntax.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+// Call graph reachability over function items, including items nested in blocks and declarations in extern blocks.
+// Callees are resolved lexically, so it works on the untyped AST as well and may run before Sema. Functions called by
+// the initializer of a const or static are roots too.
+class ReachabilityAnalysis {
+  std::unordered_map<FunctionItem const*, std::vector<FunctionItem const*>> mCallees;
+  std::unordered_set<FunctionItem const*> mReachable;
+  std::vector<FunctionItem const*> mRoots;
+
+  std::vector<std::unordered_map<std::string, FunctionItem const*>> mScopes;
+  FunctionItem const* mCurrentFn = nullptr;
+
+public:
+  ReachabilityAnalysis() = default;
+
+  // roots are `main` and the functions named in `exported`, every top-level function if the crate has no `main`
+  auto analyze(Crate const* crate, std::vector<std::string> const& exported = {}) -> void;
+  // removes every unreachable function item, returns how many were removed
+  auto prune(Crate* crate) -> u32;
+
+  auto isReachable(FunctionItem const* fn) const -> bool { return mReachable.contains(fn); }
+  auto numReachable() const -> size_t { return mReachable.size(); }
+
+private:
+  auto declareItems(std::vector<std::unique_ptr<Item>> const& items) -> void;
+  auto resolve(std::string const& name) const -> FunctionItem const*;
+
+  auto visitItem(Item const* item) -> void;
+  auto visitStmt(Stmt const* stmt) -> void;
+  auto visitExpr(Expr const* expr) -> void;
+  auto visitBlockExpr(BlockExpr const* expr) -> void;
+
+  auto pruneItems(std::vector<std::unique_ptr<Item>>& items) -> u32;
+  auto pruneBlockExpr(BlockExpr* expr) -> u32;
+  auto pruneExpr(Expr* expr) -> u32;
+};
@@ -0,0 +1,482 @@
+#include "Simplify.hpp"
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <optional>
+
+static auto MakeEmptyBlock() -> std::unique_ptr<BlockExpr>
+{
+  auto block = std::make_unique<BlockExpr>(std::vector<std::unique_ptr<Stmt>>{}, std::vector<std::unique_ptr<Item>>{},
+                                           nullptr);
+  block->mExprType = std::make_unique<TupleType>();
+  return block;
+}
+
+static auto AsBoolLiteral(Expr const* expr) -> std::optional<bool>
+{
+  if (expr->mType != Expr::Type::WithoutBlock) {
+    return std::nullopt;
+  }
+  auto e = expr->as<ExprWithoutBlock>();
+  if (e->mType != ExprWithoutBlock::Type::Literal || e->as<LiteralExpr>()->mKind != LiteralExpr::Kind::Bool) {
+    return std::nullopt;
+  }
+  return std::get<bool>(e->as<LiteralExpr>()->mValue);
+}
+
+// the value of an integer literal, widened so that literals of one type compare like their type does
+static auto AsIntegerLiteral(Expr const* expr) -> std::optional<std::variant<i64, u64>>
+{
+  if (expr->mType != Expr::Type::WithoutBlock) {
+    return std::nullopt;
+  }
+  auto e = expr->as<ExprWithoutBlock>();
+  if (e->mType != ExprWithoutBlock::Type::Literal) {
+    return std::nullopt;
+  }
+  return std::visit(
+      []<typename T>(T const& v) -> std::optional<std::variant<i64, u64>> {
+        if constexpr (!std::is_integral_v<T> || std::is_same_v<T, bool>) {
+          return std::nullopt;
+        } else if constexpr (std::is_signed_v<T>) {
+          return static_cast<i64>(v);
+        } else {
+          return static_cast<u64>(v);
+        }
+      },
+      e->as<LiteralExpr>()->mValue);
+}
+
+static auto IsNever(Expr const* expr) -> bool
+{
+  return expr != nullptr && expr->getType() != nullptr && expr->getType()->mKind == TypeBase::Kind::Never;
+}
+
+auto IsEmptyBlock(Expr const* expr) -> bool
+{
+  if (expr->mType != Expr::Type::WithBlock || expr->as<ExprWithBlock>()->mType != ExprWithBlock::Type::Block) {
+    return false;
+  }
+  auto block = expr->as<ExprWithBlock>()->as<BlockExpr>();
+  return block->mItems.empty() && block->mReturn == nullptr &&
+         std::all_of(block->mStmts.begin(), block->mStmts.end(), [](auto& stmt) { return stmt == nullptr; });
+}
+
+//===----------------------------------------------------------------------===//
+// Queries
+//===----------------------------------------------------------------------===//
+
+static auto BlockHasSideEffects(BlockExpr const* block) -> bool;
+
+// calls of non-const functions, assignments, returns and loops (which may not terminate) are side effects
+auto HasSideEffects(Expr const* expr) -> bool
+{
+  if (expr == nullptr) {
+    return false;
+  }
+  if (expr->mType == Expr::Type::WithBlock) {
+    auto e = expr->as<ExprWithBlock>();
+    switch (e->mType) {
+    case ExprWithBlock::Type::Block:
+      return BlockHasSideEffects(e->as<BlockExpr>());
+    case ExprWithBlock::Type::If: {
+      auto ifExpr = e->as<IfExpr>();
+      return HasSideEffects(ifExpr->mCond.get()) || BlockHasSideEffects(ifExpr->mThen.get()) ||
+             HasSideEffects(ifExpr->mElse.get());
+    }
+    default:
+      return true;
+    }
+  }
+
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    return false;
+  case ExprWithoutBlock::Type::Grouped:
+    return HasSideEffects(e->as<GroupedExpr>()->mExpr.get());
+  case ExprWithoutBlock::Type::Operator:
+    if (auto op = e->as<OperatorExpr>(); op->mType == OperatorExpr::Type::Binary) {
+      auto bin = op->as<BinaryExpr>();
+      return bin->mKind == BinaryExpr::Kind::Assignment || HasSideEffects(bin->mLeft.get()) ||
+             HasSideEffects(bin->mRight.get());
+    } else {
+      return HasSideEffects(op->as<UnaryExpr>()->mRight.get());
+    }
+  case ExprWithoutBlock::Type::Call: {
+    auto call = e->as<CallExpr>();
+    if (call->mFnItem == nullptr || !call->mFnItem->mIsConst) {
+      return true;
+    }
+    return std::any_of(call->mArgs.begin(), call->mArgs.end(), [](auto& arg) { return HasSideEffects(arg.get()); });
+  }
+  case ExprWithoutBlock::Type::Return:
+    return true;
+  case ExprWithoutBlock::Type::Index: { // a failed bounds check traps
+    auto index = e->as<IndexExpr>();
+    return index->mChecked || HasSideEffects(index->mBase.get()) || HasSideEffects(index->mIndex.get());
+  }
+  case ExprWithoutBlock::Type::MethodCall: {
+    auto call = e->as<MethodCallExpr>();
+    auto stores =
+        call->mBuiltin == MethodCallExpr::Builtin::Store || call->mBuiltin == MethodCallExpr::Builtin::StoreAligned;
+    return stores || HasSideEffects(call->mReceiver.get()) ||
+           std::any_of(call->mArgs.begin(), call->mArgs.end(), [](auto& arg) { return HasSideEffects(arg.get()); });
+  }
+  case ExprWithoutBlock::Type::Array: {
+    auto& elems = e->as<ArrayExpr>()->mElems;
+    return std::any_of(elems.begin(), elems.end(), [](auto& elem) { return HasSideEffects(elem.get()); });
+  }
+  case ExprWithoutBlock::Type::Struct: {
+    auto& fields = e->as<StructExpr>()->mFields;
+    return std::any_of(fields.begin(), fields.end(), [](auto& init) { return HasSideEffects(init.mValue.get()); });
+  }
+  case ExprWithoutBlock::Type::Field:
+    return HasSideEffects(e->as<FieldExpr>()->mBase.get());
+  case ExprWithoutBlock::Type::Tuple: {
+    auto& elems = e->as<TupleExpr>()->mElems;
+    return std::any_of(elems.begin(), elems.end(), [](auto& elem) { return HasSideEffects(elem.get()); });
+  }
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+static auto BlockHasSideEffects(BlockExpr const* block) -> bool
+{
+  for (auto& stmt : block->mStmts) {
+    if (stmt == nullptr) {
+      continue;
+    }
+    auto expr = stmt->mType == Stmt::Type::Let ? stmt->as<LetStmt>()->mExpr.get() : stmt->as<ExprStmt>()->mExpr.get();
+    if (HasSideEffects(expr)) {
+      return true;
+    }
+  }
+  return HasSideEffects(block->mReturn.get());
+}
+
+static auto Mentions(Expr const* expr, std::string const& name) -> bool;
+
+static auto Mentions(Stmt const* stmt, std::string const& name) -> bool
+{
+  if (stmt == nullptr) {
+    return false;
+  }
+  if (stmt->mType == Stmt::Type::Let) {
+    return Mentions(stmt->as<LetStmt>()->mExpr.get(), name);
+  }
+  return Mentions(stmt->as<ExprStmt>()->mExpr.get(), name);
+}
+
+// whether `name` appears as an identifier or callee, shadowing is ignored which only errs on the side of keeping
+static auto Mentions(Expr const* expr, std::string const& name) -> bool
+{
+  if (expr == nullptr) {
+    return false;
+  }
+  if (expr->mType == Expr::Type::WithBlock) {
+    auto e = expr->as<ExprWithBlock>();
+    switch (e->mType) {
+    case ExprWithBlock::Type::Block: {
+      auto block = e->as<BlockExpr>();
+      return std::any_of(block->mStmts.begin(), block->mStmts.end(),
+                         [&](auto& stmt) { return Mentions(stmt.get(), name); }) ||
+             Mentions(block->mReturn.get(), name);
+    }
+    case ExprWithBlock::Type::If: {
+      auto ifExpr = e->as<IfExpr>();
+      return Mentions(ifExpr->mCond.get(), name) || Mentions(ifExpr->mThen.get(), name) ||
+             Mentions(ifExpr->mElse.get(), name);
+    }
+    case ExprWithBlock::Type::Loop: {
+      auto loop = e->as<LoopExpr>();
+      if (loop->mType == LoopExpr::Type::PredicateLoop) {
+        return Mentions(loop->as<PredicateLoopExpr>()->mCond.get(), name) ||
+               Mentions(loop->as<PredicateLoopExpr>()->mExpr.get(), name);
+      }
+      if (loop->mType == LoopExpr::Type::IteratorLoop) {
+        auto forLoop = loop->as<IteratorLoopExpr>();
+        return Mentions(forLoop->mStart.get(), name) || Mentions(forLoop->mEnd.get(), name) ||
+               Mentions(forLoop->mStep.get(), name) || Mentions(forLoop->mExpr.get(), name);
+      }
+      return Mentions(loop->as<InfiniteLoopExpr>()->mExpr.get(), name);
+    }
+    default:
+      return true;
+    }
+  }
+
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Literal: {
+    auto literal = e->as<LiteralExpr>();
+    return literal->mKind == LiteralExpr::Kind::Identifier && std::get<std::string>(literal->mValue) == name;
+  }
+  case ExprWithoutBlock::Type::Grouped:
+    return Mentions(e->as<GroupedExpr>()->mExpr.get(), name);
+  case ExprWithoutBlock::Type::Operator:
+    if (auto op = e->as<OperatorExpr>(); op->mType == OperatorExpr::Type::Binary) {
+      return Mentions(op->as<BinaryExpr>()->mLeft.get(), name) || Mentions(op->as<BinaryExpr>()->mRight.get(), name);
+    } else {
+      return Mentions(op->as<UnaryExpr>()->mRight.get(), name);
+    }
+  case ExprWithoutBlock::Type::Call: {
+    auto call = e->as<CallExpr>();
+    return call->mCallee == name ||
+           std::any_of(call->mArgs.begin(), call->mArgs.end(), [&](auto& arg) { return Mentions(arg.get(), name); });
+  }
+  case ExprWithoutBlock::Type::Return:
+    return Mentions(e->as<ReturnExpr>()->mExpr.get(), name);
+  case ExprWithoutBlock::Type::Index:
+    return Mentions(e->as<IndexExpr>()->mBase.get(), name) || Mentions(e->as<IndexExpr>()->mIndex.get(), name);
+  case ExprWithoutBlock::Type::MethodCall: {
+    auto call = e->as<MethodCallExpr>();
+    return Mentions(call->mReceiver.get(), name) ||
+           std::any_of(call->mArgs.begin(), call->mArgs.end(), [&](auto& arg) { return Mentions(arg.get(), name); });
+  }
+  case ExprWithoutBlock::Type::Array: {
+    auto& elems = e->as<ArrayExpr>()->mElems;
+    return std::any_of(elems.begin(), elems.end(), [&](auto& elem) { return Mentions(elem.get(), name); });
+  }
+  case ExprWithoutBlock::Type::Struct: {
+    auto& fields = e->as<StructExpr>()->mFields;
+    return std::any_of(fields.begin(), fields.end(), [&](auto& init) { return Mentions(init.mValue.get(), name); });
+  }
+  case ExprWithoutBlock::Type::Field:
+    return Mentions(e->as<FieldExpr>()->mBase.get(), name);
+  case ExprWithoutBlock::Type::Tuple: {
+    auto& elems = e->as<TupleExpr>()->mElems;
+    return std::any_of(elems.begin(), elems.end(), [&](auto& elem) { return Mentions(elem.get(), name); });
+  }
+  }
+  utils::Unreachable(utils::SrcLoc::current());
+}
+
+//===----------------------------------------------------------------------===//
+// Rewriting
+//===----------------------------------------------------------------------===//
+
+auto Simplifier::simplifyCrate(Crate* crate) -> void
+{
+  for (auto& item : crate->mItems) {
+    simplifyItem(item.get());
+  }
+}
+
+auto Simplifier::simplifyItem(Item* item) -> void
+{
+  if (item->mKind == Item::Kind::Function) {
+    if (auto fn = item->as<FunctionItem>(); !fn->isDeclaration()) {
+      simplifyBlockExpr(fn->mBody.get());
+    }
+  }
+}
+
+auto Simplifier::simplifyBlockExpr(BlockExpr* expr) -> void
+{
+  for (auto& item : expr->mItems) {
+    simplifyItem(item.get());
+  }
+  for (auto& stmt : expr->mStmts) {
+    if (stmt == nullptr) {
+      continue;
+    }
+    if (stmt->mType == Stmt::Type::Let) {
+      simplifyExpr(stmt->as<LetStmt>()->mExpr);
+    } else {
+      auto& e = stmt->as<ExprStmt>()->mExpr;
+      simplifyExpr(e);
+      if (IsEmptyBlock(e.get())) { // what is left of a pruned `if`
+        stmt = nullptr;
+      }
+    }
+  }
+  simplifyExpr(expr->mReturn);
+
+  removeDeadStmts(expr);
+  removeUnusedLets(expr);
+  std::erase(expr->mStmts, nullptr);
+}
+
+// returns whether the condition is constant, `taken` is then the branch always executed, null if there is none
+auto Simplifier::simplifyIf(IfExpr* expr, std::unique_ptr<ExprWithBlock>& taken) -> bool
+{
+  simplifyExpr(expr->mCond);
+  simplifyBlockExpr(expr->mThen.get());
+  if (expr->mElse) {
+    simplifyElse(expr->mElse);
+  }
+
+  auto cond = AsBoolLiteral(expr->mCond.get());
+  if (!cond) {
+    return false;
+  }
+  ++mStats.mPrunedBranches;
+  taken = *cond ? std::move(expr->mThen) : std::move(expr->mElse);
+  return true;
+}
+
+auto Simplifier::simplifyElse(std::unique_ptr<ExprWithBlock>& expr) -> void
+{
+  if (expr->mType == ExprWithBlock::Type::Block) {
+    return simplifyBlockExpr(expr->as<BlockExpr>());
+  }
+  if (expr->mType == ExprWithBlock::Type::If) {
+    if (std::unique_ptr<ExprWithBlock> taken; simplifyIf(expr->as<IfExpr>(), taken)) {
+      expr = std::move(taken);
+    }
+  }
+}
+
+auto Simplifier::simplifyExpr(std::unique_ptr<Expr>& expr) -> void
+{
+  if (expr == nullptr) {
+    return;
+  }
+
+  if (expr->mType == Expr::Type::WithBlock) {
+    auto e = expr->as<ExprWithBlock>();
+    switch (e->mType) {
+    case ExprWithBlock::Type::Block:
+      return simplifyBlockExpr(e->as<BlockExpr>());
+    case ExprWithBlock::Type::If: {
+      if (std::unique_ptr<ExprWithBlock> taken; simplifyIf(e->as<IfExpr>(), taken)) {
+        expr = taken ? std::move(taken) : MakeEmptyBlock();
+      }
+    } break;
+    case ExprWithBlock::Type::Loop: {
+      auto loop = e->as<LoopExpr>();
+      if (loop->mType == LoopExpr::Type::InfiniteLoop) {
+        return simplifyBlockExpr(loop->as<InfiniteLoopExpr>()->mExpr.get());
+      }
+      if (loop->mType == LoopExpr::Type::IteratorLoop) {
+        // a constant empty range runs the body never, the step is still evaluated
+        auto forLoop = loop->as<IteratorLoopExpr>();
+        simplifyExpr(forLoop->mStart);
+        simplifyExpr(forLoop->mEnd);
+        simplifyExpr(forLoop->mStep);
+        simplifyBlockExpr(forLoop->mExpr.get());
+        if (auto start = AsIntegerLiteral(forLoop->mStart.get()), end = AsIntegerLiteral(forLoop->mEnd.get());
+            start && end && !(*start < *end) && !HasSideEffects(forLoop->mStep.get())) {
+          ++mStats.mPrunedBranches;
+          expr = MakeEmptyBlock();
+        }
+        return;
+      }
+      auto whileLoop = loop->as<PredicateLoopExpr>();
+      simplifyExpr(whileLoop->mCond);
+      simplifyBlockExpr(whileLoop->mExpr.get());
+      if (auto cond = AsBoolLiteral(whileLoop->mCond.get()); cond && !*cond) {
+        ++mStats.mPrunedBranches;
+        expr = MakeEmptyBlock();
+      }
+    } break;
+    case ExprWithBlock::Type::IfLet:
+    case ExprWithBlock::Type::Match:
+      utils::Unimplemented(utils::SrcLoc::current());
+    }
+    return;
+  }
+
+  auto e = expr->as<ExprWithoutBlock>();
+  switch (e->mType) {
+  case ExprWithoutBlock::Type::Literal:
+    break;
+  case ExprWithoutBlock::Type::Grouped:
+    simplifyExpr(e->as<GroupedExpr>()->mExpr);
+    break;
+  case ExprWithoutBlock::Type::Operator:
+    if (auto op = e->as<OperatorExpr>(); op->mType == OperatorExpr::Type::Binary) {
+      simplifyExpr(op->as<BinaryExpr>()->mLeft);
+      simplifyExpr(op->as<BinaryExpr>()->mRight);
+    } else {
+      simplifyExpr(op->as<UnaryExpr>()->mRight);
+    }
+    break;
+  case ExprWithoutBlock::Type::Call:
+    for (auto& arg : e->as<CallExpr>()->mArgs) {
+      simplifyExpr(arg);
+    }
+    break;
+  case ExprWithoutBlock::Type::Return:
+    simplifyExpr(e->as<ReturnExpr>()->mExpr);
+    break;
+  case ExprWithoutBlock::Type::Index:
+    simplifyExpr(e->as<IndexExpr>()->mBase);
+    simplifyExpr(e->as<IndexExpr>()->mIndex);
+    break;
+  case ExprWithoutBlock::Type::MethodCall:
+    simplifyExpr(e->as<MethodCallExpr>()->mReceiver);
+    for (auto& arg : e->as<MethodCallExpr>()->mArgs) {
+      simplifyExpr(arg);
+    }
+    break;
+  case ExprWithoutBlock::Type::Array:
+    for (auto& elem : e->as<ArrayExpr>()->mElems) {
+      simplifyExpr(elem);
+    }
+    break;
+  case ExprWithoutBlock::Type::Struct:
+    for (auto& init : e->as<StructExpr>()->mFields) {
+      simplifyExpr(init.mValue);
+    }
+    break;
+  case ExprWithoutBlock::Type::Field:
+    simplifyExpr(e->as<FieldExpr>()->mBase);
+    break;
+  case ExprWithoutBlock::Type::Tuple:
+    for (auto& elem : e->as<TupleExpr>()->mElems) {
+      simplifyExpr(elem);
+    }
+    break;
+  }
+}
+
+// everything after a statement of type `!` can never execute
+auto Simplifier::removeDeadStmts(BlockExpr* expr) -> void
+{
+  auto diverges = [](Stmt const* stmt) {
+    if (stmt == nullptr) {
+      return false;
+    }
+    return IsNever(stmt->mType == Stmt::Type::Let ? stmt->as<LetStmt>()->mExpr.get()
+                                                  : stmt->as<ExprStmt>()->mExpr.get());
+  };
+  auto it = std::find_if(expr->mStmts.begin(), expr->mStmts.end(), [&](auto& stmt) { return diverges(stmt.get()); });
+  if (it == expr->mStmts.end()) {
+    return;
+  }
+  ++it;
+  mStats.mDeadStmts += std::count_if(it, expr->mStmts.end(), [](auto& stmt) { return stmt != nullptr; });
+  expr->mStmts.erase(it, expr->mStmts.end());
+  if (expr->mReturn) {
+    ++mStats.mDeadStmts;
+    expr->mReturn = nullptr;
+  }
+}
+
+// walks backwards so that removing a binding can make the bindings it read unused as well
+auto Simplifier::removeUnusedLets(BlockExpr* expr) -> void
+{
+  auto& stmts = expr->mStmts;
+  for (size_t i = stmts.size(); i-- > 0;) {
+    if (stmts[i] == nullptr || stmts[i]->mType != Stmt::Type::Let) {
+      continue;
+    }
+    auto let = stmts[i]->as<LetStmt>();
+    if (HasSideEffects(let->mExpr.get())) {
+      continue;
+    }
+    // a pattern is kept as a whole while any of its names is used
+    auto mentioned = [&](std::string const& name) {
+      return Mentions(expr->mReturn.get(), name) ||
+             std::any_of(stmts.begin() + i + 1, stmts.end(), [&](auto& stmt) { return Mentions(stmt.get(), name); });
+    };
+    auto names = let->boundNames();
+    bool used = std::any_of(names.begin(), names.end(), mentioned);
+    if (!used) {
+      ++mStats.mUnusedLets;
+      stmts[i] = nullptr;
+    }
+  }
+}
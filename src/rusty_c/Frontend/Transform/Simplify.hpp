@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Frontend/Syntax.hpp"
+
+struct SimplifyStats {
+  u32 mPrunedBranches = 0; // `if`/`while` with a constant condition, `for` over a constant empty range
+  u32 mDeadStmts = 0;      // statements after an expression of type `!`
+  u32 mUnusedLets = 0;     // side-effect free `let` whose binding is never read
+};
+
+// Rewrites the typed AST between Sema and IRGen: prunes branches on constant conditions, drops unreachable
+// statements and removes unused side-effect free let bindings. Expects constants to be folded already.
+class Simplifier {
+  SimplifyStats mStats;
+
+public:
+  Simplifier() = default;
+
+  auto simplifyCrate(Crate* crate) -> void;
+  auto simplifyItem(Item* item) -> void;
+  auto stats() const -> SimplifyStats const& { return mStats; }
+
+private:
+  auto simplifyBlockExpr(BlockExpr* expr) -> void;
+  auto simplifyExpr(std::unique_ptr<Expr>& expr) -> void;
+  auto simplifyElse(std::unique_ptr<ExprWithBlock>& expr) -> void;
+  auto simplifyIf(IfExpr* expr, std::unique_ptr<ExprWithBlock>& taken) -> bool;
+
+  auto removeDeadStmts(BlockExpr* expr) -> void;
+  auto removeUnusedLets(BlockExpr* expr) -> void;
+};
+
+auto HasSideEffects(Expr const* expr) -> bool;
+auto IsEmptyBlock(Expr const* expr) -> bool;
@@ -9,6 +9,10 @@ auto TypeEquals(TypeBase const* lhs, TypeBase const* rhs) -> bool
   if (lhs == rhs) {
     return true;
   }
+  // an unknown type has already been diagnosed, don't cascade
+  if (lhs->mKind == TypeBase::Kind::Unknown || rhs->mKind == TypeBase::Kind::Unknown) {
+    return true;
+  }
   if (lhs->mKind != rhs->mKind) {
     return false;
   }
@@ -55,14 +59,25 @@ auto TypeEquals(TypeBase const* lhs, TypeBase const* rhs) -> bool
     }
     return true;
   } break;
-  case TypeBase::Kind::Array:
   case TypeBase::Kind::Slice:
+    return TypeEquals(lhs->as<SliceType>()->mElem.get(), rhs->as<SliceType>()->mElem.get());
+  case TypeBase::Kind::Array:
+    return lhs->as<ArrayType>()->mLen == rhs->as<ArrayType>()->mLen &&
+           TypeEquals(lhs->as<ArrayType>()->mElem.get(), rhs->as<ArrayType>()->mElem.get());
+  case TypeBase::Kind::Vector:
+    return lhs->as<VectorType>()->mLanes == rhs->as<VectorType>()->mLanes &&
+           TypeEquals(lhs->as<VectorType>()->mElem.get(), rhs->as<VectorType>()->mElem.get());
   case TypeBase::Kind::Struct:
+    return lhs->as<StructType>()->mName == rhs->as<StructType>()->mName;
+  case TypeBase::Kind::Reference:
+    return lhs->as<ReferenceType>()->mMutable == rhs->as<ReferenceType>()->mMutable &&
+           TypeEquals(lhs->as<ReferenceType>()->mPointee.get(), rhs->as<ReferenceType>()->mPointee.get());
+  case TypeBase::Kind::RawPointer:
+    return lhs->as<RawPointerType>()->mMutable == rhs->as<RawPointerType>()->mMutable &&
+           TypeEquals(lhs->as<RawPointerType>()->mPointee.get(), rhs->as<RawPointerType>()->mPointee.get());
   case TypeBase::Kind::Enum:
   case TypeBase::Kind::Union:
   case TypeBase::Kind::Closures:
-  case TypeBase::Kind::Reference:
-  case TypeBase::Kind::RawPointer:
   case TypeBase::Kind::FunctionPointer:
   case TypeBase::Kind::TraitObjects:
   case TypeBase::Kind::ImplTrait:
@@ -75,6 +90,45 @@ auto TypeEquals(TypeBase const* lhs, TypeBase const* rhs) -> bool
   }
 }
 
+auto PointeeType(TypeBase const* type) -> TypeBase const*
+{
+  if (type->mKind == TypeBase::Kind::Reference) {
+    return type->as<ReferenceType>()->mPointee.get();
+  }
+  if (type->mKind == TypeBase::Kind::RawPointer) {
+    return type->as<RawPointerType>()->mPointee.get();
+  }
+  return nullptr;
+}
+
+auto TypeUnsizes(TypeBase const* from, TypeBase const* to) -> bool
+{
+  if (from == nullptr || to == nullptr || from->mKind != TypeBase::Kind::Reference ||
+      to->mKind != TypeBase::Kind::Slice) {
+    return false;
+  }
+  auto pointee = from->as<ReferenceType>()->mPointee.get();
+  return pointee->mKind == TypeBase::Kind::Array &&
+         TypeEquals(pointee->as<ArrayType>()->mElem.get(), to->as<SliceType>()->mElem.get());
+}
+
+auto TypeCoercible(TypeBase const* from, TypeBase const* to) -> bool
+{
+  if (TypeEquals(from, to) || TypeUnsizes(from, to)) {
+    return true;
+  }
+  if (from == nullptr || to == nullptr || PointeeType(from) == nullptr || PointeeType(to) == nullptr ||
+      !TypeEquals(PointeeType(from), PointeeType(to))) {
+    return false;
+  }
+  auto fromMutable = from->mKind == TypeBase::Kind::Reference ? from->as<ReferenceType>()->mMutable
+                                                              : from->as<RawPointerType>()->mMutable;
+  if (to->mKind == TypeBase::Kind::Reference) {
+    return from->mKind == TypeBase::Kind::Reference && !to->as<ReferenceType>()->mMutable;
+  }
+  return fromMutable || !to->as<RawPointerType>()->mMutable;
+}
+
 auto TypeClone(TypeBase const* type) -> std::unique_ptr<TypeBase>
 {
   if (type == nullptr) {
@@ -115,23 +169,39 @@ auto TypeClone(TypeBase const* type) -> std::unique_ptr<TypeBase>
     retType = TypeClone(fn->mRet.get());
     return std::make_unique<FunctionType>(std::move(paramTypes), std::move(retType));
   }
-  case TypeBase::Kind::Tuple:
-  case TypeBase::Kind::Array:
+  case TypeBase::Kind::Tuple: {
+    auto tuple = type->as<TupleType>();
+    std::vector<std::unique_ptr<TypeBase>> types;
+    for (auto& elem : tuple->mTypes) {
+      types.push_back(TypeClone(elem.get()));
+    }
+    return std::make_unique<TupleType>(std::move(types));
+  }
   case TypeBase::Kind::Slice:
+    return std::make_unique<SliceType>(TypeClone(type->as<SliceType>()->mElem.get()));
+  case TypeBase::Kind::Array:
+    return std::make_unique<ArrayType>(TypeClone(type->as<ArrayType>()->mElem.get()), type->as<ArrayType>()->mLen);
+  case TypeBase::Kind::Vector:
+    return std::make_unique<VectorType>(TypeClone(type->as<VectorType>()->mElem.get()),
+                                        type->as<VectorType>()->mLanes);
   case TypeBase::Kind::Struct:
+    return std::make_unique<StructType>(type->as<StructType>()->mName, type->as<StructType>()->mItem);
+  case TypeBase::Kind::Reference:
+    return std::make_unique<ReferenceType>(TypeClone(type->as<ReferenceType>()->mPointee.get()),
+                                           type->as<ReferenceType>()->mMutable);
+  case TypeBase::Kind::RawPointer:
+    return std::make_unique<RawPointerType>(TypeClone(type->as<RawPointerType>()->mPointee.get()),
+                                            type->as<RawPointerType>()->mMutable);
+  case TypeBase::Kind::Unknown:
+    return std::make_unique<Unknown>();
   case TypeBase::Kind::Enum:
   case TypeBase::Kind::Union:
   case TypeBase::Kind::Closures:
-  case TypeBase::Kind::Reference:
-  case TypeBase::Kind::RawPointer:
   case TypeBase::Kind::FunctionPointer:
   case TypeBase::Kind::TraitObjects:
   case TypeBase::Kind::ImplTrait:
   case TypeBase::Kind::SIZE:
     break;
-  case TypeBase::Kind::Unknown:
-    utils::Unreachable(utils::SrcLoc::current());
-    break;
   }
 
   utils::Unimplemented(utils::SrcLoc::current());
@@ -142,12 +212,26 @@ static const std::unordered_map<std::string_view, TypeBase> gTypeMap{
     {"u16", U16{}},      {"u32", U32{}}, {"u64", U64{}}, {"f32", F32{}}, {"f64", F64{}},
 };
 
+// element and lane count, 128 and 256 bit vectors plus the masks they compare to
+static const std::unordered_map<std::string_view, std::pair<std::string_view, u32>> gVectorMap{
+    {"i8x16", {"i8", 16}},  {"i8x32", {"i8", 32}},   {"u8x16", {"u8", 16}},   {"u8x32", {"u8", 32}},
+    {"i16x8", {"i16", 8}},  {"i16x16", {"i16", 16}}, {"u16x8", {"u16", 8}},   {"u16x16", {"u16", 16}},
+    {"i32x4", {"i32", 4}},  {"i32x8", {"i32", 8}},   {"u32x4", {"u32", 4}},   {"u32x8", {"u32", 8}},
+    {"i64x2", {"i64", 2}},  {"i64x4", {"i64", 4}},   {"u64x2", {"u64", 2}},   {"u64x4", {"u64", 4}},
+    {"f32x4", {"f32", 4}},  {"f32x8", {"f32", 8}},   {"f64x2", {"f64", 2}},   {"f64x4", {"f64", 4}},
+    {"boolx2", {"bool", 2}}, {"boolx4", {"bool", 4}}, {"boolx8", {"bool", 8}}, {"boolx16", {"bool", 16}},
+    {"boolx32", {"bool", 32}},
+};
+
 auto GetNumBoolMap(std::string_view target) -> std::unique_ptr<TypeBase>
 {
   auto const it = gTypeMap.find(target);
   if (it != gTypeMap.end()) {
     return std::make_unique<TypeBase>(it->second);
   }
+  if (auto const vec = gVectorMap.find(target); vec != gVectorMap.end()) {
+    return std::make_unique<VectorType>(GetNumBoolMap(vec->second.first), vec->second.second);
+  }
   return {nullptr};
 }
 
@@ -214,6 +298,34 @@ auto TypeToString(std::string& str, TypeBase const* type) -> void
       TypeToString(str, func->mRet.get());
     }
   } break;
+  case TypeBase::Kind::Slice:
+    str += "&[";
+    TypeToString(str, type->as<SliceType>()->mElem.get());
+    str += "]";
+    break;
+  case TypeBase::Kind::Array:
+    str += "[";
+    TypeToString(str, type->as<ArrayType>()->mElem.get());
+    str += "; " + std::to_string(type->as<ArrayType>()->mLen) + "]";
+    break;
+  case TypeBase::Kind::Vector:
+    TypeToString(str, type->as<VectorType>()->mElem.get());
+    str += "x" + std::to_string(type->as<VectorType>()->mLanes);
+    break;
+  case TypeBase::Kind::Struct:
+    str += type->as<StructType>()->mName;
+    break;
+  case TypeBase::Kind::Reference:
+    str += type->as<ReferenceType>()->mMutable ? "&mut " : "&";
+    TypeToString(str, type->as<ReferenceType>()->mPointee.get());
+    break;
+  case TypeBase::Kind::RawPointer:
+    str += type->as<RawPointerType>()->mMutable ? "*mut " : "*const ";
+    TypeToString(str, type->as<RawPointerType>()->mPointee.get());
+    break;
+  case TypeBase::Kind::Unknown:
+    str += "{unknown}";
+    break;
   default:
     utils::Unimplemented(utils::SrcLoc::current(), "TypeToString");
   }
@@ -30,7 +30,7 @@ public:
                // Numeric
                I8, I16, I32, I64, U8, U16, U32, U64, F32, F64, Char, Str,
                //
-               Never, Tuple, Array, Slice, Struct, Enum, Union, Functions, Closures, Reference, RawPointer,
+               Never, Tuple, Array, Slice, Vector, Struct, Enum, Union, Functions, Closures, Reference, RawPointer,
                FunctionPointer, TraitObjects, ImplTrait,
                //
                Unknown)
@@ -122,7 +122,99 @@ public:
   ~FunctionType() override = default;
 };
 
+// `&[T]`, a pointer to the first element and the number of elements
+struct SliceType final : TypeBase {
+public:
+  std::unique_ptr<TypeBase> mElem;
+
+public:
+  SliceType(std::unique_ptr<TypeBase> elem) : TypeBase(TypeBase::Kind::Slice), mElem(std::move(elem)) {}
+  ~SliceType() override = default;
+};
+
+// `[T; N]`, stored inline
+struct ArrayType final : TypeBase {
+public:
+  std::unique_ptr<TypeBase> mElem;
+  u64 mLen;
+
+public:
+  ArrayType(std::unique_ptr<TypeBase> elem, u64 len)
+      : TypeBase(TypeBase::Kind::Array), mElem(std::move(elem)), mLen(len)
+  {
+  }
+  ~ArrayType() override = default;
+};
+
+// `f32x4`, a SIMD vector of a numeric or bool element held in registers, `boolxN` is the mask of N lanes
+struct VectorType final : TypeBase {
+public:
+  std::unique_ptr<TypeBase> mElem;
+  u32 mLanes;
+
+public:
+  VectorType(std::unique_ptr<TypeBase> elem, u32 lanes)
+      : TypeBase(TypeBase::Kind::Vector), mElem(std::move(elem)), mLanes(lanes)
+  {
+  }
+  ~VectorType() override = default;
+
+  bool isMask() const { return mElem->mKind == TypeBase::Kind::Boolean; }
+};
+
+// `&T` and `&mut T`, never null and always pointing to a live value. Nothing writes through a shared reference and
+// a mutable one is the only access to the value while it is in use, so the two never alias
+struct ReferenceType final : TypeBase {
+public:
+  std::unique_ptr<TypeBase> mPointee;
+  bool mMutable;
+
+public:
+  ReferenceType(std::unique_ptr<TypeBase> pointee, bool isMutable)
+      : TypeBase(TypeBase::Kind::Reference), mPointee(std::move(pointee)), mMutable(isMutable)
+  {
+  }
+  ~ReferenceType() override = default;
+};
+
+// `*const T` and `*mut T`, the same as a pointer in C, no guarantees at all
+struct RawPointerType final : TypeBase {
+public:
+  std::unique_ptr<TypeBase> mPointee;
+  bool mMutable;
+
+public:
+  RawPointerType(std::unique_ptr<TypeBase> pointee, bool isMutable)
+      : TypeBase(TypeBase::Kind::RawPointer), mPointee(std::move(pointee)), mMutable(isMutable)
+  {
+  }
+  ~RawPointerType() override = default;
+};
+
+struct StructItem;
+
+// a struct named in the source, Sema points it at the item holding the fields and the layout
+struct StructType final : TypeBase {
+public:
+  std::string mName;
+  StructItem* mItem = nullptr;
+
+public:
+  StructType(std::string name, StructItem* item = nullptr)
+      : TypeBase(TypeBase::Kind::Struct), mName(std::move(name)), mItem(item)
+  {
+  }
+  ~StructType() override = default;
+};
+
 auto TypeEquals(TypeBase const* lhs, TypeBase const* rhs) -> bool;
+// equal, or a pointer that converts implicitly: `&mut T` to `&T`, a reference or raw pointer to a raw pointer that
+// does not allow more, and a reference to an array to a slice of its elements
+auto TypeCoercible(TypeBase const* from, TypeBase const* to) -> bool;
+// `&[T; N]` or `&mut [T; N]` to `&[T]`, the one coercion that changes the representation
+auto TypeUnsizes(TypeBase const* from, TypeBase const* to) -> bool;
+// the pointee of a reference or raw pointer, null for any other type
+auto PointeeType(TypeBase const* type) -> TypeBase const*;
 
 auto TypeClone(TypeBase const* type) -> std::unique_ptr<TypeBase>;
 inline auto TypeClone(std::unique_ptr<TypeBase> const& type) -> std::unique_ptr<TypeBase>
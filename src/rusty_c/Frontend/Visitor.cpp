@@ -9,6 +9,20 @@ struct ToStringVisitor : public Visitor<void> {
       walkItem(item.get());
     }
   }
+  void walk(ArrayExpr* expr)
+  {
+    mResult += '[';
+    for (int i = 0; i < expr->mElems.size(); ++i) {
+      if (i != 0) {
+        mResult += ", ";
+      }
+      walkExpr(expr->mElems[i].get());
+    }
+    if (expr->mRepeat) {
+      mResult += "; " + std::to_string(*expr->mRepeat);
+    }
+    mResult += ']';
+  }
   void walk(BinaryExpr* expr)
   {
     walkExpr(expr->mLeft.get());
@@ -57,11 +71,83 @@ struct ToStringVisitor : public Visitor<void> {
       walkExpr(expr->mElse.get());
     }
   }
+  void walk(IndexExpr* expr)
+  {
+    walkExpr(expr->mBase.get());
+    mResult += '[';
+    walkExpr(expr->mIndex.get());
+    mResult += ']';
+  }
+  void walk(StructExpr* expr)
+  {
+    mResult += expr->mName;
+    mResult += '{';
+    for (int i = 0; i < expr->mFields.size(); ++i) {
+      if (i != 0) {
+        mResult += ",";
+      }
+      mResult += expr->mFields[i].mName;
+      mResult += ':';
+      walkExpr(expr->mFields[i].mValue.get());
+    }
+    mResult += '}';
+  }
+  void walk(FieldExpr* expr)
+  {
+    walkExpr(expr->mBase.get());
+    mResult += '.';
+    mResult += expr->mField;
+  }
+  void walk(TupleExpr* expr)
+  {
+    mResult += '(';
+    for (int i = 0; i < expr->mElems.size(); ++i) {
+      if (i != 0) {
+        mResult += ",";
+      }
+      walkExpr(expr->mElems[i].get());
+    }
+    if (expr->mElems.size() == 1) {
+      mResult += ",";
+    }
+    mResult += ')';
+  }
+  void walk(MethodCallExpr* expr)
+  {
+    walkExpr(expr->mReceiver.get());
+    mResult += '.';
+    mResult += expr->mMethod;
+    mResult += '(';
+    for (int i = 0; i < expr->mArgs.size(); ++i) {
+      if (i != 0) {
+        mResult += ",";
+      }
+      walkExpr(expr->mArgs[i].get());
+    }
+    mResult += ')';
+  }
   void walk(InfiniteLoopExpr* expr)
   {
+    walkAttributes(expr->mAttrs);
     mResult += "loop";
     walk(expr->mExpr.get());
   }
+  void walk(IteratorLoopExpr* expr)
+  {
+    walkAttributes(expr->mAttrs);
+    mResult += "for " + expr->mName + " in (";
+    walkExpr(expr->mStart.get());
+    mResult += "..";
+    walkExpr(expr->mEnd.get());
+    mResult += ')';
+    if (expr->mStep) {
+      mResult += ".step_by(";
+      walkExpr(expr->mStep.get());
+      mResult += ')';
+    }
+    mResult += ' ';
+    walk(expr->mExpr.get());
+  }
   void walk(LiteralExpr* expr)
   {
     mResult += std::visit(
@@ -80,6 +166,7 @@ struct ToStringVisitor : public Visitor<void> {
   }
   void walk(PredicateLoopExpr* expr)
   {
+    walkAttributes(expr->mAttrs);
     mResult += "while (";
     walkExpr(expr->mCond.get());
     mResult += ") ";
@@ -102,7 +189,18 @@ struct ToStringVisitor : public Visitor<void> {
   void walk(LetStmt* stmt)
   {
     mResult += "let ";
-    mResult += stmt->mName;
+    if (stmt->mPattern) {
+      mResult += '(';
+      for (int i = 0; i < stmt->mPattern->size(); ++i) {
+        if (i != 0) {
+          mResult += ",";
+        }
+        mResult += (*stmt->mPattern)[i];
+      }
+      mResult += ')';
+    } else {
+      mResult += stmt->mName;
+    }
     if (stmt->mExpectType) {
       mResult += ":";
       mResult += TypeToString(stmt->mExpectType.get());
@@ -116,12 +214,39 @@ struct ToStringVisitor : public Visitor<void> {
     switch (item->mKind) {
     case Item::Kind::Function:
       return walk(static_cast<FunctionItem*>(item));
+    case Item::Kind::ExternBlock:
+      return walk(static_cast<ExternalBlockItem*>(item));
+    case Item::Kind::Struct:
+      return walk(static_cast<StructItem*>(item));
+    case Item::Kind::ConstantItem:
+      return walk(static_cast<ConstantItem*>(item));
+    case Item::Kind::StaticItem:
+      return walk(static_cast<StaticItem*>(item));
     default:
       utils::Unimplemented(utils::SrcLoc::current());
     }
   }
+  void walkAttributes(std::vector<Attribute> const& attrs)
+  {
+    for (auto const& attr : attrs) {
+      mResult += "#[";
+      mResult += attr.mName;
+      if (!attr.mArgs.empty()) {
+        mResult += '(';
+        for (int i = 0; i < attr.mArgs.size(); ++i) {
+          if (i != 0) {
+            mResult += ",";
+          }
+          mResult += attr.mArgs[i];
+        }
+        mResult += ')';
+      }
+      mResult += "]";
+    }
+  }
   void walk(FunctionItem* item)
   {
+    walkAttributes(item->mAttrs);
     mResult += "fn ";
     mResult += item->mName;
     mResult += '(';
@@ -135,7 +260,60 @@ struct ToStringVisitor : public Visitor<void> {
     }
     mResult += ")->";
     mResult += TypeToString(item->mFnType->mRet.get());
-    walk(item->mBody.get());
+    if (item->isDeclaration()) {
+      mResult += ';';
+    } else {
+      walk(item->mBody.get());
+    }
+  }
+  void walk(ExternalBlockItem* item)
+  {
+    walkAttributes(item->mAttrs);
+    mResult += "extern \"";
+    mResult += item->mABI;
+    mResult += "\"{";
+    for (auto& fn : item->mItems) {
+      walk(fn.get());
+    }
+    mResult += "}";
+  }
+  void walk(StructItem* item)
+  {
+    walkAttributes(item->mAttrs);
+    mResult += "struct ";
+    mResult += item->mName;
+    mResult += '{';
+    for (int i = 0; i < item->mFields.size(); ++i) {
+      if (i != 0) {
+        mResult += ",";
+      }
+      mResult += item->mFields[i].mName;
+      mResult += ":";
+      mResult += TypeToString(item->mFields[i].mType.get());
+    }
+    mResult += '}';
+  }
+  void walk(ConstantItem* item)
+  {
+    walkAttributes(item->mAttrs);
+    mResult += "const ";
+    mResult += item->mName;
+    mResult += ":";
+    mResult += TypeToString(item->mType.get());
+    mResult += "=";
+    walkExpr(item->mExpr.get());
+    mResult += ';';
+  }
+  void walk(StaticItem* item)
+  {
+    walkAttributes(item->mAttrs);
+    mResult += item->mMutable ? "static mut " : "static ";
+    mResult += item->mName;
+    mResult += ":";
+    mResult += TypeToString(item->mType.get());
+    mResult += "=";
+    walkExpr(item->mExpr.get());
+    mResult += ';';
   }
   void walk(ExprStmt* stmt)
   {
@@ -2,10 +2,12 @@
 #include "Syntax.hpp"
 
 // leaf node
-// BinaryExpr, BlockExpr, CallExpr, GroupedExpr, IfExpr, InfiniteLoopExpr, LiteralExpr, PredicateLoopExpr, ReturnExpr,
-// UnaryExpr, LetStmt, FunctionItem
+// ArrayExpr, BinaryExpr, BlockExpr, CallExpr, GroupedExpr, IfExpr, IndexExpr, InfiniteLoopExpr, IteratorLoopExpr,
+// LiteralExpr, MethodCallExpr, PredicateLoopExpr, ReturnExpr, StructExpr, FieldExpr, TupleExpr, UnaryExpr, LetStmt,
+// FunctionItem, StructItem, ConstantItem, StaticItem
 template <typename T, typename... Args>
 struct Visitor {
+  virtual auto walk(ArrayExpr* expr, Args... args) -> T = 0;
   virtual auto walk(BinaryExpr* expr, Args... args) -> T = 0;
   virtual auto walk(BlockExpr* expr, Args... args) -> T = 0;
   virtual auto walk(CallExpr* expr, Args... args) -> T = 0;
@@ -47,13 +49,28 @@ struct Visitor {
       return walk(expr->as<CallExpr>(), std::forward<Args>(args)...);
     case ExprWithoutBlock::Type::Return:
       return walk(expr->as<ReturnExpr>(), std::forward<Args>(args)...);
+    case ExprWithoutBlock::Type::Index:
+      return walk(expr->as<IndexExpr>(), std::forward<Args>(args)...);
+    case ExprWithoutBlock::Type::MethodCall:
+      return walk(expr->as<MethodCallExpr>(), std::forward<Args>(args)...);
+    case ExprWithoutBlock::Type::Array:
+      return walk(expr->as<ArrayExpr>(), std::forward<Args>(args)...);
+    case ExprWithoutBlock::Type::Struct:
+      return walk(expr->as<StructExpr>(), std::forward<Args>(args)...);
+    case ExprWithoutBlock::Type::Field:
+      return walk(expr->as<FieldExpr>(), std::forward<Args>(args)...);
+    case ExprWithoutBlock::Type::Tuple:
+      return walk(expr->as<TupleExpr>(), std::forward<Args>(args)...);
     default:
       utils::Unimplemented(utils::SrcLoc::current());
     }
   }
+  virtual auto walk(FieldExpr* expr, Args... args) -> T = 0;
   virtual auto walk(GroupedExpr* expr, Args... args) -> T = 0;
   virtual auto walk(IfExpr* expr, Args... args) -> T = 0;
+  virtual auto walk(IndexExpr* expr, Args... args) -> T = 0;
   virtual auto walk(InfiniteLoopExpr* expr, Args... args) -> T = 0;
+  virtual auto walk(IteratorLoopExpr* expr, Args... args) -> T = 0;
   virtual auto walk(LiteralExpr* expr, Args... args) -> T = 0;
   auto walk(LoopExpr* expr, Args... args) -> T
   {
@@ -62,6 +79,8 @@ struct Visitor {
       return walk(expr->as<InfiniteLoopExpr>(), std::forward<Args>(args)...);
     case LoopExpr::Type::PredicateLoop:
       return walk(expr->as<PredicateLoopExpr>(), std::forward<Args>(args)...);
+    case LoopExpr::Type::IteratorLoop:
+      return walk(expr->as<IteratorLoopExpr>(), std::forward<Args>(args)...);
     default:
       utils::Unreachable(utils::SrcLoc::current());
     }
@@ -77,8 +96,11 @@ struct Visitor {
       utils::Unreachable(utils::SrcLoc::current());
     }
   }
+  virtual auto walk(MethodCallExpr* expr, Args... args) -> T = 0;
   virtual auto walk(ReturnExpr* expr, Args... args) -> T = 0;
   virtual auto walk(PredicateLoopExpr* expr, Args... args) -> T = 0;
+  virtual auto walk(StructExpr* expr, Args... args) -> T = 0;
+  virtual auto walk(TupleExpr* expr, Args... args) -> T = 0;
   virtual auto walk(UnaryExpr* expr, Args... args) -> T = 0;
 
   auto walkStmt(Stmt* stmt, Args... args) -> T
@@ -99,11 +121,23 @@ struct Visitor {
     switch (item->mKind) {
     case Item::Kind::Function:
       return walk(item->as<FunctionItem>(), std::forward<Args>(args)...);
+    case Item::Kind::ExternBlock:
+      return walk(item->as<ExternalBlockItem>(), std::forward<Args>(args)...);
+    case Item::Kind::Struct:
+      return walk(item->as<StructItem>(), std::forward<Args>(args)...);
+    case Item::Kind::ConstantItem:
+      return walk(item->as<ConstantItem>(), std::forward<Args>(args)...);
+    case Item::Kind::StaticItem:
+      return walk(item->as<StaticItem>(), std::forward<Args>(args)...);
     default:
       utils::Unimplemented(utils::SrcLoc::current());
     }
   }
   virtual auto walk(FunctionItem* item, Args... args) -> T = 0;
+  virtual auto walk(ExternalBlockItem* item, Args... args) -> T = 0;
+  virtual auto walk(StructItem* item, Args... args) -> T = 0;
+  virtual auto walk(ConstantItem* item, Args... args) -> T = 0;
+  virtual auto walk(StaticItem* item, Args... args) -> T = 0;
 };
 
 auto CrateToString(Crate* crate) -> std::string;
\ No newline at end of file
@@ -1,13 +1,300 @@
-#include "llvm/Support/InitLLVM.h"
-#include "llvm/Support/ExtensibleRTTI.h"
-#include "llvm/Support/InitLLVM.h"
-#include "llvm/Support/raw_ostream.h"
-#include <concepts>
-#include <iostream>
+#include "Driver/Backend.hpp"
+#include "Driver/Frontend.hpp"
+#include "Driver/Jit.hpp"
+#include "Driver/ObjectCache.hpp"
+#include "Driver/ThinLTO.hpp"
+#include "Frontend/Lexer.hpp"
+#include "Frontend/Parser.hpp"
 
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/InitLLVM.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/ToolOutputFile.h>
+#include <llvm/Support/WithColor.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace cl = llvm::cl;
+
+static cl::OptionCategory DriverCategory("RustyC options");
+
+static cl::opt<std::string> InputFile(cl::Positional, cl::desc("<input file>"), cl::Required, cl::cat(DriverCategory));
+
+static cl::list<std::string> RestArgs(cl::Positional,
+                                     cl::desc("[<more inputs with --thinlto-link> | -- <program args with --run>]"),
+                                     cl::cat(DriverCategory));
+
+static cl::opt<bool> Run("run", cl::desc("Run main through a lazy JIT instead of writing an output file"),
+                         cl::cat(DriverCategory));
+
+static cl::opt<bool> ThinLTOLinkMode("thinlto-link",
+                                     cl::desc("Optimize and compile thin-bc inputs together into a static archive"),
+                                     cl::cat(DriverCategory));
+
+static cl::opt<bool> Tiered("tiered", cl::desc("With --run, start every function at -O0 and promote hot ones to -O3"),
+                            cl::cat(DriverCategory));
+
+static cl::opt<u64> TierUpCalls("tier-up-calls", cl::desc("Calls before a function is promoted (0 = never)"),
+                                cl::init(TieringOptions{}.mCallThreshold), cl::cat(DriverCategory));
+
+static cl::opt<u64> TierUpBackedges("tier-up-backedges",
+                                    cl::desc("Loop iterations before a function is promoted (0 = never)"),
+                                    cl::init(TieringOptions{}.mBackedgeThreshold), cl::cat(DriverCategory));
+
+static cl::opt<bool> TierStats("tier-stats", cl::desc("Print the tier-up events when the program exits"),
+                               cl::cat(DriverCategory));
+
+static cl::opt<std::string> OutputFile("o", cl::desc("Output file, '-' for stdout"), cl::value_desc("file"),
+                                       cl::cat(DriverCategory));
+
+static cl::opt<std::string> OptLevelFlag("O", cl::desc("Optimization level: 0, 1, 2, 3, s or z"), cl::Prefix,
+                                         cl::init("0"), cl::cat(DriverCategory));
+
+static cl::opt<EmitKind> Emit("emit", cl::desc("Kind of output"),
+                              cl::values(clEnumValN(EmitKind::LLVMIR, "llvm-ir", "LLVM assembly"),
+                                         clEnumValN(EmitKind::Bitcode, "bc", "LLVM bitcode"),
+                                         clEnumValN(EmitKind::ThinBitcode, "thin-bc",
+                                                    "LLVM bitcode with a ThinLTO summary, for --thinlto-link"),
+                                         clEnumValN(EmitKind::Assembly, "asm", "Native assembly"),
+                                         clEnumValN(EmitKind::Object, "obj", "Relocatable object")),
+                              cl::init(EmitKind::Object), cl::cat(DriverCategory));
+
+static cl::list<std::string> CodegenFlags("C",
+                                          cl::desc("Codegen option: opt-level=, target-cpu=, target-feature=, "
+                                                   "profile-generate[=dir], profile-use="),
+                                          cl::value_desc("key=value"), cl::Prefix, cl::cat(DriverCategory));
+
+static cl::opt<unsigned> Jobs("j",
+                           cl::desc("Native codegen threads, 0 = one per core. With more than one an object is "
+                                    "written as a static archive of the partitions"),
+                           cl::value_desc("N"), cl::Prefix, cl::init(1), cl::cat(DriverCategory));
+
+static cl::opt<std::string> CacheDir("cache-dir",
+                                     cl::desc("Compile every function on its own, reuse unchanged ones from <dir> and write a static archive"),
+                                     cl::value_desc("dir"), cl::cat(DriverCategory));
+
+static cl::opt<bool> CacheStats("cache-stats", cl::desc("Print how many functions came from the cache"),
+                                cl::cat(DriverCategory));
+
+static cl::opt<std::string> TargetTriple("target", cl::desc("Target triple, the host if not given"),
+                                         cl::cat(DriverCategory));
+
+static cl::opt<unsigned> ErrorLimit("error-limit", cl::desc("Stop reporting errors after N (0 = no limit)"),
+                                    cl::init(0), cl::cat(DriverCategory));
+
+static cl::opt<DiagnosticsEngine::OutputFormat> DiagnosticFormat(
+    "diagnostic-format", cl::desc("Diagnostic output format"),
+    cl::values(clEnumValN(DiagnosticsEngine::OutputFormat::Text, "text", "Human readable text"),
+               clEnumValN(DiagnosticsEngine::OutputFormat::Json, "json", "JSON array"),
+               clEnumValN(DiagnosticsEngine::OutputFormat::Sarif, "sarif", "SARIF 2.1.0 log")),
+    cl::init(DiagnosticsEngine::OutputFormat::Text), cl::cat(DriverCategory));
+
+static cl::opt<u64> ConstEvalSteps("const-eval-steps", cl::desc("Maximum number of steps when evaluating a const fn call"),
+                                   cl::init(1'000'000), cl::cat(DriverCategory));
+
+static cl::opt<bool> Pipeline("pipeline", cl::desc("Lower each function while Sema checks the rest of the crate"),
+                              cl::cat(DriverCategory));
+
+static cl::list<std::string> ExportedSymbols("export-symbol", cl::desc("Keep the function even if main never calls it"),
+                                             cl::cat(DriverCategory));
+
+static cl::opt<bool> PrintStats("pass-stats", cl::desc("Print statistics of the AST transformation passes"),
+                                cl::cat(DriverCategory));
+
+static cl::opt<bool> PrintTypeLayouts("print-type-layouts",
+                                      cl::desc("Print the size, alignment and field offsets of every struct"),
+                                      cl::cat(DriverCategory));
+
+static auto Fatal(llvm::Twine const& message) -> int
+{
+  llvm::WithColor::error(llvm::errs(), "rusty_c") << message << '\n';
+  return 1;
+}
+
+// -C flags follow rustc, later ones override earlier ones and -O
+static auto ParseCodegenFlags(CodegenOptions& opts) -> bool
+{
+  for (auto& flag : CodegenFlags) {
+    auto [key, value] = llvm::StringRef(flag).split('=');
+    if (key == "target-cpu") {
+      opts.mCPU = value.str();
+    } else if (key == "target-feature") {
+      opts.mFeatures = opts.mFeatures.empty() ? value.str() : opts.mFeatures + "," + value.str();
+    } else if (key == "profile-generate") {
+      opts.mProfileGenerate = value.str();
+    } else if (key == "profile-use") {
+      if (value.empty()) {
+        Fatal("profile-use needs a .profdata file");
+        return false;
+      }
+      opts.mProfileUse = value.str();
+    } else if (key == "opt-level") {
+      auto level = ParseOptLevel(value);
+      if (!level) {
+        Fatal("invalid opt-level '" + value + "'");
+        return false;
+      }
+      opts.mOptLevel = *level;
+    } else {
+      Fatal("unknown codegen option '" + key + "'");
+      return false;
+    }
+  }
+  return true;
+}
 
 int main(int argc, char* argv[])
 {
-  llvm::InitLLVM X(argc, argv);
-  llvm::outs() << "Hello, I'm Rusty C, 你好世界";
-}
\ No newline at end of file
+  llvm::InitLLVM vm(argc, argv);
+  cl::HideUnrelatedOptions(DriverCategory);
+  cl::ParseCommandLineOptions(argc, argv, "RustyC compiler\n");
+
+  auto codegenOpts = CodegenOptions{};
+  codegenOpts.mTriple = TargetTriple;
+  if (auto level = ParseOptLevel(OptLevelFlag)) {
+    codegenOpts.mOptLevel = *level;
+  } else {
+    return Fatal("invalid optimization level '-O" + OptLevelFlag + "'");
+  }
+  if (!ParseCodegenFlags(codegenOpts)) {
+    return 1;
+  }
+  if (codegenOpts.mProfileGenerate && !codegenOpts.mProfileUse.empty()) {
+    return Fatal("-C profile-generate and -C profile-use are mutually exclusive");
+  }
+  if (codegenOpts.mProfileGenerate && Run) {
+    return Fatal("-C profile-generate needs the profile runtime at link time, it cannot be used with --run");
+  }
+  if (!codegenOpts.mProfileUse.empty() && !llvm::sys::fs::exists(codegenOpts.mProfileUse)) {
+    return Fatal("cannot find profile '" + codegenOpts.mProfileUse + "'");
+  }
+  if (Run && !TargetTriple.empty()) {
+    return Fatal("--target cannot be used with --run");
+  }
+  if (!Run && Tiered) {
+    return Fatal("--tiered requires --run");
+  }
+  if (!CacheDir.empty() && (Run || Emit != EmitKind::Object)) {
+    return Fatal("--cache-dir only works with --emit=obj");
+  }
+  if (!Run && !ThinLTOLinkMode && !RestArgs.empty()) {
+    return Fatal("more than one input is only accepted with --thinlto-link");
+  }
+
+  auto jobs = Jobs == 0 ? llvm::hardware_concurrency().compute_thread_count() : Jobs.getValue();
+  auto stem = llvm::sys::path::stem(InputFile.getValue());
+  if (ThinLTOLinkMode) {
+    if (Run || Emit != EmitKind::Object || !CacheDir.empty()) {
+      return Fatal("--thinlto-link only writes objects");
+    }
+    auto inputs = std::vector<std::string>{InputFile.getValue()};
+    inputs.insert(inputs.end(), RestArgs.begin(), RestArgs.end());
+    auto objects = ThinLTOLink(inputs, codegenOpts, jobs, ExportedSymbols);
+    if (!objects) {
+      return Fatal(llvm::toString(objects.takeError()));
+    }
+    auto outputFile = OutputFile.empty() ? stem.str() + ".a" : OutputFile.getValue();
+    auto triple = llvm::Triple(codegenOpts.mTriple.empty() ? llvm::sys::getDefaultTargetTriple() : codegenOpts.mTriple);
+    if (auto err = WriteObjectArchive(outputFile, stem, triple, *objects)) {
+      return Fatal("cannot write '" + outputFile + "': " + llvm::toString(std::move(err)));
+    }
+    return 0;
+  }
+
+  auto fileOrError = llvm::MemoryBuffer::getFile(InputFile);
+  if (auto error = fileOrError.getError()) {
+    return Fatal("cannot read '" + InputFile + "': " + error.message());
+  }
+  auto srcMgr = llvm::SourceMgr{};
+  auto diags = DiagnosticsEngine{srcMgr};
+  diags.setErrorLimit(ErrorLimit);
+  diags.setOutputFormat(DiagnosticFormat);
+  srcMgr.AddNewSourceBuffer(std::move(fileOrError.get()), llvm::SMLoc());
+
+  auto tokens = Lexer{srcMgr, diags}.tokenize();
+  auto crate = Parser{tokens, diags}.parseCrate();
+
+  auto frontendOpts = FrontendOptions{};
+  frontendOpts.mConstEvalSteps = ConstEvalSteps;
+  frontendOpts.mPipeline = Pipeline;
+  frontendOpts.mExportedSymbols = ExportedSymbols;
+  frontendOpts.mPrintStats = PrintStats;
+  frontendOpts.mPrintTypeLayouts = PrintTypeLayouts;
+  // the cache lowers one function at a time itself
+  frontendOpts.mEmitIR = CacheDir.empty();
+
+  // owned by the JIT in --run mode
+  auto ctx = std::make_unique<llvm::LLVMContext>();
+  auto module = RunFrontend(&crate, InputFile, diags, *ctx, frontendOpts);
+  diags.flush();
+  if (diags.numErrors() != 0) {
+    return 1;
+  }
+
+  auto tm = CreateTargetMachine(codegenOpts);
+  if (!tm) {
+    return Fatal(llvm::toString(tm.takeError()));
+  }
+
+  if (!CacheDir.empty()) {
+    auto cache = ObjectCache{CacheDir, codegenOpts};
+    auto objects = cache.compileCrate(&crate, InputFile, **tm);
+    if (!objects) {
+      return Fatal(llvm::toString(objects.takeError()));
+    }
+    if (CacheStats) {
+      llvm::errs() << "cache: " << cache.stats().mHits << " function(s) reused, " << cache.stats().mMisses
+                   << " compiled\n";
+    }
+    auto outputFile = OutputFile.empty() ? stem.str() + ".a" : OutputFile.getValue();
+    if (auto err = WriteObjectArchive(outputFile, stem, (*tm)->getTargetTriple(), *objects)) {
+      return Fatal("cannot write '" + outputFile + "': " + llvm::toString(std::move(err)));
+    }
+    return 0;
+  }
+  OptimizeModule(*module, **tm, codegenOpts.mOptLevel,
+                 Emit == EmitKind::ThinBitcode ? LTOPhase::ThinPreLink : LTOPhase::None, nullptr,
+                 PGOOptionsOf(codegenOpts));
+
+  if (Run) {
+    auto args = std::vector<std::string>{InputFile.getValue()};
+    args.insert(args.end(), RestArgs.begin(), RestArgs.end());
+    auto tsm = llvm::orc::ThreadSafeModule(std::move(module), std::move(ctx));
+    auto tiering = TieringOptions{TierUpCalls, TierUpBackedges, TierStats};
+    auto exitCode = Tiered ? RunInTieredJit(std::move(tsm), codegenOpts, tiering, args)
+                           : RunInJit(std::move(tsm), codegenOpts, args);
+    if (!exitCode) {
+      return Fatal(llvm::toString(exitCode.takeError()));
+    }
+    return *exitCode;
+  }
+
+  if (jobs > 1 && Emit == EmitKind::Assembly) {
+    // local labels of the partitions would clash if the listings were concatenated
+    llvm::WithColor::warning(llvm::errs(), "rusty_c") << "-j is ignored for --emit=asm\n";
+  }
+  if (jobs > 1 && Emit == EmitKind::Object) {
+    auto outputFile = OutputFile.empty() ? stem.str() + ".a" : OutputFile.getValue();
+    auto objects = EmitObjectsParallel(*module, codegenOpts, jobs);
+    if (auto err = WriteObjectArchive(outputFile, stem, (*tm)->getTargetTriple(), objects)) {
+      return Fatal("cannot write '" + outputFile + "': " + llvm::toString(std::move(err)));
+    }
+    return 0;
+  }
+
+  auto outputFile = OutputFile.empty() ? stem.str() + EmitKindExtension(Emit).data() : OutputFile.getValue();
+  auto isText = Emit == EmitKind::LLVMIR || Emit == EmitKind::Assembly;
+  auto error = std::error_code{};
+  auto out = llvm::ToolOutputFile(outputFile, error, isText ? llvm::sys::fs::OF_Text : llvm::sys::fs::OF_None);
+  if (error) {
+    return Fatal("cannot open '" + outputFile + "': " + error.message());
+  }
+  if (auto err = EmitModule(*module, **tm, Emit, out.os())) {
+    return Fatal(llvm::toString(std::move(err)));
+  }
+  out.keep();
+  return 0;
+}
@@ -11,6 +11,7 @@ using i16 = ::std::int16_t;
 using i32 = ::std::int32_t;
 using i64 = ::std::int64_t;
 #include "marco.hpp"
+#include <fmt/args.h>
 #include <fmt/format.h>
 #include <iostream>
 #include <source_location>
@@ -19,7 +20,9 @@ using i64 = ::std::int64_t;
 namespace utils {
 using SrcLoc = std::source_location;
 
+using fmt::dynamic_format_arg_store;
 using fmt::format;
+using fmt::format_context;
 using fmt::make_format_args;
 using fmt::vformat;
 
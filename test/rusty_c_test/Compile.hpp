@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Driver/Frontend.hpp"
+#include "Frontend/Lexer.hpp"
+#include "Frontend/Parser.hpp"
+
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// a crate run through the frontend, along with everything it points into
+struct Compiled {
+  std::unique_ptr<llvm::SourceMgr> mSrcMgr = std::make_unique<llvm::SourceMgr>();
+  std::unique_ptr<llvm::LLVMContext> mCtx = std::make_unique<llvm::LLVMContext>();
+  std::vector<Token> mTokens;
+  std::unique_ptr<Crate> mCrate;
+  std::unique_ptr<llvm::Module> mModule; // null if there were errors or no IR was requested
+  std::string mDiagOutput;              // the diagnostics as JSON
+  std::vector<std::string> mDiagIds;    // in the order they were printed
+
+  auto function(std::string_view name) const -> FunctionItem*
+  {
+    for (auto& item : mCrate->mItems) {
+      if (item->mKind == Item::Kind::Function && item->as<FunctionItem>()->mName == name) {
+        return item->as<FunctionItem>();
+      }
+    }
+    return nullptr;
+  }
+  auto reported(std::string_view id) const -> bool
+  {
+    return std::find(mDiagIds.begin(), mDiagIds.end(), id) != mDiagIds.end();
+  }
+};
+
+inline auto Compile(std::string_view codes, FrontendOptions const& opts = {}) -> Compiled
+{
+  auto result = Compiled{};
+  auto diags = DiagnosticsEngine{*result.mSrcMgr};
+  diags.setOutputFormat(DiagnosticsEngine::OutputFormat::Json);
+  result.mSrcMgr->AddNewSourceBuffer(llvm::MemoryBuffer::getMemBufferCopy(codes, "test.rs"), llvm::SMLoc());
+  result.mTokens = Lexer{*result.mSrcMgr, diags}.tokenize();
+  auto crate = Parser{result.mTokens, diags}.parseCrate();
+  result.mCrate = std::make_unique<Crate>(std::move(crate.mItems));
+  result.mModule = RunFrontend(result.mCrate.get(), "test", diags, *result.mCtx, opts);
+
+  auto os = llvm::raw_string_ostream(result.mDiagOutput);
+  diags.flush(os);
+  os.flush();
+  if (auto parsed = llvm::json::parse(result.mDiagOutput); parsed && parsed->getAsArray()) {
+    for (auto& diag : *parsed->getAsArray()) {
+      result.mDiagIds.push_back(diag.getAsObject()->getString("id")->str());
+    }
+  } else if (!parsed) {
+    llvm::consumeError(parsed.takeError()); // nothing was reported
+  }
+  return result;
+}
@@ -0,0 +1,239 @@
+#include "Compile.hpp"
+#include "Driver/Backend.hpp"
+#include "gtest/gtest.h"
+
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
+
+// the memcpy calls IRGen emits for a program before any optimization, -1 if it does not compile
+static auto CountMemCpys(char const* codes) -> int
+{
+  auto result = Compile(codes);
+  if (result.mModule == nullptr) {
+    return -1;
+  }
+  auto count = 0;
+  for (auto& fn : *result.mModule) {
+    for (auto& inst : llvm::instructions(fn)) {
+      count += llvm::isa<llvm::MemCpyInst>(inst);
+    }
+  }
+  return count;
+}
+
+TEST(CodegenTest, NamedReturnValueIsBuiltInTheReturnSlot)
+{
+  auto codes = R"(
+    struct Big { a: i64, b: i64, c: i64, d: i64 }
+    fn make(v: i64) -> Big {
+      let big = Big { a: v, b: v, c: v, d: v };
+      big.b = v + 1i64;
+      big
+    }
+    fn main() -> i32 {
+      let big = make(1i64);
+      if big.b == 2i64 { 0 } else { 1 }
+    }
+  )";
+  EXPECT_EQ(CountMemCpys(codes), 0);
+}
+
+TEST(CodegenTest, LastUseIsHandedOver)
+{
+  auto codes = R"(
+    struct Big { a: i64, b: i64, c: i64, d: i64 }
+    fn sum(big: Big) -> i64 { big.a + big.b + big.c + big.d }
+    fn main() -> i32 {
+      let big = Big { a: 1i64, b: 2i64, c: 3i64, d: 4i64 };
+      if sum(big) == 10i64 { 0 } else { 1 }
+    }
+  )";
+  EXPECT_EQ(CountMemCpys(codes), 0);
+}
+
+TEST(CodegenTest, LiveArgumentIsCopied)
+{
+  auto codes = R"(
+    struct Big { a: i64, b: i64, c: i64, d: i64 }
+    fn sum(big: Big) -> i64 { big.a + big.b + big.c + big.d }
+    fn main() -> i32 {
+      let big = Big { a: 1i64, b: 2i64, c: 3i64, d: 4i64 };
+      let s = sum(big);
+      if s + big.a == 11i64 { 0 } else { 1 }
+    }
+  )";
+  EXPECT_EQ(CountMemCpys(codes), 1);
+}
+
+// whether any indexing in the function kept its bounds check, failed checks branch to a block named `trap`
+static auto HasBoundsCheck(Compiled const& result, char const* name) -> bool
+{
+  auto fn = result.mModule->getFunction(name);
+  return std::any_of(fn->begin(), fn->end(), [](llvm::BasicBlock const& block) { return block.getName() == "trap"; });
+}
+
+TEST(BoundsCheckTest, LoopConditionProvesIndexInBounds)
+{
+  auto result = Compile(R"(
+    fn sum(a: &[i32]) -> i32 {
+      let s = 0;
+      let i = 0u64;
+      while i < a.len() { s = s + a[i]; i = i + 1u64; }
+      s
+    }
+    fn main() -> i32 { let arr = [1, 2, 3]; sum(&arr) }
+  )");
+  ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+  EXPECT_FALSE(HasBoundsCheck(result, "sum"));
+}
+
+TEST(BoundsCheckTest, GuardProvesIndexInBounds)
+{
+  auto result = Compile(R"(
+    fn get(a: &[i32], i: u64) -> i32 { if i < a.len() { a[i] } else { 0 } }
+    fn main() -> i32 { let arr = [1, 2, 3]; get(&arr, 1u64) }
+  )");
+  ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+  EXPECT_FALSE(HasBoundsCheck(result, "get"));
+}
+
+TEST(BoundsCheckTest, InclusiveBoundKeepsCheck)
+{
+  auto result = Compile(R"(
+    fn sum(a: &[i32]) -> i32 {
+      let s = 0;
+      let i = 0u64;
+      while i <= a.len() { s = s + a[i]; i = i + 1u64; }
+      s
+    }
+    fn get(a: &[i32], i: u64) -> i32 { a[i] }
+    fn main() -> i32 { let arr = [1, 2, 3]; sum(&arr) + get(&arr, 1u64) }
+  )");
+  ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+  EXPECT_TRUE(HasBoundsCheck(result, "sum"));
+  EXPECT_TRUE(HasBoundsCheck(result, "get"));
+}
+
+TEST(BoundsCheckTest, GetUncheckedHasNoCheck)
+{
+  auto result = Compile(R"(
+    fn get(a: &[i32], i: u64) -> i32 { a.get_unchecked(i) }
+    fn main() -> i32 { let arr = [1, 2, 3]; get(&arr, 1u64) }
+  )");
+  ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+  EXPECT_FALSE(HasBoundsCheck(result, "get"));
+}
+
+TEST(StaticTest, StaticsAreInternalToTheCrate)
+{
+  auto codes = R"(
+    static mut N: i32 = 0;
+    fn inc() -> i32 { N = N + 1; N }
+    fn main() -> i32 { inc() }
+  )";
+  for (auto pipeline : {false, true}) {
+    auto opts = FrontendOptions{};
+    opts.mPipeline = pipeline;
+    auto result = Compile(codes, opts);
+    ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+    auto gv = result.mModule->getNamedGlobal("test::N");
+    ASSERT_NE(gv, nullptr) << "pipeline " << pipeline;
+    EXPECT_TRUE(gv->hasInternalLinkage()) << "pipeline " << pipeline;
+    EXPECT_EQ(result.mModule->getNamedGlobal("N"), nullptr);
+  }
+}
+
+// the loop ID on the back edge of the only hinted loop in `name`
+static auto LoopIDOf(Compiled const& result, char const* name) -> llvm::MDNode*
+{
+  for (auto& inst : llvm::instructions(result.mModule->getFunction(name))) {
+    if (auto id = inst.getMetadata(llvm::LLVMContext::MD_loop)) {
+      return id;
+    }
+  }
+  return nullptr;
+}
+
+// the value of the hint `name` in the loop ID, -1 if it is missing
+static auto HintOf(llvm::MDNode const* id, llvm::StringRef name) -> i64
+{
+  for (auto const& op : llvm::drop_begin(id->operands())) {
+    auto hint = llvm::dyn_cast<llvm::MDNode>(op);
+    if (hint != nullptr && hint->getNumOperands() == 2 && llvm::isa<llvm::MDString>(hint->getOperand(0)) &&
+        llvm::cast<llvm::MDString>(hint->getOperand(0))->getString() == name) {
+      return llvm::mdconst::extract<llvm::ConstantInt>(hint->getOperand(1))->getSExtValue();
+    }
+  }
+  return -1;
+}
+
+// the call keeps the loop from being vectorized
+static auto kHintedLoop = R"(static mut SEEN: i32 = 0;
+#[noinline]
+fn opaque(x: i32) -> i32 { SEEN = SEEN + x; x }
+fn sum(a: &[i32]) -> i32 {
+  let s = 0;
+  let i = 0u64;
+  #[vectorize(4)]
+  #[unroll(2)]
+  while i < a.len() {
+    s = s + opaque(a[i]);
+    i = i + 1u64;
+  }
+  s
+}
+fn main() -> i32 { let a = [1, 2, 3, 4, 5, 6, 7, 8]; sum(&a) }
+)";
+
+TEST(LoopHintTest, HintsAreOnTheLatchBranch)
+{
+  for (auto pipeline : {false, true}) {
+    auto opts = FrontendOptions{};
+    opts.mPipeline = pipeline;
+    auto result = Compile(kHintedLoop, opts);
+    ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+    auto id = LoopIDOf(result, "sum");
+    ASSERT_NE(id, nullptr) << "pipeline " << pipeline;
+    EXPECT_EQ(HintOf(id, "llvm.loop.vectorize.width"), 4);
+    EXPECT_EQ(HintOf(id, "llvm.loop.unroll.count"), 2);
+
+    // the branch carrying the ID is the back edge to the condition
+    auto latch = llvm::find_if(llvm::instructions(result.mModule->getFunction("sum")), [&](auto& inst) {
+      return inst.getMetadata(llvm::LLVMContext::MD_loop) == id;
+    });
+    auto br = llvm::dyn_cast<llvm::BranchInst>(&*latch);
+    ASSERT_NE(br, nullptr);
+    ASSERT_TRUE(br->isUnconditional());
+    EXPECT_EQ(br->getSuccessor(0)->getName(), "while.cond");
+  }
+}
+
+TEST(LoopHintTest, LoopIDCarriesTheLoopLocation)
+{
+  auto result = Compile(kHintedLoop);
+  ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+  auto id = LoopIDOf(result, "sum");
+  ASSERT_NE(id, nullptr);
+  auto loc = llvm::dyn_cast<llvm::DILocation>(id->getOperand(1));
+  ASSERT_NE(loc, nullptr);
+  EXPECT_EQ(loc->getLine(), 9u);
+  EXPECT_EQ(loc->getFilename(), "test.rs");
+  EXPECT_EQ(loc->getScope()->getSubprogram()->getName(), "sum");
+}
+
+TEST(LoopHintTest, UnhonouredHintIsReportedAtTheLoop)
+{
+  auto result = Compile(kHintedLoop);
+  ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+  auto opts = CodegenOptions{};
+  opts.mOptLevel = OptLevel::O2;
+  auto tm = CreateTargetMachine(opts);
+  ASSERT_TRUE(static_cast<bool>(tm)) << llvm::toString(tm.takeError());
+
+  testing::internal::CaptureStderr();
+  OptimizeModule(*result.mModule, **tm, OptLevel::O2);
+  auto output = testing::internal::GetCapturedStderr();
+  EXPECT_NE(output.find("test.rs:9:"), std::string::npos) << output;
+  EXPECT_NE(output.find("warning: loop not vectorized"), std::string::npos) << output;
+  EXPECT_EQ(output.find("in function"), std::string::npos) << output;
+}
@@ -1,6 +1,12 @@
-#include "frontend/Lexer.hpp"
+#include "Compile.hpp"
+#include "Frontend/Lexer.hpp"
+#include "Frontend/Sema/SemanticHash.hpp"
 #include "gtest/gtest.h"
 
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/SourceMgr.h>
+
 #include <string>
 using namespace std::string_literals;
 // class LexerTest: public ::testing::Test {
@@ -13,8 +19,259 @@ TEST(FrontendTest, LexerTest)
     i8 u8 i16 u16 i32 u32 i64 u64 f32 f64 bool true false asdf leaving hello world's ;; {}()[]!= == <= >= & -> ; :, let
     12345 0xAB_CD_EF
 )";
-  auto tokens = Lexer{codes}.tokenize();
+  auto srcMgr = llvm::SourceMgr{};
+  auto diags = DiagnosticsEngine{srcMgr};
+  srcMgr.AddNewSourceBuffer(llvm::MemoryBuffer::getMemBuffer(codes), llvm::SMLoc());
+  auto tokens = Lexer{srcMgr, diags}.tokenize();
   for (auto tok : tokens) {
     std::cout << tok.toString() << '\n';
   }
+  EXPECT_EQ(diags.numErrors(), 0u);
+}
+
+TEST(ConstEvalTest, ConstFnCallIsFoldedToLiteral)
+{
+  auto result = Compile(R"(
+    const fn sq(x: i32) -> i32 { x * x }
+    const X: i32 = sq(7);
+    fn main() -> i32 { X + sq(2) }
+  )");
+  ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+  // folding left no call to sq, so it is not even lowered
+  EXPECT_EQ(result.mModule->getFunction("sq"), nullptr);
+  auto ret = llvm::dyn_cast<llvm::ReturnInst>(result.mModule->getFunction("main")->getEntryBlock().getTerminator());
+  ASSERT_NE(ret, nullptr);
+  auto value = llvm::dyn_cast<llvm::ConstantInt>(ret->getReturnValue());
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(value->getSExtValue(), 53);
+}
+
+TEST(ConstEvalTest, OverflowInInitializerIsError)
+{
+  auto result = Compile(R"(
+    const X: i32 = 2147483647 + 1;
+    fn main() -> i32 { X }
+  )");
+  EXPECT_EQ(result.mModule, nullptr);
+  EXPECT_EQ(result.mDiagIds, std::vector<std::string>{"ErrConstOverflow"});
+}
+
+TEST(ConstEvalTest, StepLimitLeavesCallForRuntime)
+{
+  auto opts = FrontendOptions{};
+  opts.mConstEvalSteps = 1000;
+  auto result = Compile(R"(
+    const fn spin(n: u64) -> u64 { let i = 0u64; while i < n { i = i + 1u64; } i }
+    fn main() -> i32 { if spin(100000u64) == 0u64 { 1 } else { 0 } }
+  )",
+                        opts);
+  ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+  EXPECT_EQ(result.mDiagIds, std::vector<std::string>{"WarnConstEvalLimit"});
+  EXPECT_NE(result.mModule->getFunction("spin"), nullptr);
+}
+
+TEST(ConstEvalTest, DepthLimitLeavesCallForRuntime)
+{
+  auto result = Compile(R"(
+    const fn down(n: u64) -> u64 { if n == 0u64 { 0u64 } else { down(n - 1u64) } }
+    fn main() -> i32 { if down(1000u64) == 0u64 { 0 } else { 1 } }
+  )");
+  ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+  EXPECT_EQ(result.mDiagIds, std::vector<std::string>{"WarnConstEvalDepth"});
+  EXPECT_NE(result.mModule->getFunction("down"), nullptr);
+}
+
+TEST(ConstEvalTest, NonConstInitializerIsRejected)
+{
+  auto result = Compile(R"(
+    fn f() -> i32 { 3 }
+    const X: i32 = f();
+    fn main() -> i32 { X }
+  )");
+  EXPECT_EQ(result.mModule, nullptr);
+  EXPECT_EQ(result.mDiagIds, std::vector<std::string>{"ErrNotConstant"});
+}
+
+TEST(PassStatsTest, SimplifyAndReachabilityCounts)
+{
+  auto codes = R"(
+    fn never() -> i32 { 7 }
+    fn main() -> i32 {
+      let x = 3;
+      if false { x = 1; }
+      let y = x + 1;
+      return x;
+      x = 2;
+      x
+    }
+  )";
+  for (auto pipeline : {false, true}) {
+    auto opts = FrontendOptions{};
+    opts.mPipeline = pipeline;
+    opts.mPrintStats = true;
+    testing::internal::CaptureStderr();
+    auto result = Compile(codes, opts);
+    auto output = testing::internal::GetCapturedStderr();
+    ASSERT_NE(result.mModule, nullptr) << result.mDiagOutput;
+    EXPECT_NE(output.find("simplify: 1 branch(es) pruned, 2 dead statement(s) removed, 1 unused let(s) removed\n"),
+              std::string::npos)
+        << "pipeline " << pipeline << '\n'
+        << output;
+    EXPECT_NE(output.find("reachability: 1 function(s) reachable, 1 unreachable item(s) removed\n"), std::string::npos)
+        << "pipeline " << pipeline << '\n'
+        << output;
+    EXPECT_EQ(result.mModule->getFunction("never"), nullptr);
+  }
+}
+
+// the hash the object cache keys `f` with, after the same passes as a real build
+static auto HashOfF(char const* codes) -> std::string
+{
+  auto opts = FrontendOptions{};
+  opts.mEmitIR = false;
+  auto result = Compile(codes, opts);
+  EXPECT_EQ(result.mDiagIds, std::vector<std::string>{}) << result.mDiagOutput;
+  auto fn = result.function("f");
+  return fn == nullptr ? std::string{} : SemanticHash(fn);
+}
+
+TEST(SemanticHashTest, BodyChangeChangesHash)
+{
+  auto before = HashOfF("fn f(x: i32) -> i32 { x + 1 }\nfn main() -> i32 { f(1) }");
+  auto after = HashOfF("fn f(x: i32) -> i32 { x + 2 }\nfn main() -> i32 { f(1) }");
+  ASSERT_FALSE(before.empty());
+  EXPECT_NE(before, after);
+}
+
+TEST(SemanticHashTest, CalleeSignatureChangeChangesHash)
+{
+  auto before = HashOfF("fn g(x: i32) -> i32 { x }\nfn f() -> i32 { g(1); 0 }\nfn main() -> i32 { f() }");
+  auto after = HashOfF("fn g(x: i32) -> i64 { 0i64 }\nfn f() -> i32 { g(1); 0 }\nfn main() -> i32 { f() }");
+  ASSERT_FALSE(before.empty());
+  EXPECT_NE(before, after);
+}
+
+TEST(SemanticHashTest, ConstInitializerChangeChangesHash)
+{
+  auto before = HashOfF("const K: i32 = 1;\nfn f() -> i32 { K }\nfn main() -> i32 { f() }");
+  auto after = HashOfF("const K: i32 = 2;\nfn f() -> i32 { K }\nfn main() -> i32 { f() }");
+  ASSERT_FALSE(before.empty());
+  EXPECT_NE(before, after);
+}
+
+TEST(SemanticHashTest, StaticInitializerChangeChangesHash)
+{
+  auto before = HashOfF("static S: i32 = 1;\nfn f() -> i32 { S }\nfn main() -> i32 { f() }");
+  auto after = HashOfF("static S: i32 = 2;\nfn f() -> i32 { S }\nfn main() -> i32 { f() }");
+  ASSERT_FALSE(before.empty());
+  EXPECT_NE(before, after);
+}
+
+TEST(SemanticHashTest, FormattingAndLocationsDoNotChangeHash)
+{
+  auto before = HashOfF("fn g(x: i32) -> i32 { x }\nfn f(x: i32) -> i32 { let y = g(x); y * 2 }\nfn main() -> i32 { f(1) }");
+  auto after = HashOfF(R"(
+
+
+    fn g(x: i32) -> i32 {
+      x
+    }
+
+    fn f(x: i32) -> i32 {
+      let y   =   g( x );
+      y * 2
+    }
+
+    fn main() -> i32 { f(1) }
+  )");
+  ASSERT_FALSE(before.empty());
+  EXPECT_EQ(before, after);
+}
+
+// a source buffer to point diagnostics into, `a` at 0, `b` at 2 and `c` at 4 of the second line
+class DiagnosticsTest : public ::testing::Test {
+protected:
+  llvm::SourceMgr mSrcMgr;
+  DiagnosticsEngine mDiags{mSrcMgr};
+  char const* mStart = nullptr;
+  std::string mOutput;
+
+  void SetUp() override
+  {
+    mSrcMgr.AddNewSourceBuffer(llvm::MemoryBuffer::getMemBuffer("first\na b c\n", "test.rs"), llvm::SMLoc());
+    mStart = mSrcMgr.getMemoryBuffer(mSrcMgr.getMainFileID())->getBufferStart();
+  }
+  auto at(char name) -> char const* { return mStart + 6 + (name - 'a') * 2; }
+  auto flush() -> std::string const&
+  {
+    auto os = llvm::raw_string_ostream(mOutput);
+    mDiags.flush(os);
+    os.flush();
+    return mOutput;
+  }
+};
+
+TEST_F(DiagnosticsTest, FlushSortsBySourceAndDropsDuplicates)
+{
+  mDiags.report(at('c'), DiagId::ErrUnknownType, "C");
+  mDiags.report(at('a'), DiagId::ErrUnknownType, "A");
+  mDiags.report(llvm::SMLoc(), DiagId::ErrUndeclaredFunction, "unlocated");
+  mDiags.report(at('b'), DiagId::ErrUnknownType, "B");
+  mDiags.report(at('a'), DiagId::ErrUnknownType, "A");
+  mDiags.report(at('a'), DiagId::ErrRedefinedSym, "A");
+  auto const& output = flush();
+
+  auto order = std::vector<size_t>{};
+  for (auto needle : {"Unknown type 'A'", "Symbol 'A'", "Unknown type 'B'", "Unknown type 'C'", "'unlocated'"}) {
+    order.push_back(output.find(needle));
+    ASSERT_NE(order.back(), std::string::npos) << needle << " missing from\n" << output;
+  }
+  EXPECT_TRUE(std::is_sorted(order.begin(), order.end())) << output;
+  EXPECT_EQ(output.find("Unknown type 'A'", order[0] + 1), std::string::npos) << output;
+  EXPECT_NE(output.find("test.rs:2:1: error"), std::string::npos) << output;
+  EXPECT_EQ(output.find("<unknown>"), std::string::npos) << output;
+  EXPECT_EQ(mDiags.numErrors(), 6u);
+}
+
+TEST_F(DiagnosticsTest, ErrorLimitSuppressesFurtherErrors)
+{
+  mDiags.setErrorLimit(2);
+  mDiags.report(at('a'), DiagId::ErrUnknownType, "A");
+  mDiags.report(at('b'), DiagId::ErrUnknownType, "B");
+  EXPECT_TRUE(mDiags.hasReachedErrorLimit());
+  mDiags.report(at('c'), DiagId::ErrUnknownType, "C");
+  mDiags.report(at('c'), DiagId::ErrRedefinedSym, "C");
+  mDiags.report(at('c'), DiagId::WarnConstEvalDepth, "f", 256);
+  auto const& output = flush();
+
+  EXPECT_NE(output.find("Unknown type 'B'"), std::string::npos) << output;
+  EXPECT_EQ(output.find("'C'"), std::string::npos) << output;
+  EXPECT_NE(output.find("call depth limit of 256"), std::string::npos) << output; // warnings do not count
+  EXPECT_NE(output.find("Error limit of 2 reached, 2 further error(s) suppressed"), std::string::npos) << output;
+}
+
+TEST_F(DiagnosticsTest, JsonOutput)
+{
+  mDiags.setOutputFormat(DiagnosticsEngine::OutputFormat::Json);
+  mDiags.report(at('b'), DiagId::ErrUnknownType, "B");
+  mDiags.report(llvm::SMLoc(), DiagId::WarnConstEvalLimit, "f", 1000);
+  auto parsed = llvm::json::parse(flush());
+  ASSERT_TRUE(bool(parsed)) << llvm::toString(parsed.takeError());
+  auto array = parsed->getAsArray();
+  ASSERT_NE(array, nullptr);
+  ASSERT_EQ(array->size(), 2u);
+
+  auto located = (*array)[0].getAsObject();
+  EXPECT_EQ(located->getString("id").getValueOr(""), "ErrUnknownType");
+  EXPECT_EQ(located->getString("level").getValueOr(""), "error");
+  EXPECT_EQ(located->getString("message").getValueOr(""), "Unknown type 'B'");
+  EXPECT_EQ(located->getString("file").getValueOr(""), "test.rs");
+  EXPECT_EQ(located->getInteger("line").getValueOr(0), 2);
+  EXPECT_EQ(located->getInteger("column").getValueOr(0), 3);
+
+  auto unlocated = (*array)[1].getAsObject();
+  EXPECT_EQ(unlocated->getString("id").getValueOr(""), "WarnConstEvalLimit");
+  EXPECT_EQ(unlocated->getString("level").getValueOr(""), "warning");
+  EXPECT_EQ(unlocated->get("file"), nullptr);
+  EXPECT_EQ(unlocated->get("line"), nullptr);
 }